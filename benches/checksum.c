@@ -0,0 +1,136 @@
+/* Microbenchmark for the one's complement sum behind the packet checksums.
+ *
+ * Compares the 16 bit at a time loop the decoders used before with the
+ * kernels in src/util-checksum-simd.c: 32 bit words in 64 bit accumulators,
+ * SSE2 and AVX2 on x86-64, NEON on AArch64. The source file is included
+ * here so its static kernels can be timed one by one, "dispatch" is the
+ * ChecksumSum() the decoders call after ChecksumSimdSetup(). Each kernel
+ * is checked against the 16 bit loop before it is timed.
+ *
+ * Build from this directory, after running configure:
+ *
+ *   cc -O2 -DHAVE_CONFIG_H -I.. -I../src -o checksum checksum.c
+ *
+ * Run:    ./checksum [packet-size] [seconds]
+ *
+ * Use a packet size of 9000 for jumbo frames, 1460 for a full MSS.
+ */
+
+#include "suricata-common.h"
+/* the unittests need the rest of suricata */
+#undef UNITTESTS
+#include "../src/util-checksum-simd.c"
+
+#define NPKTS 1024
+
+/* keeps the sums from being optimized out */
+static volatile uint64_t sink;
+
+/* the unrolled loop from the old TCPChecksum */
+static uint64_t Sum16(const uint8_t *data, uint32_t len)
+{
+    const uint16_t *pkt = (const uint16_t *)data;
+    uint32_t csum = 0;
+    while (len >= 32) {
+        csum += pkt[0] + pkt[1] + pkt[2] + pkt[3] + pkt[4] + pkt[5] + pkt[6] + pkt[7] + pkt[8] +
+                pkt[9] + pkt[10] + pkt[11] + pkt[12] + pkt[13] + pkt[14] + pkt[15];
+        len -= 32;
+        pkt += 16;
+    }
+    while (len > 1) {
+        csum += pkt[0];
+        pkt += 1;
+        len -= 2;
+    }
+    if (len == 1) {
+        uint16_t pad = 0;
+        *(uint8_t *)(&pad) = (*(uint8_t *)pkt);
+        csum += pad;
+    }
+    return csum;
+}
+
+static uint64_t SumDispatch(const uint8_t *data, uint32_t len)
+{
+    return ChecksumSum(data, len);
+}
+
+typedef struct Kernel_ {
+    const char *name;
+    uint64_t (*Sum)(const uint8_t *, uint32_t);
+    bool available;
+} Kernel;
+
+static double Now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char **argv)
+{
+    const uint32_t size = argc > 1 ? (uint32_t)atoi(argv[1]) : 1460;
+    const double seconds = argc > 2 ? atof(argv[2]) : 1.0;
+    if (size == 0 || size > 65535) {
+        fprintf(stderr, "packet size must be 1-65535\n");
+        return 1;
+    }
+
+    ChecksumSimdSetup();
+    Kernel kernels[] = {
+        { "16bit", Sum16, true },
+        { "words", ChecksumSumWords, true },
+#if defined(CHECKSUM_SIMD_X86)
+        { "sse2", ChecksumSumSSE2, true },
+        { "avx2", ChecksumSumAVX2, __builtin_cpu_supports("avx2") != 0 },
+#elif defined(CHECKSUM_SIMD_NEON)
+        { "neon", ChecksumSumNEON, true },
+#endif
+        { "dispatch", SumDispatch, true },
+    };
+
+    /* spread the packets out so they don't all sit in L1 */
+    const uint32_t stride = (size + 63) & ~63U;
+    uint8_t *pkts = aligned_alloc(64, (size_t)stride * NPKTS);
+    if (pkts == NULL)
+        return 1;
+    uint32_t x = 0x12345678;
+    for (size_t i = 0; i < (size_t)stride * NPKTS; i++) {
+        x = x * 1103515245 + 12345;
+        pkts[i] = (uint8_t)(x >> 16);
+    }
+
+    printf("packet size %u, %u packets, %.1fs per kernel, dispatch to %s\n", size, NPKTS, seconds,
+            ChecksumSimdImpl());
+    for (size_t k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++) {
+        if (!kernels[k].available) {
+            printf("%-8s not supported by this cpu\n", kernels[k].name);
+            continue;
+        }
+        for (uint32_t i = 0; i < NPKTS; i++) {
+            const uint8_t *pkt = pkts + (size_t)i * stride;
+            if (ChecksumFold(kernels[k].Sum(pkt, size)) != ChecksumFold(Sum16(pkt, size))) {
+                printf("%-8s wrong result for packet %u\n", kernels[k].name, i);
+                return 1;
+            }
+        }
+
+        uint64_t sum = 0, n = 0;
+        const double start = Now();
+        double elapsed;
+        do {
+            for (uint32_t i = 0; i < NPKTS; i++) {
+                sum += kernels[k].Sum(pkts + (size_t)i * stride, size);
+            }
+            n += NPKTS;
+            elapsed = Now() - start;
+        } while (elapsed < seconds);
+
+        sink = sum;
+        printf("%-8s %8.1f ns/pkt %8.2f GB/s\n", kernels[k].name, elapsed * 1e9 / n,
+                (double)n * size / elapsed / 1e9);
+    }
+    free(pkts);
+    return 0;
+}
@@ -0,0 +1,208 @@
+/* Microbenchmark for the flow hash lookup of existing flows.
+ *
+ * Runs FlowGetFlowFromHash in workers mode: each thread looks up flows it
+ * owns in the flow hash, through the same FlowLookupStruct a flow worker
+ * uses. Compares the locked lookup (no FlowHashReader registered) against
+ * the optimistic lookup, and the optimistic lookup on per thread shards of
+ * the hash (flow.hash-shards). A second thread locks every bucket in turn
+ * with FBLOCK_LOCK, like the flow manager does when it walks the hash.
+ *
+ * Build from this directory, after building suricata:
+ *
+ *   cc -O2 -pthread -DHAVE_CONFIG_H -I.. -I../src -I../rust/gen -I../rust/dist \
+ *       -o flow-hash-lookup flow-hash-lookup.c ../src/libsuricata_c.a \
+ *       <RUST_SURICATA_LIB, HTP_LDADD, RUST_LDADD and LIBS from src/Makefile>
+ *
+ * Run:    ./flow-hash-lookup [threads] [seconds] [flows-per-thread]
+ */
+
+#include "suricata-common.h"
+#include "conf.h"
+#include "decode.h"
+#include "flow.h"
+#include "flow-hash.h"
+#include "flow-private.h"
+#include "flow-queue.h"
+#include "flow-util.h"
+#include "util-debug.h"
+#include "util-storage.h"
+#include "util-time.h"
+
+static SC_ATOMIC_DECLARE(bool, stop);
+static bool lockless;
+static uint32_t flows_per_thread;
+
+typedef struct Worker_ {
+    pthread_t t;
+    uint32_t id;
+    uint64_t lookups;
+} __attribute__((aligned(CLS))) Worker;
+
+/* UDP packet of flow 'idx' of thread 'id', set up like the decoders do */
+static Packet *BuildPacket(uint32_t id, uint32_t idx, SCTime_t ts)
+{
+    Packet *p = PacketGetFromAlloc();
+    if (p == NULL)
+        return NULL;
+
+    p->ts = ts;
+    p->proto = IPPROTO_UDP;
+    p->ip4h = (IPV4Hdr *)GET_PKT_DATA(p);
+    p->ip4h->ip_verhl = 0x45;
+    p->ip4h->ip_proto = IPPROTO_UDP;
+    p->ip4h->s_ip_src.s_addr = htonl(0x0a000000 | id);
+    p->ip4h->s_ip_dst.s_addr = htonl(0xc0a80001);
+    p->udph = (UDPHdr *)(GET_PKT_DATA(p) + sizeof(IPV4Hdr));
+    p->sp = (uint16_t)(1024 + idx % 60000);
+    p->dp = (uint16_t)(53 + idx / 60000);
+    p->udph->uh_sport = htons(p->sp);
+    p->udph->uh_dport = htons(p->dp);
+    SET_PKT_LEN(p, sizeof(IPV4Hdr) + sizeof(UDPHdr));
+    SET_IPV4_SRC_ADDR(p, &p->src);
+    SET_IPV4_DST_ADDR(p, &p->dst);
+
+    FlowSetupPacket(p);
+    return p;
+}
+
+/* look up the flow of p, the way FlowWorker does */
+static inline bool Lookup(FlowLookupStruct *fls, Packet *p)
+{
+    FlowHandlePacket(NULL, fls, p);
+    if (p->flow == NULL)
+        return false;
+    FLOWLOCK_UNLOCK(p->flow);
+    FlowDeReference(&p->flow);
+    return true;
+}
+
+static void *WorkerLoop(void *arg)
+{
+    Worker *w = arg;
+    FlowLookupStruct fls;
+    memset(&fls, 0, sizeof(fls));
+    fls.hash_shard = FlowHashShardAssign();
+    if (lockless)
+        fls.reader = FlowHashReaderRegister();
+
+    const SCTime_t ts = TimeGet();
+    Packet **pkts = SCCalloc(flows_per_thread, sizeof(Packet *));
+    if (pkts == NULL)
+        abort();
+    /* first packet of each flow creates it */
+    for (uint32_t i = 0; i < flows_per_thread; i++) {
+        pkts[i] = BuildPacket(w->id, i, ts);
+        if (pkts[i] == NULL || !Lookup(&fls, pkts[i]))
+            abort();
+    }
+
+    uint32_t i = 0;
+    uint64_t n = 0;
+    while (!SC_ATOMIC_GET(stop)) {
+        for (int batch = 0; batch < 1024; batch++) {
+            if (!Lookup(&fls, pkts[i]))
+                abort();
+            if (++i == flows_per_thread)
+                i = 0;
+        }
+        n += 1024;
+    }
+    w->lookups = n;
+
+    if (fls.reader != NULL)
+        FlowHashReaderDeregister(fls.reader);
+    for (i = 0; i < flows_per_thread; i++)
+        PacketFree(pkts[i]);
+    SCFree(pkts);
+    Flow *f;
+    while ((f = FlowQueuePrivateGetFromTop(&fls.spare_queue)) != NULL)
+        FlowFree(f);
+    return NULL;
+}
+
+static void *ManagerLoop(void *arg)
+{
+    (void)arg;
+    uint32_t idx = 0;
+    while (!SC_ATOMIC_GET(stop)) {
+        for (int i = 0; i < 1024; i++) {
+            FlowBucket *fb = &flow_hash[idx];
+            FBLOCK_LOCK(fb);
+            FBLOCK_UNLOCK(fb);
+            idx = (idx + 1) % flow_config.hash_size;
+        }
+        usleep(100);
+    }
+    return NULL;
+}
+
+static double Run(uint32_t threads, uint32_t seconds, uint32_t shards)
+{
+    char val[16];
+    snprintf(val, sizeof(val), "%u", shards);
+    ConfSet("flow.hash-shards", val);
+    FlowInitConfig(FLOW_QUIET);
+
+    Worker *workers = SCMallocAligned(sizeof(Worker) * threads, CLS);
+    if (workers == NULL)
+        abort();
+    memset(workers, 0, sizeof(Worker) * threads);
+    SC_ATOMIC_SET(stop, false);
+
+    pthread_t manager;
+    pthread_create(&manager, NULL, ManagerLoop, NULL);
+    for (uint32_t t = 0; t < threads; t++) {
+        workers[t].id = t;
+        pthread_create(&workers[t].t, NULL, WorkerLoop, &workers[t]);
+    }
+    sleep(seconds);
+    SC_ATOMIC_SET(stop, true);
+
+    uint64_t total = 0;
+    for (uint32_t t = 0; t < threads; t++) {
+        pthread_join(workers[t].t, NULL);
+        total += workers[t].lookups;
+    }
+    pthread_join(manager, NULL);
+    SCFreeAligned(workers);
+
+    FlowShutdown();
+    return (double)total / seconds / threads;
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t threads = argc > 1 ? (uint32_t)atoi(argv[1]) : (uint32_t)sysconf(_SC_NPROCESSORS_ONLN);
+    uint32_t seconds = argc > 2 ? (uint32_t)atoi(argv[2]) : 5;
+    flows_per_thread = argc > 3 ? (uint32_t)atoi(argv[3]) : 4096;
+    if (threads == 0 || seconds == 0 || flows_per_thread == 0) {
+        fprintf(stderr, "usage: %s [threads] [seconds] [flows-per-thread]\n", argv[0]);
+        return 1;
+    }
+
+    SCLogInitLogModule(NULL);
+    ConfInit();
+    StorageInit();
+    StorageFinalize();
+    ConfSet("flow.memcap", "4gb");
+    char val[16];
+    snprintf(val, sizeof(val), "%u", threads * flows_per_thread);
+    ConfSet("flow.hash-size", val);
+    ConfSet("flow.prealloc", "0");
+
+    printf("%u threads, %u flows per thread, %u seconds per run\n", threads, flows_per_thread,
+            seconds);
+    lockless = false;
+    const double locked = Run(threads, seconds, 1);
+    printf("bucket lock:     %8.2f Mpps per core\n", locked / 1e6);
+    lockless = true;
+    const double optimistic = Run(threads, seconds, 1);
+    printf("lockless lookup: %8.2f Mpps per core (%+.1f%%)\n", optimistic / 1e6,
+            (optimistic - locked) * 100.0 / locked);
+    if (threads > 1) {
+        const double sharded = Run(threads, seconds, threads);
+        printf("lockless shards: %8.2f Mpps per core (%+.1f%%)\n", sharded / 1e6,
+                (sharded - locked) * 100.0 / locked);
+    }
+    return 0;
+}
@@ -25,6 +25,8 @@
 #ifndef __DECODE_TCP_H__
 #define __DECODE_TCP_H__
 
+#include "util-checksum-simd.h"
+
 #define TCP_HEADER_LEN                       20
 #define TCP_OPTLENMAX                        40
 #define TCP_OPTMAX                           20 /* every opt is at least 2 bytes
@@ -193,54 +195,15 @@ void DecodeTCPRegisterTests(void);
 static inline uint16_t TCPChecksum(
         const uint16_t *shdr, const uint16_t *pkt, uint16_t tlen, uint16_t init)
 {
-    uint16_t pad = 0;
-    uint32_t csum = init;
+    uint64_t csum = init;
 
     csum += shdr[0] + shdr[1] + shdr[2] + shdr[3] + htons(6) + htons(tlen);
 
-    csum += pkt[0] + pkt[1] + pkt[2] + pkt[3] + pkt[4] + pkt[5] + pkt[6] +
-        pkt[7] + pkt[9];
-
-    tlen -= 20;
-    pkt += 10;
-
-    while (tlen >= 32) {
-        csum += pkt[0] + pkt[1] + pkt[2] + pkt[3] + pkt[4] + pkt[5] + pkt[6] +
-            pkt[7] +
-            pkt[8] +
-            pkt[9] + pkt[10] + pkt[11] + pkt[12] + pkt[13] +
-            pkt[14] + pkt[15];
-        tlen -= 32;
-        pkt += 16;
-    }
-
-    while(tlen >= 8) {
-        csum += pkt[0] + pkt[1] + pkt[2] + pkt[3];
-        tlen -= 8;
-        pkt += 4;
-    }
-
-    while(tlen >= 4) {
-        csum += pkt[0] + pkt[1];
-        tlen -= 4;
-        pkt += 2;
-    }
-
-    while (tlen > 1) {
-        csum += pkt[0];
-        pkt += 1;
-        tlen -= 2;
-    }
-
-    if (tlen == 1) {
-        *(uint8_t *)(&pad) = (*(uint8_t *)pkt);
-        csum += pad;
-    }
-
-    csum = (csum >> 16) + (csum & 0x0000FFFF);
-    csum += (csum >> 16);
-
-    return (uint16_t)~csum;
+    /* init replaces the checksum field: cancel it out of the sum */
+    csum += (uint16_t)~pkt[8];
+    csum += ChecksumSum((const uint8_t *)pkt, tlen);
+
+    return (uint16_t)~ChecksumFold(csum);
 }
 
 /**
@@ -258,54 +221,17 @@ static inline uint16_t TCPChecksum(
 static inline uint16_t TCPV6Checksum(
         const uint16_t *shdr, const uint16_t *pkt, uint16_t tlen, uint16_t init)
 {
-    uint16_t pad = 0;
-    uint32_t csum = init;
+    uint64_t csum = init;
 
     csum += shdr[0] + shdr[1] + shdr[2] + shdr[3] + shdr[4] + shdr[5] +
         shdr[6] +  shdr[7] + shdr[8] + shdr[9] + shdr[10] + shdr[11] +
         shdr[12] + shdr[13] + shdr[14] + shdr[15] + htons(6) + htons(tlen);
 
-    csum += pkt[0] + pkt[1] + pkt[2] + pkt[3] + pkt[4] + pkt[5] + pkt[6] +
-        pkt[7] + pkt[9];
-
-    tlen -= 20;
-    pkt += 10;
-
-    while (tlen >= 32) {
-        csum += pkt[0] + pkt[1] + pkt[2] + pkt[3] + pkt[4] + pkt[5] + pkt[6] +
-            pkt[7] + pkt[8] + pkt[9] + pkt[10] + pkt[11] + pkt[12] + pkt[13] +
-            pkt[14] + pkt[15];
-        tlen -= 32;
-        pkt += 16;
-    }
-
-    while(tlen >= 8) {
-        csum += pkt[0] + pkt[1] + pkt[2] + pkt[3];
-        tlen -= 8;
-        pkt += 4;
-    }
-
-    while(tlen >= 4) {
-        csum += pkt[0] + pkt[1];
-        tlen -= 4;
-        pkt += 2;
-    }
-
-    while (tlen > 1) {
-        csum += pkt[0];
-        pkt += 1;
-        tlen -= 2;
-    }
-
-    if (tlen == 1) {
-        *(uint8_t *)(&pad) = (*(uint8_t *)pkt);
-        csum += pad;
-    }
-
-    csum = (csum >> 16) + (csum & 0x0000FFFF);
-    csum += (csum >> 16);
-
-    return (uint16_t)~csum;
+    /* init replaces the checksum field: cancel it out of the sum */
+    csum += (uint16_t)~pkt[8];
+    csum += ChecksumSum((const uint8_t *)pkt, tlen);
+
+    return (uint16_t)~ChecksumFold(csum);
 }
 
 #endif /* __DECODE_TCP_H__ */
@@ -73,6 +73,7 @@ enum PktSrcEnum {
 #include "source-af-packet.h"
 #include "source-netmap.h"
 #include "source-windivert.h"
+#include "source-lipc.h"
 #ifdef HAVE_DPDK
 #include "source-dpdk.h"
 #endif
@@ -505,6 +506,9 @@ typedef struct Packet_
 #endif
 #ifdef HAVE_AF_XDP
         AFXDPPacketVars afxdp_v;
+#endif
+#ifdef HAVE_LIPC
+        LIPCPacketVars lipc_v;
 #endif
         /* A chunk of memory that a plugin can use for its packet vars. */
         uint8_t plugin_v[PLUGIN_VAR_SIZE];
@@ -384,6 +384,8 @@ void DetectContentFree(DetectEngineCtx *de_ctx, void *ptr)
         SCReturn;
 
     SpmDestroyCtx(cd->spm_ctx);
+    if (cd->prog != NULL)
+        SCFree(cd->prog);
 
     SCFree(cd);
     SCReturn;
@@ -111,6 +111,9 @@ typedef struct DetectContentData_ {
     SpmCtx *spm_ctx;
     /* pointer to replacement data */
     uint8_t *replace;
+    /* compiled chain of this and the following contents, see
+     * DetectEngineContentInspectionCompile */
+    struct DetectEngineContentProg_ *prog;
 } DetectContentData;
 
 /* prototypes */
@@ -25,6 +25,7 @@
 #include "detect-engine-address.h"
 #include "detect-engine-analyzer.h"
 #include "detect-engine-iponly.h"
+#include "detect-engine-loader.h"
 #include "detect-engine-mpm.h"
 #include "detect-engine-siggroup.h"
 #include "detect-engine-port.h"
@@ -42,6 +43,7 @@
 #include "util-validate.h"
 #include "util-var-name.h"
 #include "util-conf.h"
+#include "util-time.h"
 
 void SigCleanSignatures(DetectEngineCtx *de_ctx)
 {
@@ -812,6 +814,8 @@ static json_t *RulesGroupPrintSghStats(const DetectEngineCtx *de_ctx, const SigG
     json_object_set_new(types, "negated_mpm", json_integer(negmpm_cnt));
     json_object_set_new(types, "payload_but_no_mpm", json_integer(payload_no_mpm_cnt));
     json_object_set_new(types, "prefilter", json_integer(prefilter_cnt));
+    /* rules inspected for every packet of the group, incl syn only rules */
+    json_object_set_new(types, "non_prefilter", json_integer(sgh->non_pf_syn_store_cnt));
     json_object_set_new(types, "syn", json_integer(syn_cnt));
     json_object_set_new(types, "any5", json_integer(any5_cnt));
     json_object_set_new(stats, "types", types);
@@ -1034,7 +1038,6 @@ static int RulesGroupByProto(DetectEngineCtx *de_ctx)
             SCLogDebug("proto group %d sgh %p is the original", p, sgh_ts[p]);
 
             SigGroupHeadSetSigCnt(sgh_ts[p], max_idx);
-            SigGroupHeadBuildMatchArray(de_ctx, sgh_ts[p], max_idx);
 
             SigGroupHeadHashAdd(de_ctx, sgh_ts[p]);
             SigGroupHeadStore(de_ctx, sgh_ts[p]);
@@ -1066,7 +1069,6 @@ static int RulesGroupByProto(DetectEngineCtx *de_ctx)
             SCLogDebug("proto group %d sgh %p is the original", p, sgh_tc[p]);
 
             SigGroupHeadSetSigCnt(sgh_tc[p], max_idx);
-            SigGroupHeadBuildMatchArray(de_ctx, sgh_tc[p], max_idx);
 
             SigGroupHeadHashAdd(de_ctx, sgh_tc[p]);
             SigGroupHeadStore(de_ctx, sgh_tc[p]);
@@ -1267,7 +1269,6 @@ static DetectPort *RulesGroupByPorts(DetectEngineCtx *de_ctx, uint8_t ipproto, u
             SCLogDebug("port group %p sgh %p is the original", iter, iter->sh);
 
             SigGroupHeadSetSigCnt(iter->sh, max_idx);
-            SigGroupHeadBuildMatchArray(de_ctx, iter->sh, max_idx);
             SigGroupHeadSetProtoAndDirection(iter->sh, ipproto, direction);
             SigGroupHeadHashAdd(de_ctx, iter->sh);
             SigGroupHeadStore(de_ctx, iter->sh);
@@ -1830,12 +1831,60 @@ static void DbgPrintSigs2(DetectEngineCtx *de_ctx, SigGroupHead *sgh)
 }
 #endif
 
-/** \brief finalize preparing sgh's */
+/** \internal
+ *  \brief per sgh work that only reads the signatures, run on the loaders */
+static int SigGroupHeadPrepareTask(void *data, uint32_t idx)
+{
+    DetectEngineCtx *de_ctx = (DetectEngineCtx *)data;
+    SigGroupHead *sgh = de_ctx->sgh_array[idx];
+    if (sgh == NULL)
+        return 0;
+
+    if (SigGroupHeadBuildMatchArray(de_ctx, sgh, DetectEngineGetMaxSigId(de_ctx)) != 0)
+        return -1;
+
+    SigGroupHeadSetFilemagicFlag(de_ctx, sgh);
+    SigGroupHeadSetFileHashFlag(de_ctx, sgh);
+    SigGroupHeadSetFilesizeFlag(de_ctx, sgh);
+    SigGroupHeadSetFilestoreCount(de_ctx, sgh);
+    SCLogDebug("filestore count %u", sgh->filestore_cnt);
+    SigGroupHeadSetPrefilterBitmapRange(sgh);
+    return 0;
+}
+
+/** \internal
+ *  \brief non-prefilter arrays depend on the prefilter flags of the
+ *         signatures, so these are built after all prefilter setup */
+static int SigGroupHeadNonPrefilterTask(void *data, uint32_t idx)
+{
+    DetectEngineCtx *de_ctx = (DetectEngineCtx *)data;
+    SigGroupHead *sgh = de_ctx->sgh_array[idx];
+    if (sgh == NULL)
+        return 0;
+    return SigGroupHeadBuildNonPrefilterArray(de_ctx, sgh);
+}
+
+/** \brief finalize preparing sgh's
+ *
+ *  The work that only touches a single sgh is spread over the detect loader
+ *  threads. Prefilter setup registers engines and mpm stores in hashes
+ *  shared by all sgh's, so it runs serially and in sgh order to keep the
+ *  ids the same on every run.
+ */
 int SigAddressPrepareStage4(DetectEngineCtx *de_ctx)
 {
     SCEnter();
 
-    //SCLogInfo("sgh's %"PRIu32, de_ctx->sgh_array_cnt);
+    SigGroupBuildStat *stat = &de_ctx->sgh_build_stat;
+    struct timeval t0, t1;
+
+    gettimeofday(&t0, NULL);
+    if (DetectLoadersParallelFor(de_ctx->sgh_array_cnt, SigGroupHeadPrepareTask, de_ctx) != 0) {
+        SCLogError("failed to prepare rule groups");
+        SCReturnInt(-1);
+    }
+    gettimeofday(&t1, NULL);
+    stat->match_arrays = TimeDifferenceMicros(t0, t1);
 
     uint32_t cnt = 0;
     for (uint32_t idx = 0; idx < de_ctx->sgh_array_cnt; idx++) {
@@ -1845,20 +1894,46 @@ int SigAddressPrepareStage4(DetectEngineCtx *de_ctx)
 
         SCLogDebug("sgh %p", sgh);
 
-        SigGroupHeadSetFilemagicFlag(de_ctx, sgh);
-        SigGroupHeadSetFileHashFlag(de_ctx, sgh);
-        SigGroupHeadSetFilesizeFlag(de_ctx, sgh);
-        SigGroupHeadSetFilestoreCount(de_ctx, sgh);
-        SCLogDebug("filestore count %u", sgh->filestore_cnt);
-
         PrefilterSetupRuleGroup(de_ctx, sgh);
 
-        SigGroupHeadBuildNonPrefilterArray(de_ctx, sgh);
-
         sgh->id = idx;
         cnt++;
     }
     SCLogPerf("Unique rule groups: %u", cnt);
+    gettimeofday(&t0, NULL);
+    stat->prefilter = TimeDifferenceMicros(t1, t0);
+
+    if (MpmStorePrepareAll(de_ctx) != 0) {
+        SCLogError("failed to compile rule group pattern matchers");
+        SCReturnInt(-1);
+    }
+    gettimeofday(&t1, NULL);
+    stat->mpm_compile = TimeDifferenceMicros(t0, t1);
+
+    if (DetectLoadersParallelFor(
+                de_ctx->sgh_array_cnt, SigGroupHeadNonPrefilterTask, de_ctx) != 0) {
+        SCReturnInt(-1);
+    }
+    /* track highest cnt for any sgh in our de_ctx */
+    stat->non_pf_groups = 0;
+    stat->non_pf_rules = 0;
+    for (uint32_t idx = 0; idx < de_ctx->sgh_array_cnt; idx++) {
+        const SigGroupHead *sgh = de_ctx->sgh_array[idx];
+        if (sgh == NULL)
+            continue;
+        const uint32_t max = MAX(sgh->non_pf_other_store_cnt, sgh->non_pf_syn_store_cnt);
+        if (max > de_ctx->non_pf_store_cnt_max)
+            de_ctx->non_pf_store_cnt_max = max;
+        if (max > 0) {
+            stat->non_pf_rules += max;
+            stat->non_pf_groups++;
+        }
+    }
+    SCLogPerf("%u rule groups have rules without prefilter: %u rules in total, "
+              "at most %u in a group",
+            stat->non_pf_groups, stat->non_pf_rules, de_ctx->non_pf_store_cnt_max);
+    gettimeofday(&t0, NULL);
+    stat->non_pf_arrays = TimeDifferenceMicros(t1, t0);
 
     MpmStoreReportStats(de_ctx);
 
@@ -1974,6 +2049,12 @@ static int SigMatchPrepare(DetectEngineCtx *de_ctx)
 int SigGroupBuild(DetectEngineCtx *de_ctx)
 {
     Signature *s = de_ctx->sig_list;
+    SigGroupBuildStat *stat = &de_ctx->sgh_build_stat;
+    struct timeval start, t0, t1;
+
+    memset(stat, 0, sizeof(*stat));
+    stat->threads = DetectLoadersParallelThreads();
+    gettimeofday(&start, NULL);
 
     /* Assign the unique order id of signatures after sorting,
      * so the IP Only engine process them in order too.  Also
@@ -2003,10 +2084,14 @@ int SigGroupBuild(DetectEngineCtx *de_ctx)
     if (SigAddressPrepareStage3(de_ctx) != 0) {
         FatalError("initializing the detection engine failed");
     }
+    gettimeofday(&t0, NULL);
+    stat->grouping = TimeDifferenceMicros(start, t0);
+
     if (SigAddressPrepareStage4(de_ctx) != 0) {
         FatalError("initializing the detection engine failed");
     }
 
+    gettimeofday(&t0, NULL);
     int r = DetectMpmPrepareBuiltinMpms(de_ctx);
     r |= DetectMpmPrepareAppMpms(de_ctx);
     r |= DetectMpmPreparePktMpms(de_ctx);
@@ -2018,6 +2103,11 @@ int SigGroupBuild(DetectEngineCtx *de_ctx)
     if (SigMatchPrepare(de_ctx) != 0) {
         FatalError("initializing the detection engine failed");
     }
+    gettimeofday(&t1, NULL);
+    stat->finalize = TimeDifferenceMicros(t0, t1);
+    stat->total = TimeDifferenceMicros(start, t1);
+    SCLogPerf("rule groups built in %" PRIu64 "ms using %d threads", stat->total / 1000,
+            stat->threads);
 
 #ifdef PROFILING
     SCProfilingKeywordInitCounters(de_ctx);
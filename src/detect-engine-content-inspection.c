@@ -65,6 +65,338 @@
 #include "util-lua.h"
 #endif
 
+/** max number of contents in a compiled chain */
+#define CONTENT_PROG_MAX_OPS 32
+
+/** patterns up to this size are searched with memchr and memcmp */
+#define CONTENT_PROG_SHORT_LEN 4
+
+/** \brief one content of a compiled chain
+ *
+ *  The values of DetectContentData that the inspection needs, stored next
+ *  to each other so the chain is walked without touching the sigmatches.
+ */
+typedef struct DetectEngineContentOp_ {
+    const uint8_t *content;
+    SpmCtx *spm_ctx;
+    uint32_t flags;
+    PatIntId id;
+    uint16_t content_len;
+    uint16_t depth;
+    uint16_t offset;
+    bool short_search; /**< use memchr/memcmp instead of the spm */
+    int32_t distance;
+    int32_t within;
+} DetectEngineContentOp;
+
+/** \brief chain of contents that runs until the end of a SigMatchData array
+ *
+ *  Owned by the DetectContentData of the first content of the chain.
+ */
+typedef struct DetectEngineContentProg_ {
+    uint32_t cnt;
+    DetectEngineContentOp ops[];
+} DetectEngineContentProg;
+
+/** \internal
+ *  \brief contents that can be part of a compiled chain
+ *
+ *  Values from byte_extract/byte_math and replace need the interpreter.
+ */
+static bool ContentProgSupported(const SigMatchData *smd)
+{
+    if (smd->type != DETECT_CONTENT || smd->ctx == NULL)
+        return false;
+    const DetectContentData *cd = (const DetectContentData *)smd->ctx;
+    return (cd->flags & (DETECT_CONTENT_OFFSET_VAR | DETECT_CONTENT_DEPTH_VAR |
+                                DETECT_CONTENT_DISTANCE_VAR | DETECT_CONTENT_WITHIN_VAR |
+                                DETECT_CONTENT_REPLACE)) == 0;
+}
+
+/**
+ * \brief compile the content chains of a SigMatchData array
+ *
+ * For each content that is only followed by supported contents, the rest of
+ * the array is stored as a flat program in the DetectContentData. The inspection then
+ * runs it in a loop with explicit backtracking instead of a recursive call
+ * per content. Results, buffer offset and recursion counting are the same as
+ * with DetectEngineContentInspection.
+ *
+ * \param smd array as returned by SigMatchList2DataArray
+ */
+void DetectEngineContentInspectionCompile(SigMatchData *smd)
+{
+    if (smd == NULL)
+        return;
+
+    uint32_t len = 1;
+    while (!smd[len - 1].is_last)
+        len++;
+
+    /* a program runs to the end of the array, so only the contents after
+     * the last keyword it can't run get one */
+    bool blocked = false;
+    uint32_t tail = 0;
+    for (uint32_t i = len; i-- > 0;) {
+        DetectContentData *cd = NULL;
+        if (smd[i].type == DETECT_CONTENT && smd[i].ctx != NULL) {
+            cd = (DetectContentData *)smd[i].ctx;
+            /* the same list can be converted more than once */
+            if (cd->prog != NULL) {
+                SCFree(cd->prog);
+                cd->prog = NULL;
+            }
+        }
+        if (blocked || !ContentProgSupported(&smd[i])) {
+            blocked = true;
+            continue;
+        }
+        tail++;
+        if (tail > CONTENT_PROG_MAX_OPS)
+            continue;
+
+        DetectEngineContentProg *prog =
+                SCCalloc(1, sizeof(*prog) + tail * sizeof(DetectEngineContentOp));
+        if (prog == NULL)
+            continue;
+        prog->cnt = tail;
+        for (uint32_t x = 0; x < tail; x++) {
+            const DetectContentData *c = (const DetectContentData *)smd[i + x].ctx;
+            DetectEngineContentOp *op = &prog->ops[x];
+            op->content = c->content;
+            op->spm_ctx = c->spm_ctx;
+            op->flags = c->flags;
+            op->id = c->id;
+            op->content_len = c->content_len;
+            op->depth = c->depth;
+            op->offset = c->offset;
+            op->distance = c->distance;
+            op->within = c->within;
+            op->short_search = !(c->flags & DETECT_CONTENT_NOCASE) &&
+                               c->content_len <= CONTENT_PROG_SHORT_LEN;
+        }
+        cd->prog = prog;
+    }
+}
+
+static inline const uint8_t *ContentProgSearchShort(
+        const uint8_t *buf, const uint32_t buf_len, const DetectEngineContentOp *op)
+{
+    const uint8_t *end = buf + buf_len - op->content_len + 1;
+    while (buf < end) {
+        const uint8_t *c = memchr(buf, op->content[0], end - buf);
+        if (c == NULL)
+            return NULL;
+        if (memcmp(c + 1, op->content + 1, op->content_len - 1) == 0)
+            return c;
+        buf = c + 1;
+    }
+    return NULL;
+}
+
+/** \internal
+ *  \brief look up a fast pattern match using the offset the mpm found
+ *
+ *  The mpm stored where the first match of the pattern in this buffer ends.
+ *  If that match is inside the window it's also the first match in there.
+ *  If it ends after the window, nothing can match in there.
+ *
+ *  \param offset start of the search window in the buffer
+ *  \param depth end of the search window in the buffer
+ *  \param found set to the match or NULL if it can't be in the window
+ *
+ *  \retval true *found is set
+ *  \retval false no usable offset, the window needs to be searched
+ */
+static inline bool ContentFindFromMpm(const DetectEngineThreadCtx *det_ctx, const uint32_t flags,
+        const PatIntId id, const uint16_t content_len, const uint8_t *buffer,
+        const uint32_t buffer_len, const uint32_t offset, const uint32_t depth,
+        const uint8_t **found)
+{
+    /* a chopped pattern is only part of the content */
+    if ((flags & (DETECT_CONTENT_MPM | DETECT_CONTENT_FAST_PATTERN_CHOP |
+                         DETECT_CONTENT_NEGATED)) != DETECT_CONTENT_MPM)
+        return false;
+
+    uint32_t end;
+    if (!PrefilterPatternFirstEnd(&det_ctx->pmq, id, buffer, buffer_len, &end))
+        return false;
+
+    if (end > depth) {
+        *found = NULL;
+        return true;
+    }
+    if (end - content_len >= offset) {
+        *found = buffer + (end - content_len);
+        return true;
+    }
+    return false;
+}
+
+/** \internal
+ *  \brief run a compiled content chain
+ *
+ *  Follows the content branch of DetectEngineContentInspection. Where that
+ *  recurses into the next sigmatch, we move to the next op. Where the
+ *  recursion returns no match, we go back to the previous op, which then
+ *  looks for its next occurrence if the next content is relative to it
+ *  through within.
+ *
+ *  The caller has counted the first op in inspection_recursion_counter.
+ */
+static uint8_t ContentProgRun(DetectEngineCtx *de_ctx, DetectEngineThreadCtx *det_ctx,
+        const DetectEngineContentProg *prog, const uint8_t *buffer, const uint32_t buffer_len,
+        const uint32_t stream_start_offset)
+{
+    /* buffer offset when the op was entered */
+    uint32_t entry_offset[CONTENT_PROG_MAX_OPS];
+    /* offset to look for the next occurrence, 0 for the first search */
+    uint32_t retry_offset[CONTENT_PROG_MAX_OPS];
+    /* end of the current match of an op */
+    uint32_t match_end[CONTENT_PROG_MAX_OPS];
+
+    uint32_t i = 0;
+    entry_offset[0] = det_ctx->buffer_offset;
+    retry_offset[0] = 0;
+
+    for (;;) {
+        const DetectEngineContentOp *op = &prog->ops[i];
+        const uint32_t prev_buffer_offset = entry_offset[i];
+        uint32_t offset;
+        uint32_t depth = buffer_len;
+
+        if (op->flags & (DETECT_CONTENT_DISTANCE | DETECT_CONTENT_WITHIN)) {
+            offset = prev_buffer_offset;
+
+            const int distance = op->distance;
+            if (op->flags & DETECT_CONTENT_DISTANCE) {
+                if (distance < 0 && (uint32_t)(abs(distance)) > offset)
+                    offset = 0;
+                else
+                    offset += distance;
+            }
+
+            if (op->flags & DETECT_CONTENT_WITHIN) {
+                if ((int32_t)depth > (int32_t)(prev_buffer_offset + op->within + distance)) {
+                    depth = prev_buffer_offset + op->within + distance;
+                }
+
+                if (stream_start_offset != 0 && prev_buffer_offset == 0) {
+                    if (depth <= stream_start_offset) {
+                        goto no_match;
+                    } else if (depth < (stream_start_offset + buffer_len)) {
+                        depth = depth - stream_start_offset;
+                    }
+                }
+            }
+
+            if (op->depth != 0 && (op->depth + prev_buffer_offset) < depth) {
+                depth = prev_buffer_offset + op->depth;
+            }
+            if (op->offset > offset) {
+                offset = op->offset;
+            }
+        } else {
+            if (op->depth != 0) {
+                depth = op->depth;
+            }
+            if (stream_start_offset != 0 && op->flags & DETECT_CONTENT_DEPTH) {
+                if (depth <= stream_start_offset) {
+                    goto no_match;
+                } else if (depth < (stream_start_offset + buffer_len)) {
+                    depth = depth - stream_start_offset;
+                }
+            }
+            offset = op->offset;
+        }
+
+        if (retry_offset[i] != 0)
+            offset = retry_offset[i];
+        if (depth > buffer_len)
+            depth = buffer_len;
+
+        if (offset > depth || depth == 0) {
+            if (op->flags & DETECT_CONTENT_NEGATED)
+                goto match;
+            goto no_match;
+        }
+
+        const uint8_t *sbuffer = buffer + offset;
+        const uint32_t sbuffer_len = depth - offset;
+        const uint8_t *found;
+        if (op->flags & DETECT_CONTENT_ENDS_WITH && depth < buffer_len) {
+            found = NULL;
+        } else if (op->content_len > sbuffer_len) {
+            found = NULL;
+        } else if (ContentFindFromMpm(det_ctx, op->flags, op->id, op->content_len, buffer,
+                           buffer_len, offset, depth, &found)) {
+            /* found is set from the mpm offset */
+        } else if (op->short_search) {
+            found = ContentProgSearchShort(sbuffer, sbuffer_len, op);
+        } else {
+            found = SpmScan(op->spm_ctx, det_ctx->spm_thread_ctx, sbuffer, sbuffer_len);
+        }
+
+        if (found == NULL) {
+            if (op->flags & DETECT_CONTENT_NEGATED)
+                goto match;
+            if ((op->flags & (DETECT_CONTENT_DISTANCE | DETECT_CONTENT_WITHIN)) == 0) {
+                /* independent match from previous matches, so failure is fatal */
+                det_ctx->discontinue_matching = 1;
+            }
+            goto no_match;
+        }
+
+        const uint32_t match_offset = (uint32_t)((found - buffer) + op->content_len);
+        if (op->flags & DETECT_CONTENT_NEGATED) {
+            if (op->flags & DETECT_CONTENT_ENDS_WITH && sbuffer_len != match_offset)
+                goto match;
+            if (DETECT_CONTENT_IS_SINGLE(op))
+                det_ctx->discontinue_matching = 1;
+            goto no_match;
+        }
+
+        det_ctx->buffer_offset = match_offset;
+        if ((op->flags & DETECT_CONTENT_ENDS_WITH) && match_offset != buffer_len) {
+            /* look for another match after the start of this one */
+            retry_offset[i] = match_offset - (op->content_len - 1);
+            continue;
+        }
+        match_end[i] = match_offset;
+
+    match:
+        if (i + 1 == prog->cnt)
+            return 1;
+        i++;
+        det_ctx->inspection_recursion_counter++;
+        if (det_ctx->inspection_recursion_counter == de_ctx->inspection_recursion_limit) {
+            det_ctx->discontinue_matching = 1;
+            return 0;
+        }
+        entry_offset[i] = det_ctx->buffer_offset;
+        retry_offset[i] = 0;
+        continue;
+
+    no_match:
+        /* back to the last content that can look for another match */
+        for (;;) {
+            if (i == 0 || det_ctx->discontinue_matching)
+                return 0;
+            i--;
+            op = &prog->ops[i];
+            if (op->flags & DETECT_CONTENT_NEGATED)
+                continue;
+            /* no match and no reason to look for another instance */
+            if ((op->flags & DETECT_CONTENT_WITHIN_NEXT) == 0) {
+                det_ctx->discontinue_matching = 1;
+                return 0;
+            }
+            retry_offset[i] = match_end[i] - (op->content_len - 1);
+            break;
+        }
+    }
+}
+
 /**
  * \brief Run the actual payload match functions
  *
@@ -130,6 +462,13 @@ uint8_t DetectEngineContentInspection(DetectEngineCtx *de_ctx, DetectEngineThrea
         DetectContentData *cd = (DetectContentData *)smd->ctx;
         SCLogDebug("inspecting content %"PRIu32" buffer_len %"PRIu32, cd->id, buffer_len);
 
+        if (cd->prog != NULL) {
+            const uint8_t r = ContentProgRun(
+                    de_ctx, det_ctx, cd->prog, buffer, buffer_len, stream_start_offset);
+            KEYWORD_PROFILING_END(det_ctx, smd->type, r);
+            SCReturnInt(r);
+        }
+
         /* we might have already have this content matched by the mpm.
          * (if there is any other reason why we'd want to avoid checking
          *  it here, please fill it in) */
@@ -289,6 +628,9 @@ uint8_t DetectEngineContentInspection(DetectEngineCtx *de_ctx, DetectEngineThrea
                 found = NULL;
             } else if (cd->content_len > sbuffer_len) {
                 found = NULL;
+            } else if (ContentFindFromMpm(det_ctx, cd->flags, cd->id, cd->content_len, buffer,
+                               buffer_len, offset, depth, &found)) {
+                SCLogDebug("content %" PRIu32 " found through the mpm offset", cd->id);
             } else {
                 /* do the actual search */
                 found = SpmScan(cd->spm_ctx, det_ctx->spm_thread_ctx, sbuffer,
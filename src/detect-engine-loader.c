@@ -438,6 +438,138 @@ int DetectLoaderQueueTask(int loader_id, LoaderFunc Func, void *func_ctx)
     return loader_id;
 }
 
+/** \brief shared state of a DetectLoadersParallelFor call
+ *
+ *  Reference counted as a loader may only get to its task after all items
+ *  have been claimed by the other threads and the caller has returned. */
+typedef struct DetectLoaderParallelCtx_ {
+    DetectLoaderParallelFunc Func;
+    void *data;
+    uint32_t cnt;
+    SC_ATOMIC_DECLARE(uint32_t, next);
+    SC_ATOMIC_DECLARE(uint32_t, refcnt);
+    SC_ATOMIC_DECLARE(uint32_t, errors);
+
+    SCMutex m;
+    SCCondT cond;
+    uint32_t done; /**< items completed, protected by m */
+} DetectLoaderParallelCtx;
+
+typedef struct DetectLoaderParallelTask_ {
+    DetectLoaderParallelCtx *ctx;
+} DetectLoaderParallelTask;
+
+/** set in the loader threads: work queued from a loader to the other
+ *  loaders could wait on itself, so these run serially there. */
+static thread_local bool detect_loader_thread = false;
+
+static void DetectLoaderParallelRelease(DetectLoaderParallelCtx *ctx)
+{
+    if (SC_ATOMIC_SUB(ctx->refcnt, 1) == 1) {
+        SCCondDestroy(&ctx->cond);
+        SCMutexDestroy(&ctx->m);
+        SCFree(ctx);
+    }
+}
+
+/** \internal
+ *  \brief claim and run items until none are left */
+static void DetectLoaderParallelRun(DetectLoaderParallelCtx *ctx)
+{
+    uint32_t idx;
+    while ((idx = SC_ATOMIC_ADD(ctx->next, 1)) < ctx->cnt) {
+        if (ctx->Func(ctx->data, idx) != 0) {
+            (void)SC_ATOMIC_ADD(ctx->errors, 1);
+        }
+        SCMutexLock(&ctx->m);
+        if (++ctx->done == ctx->cnt) {
+            SCCondSignal(&ctx->cond);
+        }
+        SCMutexUnlock(&ctx->m);
+    }
+}
+
+static int DetectLoaderParallelTaskFunc(void *task_ctx, int loader_id)
+{
+    DetectLoaderParallelTask *t = (DetectLoaderParallelTask *)task_ctx;
+    DetectLoaderParallelRun(t->ctx);
+    DetectLoaderParallelRelease(t->ctx);
+    /* errors are reported to the caller, not the loader */
+    return 0;
+}
+
+/** \brief number of threads DetectLoadersParallelFor spreads its work over
+ *
+ *  The loaders plus the calling thread, or 1 if the loaders are not running
+ *  or if called from a loader thread. */
+int DetectLoadersParallelThreads(void)
+{
+    if (loaders == NULL || detect_loader_thread)
+        return 1;
+    return num_loaders + 1;
+}
+
+/** \brief call Func for each idx in [0, cnt) on the loader threads
+ *
+ *  The calling thread takes part and the call returns after all items are
+ *  done. Items are claimed in order but complete in any order, so Func
+ *  should only write state that belongs to its idx.
+ *
+ *  \retval result 0 for ok, -1 if Func failed for any item */
+int DetectLoadersParallelFor(uint32_t cnt, DetectLoaderParallelFunc Func, void *data)
+{
+    if (cnt == 0)
+        return 0;
+
+    DetectLoaderParallelCtx *ctx = NULL;
+    if (cnt > 1 && DetectLoadersParallelThreads() > 1) {
+        ctx = SCCalloc(1, sizeof(*ctx));
+    }
+    if (ctx == NULL) {
+        int errors = 0;
+        for (uint32_t idx = 0; idx < cnt; idx++) {
+            if (Func(data, idx) != 0)
+                errors++;
+        }
+        return errors ? -1 : 0;
+    }
+
+    ctx->Func = Func;
+    ctx->data = data;
+    ctx->cnt = cnt;
+    SC_ATOMIC_INIT(ctx->next);
+    SC_ATOMIC_INIT(ctx->refcnt);
+    SC_ATOMIC_INIT(ctx->errors);
+    SCMutexInit(&ctx->m, NULL);
+    SCCondInit(&ctx->cond, NULL);
+    SC_ATOMIC_SET(ctx->refcnt, 1);
+
+    for (int i = 0; i < num_loaders && (uint32_t)i < cnt - 1; i++) {
+        DetectLoaderParallelTask *t = SCCalloc(1, sizeof(*t));
+        if (t == NULL)
+            break;
+        t->ctx = ctx;
+        (void)SC_ATOMIC_ADD(ctx->refcnt, 1);
+        if (DetectLoaderQueueTask(i, DetectLoaderParallelTaskFunc, t) < 0) {
+            (void)SC_ATOMIC_SUB(ctx->refcnt, 1);
+            SCFree(t);
+            break;
+        }
+    }
+
+    DetectLoaderParallelRun(ctx);
+
+    SCMutexLock(&ctx->m);
+    while (ctx->done < ctx->cnt) {
+        SCCondWait(&ctx->cond, &ctx->m);
+    }
+    SCMutexUnlock(&ctx->m);
+
+    const uint32_t errors = SC_ATOMIC_GET(ctx->errors);
+    DetectLoaderParallelRelease(ctx);
+    return errors ? -1 : 0;
+}
+
 /** \brief wait for loader tasks to complete
  *  \retval result 0 for ok, -1 for errors */
 int DetectLoadersSync(void)
@@ -582,6 +714,7 @@ static TmEcode DetectLoader(ThreadVars *th_v, void *thread_data)
     DetectLoaderThreadData *ftd = (DetectLoaderThreadData *)thread_data;
     BUG_ON(ftd == NULL);
 
+    detect_loader_thread = true;
     TmThreadsSetFlag(th_v, THV_INIT_DONE | THV_RUNNING);
     SCLogDebug("loader thread started");
     while (1)
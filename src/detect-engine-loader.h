@@ -33,6 +33,13 @@
  */
 typedef int (*LoaderFunc)(void *ctx, int loader_id);
 
+/**
+ * \param data caller data
+ * \param idx item to process
+ * \retval 0 for ok, error otherwise
+ */
+typedef int (*DetectLoaderParallelFunc)(void *data, uint32_t idx);
+
 typedef struct DetectLoaderTask_ {
     LoaderFunc Func;
     void *ctx;
@@ -48,6 +55,8 @@ typedef struct DetectLoaderControl_ {
 
 int DetectLoaderQueueTask(int loader_id, LoaderFunc Func, void *func_ctx);
 int DetectLoadersSync(void);
+int DetectLoadersParallelFor(uint32_t cnt, DetectLoaderParallelFunc Func, void *data);
+int DetectLoadersParallelThreads(void);
 void DetectLoadersInit(void);
 
 void TmThreadContinueDetectLoaderThreads(void);
@@ -37,6 +37,7 @@
 #include "detect-engine-iponly.h"
 #include "detect-parse.h"
 #include "detect-engine-prefilter.h"
+#include "detect-engine-loader.h"
 #include "util-mpm.h"
 #include "util-memcmp.h"
 #include "util-memcpy.h"
@@ -1609,18 +1610,81 @@ static void MpmStoreSetup(const DetectEngineCtx *de_ctx, MpmStore *ms)
         }
     }
 
+    /* the unique contexts are compiled by MpmStorePrepareAll */
     if (ms->mpm_ctx->pattern_cnt == 0) {
         MpmFactoryReClaimMpmCtx(de_ctx, ms->mpm_ctx);
         ms->mpm_ctx = NULL;
-    } else {
-        if (ms->sgh_mpm_context == MPM_CTX_FACTORY_UNIQUE_CONTEXT) {
-            if (mpm_table[ms->mpm_ctx->mpm_type].Prepare != NULL) {
-                mpm_table[ms->mpm_ctx->mpm_type].Prepare(ms->mpm_ctx);
-            }
-        }
     }
 }
 
+static int MpmStorePrepareTask(void *data, uint32_t idx)
+{
+    MpmStore **stores = (MpmStore **)data;
+    MpmCtx *mpm_ctx = stores[idx]->mpm_ctx;
+
+    if (mpm_table[mpm_ctx->mpm_type].Prepare != NULL) {
+        if (mpm_table[mpm_ctx->mpm_type].Prepare(mpm_ctx) < 0)
+            return -1;
+    }
+    return 0;
+}
+
+/* largest first, so the long compiles don't end up last */
+static int MpmStorePrepareSortHelper(const void *a, const void *b)
+{
+    const MpmStore *ms0 = *(const MpmStore **)a;
+    const MpmStore *ms1 = *(const MpmStore **)b;
+
+    if (ms0->mpm_ctx->pattern_cnt > ms1->mpm_ctx->pattern_cnt)
+        return -1;
+    if (ms0->mpm_ctx->pattern_cnt < ms1->mpm_ctx->pattern_cnt)
+        return 1;
+    return 0;
+}
+
+/** \brief compile the mpm contexts of all rule group stores
+ *
+ *  MpmStoreSetup only adds the patterns. Compiling is the most expensive
+ *  part of the rule group build, so it is done here for all stores at
+ *  once, spread over the detect loader threads.
+ *
+ *  \retval 0 ok
+ *  \retval -1 error
+ */
+int MpmStorePrepareAll(DetectEngineCtx *de_ctx)
+{
+    if (de_ctx->mpm_hash_table == NULL)
+        return 0;
+
+    uint32_t cnt = 0;
+    HashListTableBucket *htb = NULL;
+    for (htb = HashListTableGetListHead(de_ctx->mpm_hash_table); htb != NULL;
+            htb = HashListTableGetListNext(htb)) {
+        const MpmStore *ms = (MpmStore *)HashListTableGetListData(htb);
+        if (ms->mpm_ctx != NULL && ms->sgh_mpm_context == MPM_CTX_FACTORY_UNIQUE_CONTEXT)
+            cnt++;
+    }
+    if (cnt == 0)
+        return 0;
+
+    MpmStore **stores = SCCalloc(cnt, sizeof(MpmStore *));
+    if (stores == NULL)
+        return -1;
+
+    uint32_t i = 0;
+    for (htb = HashListTableGetListHead(de_ctx->mpm_hash_table); htb != NULL;
+            htb = HashListTableGetListNext(htb)) {
+        MpmStore *ms = (MpmStore *)HashListTableGetListData(htb);
+        if (ms->mpm_ctx != NULL && ms->sgh_mpm_context == MPM_CTX_FACTORY_UNIQUE_CONTEXT)
+            stores[i++] = ms;
+    }
+    qsort(stores, cnt, sizeof(MpmStore *), MpmStorePrepareSortHelper);
+
+    int r = DetectLoadersParallelFor(cnt, MpmStorePrepareTask, stores);
+    SCFree(stores);
+    return r;
+}
+
 
 /** \brief Get MpmStore for a built-in buffer type
  *
@@ -2462,6 +2526,7 @@ int DetectSetFastPatternAndItsId(DetectEngineCtx *de_ctx)
     }
 
     HashListTableFree(ht);
+    de_ctx->max_fp_id = max_id;
 
     return 0;
 }
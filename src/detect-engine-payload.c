@@ -123,9 +123,11 @@ static void PrefilterPktPayload(DetectEngineThreadCtx *det_ctx,
     if (p->payload_len < mpm_ctx->minlen)
         SCReturn;
 
+    PrefilterTrackStart(&det_ctx->pmq, p->payload, p->payload_len);
     (void)mpm_table[mpm_ctx->mpm_type].Search(mpm_ctx,
             &det_ctx->mtc, &det_ctx->pmq,
             p->payload, p->payload_len);
+    PrefilterTrackEnd(&det_ctx->pmq);
 
     PREFILTER_PROFILING_ADD_BYTES(det_ctx, p->payload_len);
 }
@@ -190,8 +190,11 @@ void Prefilter(DetectEngineThreadCtx *det_ctx, const SigGroupHead *sgh,
     }
 
     /* Sort the rule list to lets look at pmq.
-     * NOTE due to merging of 'stream' pmqs we *MAY* have duplicate entries */
-    if (likely(det_ctx->pmq.rule_id_array_cnt > 1)) {
+     * NOTE due to merging of 'stream' pmqs we *MAY* have duplicate entries.
+     * Many matches are merged through the bitmap instead, which doesn't
+     * need the list sorted. */
+    if (likely(det_ctx->pmq.rule_id_array_cnt > 1) &&
+            !PrefilterUseBitmap(sgh, det_ctx->pmq.rule_id_array_cnt)) {
         PACKET_PROFILING_DETECT_START(p, PROF_DETECT_PF_SORT1);
         QuickSortSigIntId(det_ctx->pmq.rule_id_array, det_ctx->pmq.rule_id_array_cnt);
         PACKET_PROFILING_DETECT_END(p, PROF_DETECT_PF_SORT1);
@@ -731,8 +734,10 @@ static void PrefilterMpm(DetectEngineThreadCtx *det_ctx, const void *pectx, Pack
     //PrintRawDataFp(stdout, data, data_len);
 
     if (data != NULL && data_len >= mpm_ctx->minlen) {
+        PrefilterTrackStart(&det_ctx->pmq, data, data_len);
         (void)mpm_table[mpm_ctx->mpm_type].Search(mpm_ctx,
                 &det_ctx->mtcu, &det_ctx->pmq, data, data_len);
+        PrefilterTrackEnd(&det_ctx->pmq);
         PREFILTER_PROFILING_ADD_BYTES(det_ctx, data_len);
     }
 }
@@ -801,8 +806,10 @@ static void PrefilterMpmPkt(DetectEngineThreadCtx *det_ctx,
     //PrintRawDataFp(stdout, data, data_len);
 
     if (data != NULL && data_len >= mpm_ctx->minlen) {
+        PrefilterTrackStart(&det_ctx->pmq, data, data_len);
         (void)mpm_table[mpm_ctx->mpm_type].Search(mpm_ctx,
                 &det_ctx->mtcu, &det_ctx->pmq, data, data_len);
+        PrefilterTrackEnd(&det_ctx->pmq);
         PREFILTER_PROFILING_ADD_BYTES(det_ctx, data_len);
     }
 }
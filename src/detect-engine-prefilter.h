@@ -47,6 +47,28 @@ typedef struct PrefilterStore_ {
     uint32_t id;
 } PrefilterStore;
 
+/** below this many prefilter matches sorting is always cheaper */
+#define PREFILTER_BITMAP_MIN_CNT 8
+
+/**
+ *  \brief Check if the prefilter matches of a packet should be merged
+ *         through the bitmap instead of sorting them.
+ *
+ *  Sorting costs about cnt * log2(cnt), the bitmap merge a scan over the
+ *  words of the bitmap that cover the sgh. Few matches in a large rule
+ *  group keep using the sort.
+ *
+ *  \param sgh rule group of the packet
+ *  \param cnt number of entries in the rule store
+ */
+static inline bool PrefilterUseBitmap(const SigGroupHead *sgh, const uint32_t cnt)
+{
+    if (cnt < PREFILTER_BITMAP_MIN_CNT)
+        return false;
+    const uint32_t log2 = 32 - __builtin_clz(cnt);
+    return (uint64_t)cnt * log2 >= sgh->pf_bitmap_words;
+}
+
 void Prefilter(DetectEngineThreadCtx *, const SigGroupHead *, Packet *p,
         const uint8_t flags);
 
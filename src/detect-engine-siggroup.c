@@ -644,8 +644,39 @@ void SigGroupHeadSetFilestoreCount(DetectEngineCtx *de_ctx, SigGroupHead *sgh)
     return;
 }
 
+/**
+ *  \brief Set the range of the prefilter bitmap covering the sigs of the sgh.
+ *
+ *  \param sgh sig group head with its match array set up
+ */
+void SigGroupHeadSetPrefilterBitmapRange(SigGroupHead *sgh)
+{
+    uint32_t min = UINT32_MAX;
+    uint32_t max = 0;
+
+    for (uint32_t sig = 0; sig < sgh->init->sig_cnt; sig++) {
+        const Signature *s = sgh->init->match_array[sig];
+        if (s == NULL)
+            continue;
+
+        if (s->num < min)
+            min = s->num;
+        if (s->num > max)
+            max = s->num;
+    }
+
+    if (min > max) {
+        sgh->pf_bitmap_offset = 0;
+        sgh->pf_bitmap_words = 0;
+        return;
+    }
+    sgh->pf_bitmap_offset = min / 64;
+    sgh->pf_bitmap_words = max / 64 - min / 64 + 1;
+}
+
 /** \brief build an array of rule id's for sigs with no prefilter
- *  Also updated de_ctx::non_pf_store_cnt_max to track the highest cnt
+ *  Only updates the sgh, so it can run for several sgh's in parallel. The
+ *  caller tracks de_ctx::non_pf_store_cnt_max.
  */
 int SigGroupHeadBuildNonPrefilterArray(DetectEngineCtx *de_ctx, SigGroupHead *sgh)
 {
@@ -714,11 +745,6 @@ int SigGroupHeadBuildNonPrefilterArray(DetectEngineCtx *de_ctx, SigGroupHead *sg
         }
     }
 
-    /* track highest cnt for any sgh in our de_ctx */
-    uint32_t max = MAX(sgh->non_pf_other_store_cnt, sgh->non_pf_syn_store_cnt);
-    if (max > de_ctx->non_pf_store_cnt_max)
-        de_ctx->non_pf_store_cnt_max = max;
-
     return 0;
 }
 
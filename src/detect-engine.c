@@ -73,6 +73,7 @@
 #include "util-unittest.h"
 #include "util-action.h"
 #include "util-magic.h"
+#include "util-numa.h"
 #include "util-signal.h"
 #include "util-spm.h"
 #include "util-device.h"
@@ -1520,6 +1521,9 @@ void InspectionBufferClean(DetectEngineThreadCtx *det_ctx)
         mbuffer->max = 0;
     }
     det_ctx->multi_inspect.to_clear_idx = 0;
+
+    /* offsets found by the mpm are only valid for the buffers above */
+    PrefilterTrackReset(&det_ctx->pmq);
 }
 
 InspectionBuffer *InspectionBufferGet(DetectEngineThreadCtx *det_ctx, const int list_id)
@@ -2356,7 +2360,10 @@ static int DetectEngineReloadThreads(DetectEngineCtx *new_de_ctx)
             old_det_ctx[i] = FlowWorkerGetDetectCtxPtr(SC_ATOMIC_GET(s->slot_data));
             detect_tvs[i] = tv;
 
+            /* allocate on the NUMA node of the thread that will use it */
+            UtilNumaSetPreferredNode(tv->numa_node);
             new_det_ctx[i] = DetectEngineThreadCtxInitForReload(tv, new_de_ctx, 1);
+            UtilNumaSetPreferredNode(-1);
             if (new_det_ctx[i] == NULL) {
                 SCLogError("Detect engine thread init "
                            "failure in live rule swap.  Let's get out of here");
@@ -2726,6 +2733,7 @@ static int DetectEngineCtxLoadConf(DetectEngineCtx *de_ctx)
         /* for now, since we still haven't implemented any intelligence into
          * understanding the patterns and distributing mpm_ctx across sgh */
         if (de_ctx->mpm_matcher == MPM_AC || de_ctx->mpm_matcher == MPM_AC_KS ||
+                de_ctx->mpm_matcher == MPM_AC_SIMD ||
 #ifdef BUILD_HYPERSCAN
             de_ctx->mpm_matcher == MPM_HS ||
 #endif
@@ -3196,6 +3204,15 @@ static TmEcode ThreadCtxDoInit (DetectEngineCtx *de_ctx, DetectEngineThreadCtx *
     PatternMatchThreadPrepare(&det_ctx->mtcu, de_ctx->mpm_matcher);
 
     PmqSetup(&det_ctx->pmq);
+#ifdef BUILD_HYPERSCAN
+    /* Hyperscan reports where the patterns end, so keep those to avoid
+     * searching for the fast pattern again during inspection. */
+    if (de_ctx->mpm_matcher == MPM_HS && de_ctx->max_fp_id > 0) {
+        if (PmqSetupPatternOffsets(&det_ctx->pmq, de_ctx->max_fp_id) != 0) {
+            return TM_ECODE_FAILED;
+        }
+    }
+#endif
 
     det_ctx->spm_thread_ctx = SpmMakeThreadCtx(de_ctx->spm_global_thread_ctx);
     if (det_ctx->spm_thread_ctx == NULL) {
@@ -3219,6 +3236,11 @@ static TmEcode ThreadCtxDoInit (DetectEngineCtx *de_ctx, DetectEngineThreadCtx *
         memset(det_ctx->match_array, 0,
                det_ctx->match_array_len * sizeof(Signature *));
 
+        det_ctx->pf_bitmap = SCCalloc((de_ctx->sig_array_len + 63) / 64, sizeof(uint64_t));
+        if (det_ctx->pf_bitmap == NULL) {
+            return TM_ECODE_FAILED;
+        }
+
         RuleMatchCandidateTxArrayInit(det_ctx, de_ctx->sig_array_len);
     }
 
@@ -3460,6 +3482,9 @@ static void DetectEngineThreadCtxFree(DetectEngineThreadCtx *det_ctx)
     if (det_ctx->match_array != NULL)
         SCFree(det_ctx->match_array);
 
+    if (det_ctx->pf_bitmap != NULL)
+        SCFree(det_ctx->pf_bitmap);
+
     RuleMatchCandidateTxArrayFree(det_ctx);
 
     AlertQueueFree(det_ctx);
@@ -4135,14 +4160,16 @@ int DetectEngineMultiTenantSetup(const bool unix_socket)
     int failure_fatal = 0;
     (void)ConfGetBool("engine.init-failure-fatal", &failure_fatal);
 
+    /* the loaders are used for building the rule groups as well, so
+     * they are spawned even if multi tenancy is disabled. */
+    DetectLoadersInit();
+    TmModuleDetectLoaderRegister();
+    DetectLoaderThreadSpawn();
+    TmThreadContinueDetectLoaderThreads();
+
     int enabled = 0;
     (void)ConfGetBool("multi-detect.enabled", &enabled);
     if (enabled == 1) {
-        DetectLoadersInit();
-        TmModuleDetectLoaderRegister();
-        DetectLoaderThreadSpawn();
-        TmThreadContinueDetectLoaderThreads();
-
         SCMutexLock(&master->lock);
         master->multi_tenant_enabled = 1;
 
@@ -41,6 +41,8 @@
 #include "detect-engine-mpm.h"
 #include "detect-engine-state.h"
 #include "detect-engine-build.h"
+#include "detect-engine-prefilter.h"
+#include "detect-engine-prefilter-common.h"
 
 #include "util-var-name.h"
 #include "util-unittest.h"
@@ -57,6 +59,8 @@ int DetectFlowbitMatch (DetectEngineThreadCtx *, Packet *,
 static int DetectFlowbitSetup (DetectEngineCtx *, Signature *, const char *);
 static int FlowbitOrAddData(DetectEngineCtx *, DetectFlowbitsData *, char *);
 void DetectFlowbitFree (DetectEngineCtx *, void *);
+static int PrefilterSetupFlowbits(DetectEngineCtx *de_ctx, SigGroupHead *sgh);
+static bool PrefilterFlowbitIsPrefilterable(const Signature *s);
 #ifdef UNITTESTS
 void FlowBitsRegisterTests(void);
 #endif
@@ -75,6 +79,9 @@ void DetectFlowbitsRegister (void)
     /* this is compatible to ip-only signatures */
     sigmatch_table[DETECT_FLOWBITS].flags |= SIGMATCH_IPONLY_COMPAT;
 
+    sigmatch_table[DETECT_FLOWBITS].SupportsPrefilter = PrefilterFlowbitIsPrefilterable;
+    sigmatch_table[DETECT_FLOWBITS].SetupPrefilter = PrefilterSetupFlowbits;
+
     DetectSetupParseRegexes(PARSE_REGEX, &parse_regex);
 }
 
@@ -380,6 +387,207 @@ void DetectFlowbitFree (DetectEngineCtx *de_ctx, void *ptr)
     SCFree(fd);
 }
 
+/** \internal
+ *  \brief get the first isset check of a rule
+ */
+static const DetectFlowbitsData *PrefilterFlowbitGetIsset(const Signature *s)
+{
+    for (const SigMatch *sm = s->init_data->smlists[DETECT_SM_LIST_MATCH]; sm != NULL;
+            sm = sm->next) {
+        if (sm->type != DETECT_FLOWBITS)
+            continue;
+        const DetectFlowbitsData *fd = (const DetectFlowbitsData *)sm->ctx;
+        if (fd->cmd == DETECT_FLOWBITS_CMD_ISSET)
+            return fd;
+    }
+    return NULL;
+}
+
+/** \brief prefilter ctx for flowbits:isset
+ *
+ *  Rules are stored by the flowbit they check. Rules that can't be keyed on
+ *  a bit are added for every packet with a flow.
+ */
+typedef struct PrefilterFlowbits_ {
+    uint32_t size;          /**< size of array, max flowbit idx + 1 */
+    SigsArray **array;      /**< rules per flowbit idx, NULL if none */
+    SigsArray always;       /**< rules added for each packet with a flow */
+} PrefilterFlowbits;
+
+static void PrefilterFlowbitsFree(void *ptr)
+{
+    PrefilterFlowbits *ctx = ptr;
+    if (ctx == NULL)
+        return;
+    if (ctx->array != NULL) {
+        for (uint32_t i = 0; i < ctx->size; i++) {
+            SigsArray *sa = ctx->array[i];
+            if (sa == NULL)
+                continue;
+            SCFree(sa->sigs);
+            SCFree(sa);
+        }
+        SCFree(ctx->array);
+    }
+    SCFree(ctx->always.sigs);
+    SCFree(ctx);
+}
+
+/** \internal
+ *  \brief add the rules for each flowbit set on the flow
+ *
+ *  The bits are taken from the flow before the packet rules run. Rules
+ *  checking a bit that a rule in the same group can set on this packet are
+ *  in ctx::always, see PrefilterSetupFlowbits.
+ */
+static void PrefilterFlowbitsMatch(DetectEngineThreadCtx *det_ctx, Packet *p, const void *pectx)
+{
+    const PrefilterFlowbits *ctx = pectx;
+
+    if (p->flow == NULL)
+        return;
+
+    PrefilterAddSids(&det_ctx->pmq, ctx->always.sigs, ctx->always.cnt);
+
+    for (const GenericVar *gv = p->flow->flowvar; gv != NULL; gv = gv->next) {
+        if (gv->type != DETECT_FLOWBITS || gv->idx >= ctx->size)
+            continue;
+        const SigsArray *sa = ctx->array[gv->idx];
+        if (sa != NULL) {
+            PrefilterAddSids(&det_ctx->pmq, sa->sigs, sa->cnt);
+        }
+    }
+}
+
+static int PrefilterFlowbitsAppend(SigsArray *sa, const SigIntId num)
+{
+    SigIntId *sigs = SCRealloc(sa->sigs, (sa->cnt + 1) * sizeof(SigIntId));
+    if (sigs == NULL)
+        return -1;
+    sa->sigs = sigs;
+    sa->sigs[sa->cnt++] = num;
+    return 0;
+}
+
+static int PrefilterFlowbitsAddSig(PrefilterFlowbits *ctx, const uint32_t idx, const SigIntId num)
+{
+    if (ctx->array[idx] == NULL) {
+        ctx->array[idx] = SCCalloc(1, sizeof(SigsArray));
+        if (ctx->array[idx] == NULL)
+            return -1;
+    }
+    return PrefilterFlowbitsAppend(ctx->array[idx], num);
+}
+
+/** \internal
+ *  \brief set up the flowbits engine for a rule group
+ *
+ *  Rules in a group are inspected in order, and a flowbits:set of one rule
+ *  is seen by the isset of a later rule on the same packet. So a rule is
+ *  only keyed on its flowbit if no rule in the group sets or toggles it.
+ *  Other rules end up in the always list. IP-only rules run before the
+ *  prefilter, the bits they set are on the flow already.
+ */
+static int PrefilterSetupFlowbits(DetectEngineCtx *de_ctx, SigGroupHead *sgh)
+{
+    const uint32_t size = de_ctx->max_fb_id + 1;
+
+    PrefilterFlowbits *ctx = SCCalloc(1, sizeof(*ctx));
+    if (ctx == NULL)
+        return -1;
+    ctx->size = size;
+    ctx->array = SCCalloc(size, sizeof(SigsArray *));
+    uint8_t *set_in_group = SCCalloc(size, sizeof(uint8_t));
+    if (ctx->array == NULL || set_in_group == NULL)
+        goto error;
+
+    for (uint32_t sig = 0; sig < sgh->init->sig_cnt; sig++) {
+        const Signature *s = sgh->init->match_array[sig];
+        if (s == NULL)
+            continue;
+        for (const SigMatch *sm = s->init_data->smlists[DETECT_SM_LIST_POSTMATCH]; sm != NULL;
+                sm = sm->next) {
+            if (sm->type != DETECT_FLOWBITS)
+                continue;
+            const DetectFlowbitsData *fd = (const DetectFlowbitsData *)sm->ctx;
+            if (fd->cmd == DETECT_FLOWBITS_CMD_SET || fd->cmd == DETECT_FLOWBITS_CMD_TOGGLE)
+                set_in_group[fd->idx] = 1;
+        }
+    }
+
+    uint32_t keyed = 0;
+    for (uint32_t sig = 0; sig < sgh->init->sig_cnt; sig++) {
+        const Signature *s = sgh->init->match_array[sig];
+        if (s == NULL || s->init_data->prefilter_sm == NULL ||
+                s->init_data->prefilter_sm->type != DETECT_FLOWBITS)
+            continue;
+
+        /* the prefilter keyword can be used on a set or isnotset as well,
+         * use the first isset of the rule if there is one. */
+        const DetectFlowbitsData *fd = PrefilterFlowbitGetIsset(s);
+        bool always = (fd == NULL || s->type == SIG_TYPE_APP_TX);
+        if (fd != NULL) {
+            if (fd->or_list_size > 0) {
+                for (uint8_t i = 0; i < fd->or_list_size; i++) {
+                    if (set_in_group[fd->or_list[i]])
+                        always = true;
+                }
+            } else if (set_in_group[fd->idx]) {
+                always = true;
+            }
+        }
+
+        if (always) {
+            if (PrefilterFlowbitsAppend(&ctx->always, s->num) != 0)
+                goto error;
+            SCLogDebug("sgh %p: sid %u flowbit can be set in group", sgh, s->id);
+            continue;
+        }
+
+        if (fd->or_list_size > 0) {
+            for (uint8_t i = 0; i < fd->or_list_size; i++) {
+                if (PrefilterFlowbitsAddSig(ctx, fd->or_list[i], s->num) != 0)
+                    goto error;
+            }
+        } else if (PrefilterFlowbitsAddSig(ctx, fd->idx, s->num) != 0) {
+            goto error;
+        }
+        keyed++;
+    }
+    SCFree(set_in_group);
+    set_in_group = NULL;
+
+    if (keyed == 0 && ctx->always.cnt == 0) {
+        PrefilterFlowbitsFree(ctx);
+        return 0;
+    }
+    SCLogDebug("sgh %p: %u rules keyed on flowbits, %u always added", sgh, keyed,
+            ctx->always.cnt);
+
+    if (PrefilterAppendEngine(
+                de_ctx, sgh, PrefilterFlowbitsMatch, ctx, PrefilterFlowbitsFree, "flowbits") < 0)
+        goto error;
+    return 0;
+
+error:
+    SCFree(set_in_group);
+    PrefilterFlowbitsFree(ctx);
+    return -1;
+}
+
+/** \internal
+ *  \brief rules with a flowbits:isset can be prefiltered on the flow's bits
+ *
+ *  Not for tx rules. They are inspected after the packet rules and can see
+ *  bits that any packet rule set on the same packet.
+ */
+static bool PrefilterFlowbitIsPrefilterable(const Signature *s)
+{
+    if (s->type == SIG_TYPE_APP_TX)
+        return false;
+    return PrefilterFlowbitGetIsset(s) != NULL;
+}
+
 struct FBAnalyze {
     uint16_t cnts[DETECT_FLOWBITS_CMD_MAX];
     uint16_t state_cnts[DETECT_FLOWBITS_CMD_MAX];
@@ -740,6 +948,8 @@ static void DetectFlowbitsAnalyzeDump(const DetectEngineCtx *de_ctx,
 }
 
 #ifdef UNITTESTS
+#include "detect-engine-alert.h"
+#include "util-unittest-helper.h"
 
 static int FlowBitsTestParse01(void)
 {
@@ -1153,6 +1363,62 @@ static int FlowBitsTestSig08(void)
     PASS;
 }
 
+/**
+ * \test prefilter on flowbits:isset. A rule checking a bit that is set by
+ *       a rule in the same group has to see it on the same packet.
+ */
+static int FlowBitsTestPrefilter01(void)
+{
+    uint8_t buf[] = "GET / HTTP/1.0\r\n\r\n";
+    ThreadVars th_v;
+    DetectEngineThreadCtx *det_ctx = NULL;
+    Flow f;
+
+    memset(&th_v, 0, sizeof(th_v));
+    memset(&f, 0, sizeof(f));
+    FLOW_INITIALIZE(&f);
+
+    Packet *p = UTHBuildPacket(buf, sizeof(buf) - 1, IPPROTO_TCP);
+    FAIL_IF_NULL(p);
+    p->flow = &f;
+    p->flags |= PKT_HAS_FLOW;
+    p->flowflags |= FLOW_PKT_TOSERVER;
+
+    DetectEngineCtx *de_ctx = DetectEngineCtxInit();
+    FAIL_IF_NULL(de_ctx);
+    de_ctx->flags |= DE_QUIET;
+
+    FAIL_IF_NULL(DetectEngineAppendSig(de_ctx, "alert tcp any any -> any any (dsize:>0; "
+                                               "flowbits:isset,pf_a; prefilter; sid:1;)"));
+    FAIL_IF_NULL(DetectEngineAppendSig(de_ctx, "alert tcp any any -> any any (dsize:>0; "
+                                               "flowbits:isset,pf_b; prefilter; sid:2;)"));
+    FAIL_IF_NULL(DetectEngineAppendSig(de_ctx, "alert tcp any any -> any any (content:\"GET\"; "
+                                               "flowbits:set,pf_c; sid:3;)"));
+    FAIL_IF_NULL(DetectEngineAppendSig(de_ctx, "alert tcp any any -> any any (dsize:>0; "
+                                               "flowbits:isset,pf_c; prefilter; sid:4;)"));
+    FAIL_IF_NULL(DetectEngineAppendSig(de_ctx, "alert tcp any any -> any any (dsize:>0; "
+                                               "flowbits:isset,pf_b|pf_a; prefilter; sid:5;)"));
+
+    FlowBitSet(&f, VarNameStoreSetupAdd("pf_a", VAR_TYPE_FLOW_BIT));
+
+    SigGroupBuild(de_ctx);
+    DetectEngineThreadCtxInit(&th_v, (void *)de_ctx, (void *)&det_ctx);
+
+    SigMatchSignatures(&th_v, de_ctx, det_ctx, p);
+
+    FAIL_IF_NOT(PacketAlertCheck(p, 1));
+    FAIL_IF(PacketAlertCheck(p, 2));
+    FAIL_IF_NOT(PacketAlertCheck(p, 3));
+    FAIL_IF_NOT(PacketAlertCheck(p, 4));
+    FAIL_IF_NOT(PacketAlertCheck(p, 5));
+
+    DetectEngineThreadCtxDeinit(&th_v, (void *)det_ctx);
+    DetectEngineCtxFree(de_ctx);
+    UTHFreePacket(p);
+    FLOW_DESTROY(&f);
+    PASS;
+}
+
 /**
  * \brief this function registers unit tests for FlowBits
  */
@@ -1167,5 +1433,6 @@ void FlowBitsRegisterTests(void)
     UtRegisterTest("FlowBitsTestSig06", FlowBitsTestSig06);
     UtRegisterTest("FlowBitsTestSig07", FlowBitsTestSig07);
     UtRegisterTest("FlowBitsTestSig08", FlowBitsTestSig08);
+    UtRegisterTest("FlowBitsTestPrefilter01", FlowBitsTestPrefilter01);
 }
 #endif /* UNITTESTS */
@@ -372,8 +372,10 @@ static void PrefilterTxHttpRequestBody(DetectEngineThreadCtx *det_ctx, const voi
         return;
 
     if (buffer->inspect_len >= mpm_ctx->minlen) {
+        PrefilterTrackStart(&det_ctx->pmq, buffer->inspect, buffer->inspect_len);
         (void)mpm_table[mpm_ctx->mpm_type].Search(
                 mpm_ctx, &det_ctx->mtcu, &det_ctx->pmq, buffer->inspect, buffer->inspect_len);
+        PrefilterTrackEnd(&det_ctx->pmq);
         PREFILTER_PROFILING_ADD_BYTES(det_ctx, buffer->inspect_len);
     }
 }
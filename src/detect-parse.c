@@ -32,6 +32,7 @@
 #include "detect-engine-mpm.h"
 #include "detect-engine-state.h"
 #include "detect-engine-build.h"
+#include "detect-engine-content-inspection.h"
 
 #include "detect-content.h"
 #include "detect-bsize.h"
@@ -1798,6 +1799,7 @@ SigMatchData* SigMatchList2DataArray(SigMatch *head)
         sm->ctx = NULL; // SigMatch no longer owns the ctx
         smd->is_last = (sm->next == NULL);
     }
+    DetectEngineContentInspectionCompile(out);
     return out;
 }
 
@@ -86,6 +86,8 @@ static int DetectReplacePostMatch(DetectEngineThreadCtx *det_ctx,
     if (det_ctx->replist) {
         DetectReplaceExecuteInternal(p, det_ctx->replist);
         det_ctx->replist = NULL;
+        /* the payload changed, so the mpm offsets are no longer valid */
+        PrefilterTrackReset(&det_ctx->pmq);
     }
     return 1;
 }
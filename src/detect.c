@@ -373,6 +373,62 @@ static inline void DetectPrefilterMergeSort(DetectEngineCtx *de_ctx,
     PMQ_RESET(&det_ctx->pmq);
 }
 
+/** \internal
+ *  \brief merge the prefilter matches and the non-prefilter list through
+ *         a bitmap
+ *
+ *  Gives the same match_array as DetectPrefilterMergeSort, without sorting
+ *  the prefilter matches. Setting the bits drops the duplicates, a sig on
+ *  both lists has a negated mpm pattern that matched so its bit is toggled
+ *  off again. The scan over the words of the sgh clears the bitmap for the
+ *  next packet.
+ */
+static inline void DetectPrefilterMergeBitmap(DetectEngineCtx *de_ctx,
+        DetectEngineThreadCtx *det_ctx, const SigGroupHead *sgh)
+{
+    uint64_t *bitmap = det_ctx->pf_bitmap;
+    const SigIntId *mpm_ptr = det_ctx->pmq.rule_id_array;
+    const SigIntId *nonmpm_ptr = det_ctx->non_pf_id_array;
+    Signature **sig_array = de_ctx->sig_array;
+    Signature **match_array = det_ctx->match_array;
+
+    SCLogDebug("PMQ rule id array count %d", det_ctx->pmq.rule_id_array_cnt);
+
+    /* with a shared mpm context (sgh-mpm-context single or auto) the mpm
+     * also reports rules of other groups. Those outside of the words of
+     * this group can't be in it, skip them so no bits are left behind. */
+    for (uint32_t i = 0; i < det_ctx->pmq.rule_id_array_cnt; i++) {
+        const SigIntId id = mpm_ptr[i];
+        if (unlikely((uint32_t)(id / 64) - sgh->pf_bitmap_offset >= sgh->pf_bitmap_words))
+            continue;
+        bitmap[id / 64] |= BIT_U64(id % 64);
+    }
+    for (uint32_t i = 0; i < det_ctx->non_pf_id_cnt; i++) {
+        const SigIntId id = nonmpm_ptr[i];
+        DEBUG_VALIDATE_BUG_ON(id / 64 < sgh->pf_bitmap_offset ||
+                              id / 64 >= sgh->pf_bitmap_offset + sgh->pf_bitmap_words);
+        bitmap[id / 64] ^= BIT_U64(id % 64);
+    }
+
+    const uint32_t end = sgh->pf_bitmap_offset + sgh->pf_bitmap_words;
+    for (uint32_t w = sgh->pf_bitmap_offset; w < end; w++) {
+        uint64_t word = bitmap[w];
+        if (word == 0)
+            continue;
+        bitmap[w] = 0;
+
+        Signature **base = sig_array + (w * 64);
+        do {
+            *match_array++ = base[__builtin_ctzll(word)];
+            word &= word - 1;
+        } while (word != 0);
+    }
+
+    det_ctx->match_array_cnt = match_array - det_ctx->match_array;
+    DEBUG_VALIDATE_BUG_ON((det_ctx->pmq.rule_id_array_cnt + det_ctx->non_pf_id_cnt) < det_ctx->match_array_cnt);
+    PMQ_RESET(&det_ctx->pmq);
+}
+
 /** \internal
  *  \brief build non-prefilter list based on the rule group list we've set.
  */
@@ -699,7 +755,11 @@ static inline void DetectRunPrefilterPkt(
         }
 #endif
         PACKET_PROFILING_DETECT_START(p, PROF_DETECT_PF_SORT2);
-        DetectPrefilterMergeSort(de_ctx, det_ctx);
+        if (PrefilterUseBitmap(scratch->sgh, det_ctx->pmq.rule_id_array_cnt)) {
+            DetectPrefilterMergeBitmap(de_ctx, det_ctx, scratch->sgh);
+        } else {
+            DetectPrefilterMergeSort(de_ctx, det_ctx);
+        }
         PACKET_PROFILING_DETECT_END(p, PROF_DETECT_PF_SORT2);
     }
 
@@ -833,6 +893,7 @@ static DetectRunScratchpad DetectRunSetup(
     det_ctx->base64_decoded_len = 0;
     det_ctx->raw_stream_progress = 0;
     det_ctx->match_array_cnt = 0;
+    PrefilterTrackReset(&det_ctx->pmq);
 
     det_ctx->alert_queue_size = 0;
     p->alerts.drop.action = 0;
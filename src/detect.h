@@ -793,6 +793,20 @@ typedef struct SigFileLoaderStat_ {
     int bad_sigs_total;
 } SigFileLoaderStat;
 
+/** \brief time spent in the phases of SigGroupBuild, in microseconds */
+typedef struct SigGroupBuildStat_ {
+    uint64_t grouping;     /**< sig numbering, fast patterns, stages 1 to 3 */
+    uint64_t match_arrays; /**< per sgh match arrays and flags */
+    uint64_t prefilter;    /**< prefilter engines and mpm store setup */
+    uint64_t mpm_compile;  /**< compiling the per sgh mpm contexts */
+    uint64_t non_pf_arrays; /**< per sgh arrays of the not prefiltered rules */
+    uint64_t finalize;     /**< shared mpm contexts and per sig setup */
+    uint64_t total;
+    int threads;           /**< threads used for the parallel phases */
+    uint32_t non_pf_groups; /**< groups with rules that are not prefiltered */
+    uint32_t non_pf_rules;  /**< not prefiltered rules summed over the groups */
+} SigGroupBuildStat;
+
 typedef struct DetectEngineThreadKeywordCtxItem_ {
     void *(*InitFunc)(void *);
     void (*FreeFunc)(void *);
@@ -847,6 +861,9 @@ typedef struct DetectEngineCtx_ {
      *  used to alloc det_ctx::non_mpm_id_array */
     uint32_t non_pf_store_cnt_max;
 
+    /** number of fast pattern ids, see DetectSetFastPatternAndItsId */
+    uint32_t max_fp_id;
+
     /* used by the signature ordering module */
     struct SCSigOrderFunc_ *sc_sig_order_funcs;
 
@@ -1000,6 +1017,9 @@ typedef struct DetectEngineCtx_ {
     /** signatures stats */
     SigFileLoaderStat sig_stat;
 
+    /** rule group build timing */
+    SigGroupBuildStat sgh_build_stat;
+
     /* list of Fast Pattern registrations. Initially filled using a copy of
      * `g_fp_support_smlist_list`, then extended at rule loading time if needed */
     SCFPSupportSMList *fp_support_smlist_list;
@@ -1149,6 +1169,10 @@ typedef struct DetectEngineThreadCtx_ {
     /** size in use */
     SigIntId match_array_cnt;
 
+    /** one bit per signature, used to merge the prefilter results into
+     *  the match_array without sorting. All zero between packets. */
+    uint64_t *pf_bitmap;
+
     RuleMatchCandidateTx *tx_candidates;
     uint32_t tx_candidates_size;
 
@@ -1435,6 +1459,11 @@ typedef struct SigGroupHead_ {
 
     uint32_t id; /**< unique id used to index sgh_array for stats */
 
+    /** words of DetectEngineThreadCtx::pf_bitmap holding the sigs of
+     *  this sgh */
+    uint32_t pf_bitmap_offset;
+    uint32_t pf_bitmap_words;
+
     PrefilterEngine *pkt_engines;
     PrefilterEngine *payload_engines;
     PrefilterEngine *tx_engines;
@@ -148,10 +148,23 @@ static TmEcode BypassedFlowManagerThreadDeinit(ThreadVars *t, void *data)
     return TM_ECODE_OK;
 }
 
+/** \internal
+ *  \brief capture bypass looks up and creates flows by their key outside of
+ *         the flow workers, so it can't tell which worker's slice of the
+ *         hash a flow belongs in */
+static void BypassedFlowManagerCheckHashShards(void)
+{
+    if (flow_config.hash_shards > 1) {
+        FatalError("flow.hash-shards can't be used with capture bypass (eBPF or XDP), "
+                   "set flow.hash-shards to 1 or disable bypass");
+    }
+}
+
 int BypassedFlowManagerRegisterCheckFunc(BypassedCheckFunc CheckFunc,
                                          BypassedCheckFuncInit CheckFuncInit,
                                          void *data)
 {
+    BypassedFlowManagerCheckHashShards();
     if (g_bypassed_func_max_index < BYPASSFUNCMAX) {
         bypassedfunclist[g_bypassed_func_max_index].Func = CheckFunc;
         bypassedfunclist[g_bypassed_func_max_index].FuncInit = CheckFuncInit;
@@ -169,6 +182,7 @@ int BypassedFlowManagerRegisterUpdateFunc(BypassedUpdateFunc UpdateFunc,
     if (!UpdateFunc) {
         return -1;
     }
+    BypassedFlowManagerCheckHashShards();
     if (g_bypassed_update_max_index < BYPASSFUNCMAX) {
         updatefunclist[g_bypassed_update_max_index].Func = UpdateFunc;
         updatefunclist[g_bypassed_update_max_index].data = data;
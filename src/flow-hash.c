@@ -43,6 +43,7 @@
 #include "util-time.h"
 #include "util-debug.h"
 #include "util-device.h"
+#include "util-numa.h"
 
 #include "util-hash-lookup3.h"
 
@@ -823,6 +824,188 @@ static inline bool FlowIsTimedOut(const Flow *f, const uint32_t sec, const bool
     return false;
 }
 
+/** \internal
+ *  \brief get the bucket for a hash value in a slice of the hash
+ *
+ *  Without flow.hash-shards the whole hash is one slice.
+ */
+static inline FlowBucket *FlowHashGetBucket(const uint32_t hash, const uint32_t shard)
+{
+    if (flow_config.hash_shards == 0)
+        return &flow_hash[hash % flow_config.hash_size];
+    return &flow_hash[shard * flow_config.hash_shard_size + hash % flow_config.hash_shard_size];
+}
+
+/** \internal
+ *  \brief slice for flows not created by a flow worker */
+static inline uint32_t FlowHashDefaultShard(const uint32_t hash)
+{
+    if (flow_config.hash_shards == 0)
+        return 0;
+    return (hash / flow_config.hash_shard_size) % flow_config.hash_shards;
+}
+
+/** \brief pick the slice of the hash for a new flow worker thread
+ *
+ *  With flow.hash-shards each worker keeps its flows in its own slice of the
+ *  hash, so workers don't share buckets or their cache lines. This requires
+ *  the capture method to deliver all packets of a flow to the same worker,
+ *  e.g. AF_PACKET cluster_qm with symmetric RSS.
+ */
+uint32_t FlowHashShardAssign(void)
+{
+    static SC_ATOMIC_DECL_AND_INIT(uint32_t, flow_hash_shard_next);
+
+    if (flow_config.hash_shards == 0)
+        return 0;
+    const uint32_t shard = SC_ATOMIC_ADD(flow_hash_shard_next, 1) % flow_config.hash_shards;
+
+    /* the slice is only used by this worker, keep it on its NUMA node */
+    if (UtilNumaThreadGetPinnedNode() >= 0) {
+        UtilNumaBindMemory(&flow_hash[shard * flow_config.hash_shard_size],
+                (size_t)flow_config.hash_shard_size * sizeof(FlowBucket), UtilNumaThreadNode());
+    }
+    return shard;
+}
+
+/** \brief prefetch the bucket FlowGetFlowFromHash will use for hash */
+void FlowHashPrefetch(const FlowLookupStruct *fls, const uint32_t hash)
+{
+    __builtin_prefetch(FlowHashGetBucket(hash, fls->hash_shard));
+}
+
+/* threads doing lockless lookups, see FlowHashReadersSynchronize */
+static FlowHashReader *flow_hash_readers = NULL;
+static SCMutex flow_hash_readers_m = SCMUTEX_INITIALIZER;
+
+/** \brief register the calling thread for lockless flow lookups
+ *  \retval r reader to store in FlowLookupStruct::reader, or NULL */
+FlowHashReader *FlowHashReaderRegister(void)
+{
+    FlowHashReader *r = SCMallocAligned(sizeof(*r), CLS);
+    if (r == NULL)
+        return NULL;
+    memset(r, 0, sizeof(*r));
+    SC_ATOMIC_INIT(r->seq);
+
+    SCMutexLock(&flow_hash_readers_m);
+    r->next = flow_hash_readers;
+    flow_hash_readers = r;
+    SCMutexUnlock(&flow_hash_readers_m);
+    return r;
+}
+
+void FlowHashReaderDeregister(FlowHashReader *r)
+{
+    if (r == NULL)
+        return;
+
+    SCMutexLock(&flow_hash_readers_m);
+    FlowHashReader **pr = &flow_hash_readers;
+    while (*pr != NULL && *pr != r)
+        pr = &(*pr)->next;
+    if (*pr == r)
+        *pr = r->next;
+    SCMutexUnlock(&flow_hash_readers_m);
+
+    SCFreeAligned(r);
+}
+
+/** \brief wait for the lockless lookups in progress to finish
+ *
+ *  Lockless readers may dereference a flow that was removed from the hash
+ *  while they were walking its bucket. Flows that are no longer reachable
+ *  from the hash, e.g. spare pool blocks that are being shrunk, can be freed
+ *  once this returns.
+ */
+void FlowHashReadersSynchronize(void)
+{
+    SC_ATOMIC_THREAD_FENCE(SC_ATOMIC_MEMORY_ORDER_SEQ_CST);
+
+    SCMutexLock(&flow_hash_readers_m);
+    for (FlowHashReader *r = flow_hash_readers; r != NULL; r = r->next) {
+        const uint32_t seq = SC_ATOMIC_GET(r->seq);
+        if ((seq & 1) == 0)
+            continue;
+        /* lookups never block, so this is short */
+        while (SC_ATOMIC_GET(r->seq) == seq)
+            usleep(1);
+    }
+    SCMutexUnlock(&flow_hash_readers_m);
+}
+
+static inline bool FlowBucketSeqChanged(FlowBucket *fb, const uint32_t seq)
+{
+    SC_ATOMIC_THREAD_FENCE(SC_ATOMIC_MEMORY_ORDER_ACQUIRE);
+    return SC_ATOMIC_LOAD_EXPLICIT(fb->seq, SC_ATOMIC_MEMORY_ORDER_RELAXED) != seq;
+}
+
+/** \internal
+ *  \brief look up an existing flow without locking the bucket
+ *
+ *  The bucket is walked optimistically and the candidate flow is then
+ *  trylocked. Removing a flow from the hash requires the flow lock, so a
+ *  locked flow that is still in an unchanged bucket can be used as if it
+ *  was found under the bucket lock.
+ *
+ *  Anything out of the ordinary -- a concurrent bucket update, a busy,
+ *  timed out or reused flow, or no match -- is left to the locked path,
+ *  which also creates flows and handles timeouts.
+ *
+ *  \retval f *LOCKED* flow or NULL if the locked path has to be taken
+ */
+static Flow *FlowGetExistingFlowFromHashLockless(
+        FlowLookupStruct *fls, FlowBucket *fb, const Packet *p, Flow **dest)
+{
+    FlowHashReader *r = fls->reader;
+    Flow *f = NULL;
+
+    const uint32_t rseq = SC_ATOMIC_LOAD_EXPLICIT(r->seq, SC_ATOMIC_MEMORY_ORDER_RELAXED);
+    /* seq_cst: the bucket reads below must not be reordered before this */
+    (void)SC_ATOMIC_ADD(r->seq, 1);
+
+    const uint32_t seq = SC_ATOMIC_LOAD_EXPLICIT(fb->seq, SC_ATOMIC_MEMORY_ORDER_ACQUIRE);
+    if (seq & 1)
+        goto done;
+
+    for (f = fb->head; f != NULL; f = f->next) {
+        if (FlowCompare(f, p) != 0)
+            break;
+        /* stop on concurrent updates, f->next may point anywhere */
+        if (FlowBucketSeqChanged(fb, seq)) {
+            f = NULL;
+            goto done;
+        }
+    }
+    if (f == NULL || FlowBucketSeqChanged(fb, seq))
+        goto fail;
+
+    if (FLOWLOCK_TRYWRLOCK(f) != 0)
+        goto fail;
+    /* with the flow locked, an unchanged bucket means it is still ours */
+    if (FlowBucketSeqChanged(fb, seq))
+        goto fail_unlock;
+
+    const bool emerg = (SC_ATOMIC_GET(flow_flags) & FLOW_EMERGENCY) != 0;
+    const uint32_t fb_nextts = !emerg ? SC_ATOMIC_GET(fb->next_ts) : 0;
+    if (fb_nextts < (uint32_t)SCTIME_SECS(p->ts) &&
+            FlowIsTimedOut(f, (uint32_t)SCTIME_SECS(p->ts), emerg))
+        goto fail_unlock;
+    if (unlikely(TcpSessionPacketSsnReuse(p, f, f->protoctx) == 1))
+        goto fail_unlock;
+
+    FlowReference(dest, f);
+    goto done;
+
+fail_unlock:
+    FLOWLOCK_UNLOCK(f);
+fail:
+    f = NULL;
+done:
+    SC_ATOMIC_STORE_EXPLICIT(r->seq, rseq + 2, SC_ATOMIC_MEMORY_ORDER_RELEASE);
+    return f;
+}
+
 /** \brief Get Flow for packet
  *
  * Hash retrieval function for flows. Looks up the hash bucket containing the
@@ -835,6 +1018,9 @@ static inline bool FlowIsTimedOut(const Flow *f, const uint32_t sec, const bool
  *
  * The p->flow pointer is updated to point to the flow.
  *
+ * Threads with a registered FlowHashReader first try to find an existing
+ * flow without locking the bucket.
+ *
  *  \param tv thread vars
  *  \param dtv decode thread vars (for flow log api thread data)
  *
@@ -844,9 +1030,16 @@ Flow *FlowGetFlowFromHash(ThreadVars *tv, FlowLookupStruct *fls, Packet *p, Flow
 {
     Flow *f = NULL;
 
-    /* get our hash bucket and lock it */
     const uint32_t hash = p->flow_hash;
-    FlowBucket *fb = &flow_hash[hash % flow_config.hash_size];
+    FlowBucket *fb = FlowHashGetBucket(hash, fls->hash_shard);
+
+    if (fls->reader != NULL) {
+        f = FlowGetExistingFlowFromHashLockless(fls, fb, p, dest);
+        if (f != NULL)
+            return f;
+    }
+
+    /* lock our hash bucket */
     FBLOCK_LOCK(fb);
 
     SCLogDebug("fb %p fb->head %p", fb, fb->head);
@@ -958,15 +1151,12 @@ static inline int FlowCompareKey(Flow *f, FlowKey *key)
  * the flow we need. If it isn't, walk the list until the right flow is found.
  *
  *
+ *  \param fb bucket to look in
  *  \param flow_id Flow ID of the flow to look for
  *  \retval f *LOCKED* flow or NULL
  */
-
-Flow *FlowGetExistingFlowFromFlowId(int64_t flow_id)
+static Flow *FlowGetExistingFlowFromFlowIdInBucket(FlowBucket *fb, int64_t flow_id)
 {
-    uint32_t hash = flow_id & 0x0000FFFF;
-    /* get our hash bucket and lock it */
-    FlowBucket *fb = &flow_hash[hash % flow_config.hash_size];
     FBLOCK_LOCK(fb);
 
     SCLogDebug("fb %p fb->head %p", fb, fb->head);
@@ -1006,6 +1196,23 @@ Flow *FlowGetExistingFlowFromFlowId(int64_t flow_id)
     return f;
 }
 
+/** \brief Look for existing Flow using a flow id value
+ *  \retval f *LOCKED* flow or NULL
+ */
+Flow *FlowGetExistingFlowFromFlowId(int64_t flow_id)
+{
+    const uint32_t hash = flow_id & 0x0000FFFF;
+    const uint32_t shards = MAX(flow_config.hash_shards, 1);
+
+    /* the flow id doesn't tell which slice of the hash the flow is in */
+    for (uint32_t shard = 0; shard < shards; shard++) {
+        Flow *f = FlowGetExistingFlowFromFlowIdInBucket(FlowHashGetBucket(hash, shard), flow_id);
+        if (f != NULL)
+            return f;
+    }
+    return NULL;
+}
+
 /** \brief Look for existing Flow using a FlowKey
  *
  * Hash retrieval function for flows. Looks up the hash bucket containing the
@@ -1013,14 +1220,13 @@ Flow *FlowGetExistingFlowFromFlowId(int64_t flow_id)
  * the flow we need. If it isn't, walk the list until the right flow is found.
  *
  *
+ *  \param fb bucket to look in
  *  \param key Pointer to FlowKey build using flow to look for
- *  \param hash Value of the flow hash
  *  \retval f *LOCKED* flow or NULL
  */
-static Flow *FlowGetExistingFlowFromHash(FlowKey *key, const uint32_t hash)
+static Flow *FlowGetExistingFlowFromBucket(FlowBucket *fb, FlowKey *key)
 {
-    /* get our hash bucket and lock it */
-    FlowBucket *fb = &flow_hash[hash % flow_config.hash_size];
+    /* lock our hash bucket */
     FBLOCK_LOCK(fb);
 
     SCLogDebug("fb %p fb->head %p", fb, fb->head);
@@ -1061,6 +1267,19 @@ static Flow *FlowGetExistingFlowFromHash(FlowKey *key, const uint32_t hash)
     return f;
 }
 
+static Flow *FlowGetExistingFlowFromHash(FlowKey *key, const uint32_t hash)
+{
+    const uint32_t shards = MAX(flow_config.hash_shards, 1);
+
+    /* not called from a flow worker, so look in all slices of the hash */
+    for (uint32_t shard = 0; shard < shards; shard++) {
+        Flow *f = FlowGetExistingFlowFromBucket(FlowHashGetBucket(hash, shard), key);
+        if (f != NULL)
+            return f;
+    }
+    return NULL;
+}
+
 /** \brief Get or create a Flow using a FlowKey
  *
  * Hash retrieval function for flows. Looks up the hash bucket containing the
@@ -1116,7 +1335,7 @@ Flow *FlowGetFromFlowKey(FlowKey *key, struct timespec *ttime, const uint32_t ha
     f->startts = SCTIME_FROM_TIMESPEC(ttime);
     f->lastts = f->startts;
 
-    FlowBucket *fb = &flow_hash[hash % flow_config.hash_size];
+    FlowBucket *fb = FlowHashGetBucket(hash, FlowHashDefaultShard(hash));
     FBLOCK_LOCK(fb);
     f->fb = fb;
     f->next = fb->head;
@@ -39,7 +39,11 @@
 /* flow hash bucket -- the hash is basically an array of these buckets.
  * Each bucket contains a flow or list of flows. All these flows have
  * the same hashkey (the hash is a chained hash). When doing modifications
- * to the list, the entire bucket is locked. */
+ * to the list, the entire bucket is locked.
+ *
+ * The bucket lock doubles as the write side of a seqlock: 'seq' is odd
+ * while the lock is held. Workers use this to look up existing flows
+ * without taking the bucket lock, see FlowGetFlowFromHash. */
 typedef struct FlowBucket_ {
     /** head of the list of active flows for this row. */
     Flow *head;
@@ -59,28 +63,81 @@ typedef struct FlowBucket_ {
      *  flow state changes. The flow manager sets this to UINT_MAX for
      *  empty buckets. */
     SC_ATOMIC_DECLARE(uint32_t, next_ts);
+    /** seqlock sequence, odd while the bucket is locked */
+    SC_ATOMIC_DECLARE(uint32_t, seq);
 } __attribute__((aligned(CLS))) FlowBucket;
 
+/** \brief start a bucket write section, bucket must be locked */
+static inline void FlowBucketSeqBegin(FlowBucket *fb)
+{
+    const uint32_t seq = SC_ATOMIC_LOAD_EXPLICIT(fb->seq, SC_ATOMIC_MEMORY_ORDER_RELAXED);
+    SC_ATOMIC_STORE_EXPLICIT(fb->seq, seq + 1, SC_ATOMIC_MEMORY_ORDER_RELAXED);
+    SC_ATOMIC_THREAD_FENCE(SC_ATOMIC_MEMORY_ORDER_RELEASE);
+}
+
+/** \brief end a bucket write section, bucket must be locked */
+static inline void FlowBucketSeqEnd(FlowBucket *fb)
+{
+    const uint32_t seq = SC_ATOMIC_LOAD_EXPLICIT(fb->seq, SC_ATOMIC_MEMORY_ORDER_RELAXED);
+    SC_ATOMIC_STORE_EXPLICIT(fb->seq, seq + 1, SC_ATOMIC_MEMORY_ORDER_RELEASE);
+}
+
 #ifdef FBLOCK_SPIN
     #define FBLOCK_INIT(fb) SCSpinInit(&(fb)->s, 0)
     #define FBLOCK_DESTROY(fb) SCSpinDestroy(&(fb)->s)
-    #define FBLOCK_LOCK(fb) SCSpinLock(&(fb)->s)
-    #define FBLOCK_TRYLOCK(fb) SCSpinTrylock(&(fb)->s)
-    #define FBLOCK_UNLOCK(fb) SCSpinUnlock(&(fb)->s)
+    #define FBLOCK_LOCK_RAW(fb) SCSpinLock(&(fb)->s)
+    #define FBLOCK_TRYLOCK_RAW(fb) SCSpinTrylock(&(fb)->s)
+    #define FBLOCK_UNLOCK_RAW(fb) SCSpinUnlock(&(fb)->s)
 #elif defined FBLOCK_MUTEX
     #define FBLOCK_INIT(fb) SCMutexInit(&(fb)->m, NULL)
     #define FBLOCK_DESTROY(fb) SCMutexDestroy(&(fb)->m)
-    #define FBLOCK_LOCK(fb) SCMutexLock(&(fb)->m)
-    #define FBLOCK_TRYLOCK(fb) SCMutexTrylock(&(fb)->m)
-    #define FBLOCK_UNLOCK(fb) SCMutexUnlock(&(fb)->m)
+    #define FBLOCK_LOCK_RAW(fb) SCMutexLock(&(fb)->m)
+    #define FBLOCK_TRYLOCK_RAW(fb) SCMutexTrylock(&(fb)->m)
+    #define FBLOCK_UNLOCK_RAW(fb) SCMutexUnlock(&(fb)->m)
 #else
     #error Enable FBLOCK_SPIN or FBLOCK_MUTEX
 #endif
 
+static inline int FlowBucketTryLock(FlowBucket *fb)
+{
+    int r = FBLOCK_TRYLOCK_RAW(fb);
+    if (r == 0)
+        FlowBucketSeqBegin(fb);
+    return r;
+}
+
+#define FBLOCK_LOCK(fb)                                                                            \
+    do {                                                                                           \
+        FBLOCK_LOCK_RAW(fb);                                                                       \
+        FlowBucketSeqBegin(fb);                                                                    \
+    } while (0)
+#define FBLOCK_TRYLOCK(fb) FlowBucketTryLock(fb)
+#define FBLOCK_UNLOCK(fb)                                                                          \
+    do {                                                                                           \
+        FlowBucketSeqEnd(fb);                                                                      \
+        FBLOCK_UNLOCK_RAW(fb);                                                                     \
+    } while (0)
+
+/** Per thread state of an optimistic (lockless) hash reader. Flows are only
+ *  freed after FlowHashReadersSynchronize, which waits for all readers that
+ *  may still be walking a bucket. */
+typedef struct FlowHashReader_ {
+    /** odd while the thread is inside a lockless lookup */
+    SC_ATOMIC_DECLARE(uint32_t, seq);
+    struct FlowHashReader_ *next;
+} __attribute__((aligned(CLS))) FlowHashReader;
+
 /* prototypes */
 
 Flow *FlowGetFlowFromHash(ThreadVars *tv, FlowLookupStruct *tctx, Packet *, Flow **);
 
+uint32_t FlowHashShardAssign(void);
+void FlowHashPrefetch(const FlowLookupStruct *fls, const uint32_t hash);
+
+FlowHashReader *FlowHashReaderRegister(void);
+void FlowHashReaderDeregister(FlowHashReader *r);
+void FlowHashReadersSynchronize(void);
+
 Flow *FlowGetFromFlowKey(FlowKey *key, struct timespec *ttime, const uint32_t hash);
 Flow *FlowGetExistingFlowFromFlowId(int64_t flow_id);
 uint32_t FlowKeyGetHash(FlowKey *flow_key);
@@ -814,8 +814,9 @@ static TmEcode FlowManager(ThreadVars *th_v, void *thread_data)
             if (ftd->instance == 0) {
                 const uint32_t sq_len = FlowSpareGetPoolSize();
                 const uint32_t spare_perc = sq_len * 100 / MAX(flow_config.prealloc, 1);
-                /* see if we still have enough spare flows */
-                if (spare_perc < 90 || spare_perc > 110) {
+                /* see if we still have enough spare flows. The per NUMA
+                 * node pools are checked individually. */
+                if (spare_perc < 90 || spare_perc > 110 || FlowSparePoolNodesNeedUpdate()) {
                     FlowSparePoolUpdate(sq_len);
                 }
             }
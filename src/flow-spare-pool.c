@@ -27,28 +27,45 @@
 #include "threads.h"
 #include "flow-private.h"
 #include "flow-queue.h"
+#include "flow-hash.h"
 #include "flow-util.h"
 #include "flow-spare-pool.h"
 #include "util-error.h"
 #include "util-debug.h"
 #include "util-print.h"
 #include "util-validate.h"
+#include "util-numa.h"
 
 typedef struct FlowSparePool {
     FlowQueuePrivate queue;
     struct FlowSparePool *next;
 } FlowSparePool;
 
-static uint32_t flow_spare_pool_flow_cnt = 0;
+/** spare flows allocated for one NUMA node. Without NUMA awareness only
+ *  node 0 is used. */
+typedef struct FlowSparePoolNode {
+    FlowSparePool *pool;
+    uint32_t flow_cnt;
+} FlowSparePoolNode;
+
 uint32_t flow_spare_pool_block_size = 100;
-static FlowSparePool *flow_spare_pool = NULL;
+static FlowSparePoolNode flow_spare_pools[UTIL_NUMA_MAX_NODES];
 static SCMutex flow_spare_pool_m = SCMUTEX_INITIALIZER;
 
+static uint32_t FlowSpareGetPoolSizeLocked(void)
+{
+    uint32_t size = 0;
+    for (uint16_t n = 0; n < UtilNumaNodeCount(); n++) {
+        size += flow_spare_pools[n].flow_cnt;
+    }
+    return size;
+}
+
 uint32_t FlowSpareGetPoolSize(void)
 {
     uint32_t size;
     SCMutexLock(&flow_spare_pool_m);
-    size = flow_spare_pool_flow_cnt;
+    size = FlowSpareGetPoolSizeLocked();
     SCMutexUnlock(&flow_spare_pool_m);
     return size;
 }
@@ -99,68 +116,70 @@ static void Validate(FlowSparePool *top, const uint32_t target)
 
 void FlowSparePoolReturnFlow(Flow *f)
 {
+    FlowSparePoolNode *n = &flow_spare_pools[f->numa_node];
+
     SCMutexLock(&flow_spare_pool_m);
-    if (flow_spare_pool == NULL) {
-        flow_spare_pool = FlowSpareGetPool();
+    if (n->pool == NULL) {
+        n->pool = FlowSpareGetPool();
     }
-    DEBUG_VALIDATE_BUG_ON(flow_spare_pool == NULL);
+    DEBUG_VALIDATE_BUG_ON(n->pool == NULL);
 
     /* if the top is full, get a new block */
-    if (flow_spare_pool->queue.len >= flow_spare_pool_block_size) {
+    if (n->pool->queue.len >= flow_spare_pool_block_size) {
         FlowSparePool *p = FlowSpareGetPool();
         DEBUG_VALIDATE_BUG_ON(p == NULL);
-        p->next = flow_spare_pool;
-        flow_spare_pool = p;
+        p->next = n->pool;
+        n->pool = p;
     }
     /* add to the (possibly new) top */
-    FlowQueuePrivateAppendFlow(&flow_spare_pool->queue, f);
-    flow_spare_pool_flow_cnt++;
+    FlowQueuePrivateAppendFlow(&n->pool->queue, f);
+    n->flow_cnt++;
 
     SCMutexUnlock(&flow_spare_pool_m);
 }
 
-void FlowSparePoolReturnFlows(FlowQueuePrivate *fqp)
+static void FlowSparePoolReturnFlowsNode(FlowSparePoolNode *n, FlowQueuePrivate *fqp)
 {
     FlowSparePool *p = FlowSpareGetPool();
     DEBUG_VALIDATE_BUG_ON(p == NULL);
     p->queue = *fqp;
 
     SCMutexLock(&flow_spare_pool_m);
-    flow_spare_pool_flow_cnt += fqp->len;
-    if (flow_spare_pool != NULL) {
+    n->flow_cnt += fqp->len;
+    if (n->pool != NULL) {
         if (p->queue.len == flow_spare_pool_block_size) {
             /* full block insert */
 
-            if (flow_spare_pool->queue.len < flow_spare_pool_block_size) {
-                p->next = flow_spare_pool->next;
-                flow_spare_pool->next = p;
+            if (n->pool->queue.len < flow_spare_pool_block_size) {
+                p->next = n->pool->next;
+                n->pool->next = p;
                 p = NULL;
             } else {
-                p->next = flow_spare_pool;
-                flow_spare_pool = p;
+                p->next = n->pool;
+                n->pool = p;
                 p = NULL;
             }
         } else {
             /* incomplete block insert */
 
-            if (p->queue.len + flow_spare_pool->queue.len <= flow_spare_pool_block_size) {
-                FlowQueuePrivateAppendPrivate(&flow_spare_pool->queue, &p->queue);
+            if (p->queue.len + n->pool->queue.len <= flow_spare_pool_block_size) {
+                FlowQueuePrivateAppendPrivate(&n->pool->queue, &p->queue);
                 /* free 'p' outside of lock below */
             } else {
                 // put smallest first
-                if (p->queue.len < flow_spare_pool->queue.len) {
-                    p->next = flow_spare_pool;
-                    flow_spare_pool = p;
+                if (p->queue.len < n->pool->queue.len) {
+                    p->next = n->pool;
+                    n->pool = p;
                 } else {
-                    p->next = flow_spare_pool->next;
-                    flow_spare_pool->next = p;
+                    p->next = n->pool->next;
+                    n->pool->next = p;
                 }
                 p = NULL;
             }
         }
     } else {
-        p->next = flow_spare_pool;
-        flow_spare_pool = p;
+        p->next = n->pool;
+        n->pool = p;
         p = NULL;
     }
     SCMutexUnlock(&flow_spare_pool_m);
@@ -172,53 +191,85 @@ void FlowSparePoolReturnFlows(FlowQueuePrivate *fqp)
         SCFree(p);
 }
 
-FlowQueuePrivate FlowSpareGetFromPool(void)
+void FlowSparePoolReturnFlows(FlowQueuePrivate *fqp)
 {
-    SCMutexLock(&flow_spare_pool_m);
-    if (flow_spare_pool == NULL || flow_spare_pool_flow_cnt == 0) {
-        SCMutexUnlock(&flow_spare_pool_m);
-        FlowQueuePrivate empty = { NULL, NULL, 0 };
-        return empty;
+    const uint16_t nodes = UtilNumaNodeCount();
+    if (nodes == 1) {
+        FlowSparePoolReturnFlowsNode(&flow_spare_pools[0], fqp);
+        return;
+    }
+
+    /* flows may come from workers on different nodes, sort them out */
+    FlowQueuePrivate per_node[UTIL_NUMA_MAX_NODES];
+    memset(per_node, 0, sizeof(per_node));
+    Flow *f;
+    while ((f = FlowQueuePrivateGetFromTop(fqp)) != NULL) {
+        FlowQueuePrivateAppendFlow(&per_node[f->numa_node], f);
+    }
+    for (uint16_t n = 0; n < nodes; n++) {
+        if (per_node[n].len > 0) {
+            FlowSparePoolReturnFlowsNode(&flow_spare_pools[n], &per_node[n]);
+        }
+    }
+}
+
+static bool FlowSpareGetFromPoolNode(FlowSparePoolNode *n, FlowQueuePrivate *ret)
+{
+    if (n->pool == NULL || n->flow_cnt == 0) {
+        return false;
     }
 
     /* top if full or its the only block we have */
-    if (flow_spare_pool->queue.len >= flow_spare_pool_block_size || flow_spare_pool->next == NULL) {
-        FlowSparePool *p = flow_spare_pool;
-        flow_spare_pool = p->next;
-        DEBUG_VALIDATE_BUG_ON(flow_spare_pool_flow_cnt < p->queue.len);
-        flow_spare_pool_flow_cnt -= p->queue.len;
+    if (n->pool->queue.len >= flow_spare_pool_block_size || n->pool->next == NULL) {
+        FlowSparePool *p = n->pool;
+        n->pool = p->next;
+        DEBUG_VALIDATE_BUG_ON(n->flow_cnt < p->queue.len);
+        n->flow_cnt -= p->queue.len;
 #ifdef FSP_VALIDATE
-        Validate(flow_spare_pool, flow_spare_pool_flow_cnt);
+        Validate(n->pool, n->flow_cnt);
 #endif
-        SCMutexUnlock(&flow_spare_pool_m);
-
-        FlowQueuePrivate ret = p->queue;
+        *ret = p->queue;
         SCFree(p);
-        return ret;
+        return true;
     /* next should always be full if it exists */
-    } else if (flow_spare_pool->next != NULL) {
-        FlowSparePool *p = flow_spare_pool->next;
-        flow_spare_pool->next = p->next;
-        DEBUG_VALIDATE_BUG_ON(flow_spare_pool_flow_cnt < p->queue.len);
-        flow_spare_pool_flow_cnt -= p->queue.len;
+    } else if (n->pool->next != NULL) {
+        FlowSparePool *p = n->pool->next;
+        n->pool->next = p->next;
+        DEBUG_VALIDATE_BUG_ON(n->flow_cnt < p->queue.len);
+        n->flow_cnt -= p->queue.len;
 #ifdef FSP_VALIDATE
-        Validate(flow_spare_pool, flow_spare_pool_flow_cnt);
+        Validate(n->pool, n->flow_cnt);
 #endif
-        SCMutexUnlock(&flow_spare_pool_m);
-
-        FlowQueuePrivate ret = p->queue;
+        *ret = p->queue;
         SCFree(p);
-        return ret;
+        return true;
     }
+    return false;
+}
+
+/** \brief get a block of spare flows
+ *
+ *  Flows allocated for the NUMA node of the calling thread are used first,
+ *  other nodes are only used if its pool is empty.
+ */
+FlowQueuePrivate FlowSpareGetFromPool(void)
+{
+    FlowQueuePrivate ret = { NULL, NULL, 0 };
+    const uint16_t nodes = UtilNumaNodeCount();
+    const uint16_t node = UtilNumaNodeIndex(UtilNumaThreadNode());
 
+    SCMutexLock(&flow_spare_pool_m);
+    for (uint16_t i = 0; i < nodes; i++) {
+        if (FlowSpareGetFromPoolNode(&flow_spare_pools[(node + i) % nodes], &ret))
+            break;
+    }
     SCMutexUnlock(&flow_spare_pool_m);
-    FlowQueuePrivate empty = { NULL, NULL, 0 };
-    return empty;
+    return ret;
 }
 
-void FlowSparePoolUpdate(uint32_t size)
+static void FlowSparePoolUpdateNode(FlowSparePoolNode *n, const uint32_t size, const uint32_t prealloc)
 {
-    const int64_t todo = (int64_t)flow_config.prealloc - (int64_t)size;
+    const int64_t todo = (int64_t)prealloc - (int64_t)size;
     if (todo < 0) {
         uint32_t to_remove = (uint32_t)(todo * -1) / 10;
         while (to_remove) {
@@ -227,15 +278,18 @@ void FlowSparePoolUpdate(uint32_t size)
 
             FlowSparePool *p = NULL;
             SCMutexLock(&flow_spare_pool_m);
-            p = flow_spare_pool;
+            p = n->pool;
             if (p != NULL) {
-                flow_spare_pool = p->next;
-                flow_spare_pool_flow_cnt -= p->queue.len;
+                n->pool = p->next;
+                n->flow_cnt -= p->queue.len;
                 to_remove -= p->queue.len;
             }
             SCMutexUnlock(&flow_spare_pool_m);
 
             if (p != NULL) {
+                /* lockless lookups may still reference the flows */
+                FlowHashReadersSynchronize();
+
                 Flow *f;
                 while ((f = FlowQueuePrivateGetFromTop(&p->queue))) {
                     FlowFree(f);
@@ -271,59 +325,126 @@ void FlowSparePoolUpdate(uint32_t size)
         }
         if (head) {
             SCMutexLock(&flow_spare_pool_m);
-            if (flow_spare_pool == NULL) {
-                flow_spare_pool = head;
+            if (n->pool == NULL) {
+                n->pool = head;
             } else if (tail != NULL) {
                 /* since these are 'full' buckets we don't put them
                  * at the top but right after as the top is likely not
                  * full. */
-                tail->next = flow_spare_pool->next;
-                flow_spare_pool->next = head;
+                tail->next = n->pool->next;
+                n->pool->next = head;
             }
 
-            flow_spare_pool_flow_cnt += flow_cnt;
+            n->flow_cnt += flow_cnt;
 #ifdef FSP_VALIDATE
-            Validate(flow_spare_pool, flow_spare_pool_flow_cnt);
+            Validate(n->pool, n->flow_cnt);
 #endif
             SCMutexUnlock(&flow_spare_pool_m);
         }
     }
 }
 
-void FlowSparePoolInit(void)
+/** \brief check if the per NUMA node pools are out of their 90-110% range
+ *
+ *  The total can be in range while single nodes are not.
+ */
+bool FlowSparePoolNodesNeedUpdate(void)
 {
+    const uint16_t nodes = UtilNumaNodeCount();
+    if (nodes == 1)
+        return false;
+
+    const uint32_t prealloc = (flow_config.prealloc + nodes - 1) / nodes;
+    bool update = false;
     SCMutexLock(&flow_spare_pool_m);
-    for (uint32_t cnt = 0; cnt < flow_config.prealloc; ) {
-        FlowSparePool *p = FlowSpareGetPool();
-        if (p == NULL) {
-            FatalError("failed to initialize flow pool");
+    for (uint16_t node = 0; node < nodes; node++) {
+        const uint32_t spare_perc = flow_spare_pools[node].flow_cnt * 100 / MAX(prealloc, 1);
+        if (spare_perc < 90 || spare_perc > 110) {
+            update = true;
+            break;
         }
-        FlowSparePoolUpdateBlock(p);
-        cnt += p->queue.len;
+    }
+    SCMutexUnlock(&flow_spare_pool_m);
+    return update;
+}
 
-        /* prepend to list */
-        p->next = flow_spare_pool;
-        flow_spare_pool = p;
-        flow_spare_pool_flow_cnt = cnt;
+/** \brief grow or shrink the spare pools towards flow.prealloc
+ *
+ *  \param size current number of spare flows
+ *
+ *  With NUMA awareness the prealloc is split over the nodes. Each node is
+ *  updated on its own, as workers drain the pool of their node only.
+ */
+void FlowSparePoolUpdate(uint32_t size)
+{
+    const uint16_t nodes = UtilNumaNodeCount();
+    if (nodes == 1) {
+        FlowSparePoolUpdateNode(&flow_spare_pools[0], size, flow_config.prealloc);
+        return;
     }
+
+    const uint32_t prealloc = (flow_config.prealloc + nodes - 1) / nodes;
+    for (uint16_t node = 0; node < nodes; node++) {
+        FlowSparePoolNode *n = &flow_spare_pools[node];
+        SCMutexLock(&flow_spare_pool_m);
+        const uint32_t node_size = n->flow_cnt;
+        SCMutexUnlock(&flow_spare_pool_m);
+
+        const uint32_t spare_perc = node_size * 100 / MAX(prealloc, 1);
+        if (spare_perc < 90 || spare_perc > 110) {
+            UtilNumaSetPreferredNode(node);
+            FlowSparePoolUpdateNode(n, node_size, prealloc);
+            UtilNumaSetPreferredNode(-1);
+        }
+    }
+}
+
+void FlowSparePoolInit(void)
+{
+    const uint16_t nodes = UtilNumaNodeCount();
+    const uint32_t prealloc = (flow_config.prealloc + nodes - 1) / nodes;
+
+    SCMutexLock(&flow_spare_pool_m);
+    for (uint16_t node = 0; node < nodes; node++) {
+        FlowSparePoolNode *n = &flow_spare_pools[node];
+        if (nodes > 1)
+            UtilNumaSetPreferredNode(node);
+        for (uint32_t cnt = 0; cnt < prealloc; ) {
+            FlowSparePool *p = FlowSpareGetPool();
+            if (p == NULL) {
+                FatalError("failed to initialize flow pool");
+            }
+            FlowSparePoolUpdateBlock(p);
+            cnt += p->queue.len;
+
+            /* prepend to list */
+            p->next = n->pool;
+            n->pool = p;
+            n->flow_cnt = cnt;
+        }
+    }
+    UtilNumaSetPreferredNode(-1);
     SCMutexUnlock(&flow_spare_pool_m);
 }
 
 void FlowSparePoolDestroy(void)
 {
     SCMutexLock(&flow_spare_pool_m);
-    for (FlowSparePool *p = flow_spare_pool; p != NULL; ) {
-        uint32_t cnt = 0;
-        Flow *f;
-        while ((f = FlowQueuePrivateGetFromTop(&p->queue))) {
-            FlowFree(f);
-            cnt++;
+    for (uint16_t node = 0; node < UTIL_NUMA_MAX_NODES; node++) {
+        FlowSparePoolNode *n = &flow_spare_pools[node];
+        for (FlowSparePool *p = n->pool; p != NULL; ) {
+            uint32_t cnt = 0;
+            Flow *f;
+            while ((f = FlowQueuePrivateGetFromTop(&p->queue))) {
+                FlowFree(f);
+                cnt++;
+            }
+            n->flow_cnt -= cnt;
+            FlowSparePool *next = p->next;
+            SCFree(p);
+            p = next;
         }
-        flow_spare_pool_flow_cnt -= cnt;
-        FlowSparePool *next = p->next;
-        SCFree(p);
-        p = next;
+        n->pool = NULL;
     }
-    flow_spare_pool = NULL;
     SCMutexUnlock(&flow_spare_pool_m);
 }
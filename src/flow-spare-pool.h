@@ -30,6 +30,7 @@
 void FlowSparePoolInit(void);
 void FlowSparePoolDestroy(void);
 void FlowSparePoolUpdate(uint32_t size);
+bool FlowSparePoolNodesNeedUpdate(void);
 
 uint32_t FlowSpareGetPoolSize(void);
 
@@ -35,6 +35,8 @@
 #include "util-var.h"
 #include "util-debug.h"
 #include "util-macset.h"
+#include "util-numa.h"
+#include "util-arena.h"
 #include "flow-storage.h"
 
 #include "detect.h"
@@ -44,6 +46,22 @@
 
 #include "util-validate.h"
 
+/** flows are carved from this arena if arena.enabled is set */
+static Arena *flow_arena = NULL;
+
+void FlowArenaInit(void)
+{
+    if (ArenaEnabled()) {
+        flow_arena = ArenaCreate("flow", sizeof(Flow) + FlowStorageSize());
+    }
+}
+
+void FlowArenaDestroy(void)
+{
+    ArenaDestroy(flow_arena);
+    flow_arena = NULL;
+}
+
 /** \brief allocate a flow
  *
  *  We check against the memuse counter. If it passes that check we increment
@@ -62,7 +80,11 @@ Flow *FlowAlloc(void)
 
     (void) SC_ATOMIC_ADD(flow_memuse, size);
 
-    f = SCMalloc(size);
+    if (flow_arena != NULL) {
+        f = ArenaAlloc(flow_arena);
+    } else {
+        f = SCMalloc(size);
+    }
     if (unlikely(f == NULL)) {
         (void)SC_ATOMIC_SUB(flow_memuse, size);
         return NULL;
@@ -71,6 +93,8 @@ Flow *FlowAlloc(void)
 
     /* coverity[missing_lock] */
     FLOW_INITIALIZE(f);
+    f->numa_node = (uint8_t)UtilNumaNodeIndex(UtilNumaThreadNode());
+    UtilNumaMemoryAdd(f->numa_node, size);
     return f;
 }
 
@@ -82,11 +106,17 @@ Flow *FlowAlloc(void)
  */
 void FlowFree(Flow *f)
 {
+    const uint8_t numa_node = f->numa_node;
     FLOW_DESTROY(f);
-    SCFree(f);
+    if (flow_arena != NULL) {
+        ArenaFree(flow_arena, f);
+    } else {
+        SCFree(f);
+    }
 
     size_t size = sizeof(Flow) + FlowStorageSize();
     (void) SC_ATOMIC_SUB(flow_memuse, size);
+    UtilNumaMemorySub(numa_node, size);
 }
 
 /**
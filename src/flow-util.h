@@ -143,6 +143,8 @@
     ((((uint64_t)SC_ATOMIC_GET(flow_memuse) + (uint64_t)(size)) <=                                 \
             SC_ATOMIC_GET(flow_config.memcap)))
 
+void FlowArenaInit(void);
+void FlowArenaDestroy(void);
 Flow *FlowAlloc(void);
 void FlowFree(Flow *);
 uint8_t FlowGetProtoMapping(uint8_t);
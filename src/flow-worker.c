@@ -50,6 +50,7 @@
 #include "util-time.h"
 #include "tmqh-packetpool.h"
 
+#include "flow-hash.h"
 #include "flow-util.h"
 #include "flow-manager.h"
 #include "flow-timeout.h"
@@ -291,6 +292,10 @@ static TmEcode FlowWorkerThreadInit(ThreadVars *tv, const void *initdata, void *
         return TM_ECODE_FAILED;
     }
 
+    /* lookups of existing flows don't need the bucket lock */
+    fw->fls.reader = FlowHashReaderRegister();
+    fw->fls.hash_shard = FlowHashShardAssign();
+
     /* setup TCP */
     if (StreamTcpThreadInit(tv, NULL, &fw->stream_thread_ptr) != TM_ECODE_OK) {
         FlowWorkerThreadDeinit(tv, fw);
@@ -351,6 +356,11 @@ static TmEcode FlowWorkerThreadDeinit(ThreadVars *tv, void *data)
     /* free pq */
     BUG_ON(fw->pq.len);
 
+    FlowHashReaderDeregister(fw->fls.reader);
+    fw->fls.reader = NULL;
+    /* other workers may still be walking buckets */
+    FlowHashReadersSynchronize();
+
     Flow *f;
     while ((f = FlowQueuePrivateGetFromTop(&fw->fls.spare_queue)) != NULL) {
         FlowFree(f);
@@ -702,6 +712,22 @@ void *FlowWorkerGetDetectCtxPtr(void *flow_worker)
     return SC_ATOMIC_GET(fw->detect_thread);
 }
 
+/** \brief prefetch the flow hash buckets for a batch of packets
+ *
+ *  Called before a batch is run through the flow worker, so the cache misses
+ *  on the buckets overlap instead of stalling each lookup in turn.
+ */
+void FlowWorkerPrefetch(void *flow_worker, Packet **pkts, uint32_t cnt)
+{
+    FlowWorkerThreadData *fw = flow_worker;
+
+    for (uint32_t i = 0; i < cnt; i++) {
+        if (pkts[i]->flags & PKT_WANTS_FLOW) {
+            FlowHashPrefetch(&fw->fls, pkts[i]->flow_hash);
+        }
+    }
+}
+
 const char *ProfileFlowWorkerIdToString(enum ProfileFlowWorkerId fwi)
 {
     switch (fwi) {
@@ -32,6 +32,7 @@ const char *ProfileFlowWorkerIdToString(enum ProfileFlowWorkerId fwi);
 
 void FlowWorkerReplaceDetectCtx(void *flow_worker, void *detect_ctx);
 void *FlowWorkerGetDetectCtxPtr(void *flow_worker);
+void FlowWorkerPrefetch(void *flow_worker, Packet **pkts, uint32_t cnt);
 
 void TmModuleFlowWorkerRegister (void);
 
@@ -561,6 +561,8 @@ void FlowInitConfig(bool quiet)
     flow_config.hash_rand   = (uint32_t)RandomGet();
     flow_config.hash_size   = FLOW_DEFAULT_HASHSIZE;
     flow_config.prealloc    = FLOW_DEFAULT_PREALLOC;
+    flow_config.hash_shards = 0;
+    flow_config.hash_shard_size = 0;
     SC_ATOMIC_SET(flow_config.memcap, FLOW_DEFAULT_MEMCAP);
 
     /* If we have specific config, overwrite the defaults with them,
@@ -623,6 +625,32 @@ void FlowInitConfig(bool quiet)
         }
     }
 
+    if ((ConfGet("flow.hash-shards", &conf_val)) == 1 && conf_val != NULL) {
+        if (StringParseUint32(&configval, 10, strlen(conf_val), conf_val) <= 0 ||
+                configval > flow_config.hash_size) {
+            FatalError("Invalid value for flow.hash-shards: %s", conf_val);
+        }
+        if (configval == 0) {
+            FatalError("Invalid value for flow.hash-shards: %s, must be 1 or more", conf_val);
+        } else if (configval == 1) {
+            SCLogConfig("flow.hash-shards is 1: flow hash sharding disabled");
+        } else {
+            flow_config.hash_shards = configval;
+            flow_config.hash_shard_size =
+                    (flow_config.hash_size + configval - 1) / flow_config.hash_shards;
+            const uint32_t hash_size = flow_config.hash_shards * flow_config.hash_shard_size;
+            if (hash_size != flow_config.hash_size) {
+                SCLogConfig("flow.hash-size %" PRIu32 " is not a multiple of flow.hash-shards "
+                            "%" PRIu32 ", using hash-size %" PRIu32,
+                        flow_config.hash_size, flow_config.hash_shards, hash_size);
+                flow_config.hash_size = hash_size;
+            }
+            SCLogConfig("flow hash split into %" PRIu32 " per thread shards of %" PRIu32
+                        " buckets",
+                    flow_config.hash_shards, flow_config.hash_shard_size);
+        }
+    }
+
     flow_config.memcap_policy = ExceptionPolicyParse("flow.memcap-policy", false);
 
     SCLogDebug("Flow config from suricata.yaml: memcap: %"PRIu64", hash-size: "
@@ -650,6 +678,7 @@ void FlowInitConfig(bool quiet)
     for (i = 0; i < flow_config.hash_size; i++) {
         FBLOCK_INIT(&flow_hash[i]);
         SC_ATOMIC_INIT(flow_hash[i].next_ts);
+        SC_ATOMIC_INIT(flow_hash[i].seq);
     }
     (void) SC_ATOMIC_ADD(flow_memuse, (flow_config.hash_size * sizeof(FlowBucket)));
 
@@ -659,6 +688,7 @@ void FlowInitConfig(bool quiet)
                   SC_ATOMIC_GET(flow_memuse), flow_config.hash_size,
                   (uintmax_t)sizeof(FlowBucket));
     }
+    FlowArenaInit();
     FlowSparePoolInit();
     if (!quiet) {
         SCLogConfig("flow memory usage: %"PRIu64" bytes, maximum: %"PRIu64,
@@ -728,6 +758,7 @@ void FlowShutdown(void)
     (void) SC_ATOMIC_SUB(flow_memuse, flow_config.hash_size * sizeof(FlowBucket));
     FlowQueueDestroy(&flow_recycle_q);
     FlowSparePoolDestroy();
+    FlowArenaDestroy();
     return;
 }
 
@@ -1456,6 +1487,85 @@ static int FlowTest09 (void)
     return result;
 }
 
+
+/** \test existing flows are found without locking the bucket */
+static int FlowTest10(void)
+{
+    FlowInitConfig(FLOW_QUIET);
+
+    FlowLookupStruct fls;
+    memset(&fls, 0, sizeof(fls));
+    fls.reader = FlowHashReaderRegister();
+    FAIL_IF_NULL(fls.reader);
+
+    uint8_t payload[] = "Payload";
+    Packet *p1 = UTHBuildPacket(payload, sizeof(payload), IPPROTO_UDP);
+    FAIL_IF_NULL(p1);
+    FlowHandlePacket(NULL, &fls, p1);
+    FAIL_IF_NULL(p1->flow);
+    Flow *f = p1->flow;
+    FLOWLOCK_UNLOCK(f);
+
+    FlowBucket *fb = f->fb;
+    FAIL_IF_NULL(fb);
+    const uint32_t seq = SC_ATOMIC_GET(fb->seq);
+    FAIL_IF(seq & 1);
+
+    Packet *p2 = UTHBuildPacket(payload, sizeof(payload), IPPROTO_UDP);
+    FAIL_IF_NULL(p2);
+    FlowHandlePacket(NULL, &fls, p2);
+    FAIL_IF(p2->flow != f);
+    FLOWLOCK_UNLOCK(f);
+    /* the bucket lock was not taken */
+    FAIL_IF(SC_ATOMIC_GET(fb->seq) != seq);
+
+    FlowHashReaderDeregister(fls.reader);
+    UTHFreePacket(p1);
+    UTHFreePacket(p2);
+    Flow *qf;
+    while ((qf = FlowQueuePrivateGetFromTop(&fls.spare_queue))) {
+        FlowFree(qf);
+    }
+    FlowShutdown();
+    PASS;
+}
+
+/** \test flows of a worker are kept in its slice of the hash */
+static int FlowTest11(void)
+{
+    ConfCreateContextBackup();
+    ConfInit();
+    ConfSet("flow.hash-size", "1000");
+    ConfSet("flow.hash-shards", "3");
+    FlowInitConfig(FLOW_QUIET);
+    FAIL_IF(flow_config.hash_shards != 3);
+    FAIL_IF(flow_config.hash_shard_size != 334);
+    FAIL_IF(flow_config.hash_size != 1002);
+
+    FlowLookupStruct fls;
+    memset(&fls, 0, sizeof(fls));
+    fls.hash_shard = 2;
+
+    uint8_t payload[] = "Payload";
+    Packet *p = UTHBuildPacket(payload, sizeof(payload), IPPROTO_UDP);
+    FAIL_IF_NULL(p);
+    p->flow_hash = 12345;
+    FlowHandlePacket(NULL, &fls, p);
+    FAIL_IF_NULL(p->flow);
+    FLOWLOCK_UNLOCK(p->flow);
+    const ptrdiff_t idx = p->flow->fb - flow_hash;
+    FAIL_IF(idx != 2 * 334 + 12345 % 334);
+
+    UTHFreePacket(p);
+    Flow *qf;
+    while ((qf = FlowQueuePrivateGetFromTop(&fls.spare_queue))) {
+        FlowFree(qf);
+    }
+    FlowShutdown();
+    ConfDeInit();
+    ConfRestoreContextBackup();
+    PASS;
+}
 #endif /* UNITTESTS */
 
 /**
@@ -1473,6 +1583,8 @@ void FlowRegisterTests (void)
                    FlowTest08);
     UtRegisterTest("FlowTest09 -- Test flow Allocations when it reach memcap",
                    FlowTest09);
+    UtRegisterTest("FlowTest10 -- Test lockless lookup of existing flows", FlowTest10);
+    UtRegisterTest("FlowTest11 -- Test per thread hash shards", FlowTest11);
 
     RegisterFlowStorageTests();
 #endif /* UNITTESTS */
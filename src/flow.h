@@ -287,6 +287,11 @@ typedef struct FlowCnf_
     uint32_t hash_size;
     uint32_t prealloc;
 
+    /** number of per thread slices of the hash, 0 for a shared hash */
+    uint32_t hash_shards;
+    /** buckets per slice */
+    uint32_t hash_shard_size;
+
     uint32_t timeout_new;
     uint32_t timeout_est;
 
@@ -381,6 +386,11 @@ typedef struct Flow_
         uint8_t ffr;
     };
 
+    /** pool index (UtilNumaNodeIndex) of the NUMA node the flow memory was
+     *  allocated for, selects the spare pool it is returned to. Set at
+     *  alloc, kept on recycle. */
+    uint8_t numa_node;
+
     /** timestamp in seconds of the moment this flow will timeout
      *  according to the timeout policy. Does *not* take emergency
      *  mode into account. */
@@ -536,6 +546,10 @@ typedef struct FlowLookupStruct_ // TODO name
     DecodeThreadVars *dtv;
     FlowQueuePrivate work_queue;
     uint32_t emerg_spare_sync_stamp;
+    /** lockless lookup state, NULL if lookups always lock the bucket */
+    struct FlowHashReader_ *reader;
+    /** slice of the hash owned by this thread, see flow.hash-shards */
+    uint32_t hash_shard;
 } FlowLookupStruct;
 
 /** \brief prepare packet for a life with flow
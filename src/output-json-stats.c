@@ -100,6 +100,29 @@ static json_t *EngineStats2Json(const DetectEngineCtx *de_ctx,
                             json_integer(sig_stat->bad_sigs_total));
     }
 
+    if (output == OUTPUT_ENGINE_RULESET || output == OUTPUT_ENGINE_ALL) {
+        const SigGroupBuildStat *build = &de_ctx->sgh_build_stat;
+        json_t *js_build = json_object();
+        if (js_build != NULL) {
+            json_object_set_new(js_build, "threads", json_integer(build->threads));
+            json_object_set_new(js_build, "grouping_usec", json_integer(build->grouping));
+            json_object_set_new(
+                    js_build, "match_arrays_usec", json_integer(build->match_arrays));
+            json_object_set_new(js_build, "prefilter_usec", json_integer(build->prefilter));
+            json_object_set_new(js_build, "mpm_compile_usec", json_integer(build->mpm_compile));
+            json_object_set_new(
+                    js_build, "non_prefilter_arrays_usec", json_integer(build->non_pf_arrays));
+            json_object_set_new(js_build, "finalize_usec", json_integer(build->finalize));
+            json_object_set_new(js_build, "total_usec", json_integer(build->total));
+            json_object_set_new(
+                    js_build, "non_prefilter_groups", json_integer(build->non_pf_groups));
+            json_object_set_new(js_build, "non_prefilter_rules", json_integer(build->non_pf_rules));
+            json_object_set_new(js_build, "non_prefilter_max",
+                    json_integer(de_ctx->non_pf_store_cnt_max));
+            json_object_set_new(jdata, "rule_group_build", js_build);
+        }
+    }
+
     return jdata;
 }
 
@@ -181,6 +181,7 @@ static void *ParseAFXDPConfig(const char *iface)
     aconf->threads = 1;
     aconf->promisc = 1;
     aconf->enable_busy_poll = true;
+    aconf->use_need_wakeup = true;
     aconf->busy_poll_time = DEFAULT_BUSY_POLL_TIME;
     aconf->busy_poll_budget = DEFAULT_BUSY_POLL_BUDGET;
     aconf->mode = XDP_FLAGS_UPDATE_IF_NOEXIST;
@@ -261,6 +262,26 @@ static void *ParseAFXDPConfig(const char *iface)
         }
     }
 
+    /* only wake up the kernel with a syscall when it asks for it */
+    if (ConfGetChildValueBoolWithDefault(if_root, if_default, "use-need-wakeup", &conf_val) == 1) {
+        if (conf_val == 0) {
+            aconf->use_need_wakeup = false;
+        }
+    }
+
+    /* packets larger than a frame are spread over multiple descriptors */
+    if (ConfGetChildValueBoolWithDefault(if_root, if_default, "enable-multi-buffer", &conf_val) ==
+                    1 &&
+            conf_val) {
+#ifdef XDP_USE_SG
+        aconf->multi_buffer = true;
+#else
+        SCLogWarning("%s: multi-buffer is not supported by this system, Linux 6.6 or newer is "
+                     "needed",
+                iface);
+#endif
+    }
+
     /* Busy polling options */
     if (ConfGetChildValueBoolWithDefault(if_root, if_default, "enable-busy-poll", &conf_val) == 1) {
         if (conf_val == 0) {
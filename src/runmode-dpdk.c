@@ -92,6 +92,7 @@ static bool ConfigSetPromiscuousMode(DPDKIfaceConfig *iconf, int entry_bool);
 static bool ConfigSetMulticast(DPDKIfaceConfig *iconf, int entry_bool);
 static int ConfigSetChecksumChecks(DPDKIfaceConfig *iconf, int entry_bool);
 static int ConfigSetChecksumOffload(DPDKIfaceConfig *iconf, int entry_bool);
+static int ConfigSetMbufPackets(DPDKIfaceConfig *iconf, int entry_bool);
 static int ConfigSetCopyIface(DPDKIfaceConfig *iconf, const char *entry_str);
 static int ConfigSetCopyMode(DPDKIfaceConfig *iconf, const char *entry_str);
 static int ConfigSetCopyIfaceSettings(DPDKIfaceConfig *iconf, const char *iface, const char *mode);
@@ -120,6 +121,7 @@ static void DPDKDerefConfig(void *conf);
 #define DPDK_CONFIG_DEFAULT_MULTICAST_MODE              1
 #define DPDK_CONFIG_DEFAULT_CHECKSUM_VALIDATION         1
 #define DPDK_CONFIG_DEFAULT_CHECKSUM_VALIDATION_OFFLOAD 1
+#define DPDK_CONFIG_DEFAULT_MBUF_PACKETS                1
 #define DPDK_CONFIG_DEFAULT_COPY_MODE                   "none"
 #define DPDK_CONFIG_DEFAULT_COPY_INTERFACE              "none"
 
@@ -129,6 +131,7 @@ DPDKIfaceConfigAttributes dpdk_yaml = {
     .multicast = "multicast",
     .checksum_checks = "checksum-checks",
     .checksum_checks_offload = "checksum-checks-offload",
+    .mbuf_packets = "mbuf-packets",
     .mtu = "mtu",
     .rss_hf = "rss-hash-functions",
     .mempool_size = "mempool-size",
@@ -309,6 +312,8 @@ static void DPDKDerefConfig(void *conf)
 
     if (SC_ATOMIC_SUB(iconf->ref, 1) == 1) {
         if (iconf->pkt_mempool != NULL) {
+            if (iconf->flags & DPDK_MBUF_PACKETS)
+                DPDKMbufPacketsDestroy(iconf->pkt_mempool);
             rte_mempool_free(iconf->pkt_mempool);
         }
 
@@ -551,6 +556,15 @@ static int ConfigSetChecksumOffload(DPDKIfaceConfig *iconf, int entry_bool)
     SCReturnInt(0);
 }
 
+static int ConfigSetMbufPackets(DPDKIfaceConfig *iconf, int entry_bool)
+{
+    SCEnter();
+    if (entry_bool)
+        iconf->flags |= DPDK_MBUF_PACKETS;
+
+    SCReturnInt(0);
+}
+
 static int ConfigSetCopyIface(DPDKIfaceConfig *iconf, const char *entry_str)
 {
     SCEnter();
@@ -732,6 +746,13 @@ static int ConfigLoad(DPDKIfaceConfig *iconf, const char *iface)
     if (retval < 0)
         SCReturnInt(retval);
 
+    retval = ConfGetChildValueBoolWithDefault(
+                     if_root, if_default, dpdk_yaml.mbuf_packets, &entry_bool) != 1
+                     ? ConfigSetMbufPackets(iconf, DPDK_CONFIG_DEFAULT_MBUF_PACKETS)
+                     : ConfigSetMbufPackets(iconf, entry_bool);
+    if (retval < 0)
+        SCReturnInt(retval);
+
     retval = ConfGetChildValueWithDefault(if_root, if_default, dpdk_yaml.copy_mode, &copy_mode_str);
     if (retval != 1)
         SCReturnInt(-ENOENT);
@@ -1107,6 +1128,7 @@ static int DeviceConfigureQueues(DPDKIfaceConfig *iconf, const struct rte_eth_de
     int retval;
     uint16_t mtu_size;
     uint16_t mbuf_size;
+    uint16_t priv_size;
     struct rte_eth_rxconf rxq_conf;
     struct rte_eth_txconf txq_conf;
 
@@ -1115,17 +1137,32 @@ static int DeviceConfigureQueues(DPDKIfaceConfig *iconf, const struct rte_eth_de
     // +4 for VLAN header
     mtu_size = iconf->mtu + RTE_ETHER_CRC_LEN + RTE_ETHER_HDR_LEN + 4;
     mbuf_size = ROUNDUP(mtu_size, 1024) + RTE_PKTMBUF_HEADROOM;
-    SCLogInfo("%s: creating packet mbuf pool %s of size %d, cache size %d, mbuf size %d",
-            iconf->iface, mempool_name, iconf->mempool_size, iconf->mempool_cache_size, mbuf_size);
+    // Packets of the workers live in the private area of the mbufs
+    priv_size = 0;
+    if (iconf->flags & DPDK_MBUF_PACKETS) {
+        priv_size = DPDKMbufPacketPrivSize();
+        if (priv_size == 0) {
+            SCLogWarning("%s: Packet does not fit in the mbuf private area, "
+                         "disabling mbuf-packets",
+                    iconf->iface);
+            iconf->flags &= ~DPDK_MBUF_PACKETS;
+        }
+    }
+    SCLogInfo("%s: creating packet mbuf pool %s of size %d, cache size %d, mbuf size %d, "
+              "private size %d",
+            iconf->iface, mempool_name, iconf->mempool_size, iconf->mempool_cache_size, mbuf_size,
+            priv_size);
 
     iconf->pkt_mempool = rte_pktmbuf_pool_create(mempool_name, iconf->mempool_size,
-            iconf->mempool_cache_size, 0, mbuf_size, (int)iconf->socket_id);
+            iconf->mempool_cache_size, priv_size, mbuf_size, (int)iconf->socket_id);
     if (iconf->pkt_mempool == NULL) {
         retval = -rte_errno;
         SCLogError("%s: rte_pktmbuf_pool_create failed with code %d (mempool: %s) - %s",
                 iconf->iface, rte_errno, mempool_name, rte_strerror(rte_errno));
         SCReturnInt(retval);
     }
+    if (iconf->flags & DPDK_MBUF_PACKETS)
+        DPDKMbufPacketsInit(iconf->pkt_mempool);
 
     for (uint16_t queue_id = 0; queue_id < iconf->nb_rx_queues; queue_id++) {
         rxq_conf = dev_info->default_rxconf;
@@ -1144,6 +1181,8 @@ static int DeviceConfigureQueues(DPDKIfaceConfig *iconf, const struct rte_eth_de
         retval = rte_eth_rx_queue_setup(iconf->port_id, queue_id, iconf->nb_rx_desc,
                 iconf->socket_id, &rxq_conf, iconf->pkt_mempool);
         if (retval < 0) {
+            if (iconf->flags & DPDK_MBUF_PACKETS)
+                DPDKMbufPacketsDestroy(iconf->pkt_mempool);
             rte_mempool_free(iconf->pkt_mempool);
             SCLogError(
                     "%s: rte_eth_rx_queue_setup failed with code %d for device queue %u of port %u",
@@ -1159,6 +1198,8 @@ static int DeviceConfigureQueues(DPDKIfaceConfig *iconf, const struct rte_eth_de
         retval = rte_eth_tx_queue_setup(
                 iconf->port_id, queue_id, iconf->nb_tx_desc, iconf->socket_id, &txq_conf);
         if (retval < 0) {
+            if (iconf->flags & DPDK_MBUF_PACKETS)
+                DPDKMbufPacketsDestroy(iconf->pkt_mempool);
             rte_mempool_free(iconf->pkt_mempool);
             SCLogError(
                     "%s: rte_eth_tx_queue_setup failed with code %d for device queue %u of port %u",
@@ -1476,6 +1517,7 @@ static void *ParseDpdkConfigAndConfigureDevice(const char *iface)
         FatalError("Device %s is not registered as a live device", iface);
     }
     ldev_instance->dpdk_vars.pkt_mp = iconf->pkt_mempool;
+    ldev_instance->dpdk_vars.mbuf_packets = (iconf->flags & DPDK_MBUF_PACKETS) != 0;
     return iconf;
 }
 
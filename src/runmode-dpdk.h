@@ -29,6 +29,7 @@ typedef struct DPDKIfaceConfigAttributes_ {
     const char *multicast;
     const char *checksum_checks;
     const char *checksum_checks_offload;
+    const char *mbuf_packets;
     const char *mtu;
     const char *rss_hf;
     const char *mempool_size;
@@ -3,7 +3,7 @@
  */
 
 /**
- * \ingroup lipcppacket
+ * \ingroup lipcpacket
  *
  * @{
  */
@@ -17,47 +17,209 @@
  *
  */
 
+#include "suricata-common.h"
+#include "suricata.h"
+#include "tm-threads.h"
+#include "conf.h"
 #include "runmodes.h"
+#include "runmode-lipc.h"
+#include "decode.h"
+
+#include "util-byte.h"
+#include "util-cpu.h"
+#include "util-debug.h"
 #include "util-runmodes.h"
 
 #include "source-lipc.h"
 
-extern uint16_t max_pending_packets;
+#define LIPC_DEFAULT_BUFFER_SIZE 4096
+#define LIPC_DEFAULT_RING_SLOTS 4096
+#define LIPC_DEFAULT_RING_SLOT_SIZE 2048
+#define LIPC_DEFAULT_RING_POLL_SPINS 1000
+#define LIPC_DEFAULT_VERDICT_BATCH 32
+#define LIPC_MAX_VERDICT_BATCH 1024
+#define LIPC_DEFAULT_VERDICT_FLUSH_USEC 100
+
+const char *RunModeLIPCGetDefaultMode(void)
+{
+    return "workers";
+}
+
+static void LIPCDerefConfig(void *data)
+{
+    LIPCIfaceConfig *cfg = (LIPCIfaceConfig *)data;
+    if (SC_ATOMIC_SUB(cfg->ref, 1) <= 1) {
+        SCFree(cfg);
+    }
+}
 
 static int LIPCConfigGeThreadsCount(void *conf)
 {
     return ((LIPCIfaceConfig *)conf)->threads;
 }
 
-static void* ParseLIPCConfig(char const * data) {
-    if (NULL == data) { return NULL; }
+static int LIPCConfigSetThreads(LIPCIfaceConfig *cfg, const char *str)
+{
+    const char *active_runmode = RunmodeGetActive();
+    if (active_runmode && !strcmp("single", active_runmode)) {
+        cfg->threads = 1;
+        return 0;
+    }
+
+    if (strcmp(str, "auto") == 0) {
+        cfg->threads = (int)UtilCpuGetNumProcessorsOnline();
+    } else if (StringParseInt32(&cfg->threads, 10, 0, str) < 0) {
+        SCLogError("lipc.threads contains non-numerical characters - \"%s\"", str);
+        return -1;
+    }
+    if (cfg->threads <= 0) {
+        cfg->threads = 1;
+    }
+    SCLogPerf("LIPC: using %d threads, one client connection per thread", cfg->threads);
+    return 0;
+}
 
-    LIPCIFaceConfig * cfg = SCMalloc(sizeof(*cfg));
-    if (NULL == cfg) {
+static int LIPCParseDatalink(const char *str)
+{
+    if (strcasecmp(str, "ethernet") == 0) {
+        return LINKTYPE_ETHERNET;
+    } else if (strcasecmp(str, "raw") == 0) {
+        return LINKTYPE_RAW;
+    }
+    return -1;
+}
+
+/**
+ * \brief extract information from the lipc config section
+ *
+ * The returned structure is dereferenced by each thread init function.
+ */
+static void *ParseLIPCConfig(const char *iface)
+{
+    intmax_t value = 0;
+    int boolval = 0;
+    const char *str = NULL;
+
+    if (iface == NULL) {
+        return NULL;
+    }
+
+    LIPCIfaceConfig *cfg = SCCalloc(1, sizeof(*cfg));
+    if (unlikely(cfg == NULL)) {
         return NULL;
     }
     SC_ATOMIC_INIT(cfg->ref);
     cfg->DerefFunc = LIPCDerefConfig;
     cfg->threads = 1;
-    cfg->req_buffer_size = 4096;
+    cfg->req_buffer_size = LIPC_DEFAULT_BUFFER_SIZE;
+    cfg->datalink = LINKTYPE_RAW;
+    cfg->ring = true;
+    cfg->ring_slots = LIPC_DEFAULT_RING_SLOTS;
+    cfg->ring_slot_size = LIPC_DEFAULT_RING_SLOT_SIZE;
+    cfg->ring_poll_spins = LIPC_DEFAULT_RING_POLL_SPINS;
+    cfg->verdict_batch = LIPC_DEFAULT_VERDICT_BATCH;
+    cfg->verdict_flush_usec = LIPC_DEFAULT_VERDICT_FLUSH_USEC;
+
+    ConfNode *node = ConfGetNode("lipc");
+    if (node == NULL) {
+        SCLogInfo("unable to find lipc config using default values");
+        goto finalize;
+    }
+
+    if (ConfGetChildValue(node, "threads", &str) == 1) {
+        if (LIPCConfigSetThreads(cfg, str) != 0) {
+            SCFree(cfg);
+            return NULL;
+        }
+    }
 
+    if (ConfGetChildValueInt(node, "buffer-size", &value) == 1) {
+        if (value < (intmax_t)sizeof(struct av_request) || value > UINT16_MAX) {
+            SCLogWarning("lipc.buffer-size %" PRIdMAX " out of range, using %d", value,
+                    LIPC_DEFAULT_BUFFER_SIZE);
+        } else {
+            cfg->req_buffer_size = (int)value;
+        }
+    }
+
+    if (ConfGetChildValue(node, "datalink", &str) == 1) {
+        int datalink = LIPCParseDatalink(str);
+        if (datalink < 0) {
+            SCLogWarning("invalid lipc.datalink \"%s\", using raw", str);
+        } else {
+            cfg->datalink = datalink;
+        }
+    }
+
+    if (ConfGetChildValueBool(node, "ring", &boolval) == 1) {
+        cfg->ring = boolval != 0;
+    }
+    if (ConfGetChildValueInt(node, "ring-slots", &value) == 1) {
+        if (value <= 0 || value > (1 << 20) || (value & (value - 1)) != 0) {
+            SCLogWarning("lipc.ring-slots must be a power of 2 up to %d, using %d", 1 << 20,
+                    LIPC_DEFAULT_RING_SLOTS);
+        } else {
+            cfg->ring_slots = (uint32_t)value;
+        }
+    }
+    if (ConfGetChildValueInt(node, "ring-slot-size", &value) == 1) {
+        if (value < 64 || value > MAX_PAYLOAD_SIZE) {
+            SCLogWarning("lipc.ring-slot-size %" PRIdMAX " out of range, using %d", value,
+                    LIPC_DEFAULT_RING_SLOT_SIZE);
+        } else {
+            cfg->ring_slot_size = (uint32_t)value;
+        }
+    }
+    if (ConfGetChildValueInt(node, "ring-poll-spins", &value) == 1) {
+        if (value < 0 || value > UINT32_MAX) {
+            SCLogWarning("lipc.ring-poll-spins %" PRIdMAX " out of range, using %d", value,
+                    LIPC_DEFAULT_RING_POLL_SPINS);
+        } else {
+            cfg->ring_poll_spins = (uint32_t)value;
+        }
+    }
+
+    if (ConfGetChildValueInt(node, "verdict-batch", &value) == 1) {
+        if (value < 1 || value > LIPC_MAX_VERDICT_BATCH) {
+            SCLogWarning("lipc.verdict-batch must be between 1 and %d, using %d", LIPC_MAX_VERDICT_BATCH,
+                    LIPC_DEFAULT_VERDICT_BATCH);
+        } else {
+            cfg->verdict_batch = (uint32_t)value;
+        }
+    }
+    if (ConfGetChildValueInt(node, "verdict-flush-usec", &value) == 1) {
+        if (value < 0 || value >= 1000000) {
+            SCLogWarning("lipc.verdict-flush-usec must be below 1000000, using %d",
+                    LIPC_DEFAULT_VERDICT_FLUSH_USEC);
+        } else {
+            cfg->verdict_flush_usec = (uint32_t)value;
+        }
+    }
+
+finalize:
+    SC_ATOMIC_RESET(cfg->ref);
+    (void)SC_ATOMIC_ADD(cfg->ref, cfg->threads);
+
+    SCLogConfig("LIPC: %s transport, %s datalink", cfg->ring ? "socket and ring" : "socket",
+            cfg->datalink == LINKTYPE_ETHERNET ? "ethernet" : "raw");
     return cfg;
 }
 
-int RunModLIPCSingle(void) {
+static void LIPCRunModeEnableIPS(void)
+{
+    SCLogInfo("Setting IPS mode");
+    EngineModeSetIPS();
+}
+
+int RunModeLIPCSingle(void)
+{
     SCEnter();
 
-    RunModInitialize();
+    RunModeInitialize();
     TimeModeSetLive();
 
-    SCLogDebug("RunModeLIPCSingle initialised");
-    int r = RunModeSetLiveLiveCaptureSingle(
-            ParseLIPCConfig,
-            LIPCConfigGeThreadsCount,
-            "ReceiveLIPC", "DecodeLIPC",
-            thread_name_single, "lipc"
-            );
-
+    int r = RunModeSetLiveCaptureSingle(ParseLIPCConfig, LIPCConfigGeThreadsCount, "ReceiveLIPC",
+            "DecodeLIPC", thread_name_single, "lipc");
     if (r != 0) {
         FatalError("Runmode start failed [%d]", r);
     }
@@ -66,19 +228,15 @@ int RunModLIPCSingle(void) {
     SCReturnInt(0);
 }
 
-int RunModeIdsPcapAutoFp(void)
+int RunModeLIPCAutoFp(void)
 {
     SCEnter();
+
     RunModeInitialize();
     TimeModeSetLive();
 
-    int r = RunModeSetLiveCaptureAutoFp(
-            ParseLIPCConfig,
-            LIPCConfigGeThreadsCount,
-            "ReceiveLIPC", "DecodeLIPC",
-            thread_name_autofp, "lipc"
-            );
-
+    int r = RunModeSetLiveCaptureAutoFp(ParseLIPCConfig, LIPCConfigGeThreadsCount, "ReceiveLIPC",
+            "DecodeLIPC", thread_name_autofp, "lipc");
     if (r != 0) {
         FatalError("Runmode start failed [%d]", r);
     }
@@ -87,17 +245,15 @@ int RunModeIdsPcapAutoFp(void)
     SCReturnInt(0);
 }
 
-int RunModeLIPCWorkers(void) {
+int RunModeLIPCWorkers(void)
+{
     SCEnter();
 
     RunModeInitialize();
     TimeModeSetLive();
 
-    int r = RunModeSetLiveCaptureWorkers(
-            ParseLIPCConfig, LIPCConfigGeThreadsCount,
-            "ReceiveLIPC", "DecodeLIPC", "lipc"
-            );
-
+    int r = RunModeSetLiveCaptureWorkers(ParseLIPCConfig, LIPCConfigGeThreadsCount, "ReceiveLIPC",
+            "DecodeLIPC", thread_name_workers, "lipc");
     if (r != 0) {
         FatalError("Runmode start failed [%d]", r);
     }
@@ -106,29 +262,18 @@ int RunModeLIPCWorkers(void) {
     SCReturnInt(0);
 }
 
-void RunModeIdsLIPCRegister(void) {
-    RunModeRegisterNewRunMode(RUNMODE_LIPC_DEV, "single", "Single threaded IPC mode",
-            RunModeLIPCSingle, NULL);
-    RunModeRegisterNewRunMode(RUNMODE_LIPC_DEV, "autofp",
-            "Multi threaded IPC live mode.  Packets from "
-            "each flow are assigned to a single detect thread, "
-            "unlike \"lipc_live_auto\" where packets from "
-            "the same flow can be processed by any detect "
-            "thread",
-            RunModeLIPCAutoFp, NULL);
-    RunModeRegisterNewRunMode(RUNMODE_LIPC_DEV, "workers",
-            "Workers IPC live mode, each thread does all"
+void RunModeIdsLIPCRegister(void)
+{
+    RunModeRegisterNewRunMode(RUNMODE_LIPC, "single", "Single threaded IPC mode",
+            RunModeLIPCSingle, LIPCRunModeEnableIPS);
+    RunModeRegisterNewRunMode(RUNMODE_LIPC, "autofp",
+            "Multi threaded IPC mode. Packets from "
+            "each flow are assigned to a single detect thread",
+            RunModeLIPCAutoFp, LIPCRunModeEnableIPS);
+    RunModeRegisterNewRunMode(RUNMODE_LIPC, "workers",
+            "Workers IPC mode, each thread does all"
             " tasks from acquisition to logging",
-            RunModeLIPCWorkers, NULL);
-
-    return;
-}
-
-static void LIPCDerefConfig(void * data) {
-    LIPCIfaceConfig * cfg = (LIPCIfaceConfig*) data;
-    if (SC_ATOMIC_SUB(cfg->ref, 1) == 1) {
-        SCFree(cfg);
-    }
+            RunModeLIPCWorkers, LIPCRunModeEnableIPS);
 }
 
 /**
@@ -1,32 +1,19 @@
-/* Copyright (C) 2011 Open Information Security Foundation
+/* Copyright (C) 2023 Aviatrix
  *
- * You can copy, redistribute or modify this Program under the terms of
- * the GNU General Public License version 2 as published by the Free
- * Software Foundation.
- *
- * This program is distributed in the hope that it will be useful,
- * but WITHOUT ANY WARRANTY; without even the implied warranty of
- * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
- * GNU General Public License for more details.
- *
- * You should have received a copy of the GNU General Public License
- * version 2 along with this program; if not, write to the Free Software
- * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
- * 02110-1301, USA.
  */
 
 /** \file
  *
- *  \author Eric Leblond <eric@regit.org>
+ *  \author Alan M. Carroll (amc@apache.org)
  */
 
-#ifndef __RUNMODE_AF_PACKET_H__
-#define __RUNMODE_AF_PACKET_H__
+#ifndef __RUNMODE_LIPC_H__
+#define __RUNMODE_LIPC_H__
 
-int RunModeIdsAFPSingle(void);
-int RunModeIdsAFPAutoFp(void);
-int RunModeIdsAFPWorkers(void);
-void RunModeIdsAFPRegister(void);
-const char *RunModeAFPGetDefaultMode(void);
+int RunModeLIPCSingle(void);
+int RunModeLIPCAutoFp(void);
+int RunModeLIPCWorkers(void);
+void RunModeIdsLIPCRegister(void);
+const char *RunModeLIPCGetDefaultMode(void);
 
-#endif /* __RUNMODE_AF_PACKET_H__ */
+#endif /* __RUNMODE_LIPC_H__ */
@@ -24,6 +24,7 @@
 
 #include "detect-engine.h"
 #include "source-pcap-file.h"
+#include "source-pcap-file-parallel.h"
 
 #include "util-debug.h"
 #include "util-time.h"
@@ -108,7 +109,8 @@ int RunModeFilePcapSingle(void)
 
 /**
  * \brief RunModeFilePcapAutoFp set up the following thread packet handlers:
- *        - Receive thread (from pcap file)
+ *        - Receive threads (from pcap file), more than one if
+ *          pcap-file.readers is set and the file can be split up
  *        - Decode thread
  *        - Stream thread
  *        - Detect: If we have only 1 cpu, it will setup one Detect thread
@@ -164,36 +166,40 @@ int RunModeFilePcapAutoFp(void)
         FatalError("RunmodeAutoFpCreatePickupQueuesString failed");
     }
 
-    snprintf(tname, sizeof(tname), "%s#01", thread_name_autofp);
+    const uint16_t readers = PcapFileParallelInit(file);
+    TmModule *tm_module = NULL;
 
-    /* create the threads */
-    ThreadVars *tv_receivepcap =
-        TmThreadCreatePacketHandler(tname,
-                                    "packetpool", "packetpool",
-                                    queues, "flow",
-                                    "pktacqloop");
-    SCFree(queues);
+    for (thread = 0; thread < readers; thread++) {
+        snprintf(tname, sizeof(tname), "%s#%02d", thread_name_autofp, thread + 1);
 
-    if (tv_receivepcap == NULL) {
-        FatalError("threading setup failed");
-    }
-    TmModule *tm_module = TmModuleGetByName("ReceivePcapFile");
-    if (tm_module == NULL) {
-        FatalError("TmModuleGetByName failed for ReceivePcap");
-    }
-    TmSlotSetFuncAppend(tv_receivepcap, tm_module, file);
+        /* create the threads */
+        ThreadVars *tv_receivepcap =
+            TmThreadCreatePacketHandler(tname,
+                                        "packetpool", "packetpool",
+                                        queues, "flow",
+                                        "pktacqloop");
+        if (tv_receivepcap == NULL) {
+            FatalError("threading setup failed");
+        }
+        tm_module = TmModuleGetByName("ReceivePcapFile");
+        if (tm_module == NULL) {
+            FatalError("TmModuleGetByName failed for ReceivePcap");
+        }
+        TmSlotSetFuncAppend(tv_receivepcap, tm_module, file);
 
-    tm_module = TmModuleGetByName("DecodePcapFile");
-    if (tm_module == NULL) {
-        FatalError("TmModuleGetByName DecodePcap failed");
-    }
-    TmSlotSetFuncAppend(tv_receivepcap, tm_module, NULL);
+        tm_module = TmModuleGetByName("DecodePcapFile");
+        if (tm_module == NULL) {
+            FatalError("TmModuleGetByName DecodePcap failed");
+        }
+        TmSlotSetFuncAppend(tv_receivepcap, tm_module, NULL);
 
-    TmThreadSetCPU(tv_receivepcap, RECEIVE_CPU_SET);
+        TmThreadSetCPU(tv_receivepcap, RECEIVE_CPU_SET);
 
-    if (TmThreadSpawn(tv_receivepcap) != TM_ECODE_OK) {
-        FatalError("TmThreadSpawn failed");
+        if (TmThreadSpawn(tv_receivepcap) != TM_ECODE_OK) {
+            FatalError("TmThreadSpawn failed");
+        }
     }
+    SCFree(queues);
 
     for (thread = 0; thread < (uint16_t)thread_max; thread++) {
         snprintf(tname, sizeof(tname), "%s#%02d", thread_name_workers, thread + 1);
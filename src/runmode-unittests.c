@@ -88,7 +88,9 @@
 #include "util-bloomfilter.h"
 #include "util-bloomfilter-counting.h"
 #include "util-pool.h"
+#include "util-arena.h"
 #include "util-byte.h"
+#include "util-checksum-simd.h"
 #include "util-proto-name.h"
 #include "util-macset.h"
 #include "util-memrchr.h"
@@ -113,6 +115,7 @@
 #include "decode-raw.h"
 #include "decode-vntag.h"
 #include "decode-vxlan.h"
+#include "source-pcap-file-mmap.h"
 
 #ifdef OS_WIN32
 #include "win32-syscall.h"
@@ -140,7 +143,10 @@ static void RegisterUnittests(void)
     BloomFilterRegisterTests();
     BloomFilterCountingRegisterTests();
     PoolRegisterTests();
+    ArenaRegisterTests();
     ByteRegisterTests();
+    ChecksumSimdRegisterTests();
+    PcapFileMmapRegisterTests();
     MpmRegisterTests();
     FlowBitRegisterTests();
     HostBitRegisterTests();
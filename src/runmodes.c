@@ -38,6 +38,7 @@
 #include "runmodes.h"
 #include "runmode-af-packet.h"
 #include "runmode-af-xdp.h"
+#include "runmode-lipc.h"
 #include "runmode-dpdk.h"
 #include "runmode-erf-dag.h"
 #include "runmode-erf-file.h"
@@ -161,6 +162,12 @@ static const char *RunModeTranslateModeToName(int runmode)
             return "AF_PACKET_DEV";
         case RUNMODE_AFXDP_DEV:
             return "AF_XDP_DEV";
+        case RUNMODE_LIPC:
+#ifdef HAVE_LIPC
+            return "LIPC";
+#else
+            return "LIPC(DISABLED)";
+#endif
         case RUNMODE_NETMAP:
 #ifdef HAVE_NETMAP
             return "NETMAP";
@@ -250,6 +257,7 @@ void RunModeRegisterRunModes(void)
     RunModeNapatechRegister();
     RunModeIdsAFPRegister();
     RunModeIdsAFXDPRegister();
+    RunModeIdsLIPCRegister();
     RunModeIdsNetmapRegister();
     RunModeIdsNflogRegister();
     RunModeUnixSocketRegister();
@@ -359,6 +367,9 @@ static const char *RunModeGetConfOrDefault(int capture_mode, const char *capture
             case RUNMODE_AFXDP_DEV:
                 custom_mode = RunModeAFXDPGetDefaultMode();
                 break;
+            case RUNMODE_LIPC:
+                custom_mode = RunModeLIPCGetDefaultMode();
+                break;
             case RUNMODE_NETMAP:
                 custom_mode = RunModeNetmapGetDefaultMode();
                 break;
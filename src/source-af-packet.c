@@ -299,6 +299,10 @@ typedef struct AFPThreadVars_
     uint16_t capture_afp_poll_data;
     uint16_t capture_afp_poll_err;
     uint16_t capture_afp_send_err;
+    uint16_t capture_afp_block_fill;
+    uint16_t capture_afp_block_pkts;
+    uint16_t capture_afp_block_hold;
+    uint16_t capture_afp_block_hold_max;
 
     uint64_t send_errors_logged; /**< snapshot of send errors logged. */
 
@@ -814,6 +818,11 @@ static void AFPReadFromRingSetupPacket(
     } else {
         if (tp_status & TP_STATUS_CSUMNOTREADY) {
             p->flags |= PKT_IGNORE_CHECKSUM;
+        } else if (ptv->checksum_mode == CHECKSUM_VALIDATION_KERNEL &&
+                   (tp_status & TP_STATUS_CSUM_VALID)) {
+            /* L4 checksum was verified by the kernel or the NIC. The IP
+             * header checksum is not covered, so it's still validated. */
+            p->level4_comp_csum = 0;
         }
     }
 }
@@ -955,11 +964,16 @@ static inline void AFPFlushBlock(struct tpacket_block_desc *pbd)
     pbd->hdr.bh1.block_status = TP_STATUS_KERNEL;
 }
 
-static inline int AFPParsePacketV3(AFPThreadVars *ptv, struct tpacket_block_desc *pbd, struct tpacket3_hdr *ppd)
+/** \internal
+ *  \brief setup a packet for a frame of a block
+ *  \retval p packet or NULL if none could be allocated
+ */
+static inline Packet *AFPParsePacketV3(
+        AFPThreadVars *ptv, struct tpacket_block_desc *pbd, struct tpacket3_hdr *ppd)
 {
     Packet *p = PacketGetFromQueueOrAlloc();
     if (p == NULL) {
-        SCReturnInt(AFP_SURI_FAILURE);
+        SCReturnPtr(NULL, "Packet");
     }
     PKT_SET_SRC(p, PKT_SRC_WIRE);
 
@@ -1002,40 +1016,43 @@ static inline int AFPParsePacketV3(AFPThreadVars *ptv, struct tpacket_block_desc
     } else {
         if (ppd->tp_status & TP_STATUS_CSUMNOTREADY) {
             p->flags |= PKT_IGNORE_CHECKSUM;
+        } else if (ptv->checksum_mode == CHECKSUM_VALIDATION_KERNEL &&
+                   (ppd->tp_status & TP_STATUS_CSUM_VALID)) {
+            /* L4 checksum was verified by the kernel or the NIC. The IP
+             * header checksum is not covered, so it's still validated. */
+            p->level4_comp_csum = 0;
         }
     }
 
-    if (TmThreadsSlotProcessPkt(ptv->tv, ptv->slot, p) != TM_ECODE_OK) {
-        SCReturnInt(AFP_SURI_FAILURE);
-    }
-
-    SCReturnInt(AFP_READ_OK);
+    SCReturnPtr(p, "Packet");
 }
 
+/** \internal
+ *  \brief run the packets of a block through the pipeline
+ *
+ *  Packets are passed on in batches of up to TM_PKT_BATCH_SIZE. A failure
+ *  to get or process a packet is an internal error, the remaining frames of
+ *  the block are still processed.
+ */
 static inline int AFPWalkBlock(AFPThreadVars *ptv, struct tpacket_block_desc *pbd)
 {
     const int num_pkts = pbd->hdr.bh1.num_pkts;
     uint8_t *ppd = (uint8_t *)pbd + pbd->hdr.bh1.offset_to_first_pkt;
+    Packet *batch[TM_PKT_BATCH_SIZE];
+    uint32_t batch_cnt = 0;
 
     for (int i = 0; i < num_pkts; ++i) {
         const struct sockaddr_ll *sll =
                 (const struct sockaddr_ll *)(ppd + TPACKET_ALIGN(sizeof(struct tpacket3_hdr)));
-        if (unlikely(AFPShouldIgnoreFrame(ptv, sll))) {
-            ppd = ppd + ((struct tpacket3_hdr *)ppd)->tp_next_offset;
-            continue;
+        if (likely(!AFPShouldIgnoreFrame(ptv, sll))) {
+            Packet *p = AFPParsePacketV3(ptv, pbd, (struct tpacket3_hdr *)ppd);
+            if (p != NULL) {
+                batch[batch_cnt++] = p;
+            }
         }
-        int ret = AFPParsePacketV3(ptv, pbd, (struct tpacket3_hdr *)ppd);
-        switch (ret) {
-            case AFP_READ_OK:
-                break;
-            case AFP_SURI_FAILURE:
-                /* Internal error but let's just continue and
-                 * treat thenext packet */
-                break;
-            case AFP_READ_FAILURE:
-                SCReturnInt(AFP_READ_FAILURE);
-            default:
-                SCReturnInt(ret);
+        if (batch_cnt == TM_PKT_BATCH_SIZE || (i == num_pkts - 1 && batch_cnt > 0)) {
+            (void)TmThreadsSlotProcessPktBatch(ptv->tv, ptv->slot, batch, batch_cnt);
+            batch_cnt = 0;
         }
         ppd = ppd + ((struct tpacket3_hdr *)ppd)->tp_next_offset;
     }
@@ -1056,6 +1073,11 @@ static inline int AFPWalkBlock(AFPThreadVars *ptv, struct tpacket_block_desc *pb
 static int AFPReadFromRingV3(AFPThreadVars *ptv)
 {
 #ifdef HAVE_TPACKET_V3
+    /* the time a block is flushed is also the time the next one is taken,
+     * so only the first block after a return needs a clock read of its own */
+    struct timespec taken = { 0, 0 };
+    bool have_taken = false;
+
     /* Loop till we have packets available */
     while (1) {
         if (unlikely(suricata_ctl_flags != 0)) {
@@ -1071,12 +1093,28 @@ static int AFPReadFromRingV3(AFPThreadVars *ptv)
             SCReturnInt(AFP_READ_OK);
         }
 
+        StatsAddUI64(ptv->tv, ptv->capture_afp_block_pkts, pbd->hdr.bh1.num_pkts);
+        StatsAddUI64(ptv->tv, ptv->capture_afp_block_fill,
+                (uint64_t)pbd->hdr.bh1.blk_len * 100 / ptv->req.v3.tp_block_size);
+        if (!have_taken) {
+            clock_gettime(CLOCK_MONOTONIC, &taken);
+            have_taken = true;
+        }
+
         int ret = AFPWalkBlock(ptv, pbd);
         if (unlikely(ret != AFP_READ_OK)) {
             AFPFlushBlock(pbd);
             SCReturnInt(ret);
         }
 
+        struct timespec flushed;
+        clock_gettime(CLOCK_MONOTONIC, &flushed);
+        const int64_t held_us = (int64_t)(flushed.tv_sec - taken.tv_sec) * 1000000 +
+                                (flushed.tv_nsec - taken.tv_nsec) / 1000;
+        StatsAddUI64(ptv->tv, ptv->capture_afp_block_hold, (uint64_t)MAX(held_us, 0));
+        StatsSetUI64(ptv->tv, ptv->capture_afp_block_hold_max, (uint64_t)MAX(held_us, 0));
+        taken = flushed;
+
         AFPFlushBlock(pbd);
         ptv->frame_offset = (ptv->frame_offset + 1) % ptv->req.v3.tp_block_nr;
         /* return to maintenance task after one loop on the ring */
@@ -2577,6 +2615,16 @@ TmEcode ReceiveAFPThreadInit(ThreadVars *tv, const void *initdata, void **data)
     ptv->capture_afp_poll_data = StatsRegisterCounter("capture.afpacket.poll_data", ptv->tv);
     ptv->capture_afp_poll_err = StatsRegisterCounter("capture.afpacket.poll_errors", ptv->tv);
     ptv->capture_afp_send_err = StatsRegisterCounter("capture.afpacket.send_errors", ptv->tv);
+    if (ptv->flags & AFP_TPACKET_V3) {
+        ptv->capture_afp_block_fill =
+                StatsRegisterAvgCounter("capture.afpacket.block_fill_pct_avg", ptv->tv);
+        ptv->capture_afp_block_pkts =
+                StatsRegisterAvgCounter("capture.afpacket.block_pkts_avg", ptv->tv);
+        ptv->capture_afp_block_hold =
+                StatsRegisterAvgCounter("capture.afpacket.block_held_usec_avg", ptv->tv);
+        ptv->capture_afp_block_hold_max =
+                StatsRegisterMaxCounter("capture.afpacket.block_held_usec_max", ptv->tv);
+    }
 #endif
 
     ptv->copy_mode = afpconfig->copy_mode;
@@ -140,6 +140,20 @@ struct QueueAssignment {
     bool assigned;
 };
 
+/** struct xdp_statistics including the ring empty counters of Linux 5.9,
+ *  older kernels only fill in the first four fields */
+struct AFXDPStatistics {
+    uint64_t rx_dropped;
+    uint64_t rx_invalid_descs;
+    uint64_t tx_invalid_descs;
+    uint64_t rx_ring_full;
+    uint64_t rx_fill_ring_empty_descs;
+    uint64_t tx_ring_empty_descs;
+};
+
+/** max descriptors of one multi-buffer packet: MAX_SKB_FRAGS + 1 */
+#define AFXDP_MAX_PKT_DESCS 18
+
 struct XskSockInfo {
     struct xsk_ring_cons rx;
     struct xsk_ring_prod tx;
@@ -151,8 +165,11 @@ struct XskSockInfo {
     /* Configuration items */
     struct xsk_socket_config cfg;
     bool enable_busy_poll;
+    bool multi_buffer;
     uint32_t busy_poll_time;
     uint32_t busy_poll_budget;
+    /* descriptors read from the rx ring at once */
+    uint32_t rx_batch;
 
     struct pollfd fd;
 };
@@ -193,6 +210,10 @@ typedef struct AFXDPThreadVars_ {
     uint16_t capture_afxdp_empty_reads;
     uint16_t capture_afxdp_failed_reads;
     uint16_t capture_afxdp_acquire_pkt_failed;
+    uint16_t capture_afxdp_wakeups;
+    uint16_t capture_afxdp_fill_ring_empty;
+    uint16_t capture_afxdp_multi_buffer_pkts;
+    uint16_t capture_afxdp_multi_buffer_copy_failed;
 } AFXDPThreadVars;
 
 static TmEcode ReceiveAFXDPThreadInit(ThreadVars *, const void *, void **);
@@ -238,13 +259,19 @@ void TmModuleDecodeAFXDPRegister(void)
 
 static inline void AFXDPDumpCounters(AFXDPThreadVars *ptv)
 {
-    struct xdp_statistics stats;
-    socklen_t len = sizeof(struct xdp_statistics);
+    struct AFXDPStatistics stats;
+    socklen_t len = sizeof(stats);
     int fd = xsk_socket__fd(ptv->xsk.xsk);
 
     if (getsockopt(fd, SOL_XDP, XDP_STATISTICS, &stats, &len) >= 0) {
         uint64_t rx_dropped = stats.rx_dropped + stats.rx_invalid_descs + stats.rx_ring_full;
 
+        /* the kernel had no fill ring entry for an incoming frame */
+        if (len >= offsetof(struct AFXDPStatistics, tx_ring_empty_descs)) {
+            StatsSetUI64(ptv->tv, ptv->capture_afxdp_fill_ring_empty,
+                    stats.rx_fill_ring_empty_descs);
+        }
+
         StatsAddUI64(ptv->tv, ptv->capture_kernel_drops,
                 rx_dropped - StatsGetLocalCounterValue(ptv->tv, ptv->capture_kernel_drops));
         StatsAddUI64(ptv->tv, ptv->capture_afxdp_packets, ptv->pkts);
@@ -576,12 +603,85 @@ static inline ssize_t WakeupSocket(void *data)
 
     /* Assuming kernel >= 5.11 in use if xdp_busy_poll is enabled */
     if (ptv->xsk.enable_busy_poll || xsk_ring_prod__needs_wakeup(&ptv->umem.fq)) {
+        StatsIncr(ptv->tv, ptv->capture_afxdp_wakeups);
         res = recvfrom(xsk_socket__fd(ptv->xsk.xsk), NULL, 0, MSG_DONTWAIT, NULL, NULL);
     }
 
     return res;
 }
 
+/**
+ * \brief Hand a frame back to the kernel through a reserved fill ring slot
+ */
+static inline void AFXDPFillFrame(AFXDPThreadVars *ptv, uint32_t idx_fq, uint64_t orig)
+{
+    *xsk_ring_prod__fill_addr(&ptv->umem.fq, idx_fq) = orig;
+}
+
+#ifdef XDP_USE_SG
+/**
+ * \brief Number of descriptors of the complete packets at the start of a read
+ *
+ * The last packet of a read can be missing its last descriptors, these are
+ * left in the ring for the next read.
+ */
+static uint32_t AFXDPCompleteDescs(AFXDPThreadVars *ptv, uint32_t idx_rx, uint32_t rcvd)
+{
+    uint32_t complete = 0;
+    for (uint32_t i = 0; i < rcvd; i++) {
+        const struct xdp_desc *desc = xsk_ring_cons__rx_desc(&ptv->xsk.rx, idx_rx + i);
+        if (!(desc->options & XDP_PKT_CONTD)) {
+            complete = i + 1;
+        }
+    }
+    return complete;
+}
+
+/**
+ * \brief Set up a packet spread over multiple descriptors
+ *
+ * The frames are copied into the packet and handed back to the kernel right
+ * away, also if the copy fails.
+ *
+ * \param ndescs set to the number of descriptors used by the packet
+ *
+ * \retval 0 on success, -1 if the data could not be copied into p
+ */
+static int AFXDPParseMultiBuffer(AFXDPThreadVars *ptv, Packet *p, uint32_t idx_rx,
+        uint32_t avail, uint32_t idx_fq, uint32_t *ndescs)
+{
+    uint32_t pkt_len = 0;
+    uint32_t n = 0;
+    bool copy_failed = p == NULL;
+
+    while (n < avail) {
+        const struct xdp_desc *desc = xsk_ring_cons__rx_desc(&ptv->xsk.rx, idx_rx + n);
+        const uint64_t orig = xsk_umem__extract_addr(desc->addr);
+        const uint64_t addr = xsk_umem__add_offset_to_addr(desc->addr);
+        const bool last = !(desc->options & XDP_PKT_CONTD);
+
+        if (!copy_failed) {
+            if (PacketCopyDataOffset(p, pkt_len, xsk_umem__get_data(ptv->umem.buf, addr),
+                        desc->len) != 0) {
+                copy_failed = true;
+            }
+        }
+        pkt_len += desc->len;
+        AFXDPFillFrame(ptv, idx_fq + n, orig);
+        n++;
+        if (last)
+            break;
+    }
+
+    *ndescs = n;
+    ptv->bytes += pkt_len;
+    if (copy_failed)
+        return -1;
+    SET_PKT_LEN(p, pkt_len);
+    return 0;
+}
+#endif /* XDP_USE_SG */
+
 /**
  * \brief Init function for ReceiveAFXDP.
  *
@@ -640,6 +740,15 @@ static TmEcode ReceiveAFXDPThreadInit(ThreadVars *tv, const void *initdata, void
     ptv->xsk.cfg.tx_size = XSK_RING_PROD__DEFAULT_NUM_DESCS;
     ptv->xsk.cfg.xdp_flags = afxdpconfig->mode;
     ptv->xsk.cfg.bind_flags = afxdpconfig->bind_flags;
+    if (afxdpconfig->use_need_wakeup) {
+        ptv->xsk.cfg.bind_flags |= XDP_USE_NEED_WAKEUP;
+    }
+#ifdef XDP_USE_SG
+    if (afxdpconfig->multi_buffer) {
+        ptv->xsk.cfg.bind_flags |= XDP_USE_SG;
+        ptv->xsk.multi_buffer = true;
+    }
+#endif
 
     /* UMEM configuration */
     ptv->umem.cfg.fill_size = XSK_RING_PROD__DEFAULT_NUM_DESCS * 2;
@@ -657,6 +766,11 @@ static TmEcode ReceiveAFXDPThreadInit(ThreadVars *tv, const void *initdata, void
     ptv->xsk.enable_busy_poll = afxdpconfig->enable_busy_poll;
     ptv->xsk.busy_poll_budget = afxdpconfig->busy_poll_budget;
     ptv->xsk.busy_poll_time = afxdpconfig->busy_poll_time;
+    /* the fill ring is replenished per read, sized like the busy poll batch */
+    ptv->xsk.rx_batch = afxdpconfig->busy_poll_budget;
+    if (ptv->xsk.multi_buffer && ptv->xsk.rx_batch < AFXDP_MAX_PKT_DESCS) {
+        ptv->xsk.rx_batch = AFXDP_MAX_PKT_DESCS;
+    }
     ptv->gro_flush_timeout = afxdpconfig->gro_flush_timeout;
     ptv->napi_defer_hard_irqs = afxdpconfig->napi_defer_hard_irqs;
 
@@ -670,6 +784,15 @@ static TmEcode ReceiveAFXDPThreadInit(ThreadVars *tv, const void *initdata, void
     ptv->capture_afxdp_failed_reads = StatsRegisterCounter("capture.afxdp.failed_reads", ptv->tv);
     ptv->capture_afxdp_acquire_pkt_failed =
             StatsRegisterCounter("capture.afxdp.acquire_pkt_failed", ptv->tv);
+    ptv->capture_afxdp_wakeups = StatsRegisterCounter("capture.afxdp.wakeups", ptv->tv);
+    ptv->capture_afxdp_fill_ring_empty =
+            StatsRegisterCounter("capture.afxdp.fill_ring_empty", ptv->tv);
+    if (ptv->xsk.multi_buffer) {
+        ptv->capture_afxdp_multi_buffer_pkts =
+                StatsRegisterCounter("capture.afxdp.multi_buffer_packets", ptv->tv);
+        ptv->capture_afxdp_multi_buffer_copy_failed =
+                StatsRegisterCounter("capture.afxdp.multi_buffer_copy_failed", ptv->tv);
+    }
 
     /* Reserve memory for umem  */
     if (AcquireBuffer(ptv) != TM_ECODE_OK) {
@@ -752,7 +875,7 @@ static TmEcode ReceiveAFXDPLoop(ThreadVars *tv, void *data, void *slot)
             }
         }
 
-        rcvd = xsk_ring_cons__peek(&ptv->xsk.rx, ptv->xsk.busy_poll_budget, &idx_rx);
+        rcvd = xsk_ring_cons__peek(&ptv->xsk.rx, ptv->xsk.rx_batch, &idx_rx);
         if (!rcvd) {
             StatsIncr(ptv->tv, ptv->capture_afxdp_empty_reads);
             ssize_t ret = WakeupSocket(ptv);
@@ -764,6 +887,23 @@ static TmEcode ReceiveAFXDPLoop(ThreadVars *tv, void *data, void *slot)
             continue;
         }
 
+#ifdef XDP_USE_SG
+        if (ptv->xsk.multi_buffer) {
+            const uint32_t complete = AFXDPCompleteDescs(ptv, idx_rx, rcvd);
+            if (complete < rcvd) {
+                xsk_ring_cons__cancel(&ptv->xsk.rx, rcvd - complete);
+                rcvd = complete;
+                if (rcvd == 0) {
+                    DumpStatsEverySecond(ptv, &last_dump);
+                    continue;
+                }
+            }
+        }
+#endif
+
+        /* reserve a fill ring slot for each descriptor of the read, the
+         * frames are handed back as the packets are released and all
+         * slots are submitted together */
         uint32_t res = xsk_ring_prod__reserve(&ptv->umem.fq, rcvd, &idx_fq);
         while (res != rcvd) {
             StatsIncr(ptv->tv, ptv->capture_afxdp_failed_reads);
@@ -771,46 +911,80 @@ static TmEcode ReceiveAFXDPLoop(ThreadVars *tv, void *data, void *slot)
             if (ret < 0) {
                 SCLogWarning("recv failed with retval %ld", ret);
                 AFXDPSwitchState(ptv, AFXDP_STATE_DOWN);
-                continue;
+                break;
             }
             res = xsk_ring_prod__reserve(&ptv->umem.fq, rcvd, &idx_fq);
         }
+        if (unlikely(res != rcvd)) {
+            xsk_ring_cons__cancel(&ptv->xsk.rx, rcvd);
+            continue;
+        }
 
         gettimeofday(&ts, NULL);
-        ptv->pkts += rcvd;
-        for (uint32_t i = 0; i < rcvd; i++) {
+        Packet *batch[TM_PKT_BATCH_SIZE];
+        uint32_t batch_cnt = 0;
+        uint32_t i = 0;
+        while (i < rcvd) {
+            const struct xdp_desc *desc = xsk_ring_cons__rx_desc(&ptv->xsk.rx, idx_rx);
             p = PacketGetFromQueueOrAlloc();
             if (unlikely(p == NULL)) {
                 StatsIncr(ptv->tv, ptv->capture_afxdp_acquire_pkt_failed);
-                continue;
+            } else {
+                PKT_SET_SRC(p, PKT_SRC_WIRE);
+                p->datalink = LINKTYPE_ETHERNET;
+                p->livedev = ptv->livedev;
+                p->flags |= PKT_IGNORE_CHECKSUM;
+                p->ts = SCTIME_FROM_TIMEVAL(&ts);
+            }
+            ptv->pkts++;
+
+#ifdef XDP_USE_SG
+            if (ptv->xsk.multi_buffer && (desc->options & XDP_PKT_CONTD)) {
+                uint32_t ndescs = 0;
+                const int r = AFXDPParseMultiBuffer(ptv, p, idx_rx, rcvd - i, idx_fq, &ndescs);
+                idx_rx += ndescs;
+                idx_fq += ndescs;
+                i += ndescs;
+                if (p != NULL) {
+                    StatsIncr(ptv->tv, ptv->capture_afxdp_multi_buffer_pkts);
+                    if (likely(r == 0)) {
+                        batch[batch_cnt++] = p;
+                    } else {
+                        StatsIncr(ptv->tv, ptv->capture_afxdp_multi_buffer_copy_failed);
+                        PacketFreeOrRelease(p);
+                    }
+                }
+            } else
+#endif
+            {
+                uint64_t addr = desc->addr;
+                uint32_t len = desc->len;
+                uint64_t orig = xsk_umem__extract_addr(addr);
+                addr = xsk_umem__add_offset_to_addr(addr);
+                ptv->bytes += len;
+
+                if (unlikely(p == NULL)) {
+                    /* frame isn't used, give it back to the kernel */
+                    AFXDPFillFrame(ptv, idx_fq, orig);
+                } else {
+                    p->ReleasePacket = AFXDPReleasePacket;
+                    p->afxdp_v.fq_idx = idx_fq;
+                    p->afxdp_v.orig = orig;
+                    p->afxdp_v.fq = &ptv->umem.fq;
+                    PacketSetData(p, xsk_umem__get_data(ptv->umem.buf, addr), len);
+                    batch[batch_cnt++] = p;
+                }
+                idx_rx++;
+                idx_fq++;
+                i++;
             }
 
-            PKT_SET_SRC(p, PKT_SRC_WIRE);
-            p->datalink = LINKTYPE_ETHERNET;
-            p->livedev = ptv->livedev;
-            p->ReleasePacket = AFXDPReleasePacket;
-            p->flags |= PKT_IGNORE_CHECKSUM;
-
-            p->ts = SCTIME_FROM_TIMEVAL(&ts);
-
-            uint64_t addr = xsk_ring_cons__rx_desc(&ptv->xsk.rx, idx_rx)->addr;
-            uint32_t len = xsk_ring_cons__rx_desc(&ptv->xsk.rx, idx_rx++)->len;
-            uint64_t orig = xsk_umem__extract_addr(addr);
-            addr = xsk_umem__add_offset_to_addr(addr);
-
-            uint8_t *pkt_data = xsk_umem__get_data(ptv->umem.buf, addr);
-
-            ptv->bytes += len;
-
-            p->afxdp_v.fq_idx = idx_fq++;
-            p->afxdp_v.orig = orig;
-            p->afxdp_v.fq = &ptv->umem.fq;
-
-            PacketSetData(p, pkt_data, len);
-
-            if (TmThreadsSlotProcessPkt(ptv->tv, ptv->slot, p) != TM_ECODE_OK) {
-                TmqhOutputPacketpool(ptv->tv, p);
-                SCReturnInt(EXIT_FAILURE);
+            if (batch_cnt == TM_PKT_BATCH_SIZE || (i == rcvd && batch_cnt > 0)) {
+                if (TmThreadsSlotProcessPktBatch(ptv->tv, ptv->slot, batch, batch_cnt) !=
+                        TM_ECODE_OK) {
+                    SCReturnInt(EXIT_FAILURE);
+                }
+                batch_cnt = 0;
             }
         }
 
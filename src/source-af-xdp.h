@@ -37,6 +37,8 @@ typedef struct AFXDPIfaceConfig {
     uint32_t bind_flags;
     int mem_alignment;
     bool enable_busy_poll;
+    bool use_need_wakeup;
+    bool multi_buffer;
     uint32_t busy_poll_time;
     uint32_t busy_poll_budget;
     uint32_t gro_flush_timeout;
@@ -41,6 +41,7 @@
 #include "tm-threads.h"
 #include "tmqh-packetpool.h"
 #include "util-privs.h"
+#include "util-validate.h"
 #include "action-globals.h"
 
 #ifndef HAVE_DPDK
@@ -90,7 +91,7 @@ TmEcode NoDPDKSupportExit(ThreadVars *tv, const void *initdata, void **data)
 #include "util-dpdk-bonding.h"
 #include <numa.h>
 
-#define BURST_SIZE 32
+#define BURST_SIZE TM_PKT_BATCH_SIZE
 static struct timeval machine_start_time = { 0, 0 };
 
 /**
@@ -124,9 +125,22 @@ typedef struct DPDKThreadVars_ {
     uint16_t queue_id;
     int32_t port_socket_id;
     struct rte_mempool *pkt_mempool;
+    /* Packets are taken from the mbuf private area instead of the packet pool */
+    bool mbuf_packets;
     struct rte_mbuf *received_mbufs[BURST_SIZE];
 } DPDKThreadVars;
 
+/**
+ * \brief mbufs released during a burst, freed in bulk after the burst
+ */
+typedef struct DPDKMbufFreeQueue_ {
+    struct rte_mbuf *mbufs[BURST_SIZE];
+    uint16_t cnt;
+    bool active;
+} DPDKMbufFreeQueue;
+
+static thread_local DPDKMbufFreeQueue mbuf_free_q;
+
 static TmEcode ReceiveDPDKThreadInit(ThreadVars *, const void *, void **);
 static void ReceiveDPDKThreadExitStats(ThreadVars *, void *);
 static TmEcode ReceiveDPDKThreadDeinit(ThreadVars *, void *);
@@ -305,9 +319,37 @@ static inline void DPDKDumpCounters(DPDKThreadVars *ptv)
     }
 }
 
+static void DPDKMbufFreeQueueFlush(void)
+{
+    if (mbuf_free_q.cnt > 0) {
+        rte_pktmbuf_free_bulk(mbuf_free_q.mbufs, mbuf_free_q.cnt);
+        mbuf_free_q.cnt = 0;
+    }
+}
+
+/**
+ * \brief free a mbuf, in bulk with the others of the burst if called from
+ *        the receive thread
+ */
+static inline void DPDKMbufFree(struct rte_mbuf *mbuf)
+{
+    if (unlikely(!mbuf_free_q.active)) {
+        rte_pktmbuf_free(mbuf);
+        return;
+    }
+    if (unlikely(mbuf_free_q.cnt == BURST_SIZE))
+        DPDKMbufFreeQueueFlush();
+    mbuf_free_q.mbufs[mbuf_free_q.cnt++] = mbuf;
+}
+
 static void DPDKReleasePacket(Packet *p)
 {
     int retval;
+    struct rte_mbuf *mbuf = p->dpdk_v.mbuf;
+    const uint16_t out_port_id = p->dpdk_v.out_port_id;
+    const uint16_t out_queue_id = p->dpdk_v.out_queue_id;
+    bool transmit = false;
+
     /* Need to be in copy mode and need to detect early release
        where Ethernet header could not be set (and pseudo packet)
        When enabling promiscuous mode on Intel cards, 2 ICMPv6 packets are generated.
@@ -319,29 +361,37 @@ static void DPDKReleasePacket(Packet *p)
 #endif
     ) {
         BUG_ON(PKT_IS_PSEUDOPKT(p));
-        retval =
-                rte_eth_tx_burst(p->dpdk_v.out_port_id, p->dpdk_v.out_queue_id, &p->dpdk_v.mbuf, 1);
+        transmit = true;
+    }
+
+    /* a Packet in the mbuf private area goes back to the mempool with its
+     * mbuf, so it has to be cleaned up before the mbuf is handed away */
+    if (p->dpdk_v.mbuf_packet) {
+        PacketRecycle(p);
+    } else {
+        p->dpdk_v.mbuf = NULL;
+        PacketFreeOrRelease(p);
+    }
+    p = NULL;
+
+    if (transmit) {
+        retval = rte_eth_tx_burst(out_port_id, out_queue_id, &mbuf, 1);
         // rte_eth_tx_burst can return only 0 (failure) or 1 (success) because we are only
         // transmitting burst of size 1 and the function rte_eth_tx_burst returns number of
         // successfully sent packets.
         if (unlikely(retval < 1)) {
             // sometimes a repeated transmit can help to send out the packet
             rte_delay_us(DPDK_BURST_TX_WAIT_US);
-            retval = rte_eth_tx_burst(
-                    p->dpdk_v.out_port_id, p->dpdk_v.out_queue_id, &p->dpdk_v.mbuf, 1);
+            retval = rte_eth_tx_burst(out_port_id, out_queue_id, &mbuf, 1);
             if (unlikely(retval < 1)) {
-                SCLogDebug("Unable to transmit the packet on port %u queue %u",
-                        p->dpdk_v.out_port_id, p->dpdk_v.out_queue_id);
-                rte_pktmbuf_free(p->dpdk_v.mbuf);
-                p->dpdk_v.mbuf = NULL;
+                SCLogDebug("Unable to transmit the packet on port %u queue %u", out_port_id,
+                        out_queue_id);
+                DPDKMbufFree(mbuf);
             }
         }
     } else {
-        rte_pktmbuf_free(p->dpdk_v.mbuf);
-        p->dpdk_v.mbuf = NULL;
+        DPDKMbufFree(mbuf);
     }
-
-    PacketFreeOrRelease(p);
 }
 
 /**
@@ -367,7 +417,10 @@ static TmEcode ReceiveDPDKLoop(ThreadVars *tv, void *data, void *slot)
     // packets)
     TmThreadsSetFlag(tv, THV_RUNNING);
 
-    PacketPoolWait();
+    if (!ptv->mbuf_packets)
+        PacketPoolWait();
+    mbuf_free_q.cnt = 0;
+    mbuf_free_q.active = true;
     while (1) {
         if (unlikely(suricata_ctl_flags != 0)) {
             SCLogDebug("Stopping Suricata!");
@@ -387,11 +440,20 @@ static TmEcode ReceiveDPDKLoop(ThreadVars *tv, void *data, void *slot)
         }
 
         ptv->pkts += (uint64_t)nb_rx;
+        Packet *batch[BURST_SIZE];
+        uint32_t batch_cnt = 0;
         for (uint16_t i = 0; i < nb_rx; i++) {
-            p = PacketGetFromQueueOrAlloc();
-            if (unlikely(p == NULL)) {
-                continue;
+            if (ptv->mbuf_packets) {
+                p = DPDK_MBUF_PACKET(ptv->received_mbufs[i]);
+                PACKET_PROFILING_START(p);
+            } else {
+                p = PacketGetFromQueueOrAlloc();
+                if (unlikely(p == NULL)) {
+                    rte_pktmbuf_free(ptv->received_mbufs[i]);
+                    continue;
+                }
             }
+            p->dpdk_v.mbuf_packet = ptv->mbuf_packets;
             PKT_SET_SRC(p, PKT_SRC_WIRE);
             p->datalink = LINKTYPE_ETHERNET;
             if (ptv->checksum_mode == CHECKSUM_VALIDATION_DISABLE) {
@@ -446,12 +508,16 @@ static TmEcode ReceiveDPDKLoop(ThreadVars *tv, void *data, void *slot)
 
             PacketSetData(p, rte_pktmbuf_mtod(p->dpdk_v.mbuf, uint8_t *),
                     rte_pktmbuf_pkt_len(p->dpdk_v.mbuf));
-            if (TmThreadsSlotProcessPkt(ptv->tv, ptv->slot, p) != TM_ECODE_OK) {
-                TmqhOutputPacketpool(ptv->tv, p);
-                DPDKFreeMbufArray(ptv->received_mbufs, nb_rx - i - 1, i + 1);
-                SCReturnInt(EXIT_FAILURE);
-            }
+            batch[batch_cnt++] = p;
+        }
+        /* the burst is run through the pipeline as one batch, the mbufs
+         * of the released packets are freed together afterwards */
+        if (TmThreadsSlotProcessPktBatch(ptv->tv, ptv->slot, batch, batch_cnt) != TM_ECODE_OK) {
+            DPDKMbufFreeQueueFlush();
+            mbuf_free_q.active = false;
+            SCReturnInt(EXIT_FAILURE);
         }
+        DPDKMbufFreeQueueFlush();
 
         /* Trigger one dump of stats every second */
         current_time = DPDKGetSeconds();
@@ -462,6 +528,8 @@ static TmEcode ReceiveDPDKLoop(ThreadVars *tv, void *data, void *slot)
         StatsSyncCountersIfSignalled(tv);
     }
 
+    DPDKMbufFreeQueueFlush();
+    mbuf_free_q.active = false;
     SCReturnInt(TM_ECODE_OK);
 }
 
@@ -513,6 +581,12 @@ static TmEcode ReceiveDPDKThreadInit(ThreadVars *tv, const void *initdata, void
     // pass the pointer to the mempool and then forget about it. Mempool is freed in thread deinit.
     ptv->pkt_mempool = dpdk_config->pkt_mempool;
     dpdk_config->pkt_mempool = NULL;
+    ptv->mbuf_packets = (dpdk_config->flags & DPDK_MBUF_PACKETS) != 0;
+    if (ptv->mbuf_packets && ptv->livedev != NULL) {
+        DEBUG_VALIDATE_BUG_ON(!ptv->livedev->dpdk_vars.mbuf_packets);
+        DEBUG_VALIDATE_BUG_ON(
+                rte_pktmbuf_priv_size(ptv->livedev->dpdk_vars.pkt_mp) < sizeof(Packet));
+    }
 
     thread_numa = GetNumaNode();
     if (thread_numa >= 0 && thread_numa != ptv->port_socket_id) {
@@ -2,7 +2,7 @@
  */
 
 /**
- *  \defgroup afppacket AF_PACKET running mode
+ *  \defgroup lipcpacket LIPC running mode
  *
  *  @{
  */
@@ -14,84 +14,217 @@
  *
  * Local IPC packet source.
  *
+ * Clients use either the socket transport, one \c SOCK_SEQPACKET message per
+ * packet, or the shared memory ring transport. The ring is a single producer,
+ * single consumer descriptor ring in a memfd. Packets are handed to the engine
+ * in place with \c PacketSetData and the verdict is written back into the slot
+ * descriptor when the packet is released. Both sides poll the ring and only
+ * fall back to eventfd wakeups when idle.
+ *
+ * All receive threads accept on one shared listening socket, so each client
+ * connection is served by a single thread. Socket transport verdicts are
+ * queued per connection and sent with \c sendmmsg, up to \c verdict-batch at a
+ * time. Pending verdicts are flushed when the connection goes idle or when the
+ * oldest one is \c verdict-flush-usec old.
  */
 
-extern uint16_t max_pending_packets;
+#include "suricata-common.h"
+#include "suricata.h"
+#include "decode.h"
+#include "packet.h"
+#include "action-globals.h"
+#include "threads.h"
+#include "threadvars.h"
+#include "tm-modules.h"
+#include "tm-threads.h"
+#include "tm-threads-common.h"
+#include "conf.h"
+#include "util-datalink.h"
+#include "util-debug.h"
+#include "util-device.h"
+#include "util-optimize.h"
+#include "util-validate.h"
+#include "tmqh-packetpool.h"
+#include "source-lipc.h"
 
-#include <stdio.h>
-#include <errno.h>
-#include <unistd.h>
-#include <sys/socket.h>
+#ifdef HAVE_LIPC
 #include <sys/un.h>
+#include <sys/eventfd.h>
+#endif
 
-static char const * const LIPC_SOCKET_NAME = "\0suricata";
-static size_t const LIPC_SOCKET_NAME_LEN = sizeof(LIPC_SOCKET_NAME) - 1;
-static size_t const LIPC_SOCKET_ADDR_LEN = sizeof(((struct sockaddr_un*)0)->sun_family) + LIPC_SOCKET_NAME_LEN;
-static size_t const LIPC_SOCKET_BUFFER_LEN = 4096;
+#ifndef HAVE_LIPC
 
-static uint16_t const LIPC_VERSION = 1;
+static TmEcode NoLIPCSupportExit(ThreadVars *, const void *, void **);
 
-static void lipc_init_addr(struct sockaddr_un * sa) {
-    sa->sun_family = AF_UNIX;
-    memcpy(&sa->sun_path, LIPC_SOCKET_NAME, LIPC_SOCKET_NAME_LEN);
+void TmModuleReceiveLIPCRegister(void)
+{
+    tmm_modules[TMM_RECEIVELIPC].name = "ReceiveLIPC";
+    tmm_modules[TMM_RECEIVELIPC].ThreadInit = NoLIPCSupportExit;
+    tmm_modules[TMM_RECEIVELIPC].Func = NULL;
+    tmm_modules[TMM_RECEIVELIPC].ThreadExitPrintStats = NULL;
+    tmm_modules[TMM_RECEIVELIPC].ThreadDeinit = NULL;
+    tmm_modules[TMM_RECEIVELIPC].cap_flags = 0;
+    tmm_modules[TMM_RECEIVELIPC].flags = TM_FLAG_RECEIVE_TM;
 }
 
-int lipc_open(char const ** err_text) {
-    int fd = socket(AF_UNIX, SOCK_SEQPACKET, 0);
-    *err_text = NULL;
-    if (fd >= 0) {
-        struct sockaddr_un addr;
-        av_init_addr(&addr);
-        int r = bind(fd, (struct sockaddr *)&addr, SOCKET_ADDR_LEN);
-        if (r == 0) {
-            r = listen(fd, 1);
-            if (r != 0) {
-                *err_text = "Unable to listen";
-            }
-        } else {
-            *err_text = "Unable to bind socket";
-        }
-    } else {
-        *err_text = "Failed to open socket";
-    }
-
-    if (*err_text != NULL) {
-        if (fd >= 0) {
-            close(fd);
-            fd = -1;
-        }
-    }
+void TmModuleDecodeLIPCRegister(void)
+{
+    tmm_modules[TMM_DECODELIPC].name = "DecodeLIPC";
+    tmm_modules[TMM_DECODELIPC].ThreadInit = NoLIPCSupportExit;
+    tmm_modules[TMM_DECODELIPC].Func = NULL;
+    tmm_modules[TMM_DECODELIPC].ThreadExitPrintStats = NULL;
+    tmm_modules[TMM_DECODELIPC].ThreadDeinit = NULL;
+    tmm_modules[TMM_DECODELIPC].cap_flags = 0;
+    tmm_modules[TMM_DECODELIPC].flags = TM_FLAG_DECODE_TM;
+}
 
-    return fd;
+/**
+ * \brief this function prints an error message and exits.
+ */
+static TmEcode NoLIPCSupportExit(ThreadVars *tv, const void *initdata, void **data)
+{
+    SCLogError("Error creating thread %s: you do not have "
+               "support for LIPC enabled, on Linux host please recompile "
+               "with --enable-lipc",
+            tv->name);
+    exit(EXIT_FAILURE);
 }
 
+#else /* We have LIPC support */
+
+/** poll timeout in ms, bounds the reaction time to shutdown */
+#define LIPC_POLL_TIMEOUT 100
+
+/** listening socket shared by all receive threads */
+static struct {
+    SCMutex lock;
+    int fd;
+    int users;
+} lipc_listener = { SCMUTEX_INITIALIZER, -1, 0 };
+
+/** \brief Verdict messages for one sendmmsg call. */
+typedef struct LIPCVerdictBatch_ {
+    struct av_response *resp;
+    struct iovec *iov;
+    struct mmsghdr *msgs;
+} LIPCVerdictBatch;
+
 /**
- * \brief Structure to hold thread specific variables.
+ * \brief A client connection.
  *
- * @internal Single structure shared among threads?
+ * Shared between the receive thread and the packets in flight, which hold a
+ * reference so the socket and the ring mapping stay valid until the last
+ * verdict is delivered.
+ */
+typedef struct LIPCConn_ {
+    int fd; ///< Connected socket.
+
+    /* ring transport, unused for the socket transport */
+    struct lipc_ring *ring; ///< Shared mapping, NULL if not in ring mode.
+    size_t ring_size; ///< Size of the mapping.
+    struct lipc_ring_desc *desc; ///< Descriptor array in the mapping.
+    uint8_t *data; ///< Slot data in the mapping.
+    uint32_t mask; ///< Number of slots - 1.
+    uint32_t slot_size; ///< Bytes of data per slot.
+    int req_efd; ///< Written by the client after publishing slots.
+    int rsp_efd; ///< Written by us after completing slots.
+
+    /* socket transport verdict batch, appended to on packet release which
+     * happens on the worker threads in autofp mode. The batch is swapped with
+     * the spare one under batch_lock and sent under send_lock, so workers
+     * never wait on the spinlock while a sendmmsg is in progress. */
+    SCSpinlock batch_lock;
+    SCMutex send_lock;
+    LIPCVerdictBatch batch[2];
+    uint32_t batch_cur; ///< Batch verdicts are appended to.
+    uint32_t batch_cnt; ///< Number of pending verdicts.
+    uint32_t batch_max; ///< Verdicts per sendmmsg.
+    uint64_t batch_start; ///< Time the oldest pending verdict was queued, in usec.
+    uint64_t batch_flushes; ///< Number of flushes, for stats.
+    uint64_t batch_flushes_reported; ///< Part of batch_flushes already in the stats.
+    bool closing; ///< Receive thread is done, send verdicts right away.
+
+    /** packets not yet released */
+    SC_ATOMIC_DECLARE(uint32_t, inflight);
+    SC_ATOMIC_DECLARE(uint32_t, ref);
+} LIPCConn;
+
+/**
+ * \brief Structure to hold thread specific variables.
  */
 typedef struct LIPCThreadVars_
 {
-    /* counters */
-    uint64_t pkts;
-
     ThreadVars *tv;
     TmSlot *slot;
+    LiveDevice *livedev;
+
+    int fd; ///< Listening socket.
+    int datalink;
+
+    /* socket transport receive buffer */
+    uint8_t *buf;
+    size_t buf_size;
+
+    /* ring transport settings */
+    bool ring;
+    uint32_t ring_slots;
+    uint32_t ring_slot_size;
+    uint32_t ring_poll_spins;
 
-    uint64_t send_errors_logged; /**< snapshot of send errors logged. */
+    /* socket transport verdict batching */
+    uint32_t verdict_batch;
+    uint32_t verdict_flush_usec;
 
-    int fd; ///< IPC socket.
+    /* counters */
+    uint64_t pkts;
+    uint64_t bytes;
+
+    uint16_t capture_lipc_packets;
+    uint16_t capture_lipc_invalid;
+    uint16_t capture_lipc_acquire_pkt_failed;
+    uint16_t capture_lipc_ring_sleeps;
+    uint16_t capture_lipc_ring_wakeups;
+    uint16_t capture_lipc_connections;
+    uint16_t capture_lipc_verdict_flushes;
 } LIPCThreadVars;
 
+static TmEcode ReceiveLIPCThreadInit(ThreadVars *, const void *, void **);
 static void ReceiveLIPCThreadExitStats(ThreadVars *, void *);
+static TmEcode ReceiveLIPCThreadDeinit(ThreadVars *, void *);
+static TmEcode ReceiveLIPCLoop(ThreadVars *tv, void *data, void *slot);
 
-/** Initialize the socket address.
- *
- * @param sa Addres to initialize.
+static TmEcode DecodeLIPCThreadInit(ThreadVars *, const void *, void **);
+static TmEcode DecodeLIPCThreadDeinit(ThreadVars *tv, void *data);
+static TmEcode DecodeLIPC(ThreadVars *, Packet *, void *);
+
+/**
+ * \brief Registration Function for ReceiveLIPC.
+ */
+void TmModuleReceiveLIPCRegister(void)
+{
+    tmm_modules[TMM_RECEIVELIPC].name = "ReceiveLIPC";
+    tmm_modules[TMM_RECEIVELIPC].ThreadInit = ReceiveLIPCThreadInit;
+    tmm_modules[TMM_RECEIVELIPC].Func = NULL;
+    tmm_modules[TMM_RECEIVELIPC].PktAcqLoop = ReceiveLIPCLoop;
+    tmm_modules[TMM_RECEIVELIPC].PktAcqBreakLoop = NULL;
+    tmm_modules[TMM_RECEIVELIPC].ThreadExitPrintStats = ReceiveLIPCThreadExitStats;
+    tmm_modules[TMM_RECEIVELIPC].ThreadDeinit = ReceiveLIPCThreadDeinit;
+    tmm_modules[TMM_RECEIVELIPC].cap_flags = 0;
+    tmm_modules[TMM_RECEIVELIPC].flags = TM_FLAG_RECEIVE_TM;
+}
+
+/**
+ * \brief Registration Function for DecodeLIPC.
  */
-static void av_init_addr(struct sockaddr_un * sa) {
-    sa->sun_family = AF_UNIX;
-    memcpy(&sa->sun_path, SOCKET_NAME, SOCKET_NAME_LEN);
+void TmModuleDecodeLIPCRegister(void)
+{
+    tmm_modules[TMM_DECODELIPC].name = "DecodeLIPC";
+    tmm_modules[TMM_DECODELIPC].ThreadInit = DecodeLIPCThreadInit;
+    tmm_modules[TMM_DECODELIPC].Func = DecodeLIPC;
+    tmm_modules[TMM_DECODELIPC].ThreadExitPrintStats = NULL;
+    tmm_modules[TMM_DECODELIPC].ThreadDeinit = DecodeLIPCThreadDeinit;
+    tmm_modules[TMM_DECODELIPC].cap_flags = 0;
+    tmm_modules[TMM_DECODELIPC].flags = TM_FLAG_DECODE_TM;
 }
 
 /** Open a server socket.
@@ -101,15 +234,20 @@ static void av_init_addr(struct sockaddr_un * sa) {
  *
  * If an error occurs, a negative file descriptor is returned.
  */
-static int av_open(char const ** err_text) {
-    int fd = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+static int LIPCOpenSocket(int backlog, char const **err_text)
+{
+    /* non blocking, as all receive threads race to accept a new client */
+    int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
     *err_text = NULL;
     if (fd >= 0) {
         struct sockaddr_un addr;
-        av_init_addr(&addr);
-        int r = bind(fd, (struct sockaddr *)&addr, SOCKET_ADDR_LEN);
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        memcpy(&addr.sun_path, LIPC_SOCKET_NAME, LIPC_SOCKET_NAME_LEN);
+        socklen_t addr_len = offsetof(struct sockaddr_un, sun_path) + LIPC_SOCKET_NAME_LEN;
+        int r = bind(fd, (struct sockaddr *)&addr, addr_len);
         if (r == 0) {
-            r = listen(fd, 1);
+            r = listen(fd, backlog);
             if (r != 0) {
                 *err_text = "Unable to listen";
             }
@@ -130,105 +268,834 @@ static int av_open(char const ** err_text) {
     return fd;
 }
 
+/** \brief Get a reference to the shared listening socket, opening it if needed. */
+static int LIPCListenerRef(int backlog, char const **err_text)
+{
+    SCMutexLock(&lipc_listener.lock);
+    if (lipc_listener.fd < 0) {
+        lipc_listener.fd = LIPCOpenSocket(backlog, err_text);
+    }
+    int fd = lipc_listener.fd;
+    if (fd >= 0) {
+        lipc_listener.users++;
+    }
+    SCMutexUnlock(&lipc_listener.lock);
+    return fd;
+}
+
+static void LIPCListenerDeref(void)
+{
+    SCMutexLock(&lipc_listener.lock);
+    if (--lipc_listener.users == 0) {
+        close(lipc_listener.fd);
+        lipc_listener.fd = -1;
+    }
+    SCMutexUnlock(&lipc_listener.lock);
+}
 
-// ----
-static TmEcode ReceiveLIPCThreadInit(ThreadVars *tvars, const void *config_data, void ** ctx_data) {
-    SCEnter();
+static inline uint64_t LIPCGetUsecs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+}
+
+static void LIPCVerdictBatchFree(LIPCVerdictBatch *b)
+{
+    SCFree(b->resp);
+    SCFree(b->iov);
+    SCFree(b->msgs);
+}
 
-    if (NULL == config_data) {
-        SCLogError("error: initdata == NULL [LIPC]");
-        SCReturnInt(TM_ECODE_OK);
+static int LIPCVerdictBatchAlloc(LIPCVerdictBatch *b, uint32_t batch_max)
+{
+    b->resp = SCCalloc(batch_max, sizeof(*b->resp));
+    b->iov = SCCalloc(batch_max, sizeof(*b->iov));
+    b->msgs = SCCalloc(batch_max, sizeof(*b->msgs));
+    if (unlikely(b->resp == NULL || b->iov == NULL || b->msgs == NULL)) {
+        return -1;
+    }
+    /* one message per verdict, so clients see the same framing as unbatched */
+    for (uint32_t i = 0; i < batch_max; i++) {
+        b->iov[i].iov_base = &b->resp[i];
+        b->iov[i].iov_len = sizeof(b->resp[i]);
+        b->msgs[i].msg_hdr.msg_iov = &b->iov[i];
+        b->msgs[i].msg_hdr.msg_iovlen = 1;
     }
+    return 0;
+}
 
-    LIPCThreadVars *ctx = SCMalloc(sizeof(*ctx));
-    if (ctx == NULL) {
-        SCLogError("error: Failed to allocated thread vars [LIPC]");
-        SCReturnInt(TM_ECODE_OK);
+static LIPCConn *LIPCConnAlloc(int fd, uint32_t batch_max)
+{
+    LIPCConn *conn = SCCalloc(1, sizeof(*conn));
+    if (unlikely(conn == NULL)) {
+        return NULL;
     }
-    *ctx_data = ctx;
+    conn->fd = fd;
+    conn->req_efd = -1;
+    conn->rsp_efd = -1;
 
-    // Open up the IPC
-    char const * err_text = NULL;
-    ctx->fd = av_open(&err_text);
-    if (ctx->fd < 0) {
-        SCLogError("error: Failed to open IPC - %s [%d]", err_text, errno);
-        SCReturnInt(TM_ECODE_FAILED);
+    for (int b = 0; b < 2; b++) {
+        if (LIPCVerdictBatchAlloc(&conn->batch[b], batch_max) < 0) {
+            LIPCVerdictBatchFree(&conn->batch[0]);
+            LIPCVerdictBatchFree(&conn->batch[1]);
+            SCFree(conn);
+            return NULL;
+        }
     }
+    conn->batch_max = batch_max;
+    SCSpinInit(&conn->batch_lock, 0);
+    SCMutexInit(&conn->send_lock, NULL);
 
-    SCReturnInt(TM_ECODE_OK);
+    SC_ATOMIC_INIT(conn->inflight);
+    SC_ATOMIC_INIT(conn->ref);
+    SC_ATOMIC_SET(conn->ref, 1);
+    return conn;
 }
 
-static TmEcode ReceiveLIPCLoop(ThreadVars *tv, void *data, void *slot)
+static inline LIPCConn *LIPCConnRef(LIPCConn *conn)
 {
-    LIPCThreadVars *ctx = (LIPCThreadVars *)data;
-    char buff[LIPC_SOCKET_BUFFER_LEN];
-    struct av_request * request = (struct av_request*)buff;
-
-    while (ctx->fd >= 0) {
-        int c_fd = accept(ctx->fd, NULL, NULL);
-        if (c_fd >= 0) {
-            while (1) {
-                ssize_t len = recv(c_fd, buff, sizeof(buff), 0);
-                if (len <= 0) {
-                    close(c_fd);
-                    break;
-                }
-                if (len != request->length) {
-                    printf("Invalid length - received=%d length=%d\n", len, request->length);
-                } else {
-                    struct av_response resp;
-                    resp.version = AV_VERSION;
-                    resp.length = sizeof(resp);
-                    resp.id = request->id;
-                    resp.result = (++R) % 5;
-                    resp.pad = 0;
-                    send(c_fd, &resp, sizeof(resp), 0);
+    SC_ATOMIC_ADD(conn->ref, 1);
+    return conn;
+}
+
+/** \brief Drop a reference, closing the connection on the last one. */
+static void LIPCConnDeref(LIPCConn *conn)
+{
+    if (SC_ATOMIC_SUB(conn->ref, 1) != 1) {
+        return;
+    }
+    if (conn->ring != NULL) {
+        munmap(conn->ring, conn->ring_size);
+    }
+    if (conn->req_efd >= 0) {
+        close(conn->req_efd);
+    }
+    if (conn->rsp_efd >= 0) {
+        close(conn->rsp_efd);
+    }
+    close(conn->fd);
+    SCSpinDestroy(&conn->batch_lock);
+    SCMutexDestroy(&conn->send_lock);
+    LIPCVerdictBatchFree(&conn->batch[0]);
+    LIPCVerdictBatchFree(&conn->batch[1]);
+    SCFree(conn);
+}
+
+static inline uint16_t LIPCGetVerdict(const Packet *p)
+{
+    return PacketCheckAction(p, ACTION_DROP) ? LIPC_VERDICT_DROP : LIPC_VERDICT_ACCEPT;
+}
+
+/** \brief Send all pending verdicts.
+ *
+ *  The pending batch is swapped with the spare one under batch_lock, so
+ *  other threads can queue verdicts while it is being sent. send_lock keeps
+ *  the batches in order and the spare one unused until it is sent.
+ */
+static void LIPCSendBatch(LIPCConn *conn)
+{
+    SCMutexLock(&conn->send_lock);
+    SCSpinLock(&conn->batch_lock);
+    const LIPCVerdictBatch *b = &conn->batch[conn->batch_cur];
+    const uint32_t cnt = conn->batch_cnt;
+    if (cnt > 0) {
+        conn->batch_cur ^= 1;
+        conn->batch_cnt = 0;
+        conn->batch_flushes++;
+    }
+    SCSpinUnlock(&conn->batch_lock);
+
+    uint32_t sent = 0;
+    while (sent < cnt) {
+        int r = sendmmsg(conn->fd, &b->msgs[sent], cnt - sent, MSG_NOSIGNAL);
+        if (r < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            /* the client may be gone already, nothing to do about it then */
+            SCLogDebug("failed to send %" PRIu32 " verdicts: %s", cnt - sent, strerror(errno));
+            break;
+        }
+        sent += (uint32_t)r;
+    }
+    SCMutexUnlock(&conn->send_lock);
+}
+
+/** \brief Send all pending verdicts, from the receive thread. */
+static void LIPCFlushVerdicts(ThreadVars *tv, LIPCThreadVars *ptv, LIPCConn *conn)
+{
+    LIPCSendBatch(conn);
+
+    SCSpinLock(&conn->batch_lock);
+    const uint64_t flushes = conn->batch_flushes - conn->batch_flushes_reported;
+    conn->batch_flushes_reported = conn->batch_flushes;
+    SCSpinUnlock(&conn->batch_lock);
+
+    if (flushes > 0) {
+        StatsAddUI64(tv, ptv->capture_lipc_verdict_flushes, flushes);
+    }
+}
+
+/** \brief Stop batching, the receive thread is done with the connection.
+ *
+ *  Verdicts of packets still in flight are sent as soon as they are queued.
+ */
+static void LIPCConnClose(ThreadVars *tv, LIPCThreadVars *ptv, LIPCConn *conn)
+{
+    SCSpinLock(&conn->batch_lock);
+    conn->closing = true;
+    SCSpinUnlock(&conn->batch_lock);
+    LIPCFlushVerdicts(tv, ptv, conn);
+}
+
+/** \brief Queue a verdict, sending the batch once it is full. */
+static void LIPCSendVerdict(LIPCConn *conn, uint32_t id, uint16_t result)
+{
+    SCSpinLock(&conn->batch_lock);
+    /* full batch that another thread is about to send */
+    while (conn->batch_cnt == conn->batch_max) {
+        SCSpinUnlock(&conn->batch_lock);
+        LIPCSendBatch(conn);
+        SCSpinLock(&conn->batch_lock);
+    }
+    if (conn->batch_cnt == 0) {
+        conn->batch_start = LIPCGetUsecs();
+    }
+    struct av_response *resp = &conn->batch[conn->batch_cur].resp[conn->batch_cnt++];
+    resp->version = LIPC_VERSION;
+    resp->length = sizeof(*resp);
+    resp->result = result;
+    resp->pad = 0;
+    resp->id = id;
+    const bool send = conn->batch_cnt == conn->batch_max || conn->closing;
+    SCSpinUnlock(&conn->batch_lock);
+
+    if (send) {
+        LIPCSendBatch(conn);
+    }
+}
+
+/** \brief Check for pending verdicts, which the workers may be queueing.
+ *
+ *  \param start set to the time the oldest pending verdict was queued
+ *  \retval true verdicts are pending
+ */
+static inline bool LIPCVerdictsPending(LIPCConn *conn, uint64_t *start)
+{
+    SCSpinLock(&conn->batch_lock);
+    const bool pending = conn->batch_cnt > 0;
+    *start = conn->batch_start;
+    SCSpinUnlock(&conn->batch_lock);
+    return pending;
+}
+
+/** \brief Flush the batch if its oldest verdict is past the deadline. */
+static inline void LIPCCheckVerdictDeadline(ThreadVars *tv, LIPCThreadVars *ptv, LIPCConn *conn)
+{
+    uint64_t start;
+    if (LIPCVerdictsPending(conn, &start) &&
+            LIPCGetUsecs() - start >= ptv->verdict_flush_usec) {
+        LIPCFlushVerdicts(tv, ptv, conn);
+    }
+}
+
+/** \brief Complete a ring slot, waking the producer if it sleeps. */
+static inline void LIPCRingComplete(LIPCConn *conn, uint32_t slot, uint16_t result)
+{
+    struct lipc_ring_desc *d = &conn->desc[slot];
+    d->result = result;
+    /* sequentially consistent: must not be reordered with the load below */
+    SC_ATOMIC_SET(d->state, LIPC_DESC_DONE);
+    /* clearing the flag makes sure only one of the completing threads pays
+     * for the wakeup */
+    uint32_t sleeping = 1;
+    if (SC_ATOMIC_GET(conn->ring->producer_sleeping) &&
+            SC_ATOMIC_CAS(&conn->ring->producer_sleeping, sleeping, 0)) {
+        uint64_t one = 1;
+        if (write(conn->rsp_efd, &one, sizeof(one)) < 0) {
+            SCLogDebug("failed to wake LIPC producer: %s", strerror(errno));
+        }
+    }
+}
+
+/** \brief Release function for socket transport packets. */
+static void LIPCReleasePacket(Packet *p)
+{
+    LIPCConn *conn = p->lipc_v.conn;
+
+    LIPCSendVerdict(conn, p->lipc_v.id, LIPCGetVerdict(p));
+    SC_ATOMIC_SUB(conn->inflight, 1);
+    LIPCConnDeref(conn);
+    p->lipc_v.conn = NULL;
+
+    PacketFreeOrRelease(p);
+}
+
+/** \brief Release function for ring transport packets.
+ *
+ *  The packet data lives in the ring slot, so the slot is handed back to the
+ *  producer only here, together with the verdict.
+ */
+static void LIPCRingReleasePacket(Packet *p)
+{
+    LIPCConn *conn = p->lipc_v.conn;
+
+    LIPCRingComplete(conn, p->lipc_v.slot, LIPCGetVerdict(p));
+    LIPCConnDeref(conn);
+    p->lipc_v.conn = NULL;
+
+    PacketFreeOrRelease(p);
+}
+
+static inline void LIPCSetupPacket(LIPCThreadVars *ptv, Packet *p, const SCTime_t ts)
+{
+    PKT_SET_SRC(p, PKT_SRC_WIRE);
+    p->ts = ts;
+    p->datalink = ptv->datalink;
+    p->livedev = ptv->livedev;
+}
+
+/**
+ * \brief Wait for and receive one message from the client.
+ *
+ * Pending verdicts are flushed as soon as the connection is idle, the client
+ * is then waiting on them. While packets are in flight on other threads the
+ * wait is bounded by the flush deadline.
+ *
+ * \retval >0 length of the message in ptv->buf
+ * \retval 0 the client closed the connection
+ * \retval -1 error or engine shutdown
+ */
+static ssize_t LIPCRecv(ThreadVars *tv, LIPCThreadVars *ptv, LIPCConn *conn)
+{
+    struct pollfd pfd = { .fd = conn->fd, .events = POLLIN };
+
+    while (likely(suricata_ctl_flags == 0)) {
+        struct timespec timeout = { 0, LIPC_POLL_TIMEOUT * 1000000L };
+        bool idle_wait = true;
+        uint64_t start;
+        if (LIPCVerdictsPending(conn, &start)) {
+            timeout.tv_nsec = 0;
+            idle_wait = false;
+        } else if (ptv->verdict_flush_usec > 0 && SC_ATOMIC_GET(conn->inflight) > 0) {
+            /* without a deadline verdicts are sent when queued, so there
+             * is nothing to wake up for */
+            timeout.tv_nsec = (long)ptv->verdict_flush_usec * 1000L;
+            idle_wait = false;
+        }
+
+        int r = ppoll(&pfd, 1, &timeout, NULL);
+        if (r == 0 || (r < 0 && errno == EINTR)) {
+            LIPCFlushVerdicts(tv, ptv, conn);
+            if (idle_wait) {
+                TmThreadsCaptureHandleTimeout(tv, NULL);
+            }
+            StatsSyncCountersIfSignalled(tv);
+            continue;
+        } else if (r < 0) {
+            SCLogWarning("poll on LIPC connection failed: %s", strerror(errno));
+            return -1;
+        }
+
+        LIPCCheckVerdictDeadline(tv, ptv, conn);
+
+        ssize_t len = recv(conn->fd, ptv->buf, ptv->buf_size, 0);
+        if (len < 0) {
+            if (errno == EINTR || errno == EAGAIN) {
+                continue;
+            }
+            SCLogDebug("recv on LIPC connection failed: %s", strerror(errno));
+            return 0;
+        }
+        return len;
+    }
+    return -1;
+}
+
+/** \brief Turn one socket transport request into a packet. */
+static TmEcode LIPCProcessRequest(ThreadVars *tv, LIPCThreadVars *ptv, LIPCConn *conn, size_t len)
+{
+    const struct av_request *req = (const struct av_request *)ptv->buf;
+
+    if (unlikely(len <= sizeof(*req) || req->length != len || req->version != LIPC_VERSION)) {
+        StatsIncr(tv, ptv->capture_lipc_invalid);
+        SCLogDebug("invalid LIPC request: received %" PRIuMAX, (uintmax_t)len);
+        return TM_ECODE_OK;
+    }
+
+    Packet *p = PacketGetFromQueueOrAlloc();
+    if (unlikely(p == NULL)) {
+        StatsIncr(tv, ptv->capture_lipc_acquire_pkt_failed);
+        LIPCSendVerdict(conn, req->id, LIPC_VERDICT_DROP);
+        return TM_ECODE_OK;
+    }
+
+    struct timeval ts;
+    gettimeofday(&ts, NULL);
+    LIPCSetupPacket(ptv, p, SCTIME_FROM_TIMEVAL(&ts));
+
+    const uint32_t pkt_len = (uint32_t)(len - sizeof(*req));
+    if (unlikely(PacketCopyData(p, ptv->buf + sizeof(*req), pkt_len) == -1)) {
+        StatsIncr(tv, ptv->capture_lipc_invalid);
+        LIPCSendVerdict(conn, req->id, LIPC_VERDICT_DROP);
+        TmqhOutputPacketpool(tv, p);
+        return TM_ECODE_OK;
+    }
+    p->lipc_v.conn = LIPCConnRef(conn);
+    p->lipc_v.id = req->id;
+    p->ReleasePacket = LIPCReleasePacket;
+    SC_ATOMIC_ADD(conn->inflight, 1);
+
+    ptv->pkts++;
+    ptv->bytes += pkt_len;
+    StatsIncr(tv, ptv->capture_lipc_packets);
+
+    return TmThreadsSlotProcessPkt(tv, ptv->slot, p);
+}
+
+/**
+ * \brief Create the shared ring and hand it to the client.
+ *
+ * \retval 0 ok
+ * \retval -1 error, the connection should be closed
+ */
+static int LIPCRingSetup(LIPCThreadVars *ptv, LIPCConn *conn)
+{
+    const size_t page_size = 4096;
+    const uint32_t slots = ptv->ring_slots;
+    const size_t desc_size = (size_t)slots * sizeof(struct lipc_ring_desc);
+    const uint64_t data_offset =
+            LIPC_RING_DESC_OFFSET + ((desc_size + page_size - 1) & ~(page_size - 1));
+    const uint64_t size = data_offset + (uint64_t)slots * ptv->ring_slot_size;
+
+    BUG_ON(sizeof(struct lipc_ring) > LIPC_RING_DESC_OFFSET);
+
+    int mfd = memfd_create("suricata-lipc", MFD_CLOEXEC);
+    if (mfd < 0) {
+        SCLogError("failed to create LIPC ring memfd: %s", strerror(errno));
+        return -1;
+    }
+    if (ftruncate(mfd, (off_t)size) != 0) {
+        SCLogError("failed to size LIPC ring to %" PRIu64 " bytes: %s", size, strerror(errno));
+        goto error;
+    }
+    void *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, mfd, 0);
+    if (map == MAP_FAILED) {
+        SCLogError("failed to map LIPC ring: %s", strerror(errno));
+        goto error;
+    }
+    conn->ring = map;
+    conn->ring_size = size;
+    conn->desc = (struct lipc_ring_desc *)((uint8_t *)map + LIPC_RING_DESC_OFFSET);
+    conn->data = (uint8_t *)map + data_offset;
+    conn->mask = slots - 1;
+    conn->slot_size = ptv->ring_slot_size;
+
+    conn->req_efd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    conn->rsp_efd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (conn->req_efd < 0 || conn->rsp_efd < 0) {
+        SCLogError("failed to create LIPC eventfd: %s", strerror(errno));
+        goto error;
+    }
+
+    /* memfd pages are zero filled, so all descriptors start out free */
+    struct lipc_ring *ring = conn->ring;
+    ring->magic = LIPC_RING_MAGIC;
+    ring->version = LIPC_RING_VERSION;
+    ring->slots = slots;
+    ring->slot_size = ptv->ring_slot_size;
+    ring->data_offset = data_offset;
+    SC_ATOMIC_INIT(ring->head);
+    SC_ATOMIC_INIT(ring->producer_sleeping);
+    SC_ATOMIC_INIT(ring->tail);
+    SC_ATOMIC_INIT(ring->consumer_sleeping);
+
+    struct lipc_ring_setup setup;
+    memset(&setup, 0, sizeof(setup));
+    setup.version = LIPC_RING_VERSION;
+    setup.length = sizeof(setup);
+    setup.slots = slots;
+    setup.slot_size = ptv->ring_slot_size;
+    setup.size = size;
+
+    int fds[3] = { mfd, conn->req_efd, conn->rsp_efd };
+    union {
+        char buf[CMSG_SPACE(sizeof(fds))];
+        struct cmsghdr align;
+    } ctrl;
+    memset(&ctrl, 0, sizeof(ctrl));
+    struct iovec iov = { .iov_base = &setup, .iov_len = sizeof(setup) };
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = ctrl.buf;
+    msg.msg_controllen = sizeof(ctrl.buf);
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+    memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+    if (sendmsg(conn->fd, &msg, MSG_NOSIGNAL) != (ssize_t)sizeof(setup)) {
+        SCLogWarning("failed to send LIPC ring setup: %s", strerror(errno));
+        goto error;
+    }
+
+    /* the mapping keeps the memory alive */
+    close(mfd);
+    SCLogInfo("LIPC client using ring transport: %" PRIu32 " slots of %" PRIu32 " bytes", slots,
+            ptv->ring_slot_size);
+    return 0;
+
+error:
+    close(mfd);
+    return -1;
+}
+
+/**
+ * \brief Block until the producer publishes more slots.
+ *
+ * \retval 0 ok, the ring should be polled again
+ * \retval -1 the client went away
+ */
+static int LIPCRingSleep(ThreadVars *tv, LIPCThreadVars *ptv, LIPCConn *conn, uint32_t tail)
+{
+    struct lipc_ring *ring = conn->ring;
+    int ret = 0;
+
+    /* announce the sleep, then check again so a publish racing with us
+     * is not missed: the producer stores head before loading our flag */
+    SC_ATOMIC_SET(ring->consumer_sleeping, 1);
+    if (SC_ATOMIC_GET(ring->head) == tail) {
+        StatsIncr(tv, ptv->capture_lipc_ring_sleeps);
+
+        struct pollfd fds[2] = {
+            { .fd = conn->req_efd, .events = POLLIN },
+            { .fd = conn->fd, .events = POLLIN },
+        };
+        int r = poll(fds, 2, LIPC_POLL_TIMEOUT);
+        if (r > 0) {
+            if (fds[0].revents & POLLIN) {
+                uint64_t cnt;
+                if (read(conn->req_efd, &cnt, sizeof(cnt)) == sizeof(cnt)) {
+                    StatsIncr(tv, ptv->capture_lipc_ring_wakeups);
                 }
             }
+            if (fds[1].revents & (POLLHUP | POLLERR)) {
+                ret = -1;
+            }
+        } else if (r == 0) {
+            TmThreadsCaptureHandleTimeout(tv, NULL);
+        } else if (errno != EINTR) {
+            SCLogWarning("poll on LIPC ring failed: %s", strerror(errno));
+            ret = -1;
         }
     }
+    SC_ATOMIC_SET(ring->consumer_sleeping, 0);
+    return ret;
 }
 
-static TmEcode ReceiveLIPCThreadDeinit(ThreadVars *tvars, void *data) {
+/** \brief Consume packets from the shared ring until the client leaves. */
+static TmEcode LIPCRingLoop(ThreadVars *tv, LIPCThreadVars *ptv, LIPCConn *conn)
+{
+    struct lipc_ring *ring = conn->ring;
+    uint32_t tail = SC_ATOMIC_GET(ring->tail);
+    uint32_t spins = 0;
+
+    while (likely(suricata_ctl_flags == 0)) {
+        const uint32_t head =
+                SC_ATOMIC_LOAD_EXPLICIT(ring->head, SC_ATOMIC_MEMORY_ORDER_ACQUIRE);
+        if (head == tail) {
+            if (spins++ < ptv->ring_poll_spins) {
+                continue;
+            }
+            if (LIPCRingSleep(tv, ptv, conn, tail) < 0) {
+                break;
+            }
+            spins = 0;
+            continue;
+        }
+        if (unlikely(head - tail > conn->mask + 1)) {
+            SCLogWarning("LIPC producer overran the ring, closing connection");
+            break;
+        }
+        spins = 0;
+
+        struct timeval tv_ts;
+        gettimeofday(&tv_ts, NULL);
+        const SCTime_t ts = SCTIME_FROM_TIMEVAL(&tv_ts);
+
+        while (tail != head) {
+            const uint32_t slot = tail & conn->mask;
+            const struct lipc_ring_desc *d = &conn->desc[slot];
+            const uint32_t len = d->length;
+            const uint32_t id = d->id;
+            tail++;
+
+            if (unlikely(len == 0 || len > conn->slot_size)) {
+                StatsIncr(tv, ptv->capture_lipc_invalid);
+                LIPCRingComplete(conn, slot, LIPC_VERDICT_DROP);
+                continue;
+            }
+
+            Packet *p = PacketGetFromQueueOrAlloc();
+            if (unlikely(p == NULL)) {
+                StatsIncr(tv, ptv->capture_lipc_acquire_pkt_failed);
+                LIPCRingComplete(conn, slot, LIPC_VERDICT_DROP);
+                continue;
+            }
+            LIPCSetupPacket(ptv, p, ts);
+            p->lipc_v.conn = LIPCConnRef(conn);
+            p->lipc_v.id = id;
+            p->lipc_v.slot = slot;
+            p->ReleasePacket = LIPCRingReleasePacket;
+            PacketSetData(p, conn->data + (size_t)slot * conn->slot_size, len);
+
+            ptv->pkts++;
+            ptv->bytes += len;
+            StatsIncr(tv, ptv->capture_lipc_packets);
+
+            if (TmThreadsSlotProcessPkt(tv, ptv->slot, p) != TM_ECODE_OK) {
+                return TM_ECODE_FAILED;
+            }
+        }
+        SC_ATOMIC_STORE_EXPLICIT(ring->tail, tail, SC_ATOMIC_MEMORY_ORDER_RELEASE);
+
+        StatsSyncCountersIfSignalled(tv);
+    }
+    return TM_ECODE_OK;
 }
-// ----
 
-void TmModuleReceivedLICPRegister(void)
+/** \brief Serve one client until it disconnects. */
+static TmEcode LIPCServeConn(ThreadVars *tv, LIPCThreadVars *ptv, LIPCConn *conn)
 {
-    tmm_modules[TMM_RECEIVELIPC].name = "RECEIVELIPC";
-    tmm_modules[TMM_RECEIVELIPC].ThreadInit = ReceiveLIPCThreadInit;
-    tmm_modules[TMM_RECEIVELIPC].Func = NULL;
-    tmm_modules[TMM_RECEIVELIPC].PktAcqLoop = ReceiveLIPCLoop;
-    tmm_modules[TMM_RECEIVELIPC].PktAcqBreakLoop = NULL;
-    tmm_modules[TMM_RECEIVELIPC].ThreadExitPrintStats = ReceiveLIPCThreadExitStats;
-    tmm_modules[TMM_RECEIVELIPC].ThreadDeinit = ReceiveLIPCTheadDeinit;
-    tmm_modules[TMM_RECEIVELIPC].cap_flags = 0;
-    tmm_modules[TMM_RECEIVELIPC].flags = TM_FLAG_RECEIVE_TM;
+    ssize_t len = LIPCRecv(tv, ptv, conn);
+    if (len <= 0) {
+        return TM_ECODE_OK;
+    }
+
+    const struct av_request *req = (const struct av_request *)ptv->buf;
+    if (len == sizeof(*req) && req->version == LIPC_RING_VERSION) {
+        if (!ptv->ring) {
+            SCLogWarning("LIPC client requested the ring transport, which is disabled");
+            return TM_ECODE_OK;
+        }
+        if (LIPCRingSetup(ptv, conn) != 0) {
+            return TM_ECODE_OK;
+        }
+        return LIPCRingLoop(tv, ptv, conn);
+    }
+
+    do {
+        if (LIPCProcessRequest(tv, ptv, conn, (size_t)len) != TM_ECODE_OK) {
+            return TM_ECODE_FAILED;
+        }
+        len = LIPCRecv(tv, ptv, conn);
+    } while (len > 0);
+
+    return TM_ECODE_OK;
 }
 
-static TmECode DecodeLIPC(ThreadVars *tv, Packet *p, void *data) {
+static TmEcode LIPCHandleConn(ThreadVars *tv, LIPCThreadVars *ptv, LIPCConn *conn)
+{
+    StatsIncr(tv, ptv->capture_lipc_connections);
+    TmEcode ret = LIPCServeConn(tv, ptv, conn);
+    LIPCConnClose(tv, ptv, conn);
+    return ret;
 }
 
-static TmEcode DecodeLIPCThreadInit(ThreadVars * tvars, void const *config_data, void **ctx_data) {
+static TmEcode ReceiveLIPCThreadInit(ThreadVars *tv, const void *initdata, void **data)
+{
+    SCEnter();
+
+    LIPCIfaceConfig *lipcconfig = (LIPCIfaceConfig *)initdata;
+    if (initdata == NULL) {
+        SCLogError("initdata == NULL");
+        SCReturnInt(TM_ECODE_FAILED);
+    }
+
+    LIPCThreadVars *ptv = SCCalloc(1, sizeof(LIPCThreadVars));
+    if (unlikely(ptv == NULL)) {
+        lipcconfig->DerefFunc(lipcconfig);
+        SCReturnInt(TM_ECODE_FAILED);
+    }
+
+    ptv->tv = tv;
+    ptv->fd = -1;
+    ptv->livedev = LiveGetDevice("lipc");
+    ptv->datalink = lipcconfig->datalink;
+    ptv->ring = lipcconfig->ring;
+    ptv->ring_slots = lipcconfig->ring_slots;
+    ptv->ring_slot_size = lipcconfig->ring_slot_size;
+    ptv->ring_poll_spins = lipcconfig->ring_poll_spins;
+    ptv->verdict_batch = lipcconfig->verdict_batch;
+    ptv->verdict_flush_usec = lipcconfig->verdict_flush_usec;
+
+    ptv->buf_size = (size_t)lipcconfig->req_buffer_size;
+    ptv->buf = SCMalloc(ptv->buf_size);
+    if (unlikely(ptv->buf == NULL)) {
+        goto error;
+    }
+
+    char const *err_text = NULL;
+    ptv->fd = LIPCListenerRef(lipcconfig->threads, &err_text);
+    if (ptv->fd < 0) {
+        SCLogError("Failed to open IPC - %s: %s", err_text, strerror(errno));
+        goto error;
+    }
+
+    DatalinkSetGlobalType(ptv->datalink);
+
+    ptv->capture_lipc_packets = StatsRegisterCounter("capture.lipc.packets", tv);
+    ptv->capture_lipc_invalid = StatsRegisterCounter("capture.lipc.invalid", tv);
+    ptv->capture_lipc_acquire_pkt_failed =
+            StatsRegisterCounter("capture.lipc.acquire_pkt_failed", tv);
+    ptv->capture_lipc_ring_sleeps = StatsRegisterCounter("capture.lipc.ring_sleeps", tv);
+    ptv->capture_lipc_ring_wakeups = StatsRegisterCounter("capture.lipc.ring_wakeups", tv);
+    ptv->capture_lipc_connections = StatsRegisterCounter("capture.lipc.connections", tv);
+    ptv->capture_lipc_verdict_flushes = StatsRegisterCounter("capture.lipc.verdict_flushes", tv);
+
+    *data = (void *)ptv;
+    lipcconfig->DerefFunc(lipcconfig);
     SCReturnInt(TM_ECODE_OK);
+
+error:
+    if (ptv->buf != NULL) {
+        SCFree(ptv->buf);
+    }
+    SCFree(ptv);
+    lipcconfig->DerefFunc(lipcconfig);
+    SCReturnInt(TM_ECODE_FAILED);
 }
 
-static TmEcode DecodeLIPCThreadInit(ThreadVars *, const void *, void **);
-static TmEcode DecodeLIPCThreadDeinit(ThreadVars *tv, void *data);
-static TmEcode DecodeLIPC(ThreadVars *, Packet *, void *);
+/**
+ *  \brief Main LIPC reading Loop function
+ */
+static TmEcode ReceiveLIPCLoop(ThreadVars *tv, void *data, void *slot)
+{
+    SCEnter();
+
+    LIPCThreadVars *ptv = (LIPCThreadVars *)data;
+    TmSlot *s = (TmSlot *)slot;
+    ptv->slot = s->slot_next;
+
+    TmThreadsSetFlag(tv, THV_RUNNING);
+
+    while (likely(suricata_ctl_flags == 0)) {
+        /* make sure we have at least one packet in the packet pool, to prevent
+         * us from alloc'ing packets at line rate */
+        PacketPoolWait();
+
+        struct pollfd pfd = { .fd = ptv->fd, .events = POLLIN };
+        int r = poll(&pfd, 1, LIPC_POLL_TIMEOUT);
+        if (r == 0 || (r < 0 && errno == EINTR)) {
+            TmThreadsCaptureHandleTimeout(tv, NULL);
+            StatsSyncCountersIfSignalled(tv);
+            continue;
+        } else if (r < 0) {
+            SCLogError("poll on LIPC socket failed: %s", strerror(errno));
+            SCReturnInt(TM_ECODE_FAILED);
+        }
+
+        /* all receive threads wait on the listener, the first one to accept
+         * serves the client */
+        int c_fd = accept4(ptv->fd, NULL, NULL, SOCK_CLOEXEC);
+        if (c_fd < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                SCLogWarning("accept on LIPC socket failed: %s", strerror(errno));
+            }
+            continue;
+        }
+        SCLogDebug("(%s) serving LIPC client on fd %d", tv->name, c_fd);
+        /* verdict-flush-usec 0 sends each verdict right away */
+        LIPCConn *conn =
+                LIPCConnAlloc(c_fd, ptv->verdict_flush_usec == 0 ? 1 : ptv->verdict_batch);
+        if (unlikely(conn == NULL)) {
+            close(c_fd);
+            continue;
+        }
+
+        TmEcode ret = LIPCHandleConn(tv, ptv, conn);
+        LIPCConnDeref(conn);
+        if (ret != TM_ECODE_OK) {
+            SCReturnInt(ret);
+        }
+    }
+
+    SCReturnInt(TM_ECODE_OK);
+}
+
+static TmEcode ReceiveLIPCThreadDeinit(ThreadVars *tv, void *data)
+{
+    LIPCThreadVars *ptv = (LIPCThreadVars *)data;
 
+    if (ptv->fd >= 0) {
+        LIPCListenerDeref();
+    }
+    SCFree(ptv->buf);
+    SCFree(ptv);
+    SCReturnInt(TM_ECODE_OK);
+}
 
 /**
- * \brief Registration Function for DecodeLIPC.
+ * \brief This function prints stats to the screen at exit.
  */
-void TmModuleDecodeAFPRegister (void)
+static void ReceiveLIPCThreadExitStats(ThreadVars *tv, void *data)
 {
-    tmm_modules[TMM_DECODELIPC].name = "DecodeLIPC";
-    tmm_modules[TMM_DECODELIPC].ThreadInit = DecodeLIPCThreadInit;
-    tmm_modules[TMM_DECODELIPC].Func = NULL;
-    tmm_modules[TMM_DECODELIPC].ThreadExitPrintStats = NULL;
-    tmm_modules[TMM_DECODELIPC].ThreadDeinit = NULL;
-    tmm_modules[TMM_DECODELIPC].cap_flags = 0;
-    tmm_modules[TMM_DECODELIPC].flags = TM_FLAG_DECODE_TM;
+    SCEnter();
+    LIPCThreadVars *ptv = (LIPCThreadVars *)data;
+
+    SCLogPerf("(%s) LIPC: Packets %" PRIu64 ", bytes %" PRIu64 ", invalid %" PRIu64 "", tv->name,
+            ptv->pkts, ptv->bytes, StatsGetLocalCounterValue(tv, ptv->capture_lipc_invalid));
+}
+
+/**
+ * \brief This function passes off to link type decoders.
+ */
+static TmEcode DecodeLIPC(ThreadVars *tv, Packet *p, void *data)
+{
+    SCEnter();
+
+    DecodeThreadVars *dtv = (DecodeThreadVars *)data;
+
+    DEBUG_VALIDATE_BUG_ON(PKT_IS_PSEUDOPKT(p));
+
+    /* update counters */
+    DecodeUpdatePacketCounters(tv, dtv, p);
+
+    /* call the decoder */
+    DecodeLinkLayer(tv, dtv, p->datalink, p, GET_PKT_DATA(p), GET_PKT_LEN(p));
+
+    PacketDecodeFinalize(tv, dtv, p);
+
+    SCReturnInt(TM_ECODE_OK);
+}
+
+static TmEcode DecodeLIPCThreadInit(ThreadVars *tv, const void *initdata, void **data)
+{
+    SCEnter();
+    DecodeThreadVars *dtv = DecodeThreadVarsAlloc(tv);
+    if (dtv == NULL)
+        SCReturnInt(TM_ECODE_FAILED);
+
+    DecodeRegisterPerfCounters(dtv, tv);
+
+    *data = (void *)dtv;
+
+    SCReturnInt(TM_ECODE_OK);
 }
 
+static TmEcode DecodeLIPCThreadDeinit(ThreadVars *tv, void *data)
+{
+    if (data != NULL)
+        DecodeThreadVarsFree(tv, data);
+    SCReturnInt(TM_ECODE_OK);
+}
+
+#endif /* HAVE_LIPC */
+/* eof */
+/**
+ * @}
+ */
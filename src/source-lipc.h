@@ -6,6 +6,21 @@
  * \file
  *
  * \author Alan M. Carroll (amc@apache.org)
+ *
+ * Local IPC packet source.
+ *
+ * Clients connect to an abstract \c SOCK_SEQPACKET socket and use one of two
+ * transports.
+ *
+ * - Socket transport (\c LIPC_VERSION): each packet is sent as one message, an
+ *   \c av_request header followed by the packet bytes. A matching \c av_response
+ *   is sent back, as its own message, once the packet has been inspected.
+ *   Responses may be sent in a different order than the requests.
+ * - Ring transport (\c LIPC_RING_VERSION): the first message is a bare
+ *   \c av_request with the ring version. Suricata replies with a
+ *   \c lipc_ring_setup message carrying, via \c SCM_RIGHTS, a memfd holding a
+ *   \c lipc_ring and two eventfds. Packets and verdicts are then exchanged
+ *   through shared memory with no per packet system calls.
  */
 
 #ifndef __SOURCE_LIPC_H__
@@ -14,47 +29,24 @@
 #include <unistd.h>
 #include <stdint.h>
 
-/* per packet LIPC vars */
-typedef struct LIPCPacketVars_
-{
-    uint32_t tenant_id;
-} LIPCPacketVars;
-
-/** needs to be able to contain Windows adapter id's, so
- *  must be quite long. */
-#define LIPC_IFACE_NAME_LENGTH 128
+void TmModuleReceiveLIPCRegister(void);
+void TmModuleDecodeLIPCRegister(void);
 
-typedef struct LIPCIfaceConfig_
-{
-    /* number of threads */
-    int threads;
-    /* Request buffer size */
-    int req_buffer_size;
-
-    // Standard config reference couting.
-    SC_ATOMIC_DECLARE(unsigned int, ref);
-    void (*DerefFunc)(void *);
-
-} LIPCIfaceConfig;
-
-/// Named used to identify the socket.
-extern char const * const SOCKET_NAME;
+/// Abstract socket name, including the leading nul.
+#define LIPC_SOCKET_NAME "\0suricata"
 /// Length of the name in the socket address structure.
-extern size_t const SOCKET_NAME_LEN;
-/// Length of the overall socket address structure.
-extern size_t const SOCKET_ADDR_LEN;
-/// Buffer size for packets
-extern size_t const SOCKET_BUFFER_LEN;
-
-/// Open a server socket to listen for connections.
-/// @return The socket file descriptor or -1 on failure.
-int av_open(char const ** err_text);
+#define LIPC_SOCKET_NAME_LEN (sizeof(LIPC_SOCKET_NAME) - 1)
 
-/// Connect to the server.
-/// @return The socket file descriptor or -1 on failure.
-int av_connect(char const ** err_text);
+/// Socket transport protocol version.
+#define LIPC_VERSION 1
+/// Ring transport protocol version.
+#define LIPC_RING_VERSION 2
 
-extern uint16_t const AV_VERSION;
+/// Verdict values returned to the client.
+enum LIPCVerdict {
+    LIPC_VERDICT_ACCEPT = 0,
+    LIPC_VERDICT_DROP = 1,
+};
 
 struct av_request {
     uint16_t version; ///< Protocol version.
@@ -70,4 +62,111 @@ struct av_response {
     uint32_t id; ///< Transaction identifier.
 };
 
+/** Reply to a ring handshake.
+ *
+ * Sent with three descriptors as \c SCM_RIGHTS, in order: the ring memfd, the
+ * eventfd the client writes to wake Suricata and the eventfd Suricata writes to
+ * wake the client.
+ */
+struct lipc_ring_setup {
+    uint16_t version; ///< Protocol version.
+    uint16_t length; ///< Length of this message.
+    uint32_t slots; ///< Number of ring slots, a power of 2.
+    uint32_t slot_size; ///< Bytes of packet data per slot.
+    uint32_t pad; ///< Future expansion.
+    uint64_t size; ///< Size of the memfd mapping.
+};
+
+/// Descriptor ownership flags, see \c lipc_ring_desc::state.
+#define LIPC_DESC_FREE 0
+#define LIPC_DESC_DONE 1
+
+/** Per slot descriptor.
+ *
+ * The producer fills \c length and \c id and publishes the slot by advancing
+ * \c lipc_ring::head. Once the packet is inspected Suricata stores the verdict
+ * in \c result and sets \c state to \c LIPC_DESC_DONE. The producer reclaims
+ * slots in ring order, resetting \c state to \c LIPC_DESC_FREE. Slot data must
+ * not be touched by the producer between publishing and reclaiming.
+ */
+struct lipc_ring_desc {
+    uint32_t id; ///< Transaction identifier.
+    uint32_t length; ///< Length of the packet in the slot.
+    uint16_t result; ///< Verdict, see \c LIPCVerdict.
+    uint16_t pad; ///< Future expansion.
+    SC_ATOMIC_DECLARE(uint32_t, state);
+};
+
+#define LIPC_RING_MAGIC 0x4c495043 /* "LIPC" */
+/// Offset of the descriptor array in the mapping.
+#define LIPC_RING_DESC_OFFSET 4096
+
+/** Shared ring header, at the start of the memfd mapping.
+ *
+ * The descriptor array starts at \c LIPC_RING_DESC_OFFSET, slot data at
+ * \c data_offset, slot \c i being at \c data_offset + \c i * \c slot_size.
+ * Indexes are free running, the slot is the index masked with \c slots - 1.
+ * Producer and consumer fields are kept on separate cache lines.
+ */
+struct lipc_ring {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t pad;
+    uint32_t slots;
+    uint32_t slot_size;
+    uint64_t data_offset;
+
+    /** Producer owned: next slot to be published. */
+    SC_ATOMIC_DECLARE(uint32_t, head) __attribute__((aligned(64)));
+    /** Set by the producer before blocking on the verdict eventfd, cleared
+     *  by Suricata when it signals the eventfd. */
+    SC_ATOMIC_DECLARE(uint32_t, producer_sleeping);
+
+    /** Consumer owned: next slot to be read by Suricata. */
+    SC_ATOMIC_DECLARE(uint32_t, tail) __attribute__((aligned(64)));
+    /** Set by Suricata before blocking on the request eventfd. */
+    SC_ATOMIC_DECLARE(uint32_t, consumer_sleeping);
+};
+
+#ifdef HAVE_LIPC
+/* per packet LIPC vars */
+typedef struct LIPCPacketVars_
+{
+    /** connection the packet came from, holds a reference */
+    struct LIPCConn_ *conn;
+    /** transaction id to echo in the verdict */
+    uint32_t id;
+    /** ring slot holding the packet data, ring transport only */
+    uint32_t slot;
+} LIPCPacketVars;
+#endif
+
+typedef struct LIPCIfaceConfig_
+{
+    /* number of threads */
+    int threads;
+    /* Request buffer size */
+    int req_buffer_size;
+    /* datalink of the packets sent by clients */
+    int datalink;
+
+    /* offer the shared memory ring transport */
+    bool ring;
+    /* ring geometry */
+    uint32_t ring_slots;
+    uint32_t ring_slot_size;
+    /* empty ring polls before sleeping on the eventfd */
+    uint32_t ring_poll_spins;
+
+    /* socket transport verdicts per sendmmsg */
+    uint32_t verdict_batch;
+    /* max time a verdict is held back for batching */
+    uint32_t verdict_flush_usec;
+
+    // Standard config reference couting.
+    SC_ATOMIC_DECLARE(unsigned int, ref);
+    void (*DerefFunc)(void *);
+
+} LIPCIfaceConfig;
+
 #endif /* __SOURCE_LIPC_H__ */
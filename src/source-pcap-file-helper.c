@@ -24,6 +24,7 @@
  */
 
 #include "source-pcap-file-helper.h"
+#include "source-pcap-file-mmap.h"
 #include "suricata.h"
 #include "util-datalink.h"
 #include "util-checksum.h"
@@ -39,6 +40,10 @@ static void PcapFileCallbackLoop(char *user, struct pcap_pkthdr *h, u_char *pkt)
 void CleanupPcapFileFileVars(PcapFileFileVars *pfv)
 {
     if (pfv != NULL) {
+        if (pfv->mmap != NULL) {
+            PcapFileMmapClose(pfv->mmap);
+            pfv->mmap = NULL;
+        }
         if (pfv->pcap_handle != NULL) {
             pcap_close(pfv->pcap_handle);
             pfv->pcap_handle = NULL;
@@ -58,6 +63,40 @@ void CleanupPcapFileFileVars(PcapFileFileVars *pfv)
     }
 }
 
+/**
+ *  \brief set the checksum validation flags of a packet read from a file
+ *
+ *  \param pkts packets read by the calling thread so far, used by the
+ *              auto mode
+ */
+void PcapFileSetPacketChecksumMode(Packet *p, uint64_t pkts)
+{
+    /* We only check for checksum disable */
+    if (pcap_g.checksum_mode == CHECKSUM_VALIDATION_DISABLE) {
+        p->flags |= PKT_IGNORE_CHECKSUM;
+    } else if (pcap_g.checksum_mode == CHECKSUM_VALIDATION_AUTO) {
+        if (ChecksumAutoModeCheck(pkts, p->pcap_cnt, SC_ATOMIC_GET(pcap_g.invalid_checksums))) {
+            pcap_g.checksum_mode = CHECKSUM_VALIDATION_DISABLE;
+            p->flags |= PKT_IGNORE_CHECKSUM;
+        }
+    }
+}
+
+TmEcode PcapFileProcessBatch(PcapFileFileVars *ptv)
+{
+    const uint32_t cnt = ptv->batch_cnt;
+    ptv->batch_cnt = 0;
+    if (cnt == 0)
+        return TM_ECODE_OK;
+
+    if (TmThreadsSlotProcessPktBatch(ptv->shared->tv, ptv->shared->slot, ptv->batch, cnt) !=
+            TM_ECODE_OK) {
+        ptv->shared->cb_result = TM_ECODE_FAILED;
+        return TM_ECODE_FAILED;
+    }
+    return TM_ECODE_OK;
+}
+
 void PcapFileCallbackLoop(char *user, struct pcap_pkthdr *h, u_char *pkt)
 {
     SCEnter();
@@ -92,22 +131,13 @@ void PcapFileCallbackLoop(char *user, struct pcap_pkthdr *h, u_char *pkt)
         SCReturn;
     }
 
-    /* We only check for checksum disable */
-    if (pcap_g.checksum_mode == CHECKSUM_VALIDATION_DISABLE) {
-        p->flags |= PKT_IGNORE_CHECKSUM;
-    } else if (pcap_g.checksum_mode == CHECKSUM_VALIDATION_AUTO) {
-        if (ChecksumAutoModeCheck(ptv->shared->pkts, p->pcap_cnt,
-                                  SC_ATOMIC_GET(pcap_g.invalid_checksums))) {
-            pcap_g.checksum_mode = CHECKSUM_VALIDATION_DISABLE;
-            p->flags |= PKT_IGNORE_CHECKSUM;
-        }
-    }
+    PcapFileSetPacketChecksumMode(p, ptv->shared->pkts);
 
     PACKET_PROFILING_TMM_END(p, TMM_RECEIVEPCAPFILE);
 
-    if (TmThreadsSlotProcessPkt(ptv->shared->tv, ptv->shared->slot, p) != TM_ECODE_OK) {
+    ptv->batch[ptv->batch_cnt++] = p;
+    if (ptv->batch_cnt == TM_PKT_BATCH_SIZE && PcapFileProcessBatch(ptv) != TM_ECODE_OK) {
         pcap_breakloop(ptv->pcap_handle);
-        ptv->shared->cb_result = TM_ECODE_FAILED;
     }
 
     SCReturn;
@@ -127,11 +157,17 @@ TmEcode PcapFileDispatch(PcapFileFileVars *ptv)
 {
     SCEnter();
 
+    if (ptv->mmap != NULL) {
+        strlcpy(pcap_filename, ptv->filename, sizeof(pcap_filename));
+        SCReturnInt(PcapFileMmapDispatch(ptv));
+    }
+
     /* initialize all the thread's initial timestamp */
     if (likely(ptv->first_pkt_hdr != NULL)) {
         TmThreadsInitThreadsTimestamp(SCTIME_FROM_TIMEVAL(&ptv->first_pkt_ts));
         PcapFileCallbackLoop((char *)ptv, ptv->first_pkt_hdr,
                 (u_char *)ptv->first_pkt_data);
+        (void)PcapFileProcessBatch(ptv);
         ptv->first_pkt_hdr = NULL;
         ptv->first_pkt_data = NULL;
     }
@@ -149,9 +185,11 @@ TmEcode PcapFileDispatch(PcapFileFileVars *ptv)
          * us from alloc'ing packets at line rate */
         PacketPoolWait();
 
-        /* Right now we just support reading packets one at a time. */
+        /* read up to packet_q_len packets, passed on in batches */
         int r = pcap_dispatch(ptv->pcap_handle, packet_q_len,
                           (pcap_handler)PcapFileCallbackLoop, (u_char *)ptv);
+        /* packets are copied, so they can outlive the pcap buffer */
+        (void)PcapFileProcessBatch(ptv);
         if (unlikely(r == -1)) {
             SCLogError("error code %" PRId32 " %s for %s", r, pcap_geterr(ptv->pcap_handle),
                     ptv->filename);
@@ -202,6 +240,17 @@ TmEcode InitPcapFile(PcapFileFileVars *pfv)
         SCReturnInt(TM_ECODE_FAILED);
     }
 
+    if (pfv->shared != NULL && pfv->shared->use_mmap &&
+            PcapFileMmapOpen(pfv->filename, pfv->shared->bpf_string, &pfv->mmap) ==
+                    TM_ECODE_OK) {
+        pfv->datalink = PcapFileMmapDatalink(pfv->mmap);
+        SCLogDebug("datalink %" PRId32 "", pfv->datalink);
+        DatalinkSetGlobalType(pfv->datalink);
+
+        DecoderFunc UnusedFnPtr;
+        SCReturnInt(ValidateLinkType(pfv->datalink, &UnusedFnPtr));
+    }
+
     pfv->pcap_handle = pcap_open_offline(pfv->filename, errbuf);
     if (pfv->pcap_handle == NULL) {
         SCLogError("%s", errbuf);
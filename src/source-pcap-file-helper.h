@@ -27,6 +27,14 @@
 #ifndef __SOURCE_PCAP_FILE_HELPER_H__
 #define __SOURCE_PCAP_FILE_HELPER_H__
 
+/* classic pcap file format */
+#define PCAP_MAGIC_USEC     0xa1b2c3d4
+#define PCAP_MAGIC_NSEC     0xa1b23c4d
+#define PCAP_FILE_HDR_LEN   24
+#define PCAP_RECORD_HDR_LEN 16
+/** largest record accepted, same as libpcap */
+#define PCAP_MAX_CAPLEN 262144
+
 typedef struct PcapFileGlobalVars_ {
     uint64_t cnt; /** packet counter */
     ChecksumValidationMode conf_checksum_mode;
@@ -46,6 +54,8 @@ typedef struct PcapFileSharedVars_
     struct timespec last_processed;
 
     bool should_delete;
+    /** read files through a memory mapping, not libpcap */
+    bool use_mmap;
 
     ThreadVars *tv;
     TmSlot *slot;
@@ -62,6 +72,8 @@ typedef struct PcapFileSharedVars_
     int cb_result;
 } PcapFileSharedVars;
 
+typedef struct PcapFileMmap_ PcapFileMmap;
+
 /**
  * Data specific to a single pcap file
  */
@@ -69,6 +81,8 @@ typedef struct PcapFileFileVars_
 {
     char *filename;
     pcap_t *pcap_handle;
+    /** set instead of pcap_handle if the file is mapped */
+    PcapFileMmap *mmap;
 
     int datalink;
     struct bpf_program filter;
@@ -80,6 +94,10 @@ typedef struct PcapFileFileVars_
     const u_char *first_pkt_data;
     struct pcap_pkthdr *first_pkt_hdr;
     struct timeval first_pkt_ts;
+
+    /* packets read but not yet run through the pipeline */
+    Packet *batch[TM_PKT_BATCH_SIZE];
+    uint32_t batch_cnt;
 } PcapFileFileVars;
 
 /**
@@ -112,6 +130,20 @@ void CleanupPcapFileFileVars(PcapFileFileVars *pfv);
  */
 TmEcode ValidateLinkType(int datalink, DecoderFunc *decoder);
 
+/**
+ * Run the packets collected in the batch through the pipeline
+ * @param ptv PcapFileFileVars object of the file
+ * @return TM_ECODE_FAILED if one of the thread modules failed
+ */
+TmEcode PcapFileProcessBatch(PcapFileFileVars *ptv);
+
+/**
+ * Set the checksum validation flags of a packet according to pcap-file.checksum-checks.
+ * @param p Packet read from the file
+ * @param pkts Number of packets read so far by the calling thread
+ */
+void PcapFileSetPacketChecksumMode(Packet *p, uint64_t pkts);
+
 const char *PcapFileGetFilename(void);
 
 #endif /* __SOURCE_PCAP_FILE_HELPER_H__ */
@@ -0,0 +1,1163 @@
+/* Copyright (C) 2026 Open Information Security Foundation
+ *
+ * You can copy, redistribute or modify this Program under the terms of
+ * the GNU General Public License version 2 as published by the Free
+ * Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/**
+ * \file
+ *
+ * Reading pcap and pcapng files through a memory mapping.
+ *
+ * Packets point into the mapping instead of getting a copy of the data.
+ * The mapping is reference counted: the reader holds one reference and
+ * every packet holds one until it is released, so the file can be closed
+ * while the workers still have some of its packets. Reading ahead is left
+ * to the kernel, helped by MADV_SEQUENTIAL and MADV_WILLNEED ahead of the
+ * read position.
+ *
+ * LZ4 compressed files are decompressed from the mapping into a buffer,
+ * their packets are copied.
+ */
+
+#include "source-pcap-file-mmap.h"
+#include "suricata.h"
+#include "packet.h"
+#include "tmqh-packetpool.h"
+#include "util-byte.h"
+#include "util-exception-policy.h"
+#include "util-profiling.h"
+#include "util-unittest.h"
+
+#include <sys/mman.h>
+
+#ifdef HAVE_LIBLZ4
+#include <lz4frame.h>
+#endif /* HAVE_LIBLZ4 */
+
+extern PcapFileGlobalVars pcap_g;
+
+/** pcapng block types */
+#define PCAPNG_BLOCK_SHB 0x0A0D0D0A
+#define PCAPNG_BLOCK_IDB 0x00000001
+#define PCAPNG_BLOCK_SPB 0x00000003
+#define PCAPNG_BLOCK_EPB 0x00000006
+#define PCAPNG_BYTE_ORDER_MAGIC 0x1A2B3C4D
+/** interface description block options */
+#define PCAPNG_OPT_END       0
+#define PCAPNG_OPT_TSRESOL   9
+#define PCAPNG_OPT_TSOFFSET  14
+/** largest block accepted */
+#define PCAPNG_MAX_BLOCK_LEN (16 * 1024 * 1024)
+
+#define LZ4F_MAGIC 0x184D2204
+
+/** bytes to ask the kernel to read ahead at once */
+#define PCAP_FILE_MMAP_READAHEAD (8 * 1024 * 1024)
+/** records read per loop, between checks of the packet pool */
+#define PCAP_FILE_MMAP_BURST 64
+/** initial size of the buffer for decompressed data */
+#define PCAP_FILE_MMAP_LZ4_BUF_SIZE (1024 * 1024)
+
+/**
+ * The mapped file, freed by whoever drops the last reference
+ */
+typedef struct PcapFileMmapRegion_ {
+    uint8_t *addr;
+    size_t len;
+    SC_ATOMIC_DECLARE(uint32_t, refcnt);
+} PcapFileMmapRegion;
+
+typedef struct PcapFileMmapIface_ {
+    uint64_t units; /**< timestamp units per second */
+    int64_t offset; /**< seconds added to the timestamps */
+    uint32_t snaplen;
+} PcapFileMmapIface;
+
+typedef struct PcapFileMmapRecord_ {
+    const uint8_t *data;
+    uint32_t caplen;
+    uint32_t len;
+    SCTime_t ts;
+} PcapFileMmapRecord;
+
+struct PcapFileMmap_ {
+    char *filename;
+    PcapFileMmapRegion *region;
+
+    /** bytes being parsed: the mapping, or the decompressed data */
+    const uint8_t *data;
+    size_t data_len;
+    size_t pos;
+    /** packets can point into data */
+    bool zero_copy;
+    /** end of the range passed to MADV_WILLNEED */
+    size_t readahead;
+
+    bool pcapng;
+    bool swapped;
+    bool nsec;
+    int datalink;
+    uint32_t max_caplen;
+    SCTime_t last_ts;
+
+    /** pcapng interfaces of the current section */
+    PcapFileMmapIface *ifaces;
+    uint32_t ifaces_cnt;
+    uint32_t ifaces_size;
+
+    bool has_filter;
+    struct bpf_program filter;
+
+    /** first packet, read at open like the libpcap reader does */
+    PcapFileMmapRecord first;
+    bool have_first;
+
+#ifdef HAVE_LIBLZ4
+    LZ4F_dctx *lz4;
+    /** read position in the compressed data */
+    size_t lz4_pos;
+    uint8_t *buf;
+    size_t buf_size;
+#endif /* HAVE_LIBLZ4 */
+};
+
+static inline uint16_t PcapFileMmapGet16(const PcapFileMmap *m, const uint8_t *data)
+{
+    uint16_t v;
+    memcpy(&v, data, sizeof(v));
+    return m->swapped ? SCByteSwap16(v) : v;
+}
+
+static inline uint32_t PcapFileMmapGet32(const PcapFileMmap *m, const uint8_t *data)
+{
+    uint32_t v;
+    memcpy(&v, data, sizeof(v));
+    return m->swapped ? SCByteSwap32(v) : v;
+}
+
+/** \internal
+ *  \brief read a little endian value, for magics with a fixed byte order */
+static inline uint32_t PcapFileMmapGetLE32(const uint8_t *data)
+{
+    return (uint32_t)data[0] | (uint32_t)data[1] << 8 | (uint32_t)data[2] << 16 |
+           (uint32_t)data[3] << 24;
+}
+
+static void PcapFileMmapRegionDeref(PcapFileMmapRegion *r)
+{
+    if (SC_ATOMIC_SUB(r->refcnt, 1) == 1) {
+        munmap(r->addr, r->len);
+        SCFree(r);
+    }
+}
+
+/** \internal
+ *  \brief release a packet pointing into the mapping */
+static void PcapFileMmapReleasePacket(Packet *p)
+{
+    PcapFileMmapRegion *r = p->pcap_v.relptr;
+    p->pcap_v.relptr = NULL;
+    PacketFreeOrRelease(p);
+
+    /* the packet data can't be used after this */
+    PcapFileMmapRegionDeref(r);
+}
+
+/** \internal
+ *  \brief let the kernel read the mapping ahead of the position */
+static void PcapFileMmapReadahead(PcapFileMmap *m, size_t pos)
+{
+    PcapFileMmapRegion *r = m->region;
+    if (pos + PCAP_FILE_MMAP_READAHEAD / 2 < m->readahead || m->readahead >= r->len)
+        return;
+
+    const size_t len = MIN(PCAP_FILE_MMAP_READAHEAD, r->len - m->readahead);
+    (void)madvise(r->addr + m->readahead, len, MADV_WILLNEED);
+    m->readahead += len;
+}
+
+#ifdef HAVE_LIBLZ4
+/** \internal
+ *  \brief decompress until at least n bytes are available at the position
+ *
+ *  The unparsed bytes are moved to the start of the buffer first, so
+ *  pointers into the data are only valid until the next call.
+ */
+static bool PcapFileMmapLz4Fill(PcapFileMmap *m, size_t n)
+{
+    size_t avail = m->data_len - m->pos;
+    if (avail > 0 && m->pos > 0)
+        memmove(m->buf, m->buf + m->pos, avail);
+    m->pos = 0;
+    m->data_len = avail;
+
+    if (n > m->buf_size) {
+        size_t size = MAX(n, MAX(m->buf_size * 2, PCAP_FILE_MMAP_LZ4_BUF_SIZE));
+        uint8_t *buf = SCRealloc(m->buf, size);
+        if (unlikely(buf == NULL))
+            return false;
+        m->buf = buf;
+        m->buf_size = size;
+    }
+    m->data = m->buf;
+
+    while (m->data_len < n && m->lz4_pos < m->region->len) {
+        PcapFileMmapReadahead(m, m->lz4_pos);
+
+        size_t dst_len = m->buf_size - m->data_len;
+        size_t src_len = m->region->len - m->lz4_pos;
+        size_t r = LZ4F_decompress(m->lz4, m->buf + m->data_len, &dst_len,
+                m->region->addr + m->lz4_pos, &src_len, NULL);
+        if (LZ4F_isError(r)) {
+            SCLogError("%s: LZ4F_decompress: %s", m->filename, LZ4F_getErrorName(r));
+            return false;
+        }
+        if (src_len == 0 && dst_len == 0)
+            break;
+        m->lz4_pos += src_len;
+        m->data_len += dst_len;
+    }
+    return m->data_len >= n;
+}
+#endif /* HAVE_LIBLZ4 */
+
+/** \internal
+ *  \brief make sure n bytes can be read at the position */
+static inline bool PcapFileMmapNeed(PcapFileMmap *m, size_t n)
+{
+    if (likely(m->data_len - m->pos >= n))
+        return true;
+#ifdef HAVE_LIBLZ4
+    if (m->lz4 != NULL)
+        return PcapFileMmapLz4Fill(m, n);
+#endif /* HAVE_LIBLZ4 */
+    return false;
+}
+
+/** \internal
+ *  \brief no more complete records, check the file ended cleanly
+ *
+ *  A partial record at the end is an error, as in libpcap.
+ *
+ *  \retval 0 end of file, -1 truncated file
+ */
+static int PcapFileMmapEnd(const PcapFileMmap *m)
+{
+    if (m->pos < m->data_len) {
+        SCLogError("%s: truncated dump file; %" PRIuMAX " bytes of an incomplete record left",
+                m->filename, (uintmax_t)(m->data_len - m->pos));
+        return -1;
+    }
+    return 0;
+}
+
+static int PcapFileMmapNextPcap(PcapFileMmap *m, PcapFileMmapRecord *rec)
+{
+    if (!PcapFileMmapNeed(m, PCAP_RECORD_HDR_LEN)) {
+        return PcapFileMmapEnd(m);
+    }
+    const uint8_t *hdr = m->data + m->pos;
+    const uint32_t caplen = PcapFileMmapGet32(m, hdr + 8);
+    if (caplen > m->max_caplen) {
+        SCLogError("%s: record has invalid length %u", m->filename, caplen);
+        return -1;
+    }
+    if (!PcapFileMmapNeed(m, PCAP_RECORD_HDR_LEN + caplen)) {
+        return PcapFileMmapEnd(m);
+    }
+    /* the buffer may have moved */
+    hdr = m->data + m->pos;
+
+    const uint32_t frac = PcapFileMmapGet32(m, hdr + 4);
+    rec->ts.secs = PcapFileMmapGet32(m, hdr);
+    rec->ts.usecs = m->nsec ? frac / 1000 : frac;
+    rec->caplen = caplen;
+    rec->len = PcapFileMmapGet32(m, hdr + 12);
+    rec->data = hdr + PCAP_RECORD_HDR_LEN;
+    m->pos += PCAP_RECORD_HDR_LEN + caplen;
+    return 1;
+}
+
+/** \internal
+ *  \brief add an interface from an interface description block */
+static int PcapFileMmapAddIface(PcapFileMmap *m, const uint8_t *body, uint32_t body_len)
+{
+    if (body_len < 8) {
+        SCLogError("%s: invalid interface description block", m->filename);
+        return -1;
+    }
+    const int linktype = PcapFileMmapGet16(m, body);
+    if (linktype != m->datalink && m->datalink != -1) {
+        SCLogError("%s: interfaces with different link types are not supported", m->filename);
+        return -1;
+    }
+    m->datalink = linktype;
+
+    if (m->ifaces_cnt == m->ifaces_size) {
+        uint32_t size = m->ifaces_size ? m->ifaces_size * 2 : 4;
+        PcapFileMmapIface *ifaces = SCRealloc(m->ifaces, size * sizeof(*ifaces));
+        if (unlikely(ifaces == NULL))
+            return -1;
+        m->ifaces = ifaces;
+        m->ifaces_size = size;
+    }
+    PcapFileMmapIface *iface = &m->ifaces[m->ifaces_cnt++];
+    iface->units = 1000000;
+    iface->offset = 0;
+    iface->snaplen = PcapFileMmapGet32(m, body + 4);
+
+    for (uint32_t o = 8; o + 4 <= body_len;) {
+        const uint16_t code = PcapFileMmapGet16(m, body + o);
+        const uint16_t len = PcapFileMmapGet16(m, body + o + 2);
+        if (code == PCAPNG_OPT_END || o + 4 + len > body_len)
+            break;
+        const uint8_t *val = body + o + 4;
+        if (code == PCAPNG_OPT_TSRESOL && len >= 1) {
+            const uint8_t exp = val[0] & 0x7f;
+            if ((val[0] & 0x80) ? exp > 63 : exp > 19) {
+                SCLogError("%s: unsupported timestamp resolution %02x", m->filename, val[0]);
+                return -1;
+            }
+            uint64_t units = 1;
+            for (uint8_t i = 0; i < exp; i++) {
+                units *= (val[0] & 0x80) ? 2 : 10;
+            }
+            iface->units = units;
+        } else if (code == PCAPNG_OPT_TSOFFSET && len >= 8) {
+            uint64_t v;
+            memcpy(&v, val, sizeof(v));
+            iface->offset = (int64_t)(m->swapped ? SCByteSwap64(v) : v);
+        }
+        o += 4 + ((len + 3) & ~3);
+    }
+    return 0;
+}
+
+/** \internal
+ *  \brief parse one pcapng block
+ *
+ *  \retval 1 packet, 2 other block, 0 end of file, -1 error or truncated file
+ */
+static int PcapFileMmapPcapngBlock(PcapFileMmap *m, PcapFileMmapRecord *rec)
+{
+    if (!PcapFileMmapNeed(m, 12)) {
+        return PcapFileMmapEnd(m);
+    }
+    const uint8_t *hdr = m->data + m->pos;
+    const uint32_t type = PcapFileMmapGet32(m, hdr);
+    if (type == PCAPNG_BLOCK_SHB) {
+        /* a new section may change the byte order */
+        uint32_t magic;
+        memcpy(&magic, hdr + 8, sizeof(magic));
+        if (magic != PCAPNG_BYTE_ORDER_MAGIC && SCByteSwap32(magic) != PCAPNG_BYTE_ORDER_MAGIC) {
+            SCLogError("%s: invalid section header block", m->filename);
+            return -1;
+        }
+        m->swapped = magic != PCAPNG_BYTE_ORDER_MAGIC;
+        m->ifaces_cnt = 0;
+    }
+    const uint32_t len = PcapFileMmapGet32(m, hdr + 4);
+    if (len < 12 || (len & 3) != 0 || len > PCAPNG_MAX_BLOCK_LEN) {
+        SCLogError("%s: block has invalid length %u", m->filename, len);
+        return -1;
+    }
+    if (!PcapFileMmapNeed(m, len)) {
+        return PcapFileMmapEnd(m);
+    }
+    hdr = m->data + m->pos;
+    m->pos += len;
+
+    const uint8_t *body = hdr + 8;
+    const uint32_t body_len = len - 12;
+    switch (type) {
+        case PCAPNG_BLOCK_IDB:
+            if (PcapFileMmapAddIface(m, body, body_len) < 0)
+                return -1;
+            return 2;
+        case PCAPNG_BLOCK_EPB: {
+            if (body_len < 20)
+                break;
+            const uint32_t id = PcapFileMmapGet32(m, body);
+            const uint32_t caplen = PcapFileMmapGet32(m, body + 12);
+            if (id >= m->ifaces_cnt || caplen > body_len - 20 || caplen > m->max_caplen)
+                break;
+            const PcapFileMmapIface *iface = &m->ifaces[id];
+            const uint64_t ts = ((uint64_t)PcapFileMmapGet32(m, body + 4) << 32) |
+                                PcapFileMmapGet32(m, body + 8);
+            const uint64_t frac = ts % iface->units;
+            rec->ts.secs = (uint64_t)((int64_t)(ts / iface->units) + iface->offset);
+            rec->ts.usecs = (uint64_t)((double)frac * 1000000 / iface->units);
+            rec->caplen = caplen;
+            rec->len = PcapFileMmapGet32(m, body + 16);
+            rec->data = body + 20;
+            m->last_ts = rec->ts;
+            return 1;
+        }
+        case PCAPNG_BLOCK_SPB: {
+            if (body_len < 4 || m->ifaces_cnt == 0)
+                break;
+            const uint32_t orig_len = PcapFileMmapGet32(m, body);
+            uint32_t caplen = MIN(orig_len, body_len - 4);
+            if (m->ifaces[0].snaplen != 0)
+                caplen = MIN(caplen, m->ifaces[0].snaplen);
+            if (caplen > m->max_caplen)
+                break;
+            /* no timestamp, keep time from going backwards */
+            rec->ts = m->last_ts;
+            rec->caplen = caplen;
+            rec->len = orig_len;
+            rec->data = body + 4;
+            return 1;
+        }
+        default:
+            return 2;
+    }
+
+    SCLogError("%s: invalid packet block", m->filename);
+    return -1;
+}
+
+static int PcapFileMmapNextPcapng(PcapFileMmap *m, PcapFileMmapRecord *rec)
+{
+    int r;
+    while ((r = PcapFileMmapPcapngBlock(m, rec)) == 2)
+        ;
+    return r;
+}
+
+/** \internal
+ *  \brief get the next record that passes the bpf filter
+ *
+ *  \retval 1 record, 0 end of file, -1 error or truncated file
+ */
+static int PcapFileMmapNext(PcapFileMmap *m, PcapFileMmapRecord *rec)
+{
+    while (1) {
+        if (m->zero_copy)
+            PcapFileMmapReadahead(m, m->pos);
+
+        int r = m->pcapng ? PcapFileMmapNextPcapng(m, rec) : PcapFileMmapNextPcap(m, rec);
+        if (r <= 0)
+            return r;
+
+        if (m->has_filter) {
+            struct pcap_pkthdr h = { .caplen = rec->caplen, .len = rec->len };
+            if (pcap_offline_filter(&m->filter, &h, rec->data) == 0)
+                continue;
+        }
+        return 1;
+    }
+}
+
+/** \internal
+ *  \brief parse the file header, up to the first interface for pcapng */
+static bool PcapFileMmapParseHeader(PcapFileMmap *m)
+{
+    if (!PcapFileMmapNeed(m, PCAP_FILE_HDR_LEN))
+        return false;
+
+    uint32_t magic;
+    memcpy(&magic, m->data, sizeof(magic));
+    if (magic == PCAPNG_BLOCK_SHB) {
+        m->pcapng = true;
+        m->datalink = -1;
+        m->max_caplen = PCAPNG_MAX_BLOCK_LEN;
+
+        /* parse blocks until the link type is known, packets can't come
+         * before the first interface */
+        while (m->ifaces_cnt == 0) {
+            PcapFileMmapRecord rec;
+            if (PcapFileMmapPcapngBlock(m, &rec) != 2)
+                return false;
+        }
+        return true;
+    }
+
+    switch (magic) {
+        case PCAP_MAGIC_USEC:
+            break;
+        case PCAP_MAGIC_NSEC:
+            m->nsec = true;
+            break;
+        default:
+            magic = SCByteSwap32(magic);
+            if (magic != PCAP_MAGIC_USEC && magic != PCAP_MAGIC_NSEC)
+                return false;
+            m->swapped = true;
+            m->nsec = magic == PCAP_MAGIC_NSEC;
+            break;
+    }
+    const uint32_t snaplen = PcapFileMmapGet32(m, m->data + 16);
+    m->max_caplen = MAX(snaplen, PCAP_MAX_CAPLEN);
+    /* the upper bits hold the FCS length */
+    m->datalink = (int)(PcapFileMmapGet32(m, m->data + 20) & 0x03FFFFFF);
+    m->pos = PCAP_FILE_HDR_LEN;
+    return true;
+}
+
+/** \internal
+ *  \brief read the first packet that passes the filter
+ *
+ *  Files without one are rejected at open, as the libpcap reader does.
+ */
+static bool PcapFileMmapPeekFirst(PcapFileMmap *m)
+{
+    if (PcapFileMmapNext(m, &m->first) != 1)
+        return false;
+    m->have_first = true;
+    return true;
+}
+
+/** \internal
+ *  \brief compile the bpf filter for the file's link type */
+static bool PcapFileMmapSetFilter(PcapFileMmap *m, const char *bpf_string)
+{
+    /* the file has LINKTYPE_ values, libpcap wants a DLT_ one */
+    const int dlt = m->datalink == LINKTYPE_RAW2 ? DLT_RAW : m->datalink;
+
+    pcap_t *handle = pcap_open_dead(dlt, (int)m->max_caplen);
+    if (handle == NULL) {
+        SCLogError("%s: failed to set up bpf filter", m->filename);
+        return false;
+    }
+    SCLogInfo("using bpf-filter \"%s\"", bpf_string);
+    if (pcap_compile(handle, &m->filter, bpf_string, 1, 0) < 0) {
+        SCLogError("bpf compilation error %s for %s", pcap_geterr(handle), m->filename);
+        pcap_close(handle);
+        return false;
+    }
+    pcap_close(handle);
+    m->has_filter = true;
+    return true;
+}
+
+TmEcode PcapFileMmapOpen(const char *filename, const char *bpf_string, PcapFileMmap **out)
+{
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        SCReturnInt(TM_ECODE_FAILED);
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size < PCAP_FILE_HDR_LEN ||
+            (uint64_t)st.st_size > SIZE_MAX) {
+        close(fd);
+        SCReturnInt(TM_ECODE_FAILED);
+    }
+
+    /* private and writable, as the decoders treat packet data as theirs */
+    void *addr = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        SCLogDebug("%s: mmap failed: %s", filename, strerror(errno));
+        SCReturnInt(TM_ECODE_FAILED);
+    }
+    (void)madvise(addr, (size_t)st.st_size, MADV_SEQUENTIAL);
+
+    PcapFileMmap *m = SCCalloc(1, sizeof(*m));
+    PcapFileMmapRegion *r = SCCalloc(1, sizeof(*r));
+    if (unlikely(m == NULL || r == NULL)) {
+        munmap(addr, (size_t)st.st_size);
+        if (m != NULL)
+            SCFree(m);
+        if (r != NULL)
+            SCFree(r);
+        SCReturnInt(TM_ECODE_FAILED);
+    }
+    r->addr = addr;
+    r->len = (size_t)st.st_size;
+    SC_ATOMIC_INIT(r->refcnt);
+    SC_ATOMIC_SET(r->refcnt, 1);
+    m->region = r;
+
+    m->filename = SCStrdup(filename);
+    if (unlikely(m->filename == NULL)) {
+        PcapFileMmapClose(m);
+        SCReturnInt(TM_ECODE_FAILED);
+    }
+
+    /* LZ4 frames are little endian */
+    if (PcapFileMmapGetLE32(addr) == LZ4F_MAGIC) {
+#ifdef HAVE_LIBLZ4
+        if (LZ4F_isError(LZ4F_createDecompressionContext(&m->lz4, LZ4F_VERSION))) {
+            PcapFileMmapClose(m);
+            SCReturnInt(TM_ECODE_FAILED);
+        }
+        m->data = m->buf;
+#else
+        SCLogError("%s: LZ4 compressed, but LZ4 support is not compiled in", filename);
+        PcapFileMmapClose(m);
+        SCReturnInt(TM_ECODE_FAILED);
+#endif /* HAVE_LIBLZ4 */
+    } else {
+        m->data = r->addr;
+        m->data_len = r->len;
+        m->zero_copy = true;
+    }
+
+    if (!PcapFileMmapParseHeader(m)) {
+        SCLogDebug("%s: not a pcap or pcapng file we can map", filename);
+        PcapFileMmapClose(m);
+        SCReturnInt(TM_ECODE_FAILED);
+    }
+
+    if (bpf_string != NULL && !PcapFileMmapSetFilter(m, bpf_string)) {
+        PcapFileMmapClose(m);
+        SCReturnInt(TM_ECODE_FAILED);
+    }
+
+    if (!PcapFileMmapPeekFirst(m)) {
+        SCLogDebug("%s: no first packet", filename);
+        PcapFileMmapClose(m);
+        SCReturnInt(TM_ECODE_FAILED);
+    }
+
+    SCLogDebug("%s: mapped %" PRIuMAX " bytes, %s%s", filename, (uintmax_t)r->len,
+            m->pcapng ? "pcapng" : "pcap", m->zero_copy ? "" : ", lz4");
+    *out = m;
+    SCReturnInt(TM_ECODE_OK);
+}
+
+void PcapFileMmapClose(PcapFileMmap *m)
+{
+    if (m == NULL)
+        return;
+#ifdef HAVE_LIBLZ4
+    if (m->lz4 != NULL)
+        LZ4F_freeDecompressionContext(m->lz4);
+    if (m->buf != NULL)
+        SCFree(m->buf);
+#endif /* HAVE_LIBLZ4 */
+    if (m->has_filter)
+        pcap_freecode(&m->filter);
+    if (m->ifaces != NULL)
+        SCFree(m->ifaces);
+    if (m->filename != NULL)
+        SCFree(m->filename);
+    if (m->region != NULL)
+        PcapFileMmapRegionDeref(m->region);
+    SCFree(m);
+}
+
+int PcapFileMmapDatalink(const PcapFileMmap *m)
+{
+    /* as libpcap reports it */
+    return m->datalink == LINKTYPE_RAW2 ? DLT_RAW : m->datalink;
+}
+
+/** \internal
+ *  \brief set up a packet for a record and add it to the batch */
+static void PcapFileMmapPacket(PcapFileFileVars *ptv, const PcapFileMmapRecord *rec)
+{
+    PcapFileMmap *m = ptv->mmap;
+#ifdef DEBUG
+    if (unlikely((pcap_g.cnt + 1ULL) == g_eps_pcap_packet_loss)) {
+        SCLogNotice("skipping packet %" PRIu64, g_eps_pcap_packet_loss);
+        pcap_g.cnt++;
+        return;
+    }
+#endif
+    Packet *p = PacketGetFromQueueOrAlloc();
+    if (unlikely(p == NULL)) {
+        return;
+    }
+    PACKET_PROFILING_TMM_START(p, TMM_RECEIVEPCAPFILE);
+
+    PKT_SET_SRC(p, PKT_SRC_WIRE);
+    p->ts = rec->ts;
+    p->datalink = ptv->datalink;
+    p->pcap_cnt = ++pcap_g.cnt;
+
+    p->pcap_v.tenant_id = ptv->shared->tenant_id;
+    ptv->shared->pkts++;
+    ptv->shared->bytes += rec->caplen;
+
+    if (m->zero_copy) {
+        (void)SC_ATOMIC_ADD(m->region->refcnt, 1);
+        p->pcap_v.relptr = m->region;
+        p->ReleasePacket = PcapFileMmapReleasePacket;
+        PacketSetData(p, rec->data, rec->caplen);
+    } else if (unlikely(PacketCopyData(p, rec->data, rec->caplen))) {
+        TmqhOutputPacketpool(ptv->shared->tv, p);
+        PACKET_PROFILING_TMM_END(p, TMM_RECEIVEPCAPFILE);
+        return;
+    }
+
+    PcapFileSetPacketChecksumMode(p, ptv->shared->pkts);
+
+    PACKET_PROFILING_TMM_END(p, TMM_RECEIVEPCAPFILE);
+
+    ptv->batch[ptv->batch_cnt++] = p;
+    if (ptv->batch_cnt == TM_PKT_BATCH_SIZE) {
+        (void)PcapFileProcessBatch(ptv);
+    }
+}
+
+TmEcode PcapFileMmapDispatch(PcapFileFileVars *ptv)
+{
+    SCEnter();
+
+    PcapFileMmap *m = ptv->mmap;
+    PcapFileMmapRecord rec;
+
+    /* initialize all the thread's initial timestamp */
+    if (likely(m->have_first)) {
+        TmThreadsInitThreadsTimestamp(m->first.ts);
+        PcapFileMmapPacket(ptv, &m->first);
+        m->have_first = false;
+    }
+
+    while (1) {
+        if (suricata_ctl_flags & SURICATA_STOP) {
+            SCReturnInt(TM_ECODE_OK);
+        }
+
+        /* make sure we have at least one packet in the packet pool, to prevent
+         * us from alloc'ing packets at line rate */
+        PacketPoolWait();
+
+        int r = 1;
+        for (int i = 0; i < PCAP_FILE_MMAP_BURST; i++) {
+            r = PcapFileMmapNext(m, &rec);
+            if (r <= 0)
+                break;
+            PcapFileMmapPacket(ptv, &rec);
+            if (ptv->shared->cb_result == TM_ECODE_FAILED)
+                break;
+        }
+        (void)PcapFileProcessBatch(ptv);
+
+        if (ptv->shared->cb_result == TM_ECODE_FAILED) {
+            SCLogError("Pcap callback PcapFileCallbackLoop failed for %s", ptv->filename);
+            SCReturnInt(TM_ECODE_FAILED);
+        } else if (r < 0) {
+            SCReturnInt(TM_ECODE_DONE);
+        } else if (r == 0) {
+            SCLogInfo("pcap file %s end of file reached", ptv->filename);
+            ptv->shared->files++;
+            SCReturnInt(TM_ECODE_DONE);
+        }
+        StatsSyncCountersIfSignalled(ptv->shared->tv);
+    }
+}
+
+/*************************************Unittests********************************/
+
+#ifdef UNITTESTS
+/** buffer a test file is written to, in the byte order of the test */
+typedef struct PcapFileMmapTestBuf_ {
+    uint8_t data[512];
+    uint32_t len;
+    bool swapped;
+} PcapFileMmapTestBuf;
+
+static void PcapFileMmapTestPut16(PcapFileMmapTestBuf *b, uint16_t v)
+{
+    if (b->swapped)
+        v = SCByteSwap16(v);
+    memcpy(b->data + b->len, &v, sizeof(v));
+    b->len += sizeof(v);
+}
+
+static void PcapFileMmapTestPut32(PcapFileMmapTestBuf *b, uint32_t v)
+{
+    if (b->swapped)
+        v = SCByteSwap32(v);
+    memcpy(b->data + b->len, &v, sizeof(v));
+    b->len += sizeof(v);
+}
+
+static void PcapFileMmapTestPut64(PcapFileMmapTestBuf *b, uint64_t v)
+{
+    if (b->swapped)
+        v = SCByteSwap64(v);
+    memcpy(b->data + b->len, &v, sizeof(v));
+    b->len += sizeof(v);
+}
+
+static void PcapFileMmapTestPutData(PcapFileMmapTestBuf *b, const uint8_t *data, uint32_t len)
+{
+    memcpy(b->data + b->len, data, len);
+    b->len += len;
+    while (b->len & 3)
+        b->data[b->len++] = 0;
+}
+
+static void PcapFileMmapTestPcapHeader(PcapFileMmapTestBuf *b, uint32_t magic, uint32_t snaplen)
+{
+    PcapFileMmapTestPut32(b, magic);
+    PcapFileMmapTestPut16(b, 2);
+    PcapFileMmapTestPut16(b, 4);
+    PcapFileMmapTestPut32(b, 0);
+    PcapFileMmapTestPut32(b, 0);
+    PcapFileMmapTestPut32(b, snaplen);
+    PcapFileMmapTestPut32(b, LINKTYPE_ETHERNET);
+}
+
+static void PcapFileMmapTestPcapRecord(PcapFileMmapTestBuf *b, uint32_t secs, uint32_t frac,
+        const uint8_t *data, uint32_t caplen, uint32_t len)
+{
+    PcapFileMmapTestPut32(b, secs);
+    PcapFileMmapTestPut32(b, frac);
+    PcapFileMmapTestPut32(b, caplen);
+    PcapFileMmapTestPut32(b, len);
+    memcpy(b->data + b->len, data, caplen);
+    b->len += caplen;
+}
+
+/** \brief start a pcapng block, the length is filled in by BlockEnd */
+static uint32_t PcapFileMmapTestBlockStart(PcapFileMmapTestBuf *b, uint32_t type)
+{
+    const uint32_t start = b->len;
+    PcapFileMmapTestPut32(b, type);
+    PcapFileMmapTestPut32(b, 0);
+    return start;
+}
+
+static void PcapFileMmapTestBlockEnd(PcapFileMmapTestBuf *b, uint32_t start)
+{
+    const uint32_t len = b->len + 4 - start;
+    PcapFileMmapTestPut32(b, len);
+    const uint32_t end = b->len;
+    b->len = start + 4;
+    PcapFileMmapTestPut32(b, len);
+    b->len = end;
+}
+
+static void PcapFileMmapTestShb(PcapFileMmapTestBuf *b)
+{
+    const uint32_t start = PcapFileMmapTestBlockStart(b, PCAPNG_BLOCK_SHB);
+    PcapFileMmapTestPut32(b, PCAPNG_BYTE_ORDER_MAGIC);
+    PcapFileMmapTestPut16(b, 1);
+    PcapFileMmapTestPut16(b, 0);
+    PcapFileMmapTestPut64(b, UINT64_MAX);
+    PcapFileMmapTestBlockEnd(b, start);
+}
+
+/** \brief interface description block, tsresol < 0 to leave it out */
+static void PcapFileMmapTestIdb(
+        PcapFileMmapTestBuf *b, uint32_t snaplen, int tsresol, int64_t tsoffset)
+{
+    const uint32_t start = PcapFileMmapTestBlockStart(b, PCAPNG_BLOCK_IDB);
+    PcapFileMmapTestPut16(b, LINKTYPE_ETHERNET);
+    PcapFileMmapTestPut16(b, 0);
+    PcapFileMmapTestPut32(b, snaplen);
+    if (tsresol >= 0) {
+        const uint8_t v = (uint8_t)tsresol;
+        PcapFileMmapTestPut16(b, PCAPNG_OPT_TSRESOL);
+        PcapFileMmapTestPut16(b, 1);
+        PcapFileMmapTestPutData(b, &v, 1);
+    }
+    if (tsoffset != 0) {
+        PcapFileMmapTestPut16(b, PCAPNG_OPT_TSOFFSET);
+        PcapFileMmapTestPut16(b, 8);
+        PcapFileMmapTestPut64(b, (uint64_t)tsoffset);
+    }
+    PcapFileMmapTestPut16(b, PCAPNG_OPT_END);
+    PcapFileMmapTestPut16(b, 0);
+    PcapFileMmapTestBlockEnd(b, start);
+}
+
+static void PcapFileMmapTestEpb(PcapFileMmapTestBuf *b, uint32_t id, uint64_t ts,
+        const uint8_t *data, uint32_t caplen, uint32_t len)
+{
+    const uint32_t start = PcapFileMmapTestBlockStart(b, PCAPNG_BLOCK_EPB);
+    PcapFileMmapTestPut32(b, id);
+    PcapFileMmapTestPut32(b, (uint32_t)(ts >> 32));
+    PcapFileMmapTestPut32(b, (uint32_t)ts);
+    PcapFileMmapTestPut32(b, caplen);
+    PcapFileMmapTestPut32(b, len);
+    PcapFileMmapTestPutData(b, data, caplen);
+    PcapFileMmapTestBlockEnd(b, start);
+}
+
+/** \brief set up a reader for the buffer, as PcapFileMmapOpen does */
+static bool PcapFileMmapTestInit(PcapFileMmap *m, const PcapFileMmapTestBuf *b)
+{
+    memset(m, 0, sizeof(*m));
+    m->filename = (char *)"test";
+    m->data = b->data;
+    m->data_len = b->len;
+    return PcapFileMmapParseHeader(m);
+}
+
+static void PcapFileMmapTestFree(PcapFileMmap *m)
+{
+    if (m->ifaces != NULL)
+        SCFree(m->ifaces);
+}
+
+static const uint8_t pcap_file_mmap_test_pkt[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+
+/** \test pcap records in both byte orders, usec and nsec, truncated record */
+static int PcapFileMmapTest01(void)
+{
+    for (int swapped = 0; swapped < 2; swapped++) {
+        for (int nsec = 0; nsec < 2; nsec++) {
+            PcapFileMmapTestBuf b = { .swapped = swapped };
+            PcapFileMmapTestPcapHeader(&b, nsec ? PCAP_MAGIC_NSEC : PCAP_MAGIC_USEC, 65535);
+            PcapFileMmapTestPcapRecord(
+                    &b, 10, nsec ? 500000 : 500, pcap_file_mmap_test_pkt, 8, 60);
+            /* header says 8 bytes, only 2 follow */
+            PcapFileMmapTestPcapRecord(&b, 11, 0, pcap_file_mmap_test_pkt, 8, 8);
+            b.len -= 6;
+
+            PcapFileMmap m;
+            FAIL_IF_NOT(PcapFileMmapTestInit(&m, &b));
+            FAIL_IF(m.pcapng);
+            FAIL_IF(m.swapped != (swapped == 1));
+            FAIL_IF(m.nsec != (nsec == 1));
+            FAIL_IF(m.datalink != LINKTYPE_ETHERNET);
+
+            PcapFileMmapRecord rec;
+            FAIL_IF(PcapFileMmapNextPcap(&m, &rec) != 1);
+            FAIL_IF(SCTIME_SECS(rec.ts) != 10);
+            FAIL_IF(SCTIME_USECS(rec.ts) != 500);
+            FAIL_IF(rec.caplen != 8);
+            FAIL_IF(rec.len != 60);
+            FAIL_IF(memcmp(rec.data, pcap_file_mmap_test_pkt, 8) != 0);
+
+            /* truncated record is an error, like libpcap's truncated dump file */
+            FAIL_IF(PcapFileMmapNextPcap(&m, &rec) != -1);
+            /* as is a truncated record header */
+            m.data_len = m.pos + PCAP_RECORD_HDR_LEN - 1;
+            FAIL_IF(PcapFileMmapNextPcap(&m, &rec) != -1);
+            /* nothing after the last record is the end of the file */
+            m.data_len = m.pos;
+            FAIL_IF(PcapFileMmapNextPcap(&m, &rec) != 0);
+            PcapFileMmapTestFree(&m);
+        }
+    }
+    PASS;
+}
+
+/** \test pcap caplen larger than the snaplen */
+static int PcapFileMmapTest02(void)
+{
+    for (int swapped = 0; swapped < 2; swapped++) {
+        PcapFileMmapTestBuf b = { .swapped = swapped };
+        PcapFileMmapTestPcapHeader(&b, PCAP_MAGIC_USEC, 4);
+        /* over the snaplen, but accepted up to PCAP_MAX_CAPLEN like libpcap */
+        PcapFileMmapTestPcapRecord(&b, 1, 0, pcap_file_mmap_test_pkt, 8, 8);
+        PcapFileMmapTestPut32(&b, 2);
+        PcapFileMmapTestPut32(&b, 0);
+        PcapFileMmapTestPut32(&b, PCAP_MAX_CAPLEN + 1);
+        PcapFileMmapTestPut32(&b, PCAP_MAX_CAPLEN + 1);
+
+        PcapFileMmap m;
+        FAIL_IF_NOT(PcapFileMmapTestInit(&m, &b));
+        FAIL_IF(m.max_caplen != PCAP_MAX_CAPLEN);
+
+        PcapFileMmapRecord rec;
+        FAIL_IF(PcapFileMmapNextPcap(&m, &rec) != 1);
+        FAIL_IF(rec.caplen != 8);
+        /* over the limit is an error, not a truncated file */
+        FAIL_IF(PcapFileMmapNextPcap(&m, &rec) != -1);
+        PcapFileMmapTestFree(&m);
+    }
+    PASS;
+}
+
+/** \test pcapng blocks in both byte orders, default timestamp resolution */
+static int PcapFileMmapTest03(void)
+{
+    for (int swapped = 0; swapped < 2; swapped++) {
+        PcapFileMmapTestBuf b = { .swapped = swapped };
+        PcapFileMmapTestShb(&b);
+        PcapFileMmapTestIdb(&b, 65535, -1, 0);
+        PcapFileMmapTestEpb(&b, 0, 1500000, pcap_file_mmap_test_pkt, 5, 64);
+        /* unknown interface */
+        PcapFileMmapTestEpb(&b, 1, 0, pcap_file_mmap_test_pkt, 5, 64);
+
+        PcapFileMmap m;
+        FAIL_IF_NOT(PcapFileMmapTestInit(&m, &b));
+        FAIL_IF_NOT(m.pcapng);
+        FAIL_IF(m.swapped != (swapped == 1));
+        FAIL_IF(m.ifaces_cnt != 1);
+        FAIL_IF(m.ifaces[0].units != 1000000);
+        FAIL_IF(m.ifaces[0].snaplen != 65535);
+        FAIL_IF(m.datalink != LINKTYPE_ETHERNET);
+
+        PcapFileMmapRecord rec;
+        FAIL_IF(PcapFileMmapPcapngBlock(&m, &rec) != 1);
+        FAIL_IF(SCTIME_SECS(rec.ts) != 1);
+        FAIL_IF(SCTIME_USECS(rec.ts) != 500000);
+        FAIL_IF(rec.caplen != 5);
+        FAIL_IF(rec.len != 64);
+        FAIL_IF(memcmp(rec.data, pcap_file_mmap_test_pkt, 5) != 0);
+
+        FAIL_IF(PcapFileMmapPcapngBlock(&m, &rec) != -1);
+        PcapFileMmapTestFree(&m);
+    }
+    PASS;
+}
+
+/** \test pcapng block lengths: too short, not aligned, truncated */
+static int PcapFileMmapTest04(void)
+{
+    for (int swapped = 0; swapped < 2; swapped++) {
+        PcapFileMmapTestBuf b = { .swapped = swapped };
+        PcapFileMmapTestShb(&b);
+        PcapFileMmapTestIdb(&b, 65535, -1, 0);
+        const uint32_t blocks = b.len;
+        PcapFileMmapTestEpb(&b, 0, 0, pcap_file_mmap_test_pkt, 8, 8);
+        const uint32_t epb_len = b.len - blocks;
+
+        PcapFileMmap m;
+        FAIL_IF_NOT(PcapFileMmapTestInit(&m, &b));
+        FAIL_IF(m.pos != blocks);
+        PcapFileMmapRecord rec;
+
+        /* below the minimum block length */
+        PcapFileMmapTestBuf bad = b;
+        bad.len = blocks + 4;
+        PcapFileMmapTestPut32(&bad, 8);
+        m.data = bad.data;
+        m.pos = blocks;
+        FAIL_IF(PcapFileMmapPcapngBlock(&m, &rec) != -1);
+
+        /* not a multiple of 4 */
+        bad = b;
+        bad.len = blocks + 4;
+        PcapFileMmapTestPut32(&bad, epb_len - 2);
+        m.data = bad.data;
+        m.pos = blocks;
+        FAIL_IF(PcapFileMmapPcapngBlock(&m, &rec) != -1);
+
+        /* EPB with a caplen past the end of the block */
+        bad = b;
+        bad.len = blocks + 20;
+        PcapFileMmapTestPut32(&bad, 9);
+        m.data = bad.data;
+        m.pos = blocks;
+        FAIL_IF(PcapFileMmapPcapngBlock(&m, &rec) != -1);
+
+        /* truncated block and block header are errors */
+        m.data = b.data;
+        m.data_len = b.len - 4;
+        m.pos = blocks;
+        FAIL_IF(PcapFileMmapPcapngBlock(&m, &rec) != -1);
+        FAIL_IF(m.pos != blocks);
+        m.data_len = blocks + 11;
+        FAIL_IF(PcapFileMmapPcapngBlock(&m, &rec) != -1);
+
+        m.data_len = b.len;
+        FAIL_IF(PcapFileMmapPcapngBlock(&m, &rec) != 1);
+        FAIL_IF(rec.caplen != 8);
+        FAIL_IF(PcapFileMmapPcapngBlock(&m, &rec) != 0);
+        PcapFileMmapTestFree(&m);
+    }
+    PASS;
+}
+
+/** \test pcapng if_tsresol and if_tsoffset */
+static int PcapFileMmapTest05(void)
+{
+    for (int swapped = 0; swapped < 2; swapped++) {
+        PcapFileMmapTestBuf b = { .swapped = swapped };
+        PcapFileMmapTestShb(&b);
+        /* nanoseconds, 100s offset */
+        PcapFileMmapTestIdb(&b, 0, 9, 100);
+        /* 2^-10 */
+        PcapFileMmapTestIdb(&b, 0, 0x80 | 10, 0);
+        PcapFileMmapTestEpb(&b, 0, 3250000000ULL, pcap_file_mmap_test_pkt, 4, 4);
+        PcapFileMmapTestEpb(&b, 1, 5 * 1024 + 256, pcap_file_mmap_test_pkt, 4, 4);
+        /* resolution out of range */
+        PcapFileMmapTestIdb(&b, 0, 20, 0);
+
+        PcapFileMmap m;
+        FAIL_IF_NOT(PcapFileMmapTestInit(&m, &b));
+        PcapFileMmapRecord rec;
+        FAIL_IF(PcapFileMmapPcapngBlock(&m, &rec) != 2);
+        FAIL_IF(m.ifaces_cnt != 2);
+        FAIL_IF(m.ifaces[0].units != 1000000000ULL);
+        FAIL_IF(m.ifaces[0].offset != 100);
+        FAIL_IF(m.ifaces[1].units != 1024);
+        FAIL_IF(m.ifaces[1].offset != 0);
+
+        FAIL_IF(PcapFileMmapPcapngBlock(&m, &rec) != 1);
+        FAIL_IF(SCTIME_SECS(rec.ts) != 103);
+        FAIL_IF(SCTIME_USECS(rec.ts) != 250000);
+
+        FAIL_IF(PcapFileMmapPcapngBlock(&m, &rec) != 1);
+        FAIL_IF(SCTIME_SECS(rec.ts) != 5);
+        FAIL_IF(SCTIME_USECS(rec.ts) != 250000);
+
+        FAIL_IF(PcapFileMmapPcapngBlock(&m, &rec) != -1);
+        PcapFileMmapTestFree(&m);
+    }
+    PASS;
+}
+
+/** \test files without a first packet are rejected, as by libpcap */
+static int PcapFileMmapTest06(void)
+{
+    for (int swapped = 0; swapped < 2; swapped++) {
+        PcapFileMmap m;
+        PcapFileMmapRecord rec;
+
+        /* pcap header only */
+        PcapFileMmapTestBuf b = { .swapped = swapped };
+        PcapFileMmapTestPcapHeader(&b, PCAP_MAGIC_USEC, 65535);
+        FAIL_IF_NOT(PcapFileMmapTestInit(&m, &b));
+        FAIL_IF(PcapFileMmapPeekFirst(&m));
+        PcapFileMmapTestFree(&m);
+
+        /* pcapng without packet blocks */
+        b = (PcapFileMmapTestBuf){ .swapped = swapped };
+        PcapFileMmapTestShb(&b);
+        PcapFileMmapTestIdb(&b, 65535, -1, 0);
+        FAIL_IF_NOT(PcapFileMmapTestInit(&m, &b));
+        FAIL_IF(PcapFileMmapPeekFirst(&m));
+        PcapFileMmapTestFree(&m);
+
+        /* only record is truncated */
+        b = (PcapFileMmapTestBuf){ .swapped = swapped };
+        PcapFileMmapTestPcapHeader(&b, PCAP_MAGIC_USEC, 65535);
+        PcapFileMmapTestPcapRecord(&b, 1, 0, pcap_file_mmap_test_pkt, 8, 8);
+        b.len -= 1;
+        FAIL_IF_NOT(PcapFileMmapTestInit(&m, &b));
+        FAIL_IF(PcapFileMmapPeekFirst(&m));
+        PcapFileMmapTestFree(&m);
+
+        /* first packet is kept for the dispatch, the next one follows it */
+        b = (PcapFileMmapTestBuf){ .swapped = swapped };
+        PcapFileMmapTestPcapHeader(&b, PCAP_MAGIC_USEC, 65535);
+        PcapFileMmapTestPcapRecord(&b, 1, 0, pcap_file_mmap_test_pkt, 8, 8);
+        PcapFileMmapTestPcapRecord(&b, 2, 0, pcap_file_mmap_test_pkt, 4, 4);
+        FAIL_IF_NOT(PcapFileMmapTestInit(&m, &b));
+        FAIL_IF_NOT(PcapFileMmapPeekFirst(&m));
+        FAIL_IF_NOT(m.have_first);
+        FAIL_IF(SCTIME_SECS(m.first.ts) != 1);
+        FAIL_IF(m.first.caplen != 8);
+        FAIL_IF(PcapFileMmapNext(&m, &rec) != 1);
+        FAIL_IF(SCTIME_SECS(rec.ts) != 2);
+        FAIL_IF(PcapFileMmapNext(&m, &rec) != 0);
+        PcapFileMmapTestFree(&m);
+    }
+    PASS;
+}
+#endif /* UNITTESTS */
+
+void PcapFileMmapRegisterTests(void)
+{
+#ifdef UNITTESTS
+    UtRegisterTest("PcapFileMmapTest01", PcapFileMmapTest01);
+    UtRegisterTest("PcapFileMmapTest02", PcapFileMmapTest02);
+    UtRegisterTest("PcapFileMmapTest03", PcapFileMmapTest03);
+    UtRegisterTest("PcapFileMmapTest04", PcapFileMmapTest04);
+    UtRegisterTest("PcapFileMmapTest05", PcapFileMmapTest05);
+    UtRegisterTest("PcapFileMmapTest06", PcapFileMmapTest06);
+#endif /* UNITTESTS */
+}
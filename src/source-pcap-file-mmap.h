@@ -0,0 +1,62 @@
+/* Copyright (C) 2026 Open Information Security Foundation
+ *
+ * You can copy, redistribute or modify this Program under the terms of
+ * the GNU General Public License version 2 as published by the Free
+ * Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/**
+ * \file
+ *
+ * Reading pcap files through a memory mapping instead of libpcap
+ */
+
+#include "suricata-common.h"
+#include "source-pcap-file-helper.h"
+
+#ifndef __SOURCE_PCAP_FILE_MMAP_H__
+#define __SOURCE_PCAP_FILE_MMAP_H__
+
+/**
+ * Map a file and parse its header. Supports pcap, pcapng and both of them
+ * compressed with LZ4, as written by the pcap-log compression option.
+ * @param filename File to open
+ * @param bpf_string Optional bpf filter
+ * @param out Set to the reader on success
+ * @return TM_ECODE_OK if the file can be read, TM_ECODE_FAILED if libpcap
+ *         should be used instead
+ */
+TmEcode PcapFileMmapOpen(const char *filename, const char *bpf_string, PcapFileMmap **out);
+
+/**
+ * Close the reader. The mapping stays until all packets pointing into it
+ * are released.
+ * @param m Reader to close
+ */
+void PcapFileMmapClose(PcapFileMmap *m);
+
+/**
+ * @return the datalink of the file
+ */
+int PcapFileMmapDatalink(const PcapFileMmap *m);
+
+/**
+ * Read the file and process its packets until the end is reached
+ * @param ptv PcapFileFileVars object to be processed
+ * @return TM_ECODE_DONE at the end of the file
+ */
+TmEcode PcapFileMmapDispatch(PcapFileFileVars *ptv);
+
+void PcapFileMmapRegisterTests(void);
+
+#endif /* __SOURCE_PCAP_FILE_MMAP_H__ */
@@ -0,0 +1,564 @@
+/* Copyright (C) 2026 Open Information Security Foundation
+ *
+ * You can copy, redistribute or modify this Program under the terms of
+ * the GNU General Public License version 2 as published by the Free
+ * Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/**
+ * \file
+ *
+ * Reading a single pcap file with multiple reader threads.
+ *
+ * The file is cut into chunks of whole records. The readers take turns
+ * reading the next chunk, which is only a pread and a walk over the record
+ * headers. Copying the packets and decoding them is done in parallel. The
+ * decoded packets are held back until all earlier chunks have been passed
+ * on to the flow workers, so every worker sees its flows' packets in file
+ * order, as with a single reader.
+ *
+ * IP defragmentation is part of decoding, so it is not ordered: fragments
+ * in different chunks are reassembled in whatever order the readers get to
+ * them, and the reassembled packet is passed on with the chunk of the
+ * reader that completed it. Fragment timeouts and overlap handling can
+ * therefore differ from a single reader.
+ */
+
+#include "source-pcap-file-parallel.h"
+#include "suricata.h"
+#include "packet.h"
+#include "runmode-unix-socket.h"
+#include "tmqh-packetpool.h"
+#include "util-byte.h"
+#include "util-datalink.h"
+#include "util-exception-policy.h"
+#include "util-profiling.h"
+
+extern uint16_t max_pending_packets;
+extern PcapFileGlobalVars pcap_g;
+extern char pcap_filename[PATH_MAX];
+
+/** bytes of records per chunk */
+#define PCAP_PARALLEL_CHUNK_SIZE (1024 * 1024)
+/** max records per chunk, all of them are held until the chunk's turn */
+#define PCAP_PARALLEL_CHUNK_PKTS 256
+
+typedef struct PcapFileParallelRecord_ {
+    uint32_t offset; /**< offset of the data in the chunk buffer */
+    uint32_t caplen;
+    uint64_t pcap_cnt;
+    SCTime_t ts;
+} PcapFileParallelRecord;
+
+/**
+ * State shared by all readers of the file
+ */
+typedef struct PcapFileParallelCtx_ {
+    char *filename;
+    int fd;
+    int datalink;
+    bool swapped;
+    bool nsec;
+    bool should_delete;
+    bool has_filter;
+    struct bpf_program filter;
+    uint32_t max_caplen;
+    uint32_t chunk_pkts;
+    SCTime_t first_ts;
+    uint16_t readers;
+
+    /** protects reading the next chunk */
+    SCMutex read_lock;
+    uint64_t offset;
+    uint64_t next_seq;
+    uint64_t cnt;
+    bool eof;
+
+    /** chunk sequence number that can be passed on next */
+    SCMutex dispatch_lock;
+    SCCondT dispatch_cond;
+    uint64_t dispatch_seq;
+
+    SC_ATOMIC_DECLARE(uint16_t, readers_done);
+} PcapFileParallelCtx;
+
+struct PcapFileParallelVars_ {
+    PcapFileSharedVars *shared;
+
+    uint8_t *buf;
+    uint32_t buf_size;
+    PcapFileParallelRecord *records;
+    uint32_t records_cnt;
+    uint64_t seq;
+
+    /** decoded packets waiting for the chunk's turn */
+    PacketQueueNoLock stash;
+
+    Packet *batch[TM_PKT_BATCH_SIZE];
+    uint32_t batch_cnt;
+};
+
+static PcapFileParallelCtx *pcap_parallel = NULL;
+static thread_local PacketQueueNoLock *pcap_parallel_stash = NULL;
+
+static inline uint32_t PcapFileParallelGet32(const PcapFileParallelCtx *ctx, const uint8_t *data)
+{
+    uint32_t v;
+    memcpy(&v, data, sizeof(v));
+    return ctx->swapped ? SCByteSwap32(v) : v;
+}
+
+static void PcapFileParallelCtxFree(PcapFileParallelCtx *ctx)
+{
+    if (ctx->fd >= 0)
+        close(ctx->fd);
+    if (ctx->has_filter)
+        pcap_freecode(&ctx->filter);
+    SCMutexDestroy(&ctx->read_lock);
+    SCMutexDestroy(&ctx->dispatch_lock);
+    SCCondDestroy(&ctx->dispatch_cond);
+    if (ctx->filename != NULL)
+        SCFree(ctx->filename);
+    SCFree(ctx);
+}
+
+/** \internal
+ *  \brief open the file and check it can be read without libpcap
+ *
+ *  Only the classic pcap format is supported, pcapng blocks can't be split
+ *  without parsing them.
+ *
+ *  \retval bool true if the file can be read in parallel
+ */
+static bool PcapFileParallelOpen(PcapFileParallelCtx *ctx)
+{
+    uint8_t hdr[PCAP_FILE_HDR_LEN + PCAP_RECORD_HDR_LEN];
+
+    ctx->fd = open(ctx->filename, O_RDONLY);
+    if (ctx->fd < 0)
+        return false;
+    if (pread(ctx->fd, hdr, sizeof(hdr), 0) != (ssize_t)sizeof(hdr)) {
+        SCLogDebug("%s: no complete record", ctx->filename);
+        return false;
+    }
+
+    uint32_t magic;
+    memcpy(&magic, hdr, sizeof(magic));
+    switch (magic) {
+        case PCAP_MAGIC_USEC:
+            break;
+        case PCAP_MAGIC_NSEC:
+            ctx->nsec = true;
+            break;
+        default:
+            magic = SCByteSwap32(magic);
+            if (magic != PCAP_MAGIC_USEC && magic != PCAP_MAGIC_NSEC) {
+                SCLogDebug("%s: not a pcap file", ctx->filename);
+                return false;
+            }
+            ctx->swapped = true;
+            ctx->nsec = magic == PCAP_MAGIC_NSEC;
+            break;
+    }
+
+    const uint32_t snaplen = PcapFileParallelGet32(ctx, hdr + 16);
+    ctx->max_caplen = MAX(snaplen, PCAP_MAX_CAPLEN);
+
+    const uint8_t *rec = hdr + PCAP_FILE_HDR_LEN;
+    const uint32_t frac = PcapFileParallelGet32(ctx, rec + 4);
+    ctx->first_ts.secs = PcapFileParallelGet32(ctx, rec);
+    ctx->first_ts.usecs = ctx->nsec ? frac / 1000 : frac;
+    ctx->offset = PCAP_FILE_HDR_LEN;
+    return true;
+}
+
+/** \internal
+ *  \brief get the datalink and compile the bpf filter with libpcap */
+static bool PcapFileParallelSetupLink(PcapFileParallelCtx *ctx)
+{
+    char errbuf[PCAP_ERRBUF_SIZE] = "";
+    const char *bpf_string = NULL;
+
+    pcap_t *handle = pcap_open_offline(ctx->filename, errbuf);
+    if (handle == NULL) {
+        SCLogDebug("%s", errbuf);
+        return false;
+    }
+
+    ctx->datalink = pcap_datalink(handle);
+    DecoderFunc decoder;
+    if (ValidateLinkType(ctx->datalink, &decoder) != TM_ECODE_OK) {
+        pcap_close(handle);
+        return false;
+    }
+
+    if (ConfGet("bpf-filter", &bpf_string) == 1) {
+        if (pcap_compile(handle, &ctx->filter, bpf_string, 1, 0) < 0) {
+            SCLogDebug("bpf compilation error %s for %s", pcap_geterr(handle), ctx->filename);
+            pcap_close(handle);
+            return false;
+        }
+        SCLogInfo("using bpf-filter \"%s\"", bpf_string);
+        ctx->has_filter = true;
+    }
+
+    pcap_close(handle);
+    return true;
+}
+
+uint16_t PcapFileParallelInit(const char *filename)
+{
+    intmax_t readers = 1;
+    if (ConfGetInt("pcap-file.readers", &readers) != 1 || readers <= 1)
+        return 1;
+    if (readers > UINT8_MAX)
+        readers = UINT8_MAX;
+
+    if (RunModeUnixSocketIsActive()) {
+        SCLogInfo("pcap-file.readers is not supported in unix socket mode, using one reader");
+        return 1;
+    }
+    struct stat st;
+    if (stat(filename, &st) != 0 || !S_ISREG(st.st_mode)) {
+        SCLogInfo("%s is not a file, using one reader to keep the order of its files",
+                filename);
+        return 1;
+    }
+
+    PcapFileParallelCtx *ctx = SCCalloc(1, sizeof(*ctx));
+    if (unlikely(ctx == NULL))
+        return 1;
+    ctx->fd = -1;
+    SCMutexInit(&ctx->read_lock, NULL);
+    SCMutexInit(&ctx->dispatch_lock, NULL);
+    SCCondInit(&ctx->dispatch_cond, NULL);
+    SC_ATOMIC_INIT(ctx->readers_done);
+
+    ctx->filename = SCStrdup(filename);
+    if (unlikely(ctx->filename == NULL) || !PcapFileParallelOpen(ctx) ||
+            !PcapFileParallelSetupLink(ctx)) {
+        SCLogInfo("%s can't be split up, using one reader", filename);
+        PcapFileParallelCtxFree(ctx);
+        return 1;
+    }
+
+    int should_delete = 0;
+    if (ConfGetBool("pcap-file.delete-when-done", &should_delete) == 1) {
+        ctx->should_delete = should_delete == 1;
+    }
+
+    ctx->readers = (uint16_t)readers;
+    ctx->chunk_pkts = MIN(PCAP_PARALLEL_CHUNK_PKTS, max_pending_packets);
+    DatalinkSetGlobalType(ctx->datalink);
+    strlcpy(pcap_filename, filename, sizeof(pcap_filename));
+
+    pcap_parallel = ctx;
+    SCLogConfig("reading %s with %u readers", filename, ctx->readers);
+    return ctx->readers;
+}
+
+bool PcapFileParallelIsActive(void)
+{
+    return pcap_parallel != NULL;
+}
+
+/**
+ * \brief set up a reader of the shared file
+ *
+ * \retval pv reader or NULL on error. A reader that failed is counted as
+ *            done, so the file is still cleaned up by the others.
+ */
+PcapFileParallelVars *PcapFileParallelThreadInit(PcapFileSharedVars *shared)
+{
+    PcapFileParallelCtx *ctx = pcap_parallel;
+
+    PcapFileParallelVars *pv = SCCalloc(1, sizeof(*pv));
+    if (unlikely(pv == NULL)) {
+        (void)PcapFileParallelReaderDone();
+        return NULL;
+    }
+    pv->shared = shared;
+
+    /* a chunk may end with one record of the max size */
+    pv->buf_size = PCAP_PARALLEL_CHUNK_SIZE + PCAP_RECORD_HDR_LEN + ctx->max_caplen;
+    pv->buf = SCMalloc(pv->buf_size);
+    pv->records = SCCalloc(ctx->chunk_pkts, sizeof(PcapFileParallelRecord));
+    if (unlikely(pv->buf == NULL || pv->records == NULL)) {
+        SCLogError("failed to allocate pcap reader buffers");
+        PcapFileParallelThreadDeinit(pv);
+        (void)PcapFileParallelReaderDone();
+        return NULL;
+    }
+    return pv;
+}
+
+void PcapFileParallelThreadDeinit(PcapFileParallelVars *pv)
+{
+    if (pv == NULL)
+        return;
+    if (pv->buf != NULL)
+        SCFree(pv->buf);
+    if (pv->records != NULL)
+        SCFree(pv->records);
+    SCFree(pv);
+}
+
+/** \internal
+ *  \brief read the next chunk of records into the thread's buffer
+ *
+ *  Only part that is serialized between the readers: a single read and a
+ *  walk over the record headers. Record numbers are assigned here so they
+ *  are the same as with a single reader.
+ *
+ *  \retval TM_ECODE_OK chunk read, pv->seq is its turn
+ *  \retval TM_ECODE_DONE end of file
+ *  \retval TM_ECODE_FAILED read error or corrupt record
+ */
+static TmEcode PcapFileParallelReadChunk(PcapFileParallelVars *pv)
+{
+    PcapFileParallelCtx *ctx = pcap_parallel;
+    TmEcode result = TM_ECODE_OK;
+
+    pv->records_cnt = 0;
+
+    SCMutexLock(&ctx->read_lock);
+    if (ctx->eof) {
+        SCMutexUnlock(&ctx->read_lock);
+        return TM_ECODE_DONE;
+    }
+    /* initialize all the thread's initial timestamp */
+    if (ctx->next_seq == 0) {
+        TmThreadsInitThreadsTimestamp(ctx->first_ts);
+    }
+
+    ssize_t len;
+    do {
+        len = pread(ctx->fd, pv->buf, pv->buf_size, ctx->offset);
+    } while (len < 0 && errno == EINTR);
+    if (len < 0) {
+        SCLogError("%s: read failed: %s", ctx->filename, strerror(errno));
+        ctx->eof = true;
+        SCMutexUnlock(&ctx->read_lock);
+        return TM_ECODE_FAILED;
+    }
+
+    uint32_t pos = 0;
+    while (pos < PCAP_PARALLEL_CHUNK_SIZE && pv->records_cnt < ctx->chunk_pkts &&
+            pos + PCAP_RECORD_HDR_LEN <= (uint64_t)len) {
+        const uint8_t *hdr = pv->buf + pos;
+        const uint32_t caplen = PcapFileParallelGet32(ctx, hdr + 8);
+        if (caplen > ctx->max_caplen) {
+            SCLogError("%s: record at offset %" PRIu64 " has invalid length %u", ctx->filename,
+                    ctx->offset + pos, caplen);
+            result = TM_ECODE_FAILED;
+            break;
+        }
+        if (pos + PCAP_RECORD_HDR_LEN + caplen > (uint64_t)len)
+            break;
+
+        const uint8_t *data = hdr + PCAP_RECORD_HDR_LEN;
+        pos += PCAP_RECORD_HDR_LEN + caplen;
+
+        if (ctx->has_filter) {
+            struct pcap_pkthdr h = { .caplen = caplen,
+                .len = PcapFileParallelGet32(ctx, hdr + 12) };
+            if (pcap_offline_filter(&ctx->filter, &h, data) == 0)
+                continue;
+        }
+#ifdef DEBUG
+        if (unlikely((ctx->cnt + 1ULL) == g_eps_pcap_packet_loss)) {
+            SCLogNotice("skipping packet %" PRIu64, g_eps_pcap_packet_loss);
+            ctx->cnt++;
+            continue;
+        }
+#endif
+        const uint32_t frac = PcapFileParallelGet32(ctx, hdr + 4);
+        PcapFileParallelRecord *rec = &pv->records[pv->records_cnt++];
+        rec->offset = (uint32_t)(data - pv->buf);
+        rec->caplen = caplen;
+        rec->pcap_cnt = ++ctx->cnt;
+        rec->ts.secs = PcapFileParallelGet32(ctx, hdr);
+        rec->ts.usecs = ctx->nsec ? frac / 1000 : frac;
+    }
+
+    if (pos == 0) {
+        if (result == TM_ECODE_OK) {
+            if (len > 0) {
+                SCLogWarning("%s: truncated record at offset %" PRIu64, ctx->filename,
+                        ctx->offset);
+            }
+            SCLogInfo("pcap file %s end of file reached", ctx->filename);
+            pv->shared->files++;
+            result = TM_ECODE_DONE;
+        }
+        ctx->eof = true;
+        SCMutexUnlock(&ctx->read_lock);
+        return result;
+    }
+
+    /* records before a corrupt one are still processed, the next read
+     * reports the error */
+    ctx->offset += pos;
+    pv->seq = ctx->next_seq++;
+    pcap_g.cnt = ctx->cnt;
+    SCMutexUnlock(&ctx->read_lock);
+    return TM_ECODE_OK;
+}
+
+/** \internal
+ *  \brief output handler for the reader while it decodes a chunk */
+static void PcapFileParallelStash(ThreadVars *tv, Packet *p)
+{
+    PacketEnqueueNoLock(pcap_parallel_stash, p);
+}
+
+/** \internal
+ *  \brief run the packets collected so far through the pipeline */
+static TmEcode PcapFileParallelProcessBatch(PcapFileParallelVars *pv)
+{
+    const uint32_t cnt = pv->batch_cnt;
+    pv->batch_cnt = 0;
+    if (cnt == 0)
+        return TM_ECODE_OK;
+    return TmThreadsSlotProcessPktBatch(pv->shared->tv, pv->shared->slot, pv->batch, cnt);
+}
+
+/** \internal
+ *  \brief turn the records of the chunk into decoded packets
+ *
+ *  The output handler is the stash, so the packets and any tunnel pseudo
+ *  packets stay with the thread until the chunk's turn.
+ */
+static TmEcode PcapFileParallelProcessChunk(PcapFileParallelVars *pv)
+{
+    PcapFileParallelCtx *ctx = pcap_parallel;
+    PcapFileSharedVars *shared = pv->shared;
+
+    for (uint32_t i = 0; i < pv->records_cnt; i++) {
+        const PcapFileParallelRecord *rec = &pv->records[i];
+
+        Packet *p = PacketGetFromQueueOrAlloc();
+        if (unlikely(p == NULL)) {
+            continue;
+        }
+        PACKET_PROFILING_TMM_START(p, TMM_RECEIVEPCAPFILE);
+
+        PKT_SET_SRC(p, PKT_SRC_WIRE);
+        p->ts = rec->ts;
+        p->datalink = ctx->datalink;
+        p->pcap_cnt = rec->pcap_cnt;
+        p->pcap_v.tenant_id = shared->tenant_id;
+        shared->pkts++;
+        shared->bytes += rec->caplen;
+
+        if (unlikely(PacketCopyData(p, pv->buf + rec->offset, rec->caplen))) {
+            TmqhOutputPacketpool(shared->tv, p);
+            PACKET_PROFILING_TMM_END(p, TMM_RECEIVEPCAPFILE);
+            continue;
+        }
+        PcapFileSetPacketChecksumMode(p, shared->pkts);
+
+        PACKET_PROFILING_TMM_END(p, TMM_RECEIVEPCAPFILE);
+
+        pv->batch[pv->batch_cnt++] = p;
+        if (pv->batch_cnt == TM_PKT_BATCH_SIZE &&
+                PcapFileParallelProcessBatch(pv) != TM_ECODE_OK) {
+            return TM_ECODE_FAILED;
+        }
+    }
+    return PcapFileParallelProcessBatch(pv);
+}
+
+/** \internal
+ *  \brief pass the stashed packets on once all earlier chunks are */
+static void PcapFileParallelFlushInOrder(
+        PcapFileParallelVars *pv, void (*OutputFunc)(ThreadVars *, Packet *))
+{
+    PcapFileParallelCtx *ctx = pcap_parallel;
+    ThreadVars *tv = pv->shared->tv;
+
+    SCMutexLock(&ctx->dispatch_lock);
+    while (ctx->dispatch_seq != pv->seq) {
+        SCCondWait(&ctx->dispatch_cond, &ctx->dispatch_lock);
+    }
+    SCMutexUnlock(&ctx->dispatch_lock);
+
+    Packet *p;
+    while ((p = PacketDequeueNoLock(&pv->stash)) != NULL) {
+        OutputFunc(tv, p);
+    }
+
+    SCMutexLock(&ctx->dispatch_lock);
+    ctx->dispatch_seq++;
+    SCCondBroadcast(&ctx->dispatch_cond);
+    SCMutexUnlock(&ctx->dispatch_lock);
+}
+
+TmEcode PcapFileParallelDispatch(PcapFileParallelVars *pv)
+{
+    SCEnter();
+
+    PcapFileParallelCtx *ctx = pcap_parallel;
+    ThreadVars *tv = pv->shared->tv;
+    void (*OutputFunc)(ThreadVars *, Packet *) = tv->tmqh_out;
+    TmEcode result = TM_ECODE_OK;
+
+    pcap_parallel_stash = &pv->stash;
+    tv->tmqh_out = PcapFileParallelStash;
+
+    while (result == TM_ECODE_OK) {
+        if (suricata_ctl_flags & SURICATA_STOP) {
+            break;
+        }
+
+        /* make sure we have at least one packet in the packet pool, to prevent
+         * us from alloc'ing packets at line rate */
+        PacketPoolWait();
+
+        result = PcapFileParallelReadChunk(pv);
+        if (result != TM_ECODE_OK)
+            break;
+
+        /* a chunk that was read is always flushed, or the readers after
+         * this one would wait for its turn forever */
+        result = PcapFileParallelProcessChunk(pv);
+        PcapFileParallelFlushInOrder(pv, OutputFunc);
+        if (result != TM_ECODE_OK) {
+            SCLogError("pcap reader failed to process %s", ctx->filename);
+        }
+        StatsSyncCountersIfSignalled(tv);
+    }
+
+    tv->tmqh_out = OutputFunc;
+    pcap_parallel_stash = NULL;
+    SCReturnInt(result);
+}
+
+bool PcapFileParallelReaderDone(void)
+{
+    PcapFileParallelCtx *ctx = pcap_parallel;
+
+    if (SC_ATOMIC_ADD(ctx->readers_done, 1) + 1 != ctx->readers)
+        return false;
+
+    /* not read at all if every reader failed to start */
+    if (ctx->should_delete && ctx->eof) {
+        SCLogDebug("Deleting pcap file %s", ctx->filename);
+        if (unlink(ctx->filename) != 0) {
+            SCLogWarning("Failed to delete %s: %s", ctx->filename, strerror(errno));
+        }
+    }
+    pcap_parallel = NULL;
+    PcapFileParallelCtxFree(ctx);
+    return true;
+}
@@ -0,0 +1,73 @@
+/* Copyright (C) 2026 Open Information Security Foundation
+ *
+ * You can copy, redistribute or modify this Program under the terms of
+ * the GNU General Public License version 2 as published by the Free
+ * Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/**
+ * \file
+ *
+ * Reading a single pcap file with multiple reader threads
+ */
+
+#include "suricata-common.h"
+#include "source-pcap-file-helper.h"
+
+#ifndef __SOURCE_PCAP_FILE_PARALLEL_H__
+#define __SOURCE_PCAP_FILE_PARALLEL_H__
+
+typedef struct PcapFileParallelVars_ PcapFileParallelVars;
+
+/**
+ * Set up reading a file with the number of readers from pcap-file.readers.
+ * Falls back to a single reader for directories, pcapng files and the unix
+ * socket mode.
+ * @param filename File or directory to read
+ * @return number of reader threads to create
+ */
+uint16_t PcapFileParallelInit(const char *filename);
+
+/**
+ * @return true if PcapFileParallelInit set up more than one reader
+ */
+bool PcapFileParallelIsActive(void);
+
+/**
+ * Set up the per thread state of a reader
+ * @param shared Thread level vars of the reader
+ * @return the vars or NULL on error
+ */
+PcapFileParallelVars *PcapFileParallelThreadInit(PcapFileSharedVars *shared);
+
+/**
+ * Cleanup the per thread state of a reader
+ * @param pv Object to be cleaned up
+ */
+void PcapFileParallelThreadDeinit(PcapFileParallelVars *pv);
+
+/**
+ * Read and process chunks of the file until the end of it is reached
+ * @param pv Reader to run
+ * @return TM_ECODE_DONE at the end of the file, TM_ECODE_FAILED on error
+ */
+TmEcode PcapFileParallelDispatch(PcapFileParallelVars *pv);
+
+/**
+ * Signal that a reader is done with the file. The last reader cleans up
+ * the shared state.
+ * @return true for the last reader
+ */
+bool PcapFileParallelReaderDone(void);
+
+#endif /* __SOURCE_PCAP_FILE_PARALLEL_H__ */
@@ -27,6 +27,7 @@
 #include "source-pcap-file.h"
 #include "source-pcap-file-helper.h"
 #include "source-pcap-file-directory-helper.h"
+#include "source-pcap-file-parallel.h"
 #include "flow-manager.h"
 #include "util-checksum.h"
 #include "runmode-unix-socket.h"
@@ -42,6 +43,7 @@ typedef union PcapFileBehaviorVar_
 {
     PcapFileDirectoryVars *directory;
     PcapFileFileVars *file;
+    PcapFileParallelVars *parallel;
 } PcapFileBehaviorVar;
 
 /**
@@ -51,6 +53,8 @@ typedef struct PcapFileThreadVars_
 {
     PcapFileBehaviorVar behavior;
     bool is_directory;
+    /** one of the readers of a file read by multiple threads */
+    bool is_parallel;
 
     PcapFileSharedVars shared;
 } PcapFileThreadVars;
@@ -89,7 +93,10 @@ void CleanupPcapDirectoryFromThreadVars(PcapFileThreadVars *tv, PcapFileDirector
 void CleanupPcapFileThreadVars(PcapFileThreadVars *ptv)
 {
     if (ptv != NULL) {
-        if (ptv->is_directory == 0) {
+        if (ptv->is_parallel) {
+            PcapFileParallelThreadDeinit(ptv->behavior.parallel);
+            ptv->behavior.parallel = NULL;
+        } else if (ptv->is_directory == 0) {
             if (ptv->behavior.file != NULL) {
                 CleanupPcapFileFromThreadVars(ptv, ptv->behavior.file);
             }
@@ -159,7 +166,10 @@ TmEcode ReceivePcapFileLoop(ThreadVars *tv, void *data, void *slot)
     if(unlikely(data == NULL)) {
         SCLogError("pcap file reader thread failed to initialize");
 
-        PcapFileExit(TM_ECODE_FAILED, NULL);
+        /* a failed reader of a shared file was counted as done at init, the
+         * engine is stopped by the last reader still working on the file */
+        if (!PcapFileParallelIsActive())
+            PcapFileExit(TM_ECODE_FAILED, NULL);
 
         SCReturnInt(TM_ECODE_DONE);
     }
@@ -175,7 +185,14 @@ TmEcode ReceivePcapFileLoop(ThreadVars *tv, void *data, void *slot)
     // packets)
     TmThreadsSetFlag(tv, THV_RUNNING);
 
-    if(ptv->is_directory == 0) {
+    if (ptv->is_parallel) {
+        status = PcapFileParallelDispatch(ptv->behavior.parallel);
+        /* the engine is stopped once all readers are done with the file */
+        if (!PcapFileParallelReaderDone()) {
+            SCLogDebug("Pcap file reader done with status %u", status);
+            SCReturnInt(status == TM_ECODE_FAILED ? status : TM_ECODE_DONE);
+        }
+    } else if (ptv->is_directory == 0) {
         SCLogInfo("Starting file run for %s", ptv->behavior.file->filename);
         status = PcapFileDispatch(ptv->behavior.file);
         CleanupPcapFileFromThreadVars(ptv, ptv->behavior.file);
@@ -207,6 +224,9 @@ TmEcode ReceivePcapFileThreadInit(ThreadVars *tv, const void *initdata, void **d
 
     PcapFileThreadVars *ptv = SCMalloc(sizeof(PcapFileThreadVars));
     if (unlikely(ptv == NULL)) {
+        /* don't keep the other readers of the file waiting on this one */
+        if (PcapFileParallelIsActive())
+            (void)PcapFileParallelReaderDone();
         SCReturnInt(TM_ECODE_OK);
     }
     memset(ptv, 0, sizeof(PcapFileThreadVars));
@@ -229,6 +249,8 @@ TmEcode ReceivePcapFileThreadInit(ThreadVars *tv, const void *initdata, void **d
         if (unlikely(ptv->shared.bpf_string == NULL)) {
             SCLogError("Failed to allocate bpf_string");
 
+            if (PcapFileParallelIsActive())
+                (void)PcapFileParallelReaderDone();
             CleanupPcapFileThreadVars(ptv);
 
             SCReturnInt(TM_ECODE_OK);
@@ -241,14 +263,23 @@ TmEcode ReceivePcapFileThreadInit(ThreadVars *tv, const void *initdata, void **d
         ptv->shared.should_delete = should_delete == 1;
     }
 
+    int use_mmap = 1;
+    (void)ConfGetBool("pcap-file.mmap", &use_mmap);
+    ptv->shared.use_mmap = use_mmap == 1;
+
     DIR *directory = NULL;
     SCLogDebug("checking file or directory %s", (char*)initdata);
-    if(PcapDetermineDirectoryOrFile((char *)initdata, &directory) == TM_ECODE_FAILED) {
+    if (PcapFileParallelIsActive()) {
+        ptv->behavior.parallel = PcapFileParallelThreadInit(&ptv->shared);
+        if (ptv->behavior.parallel == NULL) {
+            CleanupPcapFileThreadVars(ptv);
+            SCReturnInt(TM_ECODE_OK);
+        }
+        ptv->is_parallel = true;
+    } else if (PcapDetermineDirectoryOrFile((char *)initdata, &directory) == TM_ECODE_FAILED) {
         CleanupPcapFileThreadVars(ptv);
         SCReturnInt(TM_ECODE_OK);
-    }
-
-    if(directory == NULL) {
+    } else if (directory == NULL) {
         SCLogDebug("argument %s was a file", (char *)initdata);
         PcapFileFileVars *pv = SCMalloc(sizeof(PcapFileFileVars));
         if (unlikely(pv == NULL)) {
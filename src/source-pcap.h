@@ -35,6 +35,8 @@ void PcapTranslateIPToDevice(char *pcap_dev, size_t len);
 typedef struct PcapPacketVars_
 {
     uint32_t tenant_id;
+    /** pcap-file: mapping of the file the packet data points into */
+    void *relptr;
 } PcapPacketVars;
 
 /** needs to be able to contain Windows adapter id's, so
@@ -96,8 +96,16 @@ static inline int InsertSegmentDataCustom(TcpStream *stream, TcpSegment *seg, ui
         SCReturnInt(SC_OK);
     }
 
-    int ret = StreamingBufferInsertAt(&stream->sb, &stream_config.sbcnf, &seg->sbseg,
-            data + data_offset, data_len - data_offset, stream_offset);
+    int ret;
+    if (RB_EMPTY(&stream->sb.sbb_tree) && stream->sb.region.next == NULL &&
+            stream_offset == stream->sb.region.stream_offset + stream->sb.region.buf_offset) {
+        /* no gaps and the data continues where the buffer ends */
+        ret = StreamingBufferAppend(&stream->sb, &stream_config.sbcnf, &seg->sbseg,
+                data + data_offset, data_len - data_offset);
+    } else {
+        ret = StreamingBufferInsertAt(&stream->sb, &stream_config.sbcnf, &seg->sbseg,
+                data + data_offset, data_len - data_offset, stream_offset);
+    }
     if (ret != SC_OK) {
         SCReturnInt(ret);
     }
@@ -153,6 +161,42 @@ static inline bool CheckOverlap(struct TCPSEG *tree, TcpSegment *seg)
     return false;
 }
 
+/** \internal
+ *  \brief append an in order segment to the tree
+ *
+ *  A segment starting at segs_right_edge sorts after every segment in the
+ *  tree and can't overlap any of them, so it's linked in as the new
+ *  rightmost node without the tree search and overlap checks.
+ *
+ *  \retval true appended
+ *  \retval false not in order, use DoInsertSegment
+ */
+static inline bool DoAppendSegment(TcpStream *stream, TcpSegment *seg)
+{
+    if (!SEQ_EQ(seg->seq, stream->segs_right_edge) || SEQ_LT(seg->seq, stream->base_seq))
+        return false;
+
+    TcpSegment *last = stream->seg_tree_last;
+    if (last == NULL && !RB_EMPTY(&stream->seg_tree)) {
+        last = RB_MAX(TCPSEG, &stream->seg_tree);
+    }
+    DEBUG_VALIDATE_BUG_ON(last != NULL && RB_RIGHT(last, rb) != NULL);
+    DEBUG_VALIDATE_BUG_ON(last != NULL && SEQ_GT(SEG_SEQ_RIGHT_EDGE(last), seg->seq));
+
+    RB_SET(seg, last, rb);
+    if (last != NULL) {
+        RB_RIGHT(last, rb) = seg;
+    } else {
+        RB_ROOT(&stream->seg_tree) = seg;
+    }
+    TCPSEG_RB_INSERT_COLOR(&stream->seg_tree, seg);
+
+    stream->seg_tree_last = seg;
+    stream->segs_right_edge = SEG_SEQ_RIGHT_EDGE(seg);
+    SCLogDebug("appended seg %p seq %" PRIu32 ", len %" PRIu32, seg, seg->seq, TCP_SEG_LEN(seg));
+    return true;
+}
+
 /** \internal
  *  \brief insert the segment into the proper place in the tree
  *         don't worry about the data or overlaps
@@ -174,6 +218,7 @@ static int DoInsertSegment (TcpStream *stream, TcpSegment *seg, TcpSegment **dup
         SCLogDebug("empty tree, inserting seg %p seq %" PRIu32 ", "
                    "len %" PRIu32 "", seg, seg->seq, TCP_SEG_LEN(seg));
         TCPSEG_RB_INSERT(&stream->seg_tree, seg);
+        stream->seg_tree_last = seg;
         stream->segs_right_edge = SEG_SEQ_RIGHT_EDGE(seg);
         return 0;
     }
@@ -189,6 +234,8 @@ static int DoInsertSegment (TcpStream *stream, TcpSegment *seg, TcpSegment **dup
     } else {
         if (SEQ_GT(SEG_SEQ_RIGHT_EDGE(seg), stream->segs_right_edge))
             stream->segs_right_edge = SEG_SEQ_RIGHT_EDGE(seg);
+        if (stream->seg_tree_last != NULL && TcpSegmentCompare(seg, stream->seg_tree_last) > 0)
+            stream->seg_tree_last = seg;
 
         /* insert succeeded, now check if we overlap with someone */
         if (CheckOverlap(&stream->seg_tree, seg) == true) {
@@ -641,9 +688,15 @@ int StreamTcpReassembleInsertSegment(ThreadVars *tv, TcpReassemblyThreadCtx *ra_
     SCEnter();
 
     TcpSegment *dup_seg = NULL;
+    int r = 0;
 
     /* insert segment into list. Note: doesn't handle the data */
-    int r = DoInsertSegment (stream, seg, &dup_seg, p);
+    if (DoAppendSegment(stream, seg)) {
+        StatsIncr(tv, ra_ctx->counter_tcp_reass_insert_fast);
+    } else {
+        StatsIncr(tv, ra_ctx->counter_tcp_reass_insert_tree);
+        r = DoInsertSegment(stream, seg, &dup_seg, p);
+    }
 
     if (IsTcpSessionDumpingEnabled()) {
         StreamTcpSegmentAddPacketData(seg, p, tv, ra_ctx);
@@ -713,6 +766,77 @@ int StreamTcpReassembleInsertSegment(ThreadVars *tv, TcpReassemblyThreadCtx *ra_
 }
 
 
+/**
+ *  \brief check if the stream can do without TcpSegments for new data
+ *
+ *  Segments are needed by raw inspection, tcp-data logging, pcap stream
+ *  dumping, overlap checks and protocol detection. If none of those apply
+ *  and all data so far is in order, the StreamingBuffer alone is enough.
+ */
+bool StreamTcpLazyCheck(const TcpStream *stream)
+{
+    if (!stream_config.lazy_reassembly || check_overlap_different_data ||
+            stream_config.streaming_log_api || IsTcpSessionDumpingEnabled())
+        return false;
+    if (!(stream->flags & STREAMTCP_STREAM_FLAG_DISABLE_RAW))
+        return false;
+    if (!StreamTcpIsSetStreamFlagAppProtoDetectionCompleted(stream) ||
+            (stream->flags & STREAMTCP_STREAM_FLAG_APPPROTO_DETECTION_SKIPPED))
+        return false;
+    /* out of order data is tracked by segments until the tree drains */
+    if (!RB_EMPTY(&stream->seg_tree) || !RB_EMPTY(&stream->sb.sbb_tree) ||
+            stream->sb.region.next != NULL)
+        return false;
+    if (!STREAM_HAS_SEEN_DATA(stream))
+        return false;
+    return StreamingBufferGetConsecutiveDataRightEdge(&stream->sb) == STREAM_RIGHT_EDGE(stream);
+}
+
+/**
+ *  \brief add data to the stream w/o a TcpSegment
+ *
+ *  Lazy reassembly mode: in order data is appended straight to the
+ *  StreamingBuffer. Data before the right edge is already in the buffer,
+ *  so it is trimmed off and ignored (first wins). Data beyond the right
+ *  edge leaves a gap and is handed back to the segment path, which tracks
+ *  the hole in the buffer's block tree.
+ *
+ *  \retval 1 data handled
+ *  \retval 0 not handled, caller needs to use a TcpSegment
+ *  \retval -1 error, -SC_ENOMEM on memcap
+ */
+int StreamTcpReassembleLazyAppend(ThreadVars *tv, TcpReassemblyThreadCtx *ra_ctx,
+        TcpStream *stream, Packet *p, uint32_t seq, const uint8_t *data, uint32_t data_len)
+{
+    if (!StreamTcpLazyCheck(stream))
+        return 0;
+    if (SEQ_GT(seq, stream->segs_right_edge))
+        return 0;
+
+    StatsIncr(tv, ra_ctx->counter_tcp_reass_insert_lazy);
+
+    if (SEQ_LEQ(seq + data_len, stream->segs_right_edge)) {
+        SCLogDebug("seq %u len %u: data already in the buffer", seq, data_len);
+        return 1;
+    }
+    const uint32_t skip = stream->segs_right_edge - seq;
+
+    int r = StreamingBufferAppendNoTrack(
+            &stream->sb, &stream_config.sbcnf, data + skip, data_len - skip);
+    if (r != SC_OK) {
+        StatsIncr(tv, ra_ctx->counter_tcp_reass_data_normal_fail);
+        if (r == SC_ENOMEM) {
+            StatsIncr(tv, ra_ctx->counter_tcp_segment_memcap);
+            StreamTcpSetEvent(p, STREAM_REASSEMBLY_INSERT_MEMCAP);
+            return -SC_ENOMEM;
+        }
+        return -1;
+    }
+    stream->segs_right_edge += data_len - skip;
+    SCLogDebug("appended %u bytes, right edge now %u", data_len - skip, stream->segs_right_edge);
+    return 1;
+}
+
 /*
  * Pruning & removal
  */
@@ -875,6 +999,8 @@ static inline uint64_t GetLeftEdge(Flow *f, TcpSession *ssn, TcpStream *stream)
 
 static void StreamTcpRemoveSegmentFromStream(TcpStream *stream, TcpSegment *seg)
 {
+    if (stream->seg_tree_last == seg)
+        stream->seg_tree_last = NULL;
     RB_REMOVE(TCPSEG, &stream->seg_tree, seg);
 }
 
@@ -39,12 +39,14 @@
 #include "tm-threads.h"
 
 #include "util-pool.h"
+#include "util-arena.h"
 #include "util-unittest.h"
 #include "util-print.h"
 #include "util-host-os-info.h"
 #include "util-unittest-helper.h"
 #include "util-byte.h"
 #include "util-device.h"
+#include "util-misc.h"
 
 #include "stream-tcp.h"
 #include "stream-tcp-private.h"
@@ -80,10 +82,20 @@ thread_local uint64_t t_pcapcnt = UINT64_MAX;
 PoolThread *segment_thread_pool = NULL;
 /* init only, protect initializing and growing pool */
 static SCMutex segment_thread_pool_mutex = SCMUTEX_INITIALIZER;
+/** segments are carved from this arena if arena.enabled is set */
+static Arena *segment_arena = NULL;
 
 /* Memory use counter */
 SC_ATOMIC_DECLARE(uint64_t, ra_memuse);
 
+/** adaptive depth: shrink the reassembly depth as ra_memuse nears the memcap */
+static struct {
+    bool enabled;
+    uint8_t pressure;       /**< % of the memcap where the depth starts to shrink */
+    uint32_t min_depth;     /**< depth is never shrunk below this */
+    bool priority[ALPROTO_MAX]; /**< protocols that are shrunk last */
+} depth_pressure = { .enabled = false, .pressure = 75, .min_depth = 64 * 1024 };
+
 static int g_tcp_session_dump_enabled = 0;
 
 inline bool IsTcpSessionDumpingEnabled(void)
@@ -151,6 +163,53 @@ uint64_t StreamTcpReassembleMemuseGlobalCounter(void)
     return smemuse;
 }
 
+/**
+ *  \brief get the reassembly depth to use under the current memory pressure
+ *
+ *  Below the pressure threshold the depth is used as is. Above it the depth
+ *  shrinks linearly, reaching the minimum depth when ra_memuse hits the
+ *  memcap. Priority protocols only start to shrink halfway between the
+ *  threshold and the memcap. Streams that already went past the shrunk
+ *  depth stop being reassembled, so the flows that sent the most data are
+ *  cut first.
+ *
+ *  \param depth configured depth for the session, 0 for unlimited
+ *  \param alproto app-layer protocol of the flow
+ *
+ *  \retval depth effective depth, 0 for unlimited
+ */
+uint32_t StreamTcpReassembleDepthUnderPressure(const uint32_t depth, const AppProto alproto)
+{
+    const uint64_t memcap = SC_ATOMIC_GET(stream_config.reassembly_memcap);
+    if (!depth_pressure.enabled || memcap == 0)
+        return depth;
+
+    uint64_t start = memcap * depth_pressure.pressure / 100;
+    if (alproto < ALPROTO_MAX && depth_pressure.priority[alproto])
+        start += (memcap - start) / 2;
+
+    const uint64_t memuse = SC_ATOMIC_GET(ra_memuse);
+    if (memuse <= start)
+        return depth;
+
+    const uint64_t full = depth ? depth : UINT32_MAX;
+    const uint64_t min_depth = depth_pressure.min_depth;
+    if (full <= min_depth)
+        return depth;
+    if (memuse >= memcap)
+        return (uint32_t)min_depth;
+
+    /* share of the pressure range still left, in 1/1024 */
+    const uint64_t left = ((memcap - memuse) << 10) / (memcap - start);
+    return (uint32_t)(min_depth + (((full - min_depth) * left) >> 10));
+}
+
+static uint64_t StreamTcpReassembleDepthGlobalCounter(void)
+{
+    return StreamTcpReassembleDepthUnderPressure(
+            stream_config.reassembly_depth, ALPROTO_UNKNOWN);
+}
+
 /**
  * \brief  Function to Check the reassembly memory usage counter against the
  *         allowed max memory usage for TCP segments.
@@ -256,6 +315,16 @@ static void ReassembleFree(void *ptr, size_t size)
     StreamTcpReassembleDecrMemuse(size);
 }
 
+/** \brief free a tcp segment pool entry */
+static void TcpSegmentPoolFree(void *ptr)
+{
+    if (segment_arena != NULL) {
+        ArenaFree(segment_arena, ptr);
+    } else {
+        SCFree(ptr);
+    }
+}
+
 /** \brief alloc a tcp segment pool entry */
 static void *TcpSegmentPoolAlloc(void)
 {
@@ -266,7 +335,11 @@ static void *TcpSegmentPoolAlloc(void)
 
     TcpSegment *seg = NULL;
 
-    seg = SCMalloc(sizeof (TcpSegment));
+    if (segment_arena != NULL) {
+        seg = ArenaAlloc(segment_arena);
+    } else {
+        seg = SCMalloc(sizeof(TcpSegment));
+    }
     if (unlikely(seg == NULL))
         return NULL;
 
@@ -274,7 +347,7 @@ static void *TcpSegmentPoolAlloc(void)
         uint32_t memuse =
                 sizeof(TcpSegmentPcapHdrStorage) + sizeof(uint8_t) * TCPSEG_PKT_HDR_DEFAULT_SIZE;
         if (StreamTcpReassembleCheckMemcap(sizeof(TcpSegment) + memuse) == 0) {
-            SCFree(seg);
+            TcpSegmentPoolFree(seg);
             return NULL;
         }
 
@@ -282,7 +355,7 @@ static void *TcpSegmentPoolAlloc(void)
         if (seg->pcap_hdr_storage == NULL) {
             SCLogError("Unable to allocate memory for "
                        "TcpSegmentPcapHdrStorage");
-            SCFree(seg);
+            TcpSegmentPoolFree(seg);
             return NULL;
         } else {
             seg->pcap_hdr_storage->alloclen = sizeof(uint8_t) * TCPSEG_PKT_HDR_DEFAULT_SIZE;
@@ -293,7 +366,7 @@ static void *TcpSegmentPoolAlloc(void)
                            "packet header data within "
                            "TcpSegmentPcapHdrStorage");
                 SCFree(seg->pcap_hdr_storage);
-                SCFree(seg);
+                TcpSegmentPoolFree(seg);
                 return NULL;
             }
         }
@@ -401,6 +474,7 @@ void StreamTcpReturnStreamSegments (TcpStream *stream)
         RB_REMOVE(TCPSEG, &stream->seg_tree, seg);
         StreamTcpSegmentReturntoPool(seg);
     }
+    stream->seg_tree_last = NULL;
 }
 
 static inline uint64_t GetAbsLastAck(const TcpStream *stream)
@@ -500,6 +574,50 @@ static int StreamTcpReassemblyConfig(bool quiet)
         StreamTcpReassembleConfigEnableOverlapCheck();
     }
 
+    ConfNode *ad = ConfGetNode("stream.reassembly.adaptive-depth");
+    if (ad != NULL) {
+        int enabled = 0;
+        (void)ConfGetChildValueBool(ad, "enabled", &enabled);
+        depth_pressure.enabled = enabled;
+    }
+    if (depth_pressure.enabled) {
+        const char *val = NULL;
+        if (ConfGetChildValue(ad, "pressure", &val) == 1) {
+            uint8_t pressure = 0;
+            if (StringParseU8RangeCheck(&pressure, 10, 0, val, 1, 99) < 0) {
+                SCLogError("stream.reassembly.adaptive-depth.pressure %s is invalid, "
+                           "expected a percentage between 1 and 99",
+                        val);
+                return -1;
+            }
+            depth_pressure.pressure = pressure;
+        }
+        if (ConfGetChildValue(ad, "min-depth", &val) == 1) {
+            if (ParseSizeStringU32(val, &depth_pressure.min_depth) < 0) {
+                SCLogError("stream.reassembly.adaptive-depth.min-depth %s is invalid", val);
+                return -1;
+            }
+        }
+        ConfNode *prio = ConfNodeLookupChild(ad, "priority");
+        if (prio != NULL) {
+            ConfNode *n;
+            TAILQ_FOREACH (n, &prio->head, next) {
+                AppProto a = StringToAppProto(n->val);
+                if (a == ALPROTO_UNKNOWN) {
+                    SCLogWarning("stream.reassembly.adaptive-depth.priority: "
+                                 "unknown protocol %s",
+                            n->val);
+                    continue;
+                }
+                depth_pressure.priority[a] = true;
+            }
+        }
+        if (!quiet)
+            SCLogConfig("stream.reassembly \"adaptive-depth\": shrink from %u%% of "
+                        "memcap, min depth %u",
+                    depth_pressure.pressure, depth_pressure.min_depth);
+    }
+
     uint16_t max_regions = 8;
     ConfNode *mr = ConfGetNode("stream.reassembly.max-regions");
     if (mr) {
@@ -537,6 +655,13 @@ int StreamTcpReassembleInit(bool quiet)
 #endif
     StatsRegisterGlobalCounter("tcp.reassembly_memuse",
             StreamTcpReassembleMemuseGlobalCounter);
+    if (depth_pressure.enabled) {
+        StatsRegisterGlobalCounter(
+                "tcp.reassembly_depth_effective", StreamTcpReassembleDepthGlobalCounter);
+    }
+    if (ArenaEnabled()) {
+        segment_arena = ArenaCreate("tcp.segment", sizeof(TcpSegment));
+    }
     return 0;
 }
 
@@ -549,6 +674,8 @@ void StreamTcpReassembleFree(bool quiet)
     }
     SCMutexUnlock(&segment_thread_pool_mutex);
     SCMutexDestroy(&segment_thread_pool_mutex);
+    ArenaDestroy(segment_arena);
+    segment_arena = NULL;
 
 #ifdef DEBUG
     if (segment_pool_memuse > 0)
@@ -574,10 +701,10 @@ TcpReassemblyThreadCtx *StreamTcpReassembleInitThreadCtx(ThreadVars *tv)
         segment_thread_pool = PoolThreadInit(1, /* thread */
                 0, /* unlimited */
                 stream_config.prealloc_segments,
-                sizeof(TcpSegment),
+                0, /* segments come from TcpSegmentPoolAlloc */
                 TcpSegmentPoolAlloc,
                 TcpSegmentPoolInit, NULL,
-                TcpSegmentPoolCleanup, NULL);
+                TcpSegmentPoolCleanup, TcpSegmentPoolFree);
         ra_ctx->segment_thread_pool_id = 0;
         SCLogDebug("pool size %d, thread segment_thread_pool_id %d",
                 PoolThreadSize(segment_thread_pool),
@@ -642,19 +769,20 @@ int StreamTcpReassembleDepthReached(Packet *p)
  *        allowed max depth of the stream reassembly for TCP streams.
  *
  *  \param stream stream direction
+ *  \param depth depth to enforce, 0 for unlimited
  *  \param seq sequence number where "size" starts
  *  \param size size of the segment that is added
  *
  *  \retval size Part of the size that fits in the depth, 0 if none
  */
 static uint32_t StreamTcpReassembleCheckDepth(TcpSession *ssn, TcpStream *stream,
-        uint32_t seq, uint32_t size)
+        const uint32_t depth, uint32_t seq, uint32_t size)
 {
     SCEnter();
 
     /* if the configured depth value is 0, it means there is no limit on
        reassembly depth. Otherwise carry on my boy ;) */
-    if (ssn->reassembly_depth == 0) {
+    if (depth == 0) {
         SCReturnUInt(size);
     }
 
@@ -682,30 +810,30 @@ static uint32_t StreamTcpReassembleCheckDepth(TcpSession *ssn, TcpStream *stream
      * wraps as well */
     SCLogDebug("seq + size %u, base %u, seg_depth %"PRIu64" limit %u", (seq + size),
             stream->base_seq, seg_depth,
-            ssn->reassembly_depth);
+            depth);
 
-    if (seg_depth > (uint64_t)ssn->reassembly_depth) {
+    if (seg_depth > (uint64_t)depth) {
         SCLogDebug("STREAMTCP_STREAM_FLAG_DEPTH_REACHED");
         stream->flags |= STREAMTCP_STREAM_FLAG_DEPTH_REACHED;
         SCReturnUInt(0);
     }
     SCLogDebug("NOT STREAMTCP_STREAM_FLAG_DEPTH_REACHED");
-    SCLogDebug("%"PRIu64" <= %u", seg_depth, ssn->reassembly_depth);
+    SCLogDebug("%"PRIu64" <= %u", seg_depth, depth);
 #if 0
     SCLogDebug("full depth not yet reached: %"PRIu64" <= %"PRIu32,
             (stream->base_seq_offset + stream->base_seq + size),
-            (stream->isn + ssn->reassembly_depth));
+            (stream->isn + depth));
 #endif
-    if (SEQ_GEQ(seq, stream->isn) && SEQ_LT(seq, (stream->isn + ssn->reassembly_depth))) {
+    if (SEQ_GEQ(seq, stream->isn) && SEQ_LT(seq, (stream->isn + depth))) {
         /* packet (partly?) fits the depth window */
 
-        if (SEQ_LEQ((seq + size),(stream->isn + 1 + ssn->reassembly_depth))) {
+        if (SEQ_LEQ((seq + size),(stream->isn + 1 + depth))) {
             /* complete fit */
             SCReturnUInt(size);
         } else {
             stream->flags |= STREAMTCP_STREAM_FLAG_DEPTH_REACHED;
             /* partial fit, return only what fits */
-            uint32_t part = (stream->isn + 1 + ssn->reassembly_depth) - seq;
+            uint32_t part = (stream->isn + 1 + depth) - seq;
             DEBUG_VALIDATE_BUG_ON(part > size);
             if (part > size)
                 part = size;
@@ -766,9 +894,21 @@ int StreamTcpReassembleHandleSegmentHandleData(ThreadVars *tv, TcpReassemblyThre
 
     /* If we have reached the defined depth for either of the stream, then stop
        reassembling the TCP session */
-    uint32_t size = StreamTcpReassembleCheckDepth(ssn, stream, TCP_GET_SEQ(p), p->payload_len);
+    uint32_t depth = ssn->reassembly_depth;
+    if (depth_pressure.enabled) {
+        depth = StreamTcpReassembleDepthUnderPressure(
+                depth, p->flow ? p->flow->alproto : ALPROTO_UNKNOWN);
+    }
+    const bool depth_was_reached = (stream->flags & STREAMTCP_STREAM_FLAG_DEPTH_REACHED) != 0;
+    uint32_t size = StreamTcpReassembleCheckDepth(ssn, stream, depth, TCP_GET_SEQ(p), p->payload_len);
     SCLogDebug("ssn %p: check depth returned %"PRIu32, ssn, size);
 
+    if (!depth_was_reached && depth != ssn->reassembly_depth &&
+            (stream->flags & STREAMTCP_STREAM_FLAG_DEPTH_REACHED)) {
+        SCLogDebug("ssn %p: depth %u reached under memory pressure", ssn, depth);
+        StatsIncr(tv, ra_ctx->counter_tcp_stream_depth_pressure);
+    }
+
     if (stream->flags & STREAMTCP_STREAM_FLAG_DEPTH_REACHED) {
         StreamTcpSetEvent(p, STREAM_REASSEMBLY_DEPTH_REACHED);
         /* increment stream depth counter */
@@ -784,6 +924,15 @@ int StreamTcpReassembleHandleSegmentHandleData(ThreadVars *tv, TcpReassemblyThre
     if (size > p->payload_len)
         size = p->payload_len;
 
+    /* lazy mode: in order data w/o a segment */
+    int lr = StreamTcpReassembleLazyAppend(tv, ra_ctx, stream, p, TCP_GET_SEQ(p), p->payload, size);
+    if (lr != 0) {
+        if (lr == -SC_ENOMEM) {
+            ssn->flags |= STREAMTCP_FLAG_LOSSY_BE_LIBERAL;
+        }
+        SCReturnInt(lr < 0 ? -1 : 0);
+    }
+
     TcpSegment *seg = StreamTcpGetSegment(tv, ra_ctx);
     if (seg == NULL) {
         SCLogDebug("segment_pool is empty");
@@ -3139,6 +3288,51 @@ static int StreamTcpReassembleTest44(void)
     PASS;
 }
 
+/** \test   Test the depth shrinking under memcap pressure */
+static int StreamTcpReassembleTest48(void)
+{
+    StreamTcpInitConfig(true);
+    const uint64_t memcap = SC_ATOMIC_GET(stream_config.reassembly_memcap);
+    const uint32_t depth = 1024 * 1024;
+
+    /* disabled */
+    StreamTcpReassembleIncrMemuse(memcap);
+    FAIL_IF(StreamTcpReassembleDepthUnderPressure(depth, ALPROTO_HTTP1) != depth);
+    StreamTcpReassembleDecrMemuse(memcap);
+
+    depth_pressure.enabled = true;
+    depth_pressure.pressure = 50;
+    depth_pressure.min_depth = 64 * 1024;
+    depth_pressure.priority[ALPROTO_TLS] = true;
+
+    /* below the threshold */
+    StreamTcpReassembleIncrMemuse(memcap / 2);
+    FAIL_IF(StreamTcpReassembleDepthUnderPressure(depth, ALPROTO_HTTP1) != depth);
+    FAIL_IF(StreamTcpReassembleDepthUnderPressure(0, ALPROTO_HTTP1) != 0);
+
+    /* halfway: normal protocols shrink, priority ones don't yet */
+    StreamTcpReassembleIncrMemuse(memcap / 4);
+    uint32_t shrunk = StreamTcpReassembleDepthUnderPressure(depth, ALPROTO_HTTP1);
+    FAIL_IF(shrunk >= depth || shrunk <= depth_pressure.min_depth);
+    FAIL_IF(StreamTcpReassembleDepthUnderPressure(depth, ALPROTO_TLS) != depth);
+    shrunk = StreamTcpReassembleDepthUnderPressure(0, ALPROTO_HTTP1);
+    FAIL_IF(shrunk == 0 || shrunk <= depth_pressure.min_depth);
+
+    /* at the memcap everyone gets the min depth */
+    StreamTcpReassembleIncrMemuse(memcap - memcap / 2 - memcap / 4);
+    FAIL_IF(StreamTcpReassembleDepthUnderPressure(depth, ALPROTO_HTTP1) != 64 * 1024);
+    FAIL_IF(StreamTcpReassembleDepthUnderPressure(depth, ALPROTO_TLS) != 64 * 1024);
+    /* depths below the min aren't touched */
+    FAIL_IF(StreamTcpReassembleDepthUnderPressure(4096, ALPROTO_HTTP1) != 4096);
+    StreamTcpReassembleDecrMemuse(memcap);
+
+    depth_pressure.enabled = false;
+    depth_pressure.priority[ALPROTO_TLS] = false;
+    StreamTcpFreeConfig(true);
+    FAIL_IF(SC_ATOMIC_GET(ra_memuse) != 0);
+    PASS;
+}
+
 /**
  *  \test   Test to make sure that reassembly_depth is enforced.
  *
@@ -3888,6 +4082,8 @@ void StreamTcpReassembleRegisterTests(void)
                    StreamTcpReassembleTest46);
     UtRegisterTest("StreamTcpReassembleTest47 -- TCP Sequence Wraparound Test",
                    StreamTcpReassembleTest47);
+    UtRegisterTest("StreamTcpReassembleTest48 -- Depth under memcap pressure",
+                   StreamTcpReassembleTest48);
 
     UtRegisterTest("StreamTcpReassembleInlineTest01 -- inline RAW ra",
                    StreamTcpReassembleInlineTest01);
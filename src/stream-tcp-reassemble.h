@@ -70,6 +70,8 @@ typedef struct TcpReassemblyThreadCtx_ {
 
     /** number of streams that stop reassembly because their depth is reached */
     uint16_t counter_tcp_stream_depth;
+    /** streams cut short by a depth shrunk under memory pressure */
+    uint16_t counter_tcp_stream_depth_pressure;
     /** count number of streams with a unrecoverable stream gap (missing pkts) */
     uint16_t counter_tcp_reass_gap;
 
@@ -80,6 +82,12 @@ typedef struct TcpReassemblyThreadCtx_ {
 
     uint16_t counter_tcp_reass_data_normal_fail;
     uint16_t counter_tcp_reass_data_overlap_fail;
+
+    /** segments appended in order vs inserted through the tree search */
+    uint16_t counter_tcp_reass_insert_fast;
+    uint16_t counter_tcp_reass_insert_tree;
+    /** in order data added w/o a segment in lazy mode */
+    uint16_t counter_tcp_reass_insert_lazy;
 } TcpReassemblyThreadCtx;
 
 #define OS_POLICY_DEFAULT   OS_POLICY_BSD
@@ -107,6 +115,9 @@ void StreamTcpSetOSPolicy(TcpStream *, Packet *);
 
 int StreamTcpReassembleHandleSegmentHandleData(ThreadVars *tv, TcpReassemblyThreadCtx *ra_ctx,
         TcpSession *ssn, TcpStream *stream, Packet *p);
+bool StreamTcpLazyCheck(const TcpStream *stream);
+int StreamTcpReassembleLazyAppend(ThreadVars *tv, TcpReassemblyThreadCtx *ra_ctx,
+        TcpStream *stream, Packet *p, uint32_t seq, const uint8_t *data, uint32_t data_len);
 int StreamTcpReassembleInsertSegment(ThreadVars *, TcpReassemblyThreadCtx *, TcpStream *, TcpSegment *, Packet *, uint32_t pkt_seq, uint8_t *pkt_data, uint16_t pkt_datalen);
 TcpSegment *StreamTcpGetSegment(ThreadVars *, TcpReassemblyThreadCtx *);
 
@@ -117,6 +128,7 @@ void StreamTcpReassembleTriggerRawReassembly(TcpSession *, int direction);
 
 void StreamTcpPruneSession(Flow *, uint8_t);
 int StreamTcpReassembleDepthReached(Packet *p);
+uint32_t StreamTcpReassembleDepthUnderPressure(const uint32_t depth, const AppProto alproto);
 
 void StreamTcpReassembleIncrMemuse(uint64_t size);
 void StreamTcpReassembleDecrMemuse(uint64_t size);
@@ -44,6 +44,7 @@
 
 #include "util-pool.h"
 #include "util-pool-thread.h"
+#include "util-arena.h"
 #include "util-checksum.h"
 #include "util-unittest.h"
 #include "util-print.h"
@@ -108,6 +109,8 @@ extern int g_detect_disabled;
 
 PoolThread *ssn_pool = NULL;
 static SCMutex ssn_pool_mutex = SCMUTEX_INITIALIZER; /**< init only, protect initializing and growing pool */
+/** sessions are carved from this arena if arena.enabled is set */
+static Arena *ssn_arena = NULL;
 #ifdef DEBUG
 static uint64_t ssn_pool_cnt = 0; /** counts ssns, protected by ssn_pool_mutex */
 #endif
@@ -299,13 +302,27 @@ static void *StreamTcpSessionPoolAlloc(void)
     if (StreamTcpCheckMemcap((uint32_t)sizeof(TcpSession)) == 0)
         return NULL;
 
-    ptr = SCMalloc(sizeof(TcpSession));
+    if (ssn_arena != NULL) {
+        ptr = ArenaAlloc(ssn_arena);
+    } else {
+        ptr = SCMalloc(sizeof(TcpSession));
+    }
     if (unlikely(ptr == NULL))
         return NULL;
 
     return ptr;
 }
 
+/** \brief Stream free function for the Pool */
+static void StreamTcpSessionPoolFree(void *ptr)
+{
+    if (ssn_arena != NULL) {
+        ArenaFree(ssn_arena, ptr);
+    } else {
+        SCFree(ptr);
+    }
+}
+
 static int StreamTcpSessionPoolInit(void *data, void* initdata)
 {
     memset(data, 0, sizeof(TcpSession));
@@ -651,6 +668,17 @@ void StreamTcpInitConfig(bool quiet)
     if (!quiet)
         SCLogConfig("stream.reassembly.raw: %s", enable_raw ? "enabled" : "disabled");
 
+    int lazy = 0;
+    if (ConfGetBool("stream.reassembly.lazy", &lazy) == 1 && lazy) {
+        if (StreamTcpInlineMode()) {
+            SCLogWarning("stream.reassembly.lazy is not supported in inline mode, disabling");
+            lazy = 0;
+        }
+    }
+    stream_config.lazy_reassembly = lazy;
+    if (!quiet)
+        SCLogConfig("stream.reassembly.lazy: %s", lazy ? "enabled" : "disabled");
+
     /* default to true. Not many ppl (correctly) set up host-os policies, so be permissive. */
     stream_config.liberal_timestamps = true;
     int liberal_timestamps = 0;
@@ -664,6 +692,10 @@ void StreamTcpInitConfig(bool quiet)
     StreamTcpInitMemuse();
     StatsRegisterGlobalCounter("tcp.memuse", StreamTcpMemuseCounter);
 
+    if (ArenaEnabled()) {
+        ssn_arena = ArenaCreate("tcp.session", sizeof(TcpSession));
+    }
+
     StreamTcpReassembleInit(quiet);
 
     /* set the default free function and flow state function
@@ -677,10 +709,10 @@ void StreamTcpInitConfig(bool quiet)
             ssn_pool = PoolThreadInit(1, /* thread */
                     0, /* unlimited */
                     stream_config.prealloc_sessions,
-                    sizeof(TcpSession),
+                    0, /* sessions come from StreamTcpSessionPoolAlloc */
                     StreamTcpSessionPoolAlloc,
                     StreamTcpSessionPoolInit, NULL,
-                    StreamTcpSessionPoolCleanup, NULL);
+                    StreamTcpSessionPoolCleanup, StreamTcpSessionPoolFree);
         }
         SCMutexUnlock(&ssn_pool_mutex);
     }
@@ -699,6 +731,9 @@ void StreamTcpFreeConfig(bool quiet)
     SCMutexUnlock(&ssn_pool_mutex);
     SCMutexDestroy(&ssn_pool_mutex);
 
+    ArenaDestroy(ssn_arena);
+    ssn_arena = NULL;
+
     SCLogDebug("ssn_pool_cnt %"PRIu64"", ssn_pool_cnt);
 }
 
@@ -5781,12 +5816,17 @@ TmEcode StreamTcpThreadInit(ThreadVars *tv, void *initdata, void **data)
             StatsRegisterCounter("tcp.segment_from_cache", tv);
     stt->ra_ctx->counter_tcp_segment_from_pool = StatsRegisterCounter("tcp.segment_from_pool", tv);
     stt->ra_ctx->counter_tcp_stream_depth = StatsRegisterCounter("tcp.stream_depth_reached", tv);
+    stt->ra_ctx->counter_tcp_stream_depth_pressure =
+            StatsRegisterCounter("tcp.stream_depth_pressure", tv);
     stt->ra_ctx->counter_tcp_reass_gap = StatsRegisterCounter("tcp.reassembly_gap", tv);
     stt->ra_ctx->counter_tcp_reass_overlap = StatsRegisterCounter("tcp.overlap", tv);
     stt->ra_ctx->counter_tcp_reass_overlap_diff_data = StatsRegisterCounter("tcp.overlap_diff_data", tv);
 
     stt->ra_ctx->counter_tcp_reass_data_normal_fail = StatsRegisterCounter("tcp.insert_data_normal_fail", tv);
     stt->ra_ctx->counter_tcp_reass_data_overlap_fail = StatsRegisterCounter("tcp.insert_data_overlap_fail", tv);
+    stt->ra_ctx->counter_tcp_reass_insert_fast = StatsRegisterCounter("tcp.insert_fast_path", tv);
+    stt->ra_ctx->counter_tcp_reass_insert_tree = StatsRegisterCounter("tcp.insert_tree_path", tv);
+    stt->ra_ctx->counter_tcp_reass_insert_lazy = StatsRegisterCounter("tcp.insert_lazy", tv);
 
     SCLogDebug("StreamTcp thread specific ctx online at %p, reassembly ctx %p",
                 stt, stt->ra_ctx);
@@ -5796,10 +5836,10 @@ TmEcode StreamTcpThreadInit(ThreadVars *tv, void *initdata, void **data)
         ssn_pool = PoolThreadInit(1, /* thread */
                 0, /* unlimited */
                 stream_config.prealloc_sessions,
-                sizeof(TcpSession),
+                0, /* sessions come from StreamTcpSessionPoolAlloc */
                 StreamTcpSessionPoolAlloc,
                 StreamTcpSessionPoolInit, NULL,
-                StreamTcpSessionPoolCleanup, NULL);
+                StreamTcpSessionPoolCleanup, StreamTcpSessionPoolFree);
         stt->ssn_pool_id = 0;
         SCLogDebug("pool size %d, thread ssn_pool_id %d", PoolThreadSize(ssn_pool), stt->ssn_pool_id);
     } else {
@@ -6702,6 +6742,26 @@ int StreamTcpSegmentForEach(const Packet *p, uint8_t flag, StreamSegmentCallback
         stream = &(ssn->client);
     }
 
+    /* lazy reassembly: in order data w/o segments, pass the buffer as a
+     * whole. Lazy mode is IDS only. */
+    if (StreamTcpLazyCheck(stream)) {
+        const uint8_t *sb_data;
+        uint32_t sb_data_len;
+        uint64_t sb_offset;
+        StreamingBufferGetData(&stream->sb, &sb_data, &sb_data_len, &sb_offset);
+        if (!PKT_IS_PSEUDOPKT(p)) {
+            const uint64_t acked = StreamTcpGetAcked(stream);
+            sb_data_len = acked > sb_offset ? (uint32_t)MIN(acked - sb_offset, sb_data_len) : 0;
+        }
+        if (sb_data_len == 0)
+            return 0;
+        if (CallbackFunc(p, NULL, data, sb_data, sb_data_len) != 1) {
+            SCLogDebug("Callback function has failed");
+            return -1;
+        }
+        return 1;
+    }
+
     /* for IDS, return ack'd segments. For IPS all. */
     TcpSegment *seg;
     RB_FOREACH(seg, TCPSEG, &stream->seg_tree) {
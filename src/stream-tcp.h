@@ -59,6 +59,8 @@ typedef struct TcpStreamCnf_ {
     bool midstream;
     bool async_oneside;
     bool streaming_log_api;
+    /** add in order data w/o TcpSegment when nothing needs the segments */
+    bool lazy_reassembly;
     uint8_t max_syn_queued;
 
     uint32_t reassembly_depth;  /**< Depth until when we reassemble the stream */
@@ -33,6 +33,8 @@
 #define STREAM_DUMP_TOSERVER BIT_U8(2)
 #define STREAM_DUMP_HEADERS  BIT_U8(3)
 
+/** callback for stream data. The TcpSegment is NULL for data that was
+ *  added in lazy reassembly mode. */
 typedef int (*StreamSegmentCallback)(
         const Packet *, TcpSegment *, void *, const uint8_t *, uint32_t);
 int StreamSegmentForEach(const Packet *p, uint8_t flag,
@@ -103,6 +103,7 @@
 #include "source-napatech.h"
 #include "source-af-packet.h"
 #include "source-af-xdp.h"
+#include "source-lipc.h"
 #include "source-netmap.h"
 #include "source-dpdk.h"
 #include "source-windivert.h"
@@ -118,6 +119,7 @@
 #include "tm-queuehandlers.h"
 
 #include "util-byte.h"
+#include "util-checksum-simd.h"
 #include "util-conf.h"
 #include "util-coredump-config.h"
 #include "util-cpu.h"
@@ -133,6 +135,8 @@
 #include "util-macset.h"
 #include "util-misc.h"
 #include "util-mpm-hs.h"
+#include "util-numa.h"
+#include "util-arena.h"
 #include "util-pidfile.h"
 #include "util-plugin.h"
 #include "util-privs.h"
@@ -351,6 +355,7 @@ static void SignalHandlerSigHup(/*@unused@*/ int sig)
 void GlobalsInitPreConfig(void)
 {
     TimeInit();
+    ChecksumSimdSetup();
     SupportFastPatternForSigMatchTypes();
     SCThresholdConfGlobalInit();
     SCProtoNameInit();
@@ -651,6 +656,10 @@ static void PrintUsage(const char *progname)
     printf("\t--af-xdp[=<dev>]                     : run in af-xdp mode, no value select "
            "interfaces from suricata.yaml\n");
 #endif
+#ifdef HAVE_LIPC
+    printf("\t--lipc                               : run in local IPC mode, serving "
+           "verdicts to local clients\n");
+#endif
 #ifdef HAVE_NETMAP
     printf("\t--netmap[=<dev>]                     : run in netmap mode, no value select interfaces from suricata.yaml\n");
 #endif
@@ -918,6 +927,9 @@ void RegisterAllModules(void)
     /* af-xdp */
     TmModuleReceiveAFXDPRegister();
     TmModuleDecodeAFXDPRegister();
+    /* lipc */
+    TmModuleReceiveLIPCRegister();
+    TmModuleDecodeLIPCRegister();
     /* netmap */
     TmModuleReceiveNetmapRegister();
     TmModuleDecodeNetmapRegister();
@@ -1239,6 +1251,29 @@ static int ParseCommandLineAfxdp(SCInstance *suri, const char *in_arg)
 #endif
 }
 
+static int ParseCommandLineLIPC(SCInstance *suri)
+{
+#ifdef HAVE_LIPC
+    if (suri->run_mode == RUNMODE_UNKNOWN) {
+        suri->run_mode = RUNMODE_LIPC;
+        LiveRegisterDeviceName("lipc");
+    } else if (suri->run_mode == RUNMODE_LIPC) {
+        SCLogInfo("Multiple lipc options have no effect on Suricata");
+    } else {
+        SCLogError("more than one run mode "
+                   "has been specified");
+        PrintUsage(suri->progname);
+        return TM_ECODE_FAILED;
+    }
+    return TM_ECODE_OK;
+#else
+    SCLogError("LIPC not enabled. On Linux "
+               "host, make sure to pass --enable-lipc to "
+               "configure when building.");
+    return TM_ECODE_FAILED;
+#endif
+}
+
 static int ParseCommandLineDpdk(SCInstance *suri, const char *in_arg)
 {
 #ifdef HAVE_DPDK
@@ -1347,6 +1382,7 @@ static TmEcode ParseCommandLine(int argc, char** argv, SCInstance *suri)
 #endif
         {"af-packet", optional_argument, 0, 0},
         {"af-xdp", optional_argument, 0, 0},
+        {"lipc", 0, 0, 0},
         {"netmap", optional_argument, 0, 0},
         {"pcap", optional_argument, 0, 0},
         {"pcap-file-continuous", 0, 0, 0},
@@ -1480,6 +1516,10 @@ static TmEcode ParseCommandLine(int argc, char** argv, SCInstance *suri)
                 if (ParseCommandLineAfxdp(suri, optarg) != TM_ECODE_OK) {
                     return TM_ECODE_FAILED;
                 }
+            } else if (strcmp((long_opts[option_index]).name, "lipc") == 0) {
+                if (ParseCommandLineLIPC(suri) != TM_ECODE_OK) {
+                    return TM_ECODE_FAILED;
+                }
             } else if (strcmp((long_opts[option_index]).name, "netmap") == 0) {
 #ifdef HAVE_NETMAP
                 if (suri->run_mode == RUNMODE_UNKNOWN) {
@@ -2244,12 +2284,18 @@ void PreRunInit(const int runmode)
     SCProfilingInit();
 #endif
     DefragInit();
+    UtilNumaInit();
+    ArenaGlobalInit();
     FlowInitConfig(FLOW_QUIET);
     IPPairInitConfig(FLOW_QUIET);
     StreamTcpInitConfig(STREAM_VERBOSE);
     AppLayerParserPostStreamSetup();
     AppLayerRegisterGlobalCounters();
     OutputFilestoreRegisterGlobalCounters();
+#ifdef BUILD_HYPERSCAN
+    MpmHSRegisterGlobalCounters();
+#endif
+    UtilNumaRegisterGlobalCounters();
 }
 
 /* tasks we need to run before packets start flowing,
@@ -273,6 +273,214 @@ static int DetectEngineContentInspectionTest13(void) {
     TEST_FOOTER;
 }
 
+/** \internal
+ *  \brief inspect buffers with and without the compiled content chains
+ *         of a rule and compare the results
+ */
+static int ContentProgCompare(const char *sig, const char *bufs[], const int nbufs)
+{
+    TEST_HEADER;
+    DetectEngineCtx *de_ctx = DetectEngineCtxInit();
+    FAIL_IF_NULL(de_ctx);
+    de_ctx->flags |= DE_QUIET;
+    DetectEngineThreadCtx *det_ctx = NULL;
+    char rule[2048];
+    snprintf(rule, sizeof(rule), "alert tcp any any -> any any (%s sid:1; rev:1;)", sig);
+    Signature *s = DetectEngineAppendSig(de_ctx, rule);
+    FAIL_IF_NULL(s);
+    SigGroupBuild(de_ctx);
+    DetectEngineThreadCtxInit(&tv, (void *)de_ctx, (void *)&det_ctx);
+    FAIL_IF_NULL(det_ctx);
+
+    const SigMatchData *smd = s->sm_arrays[DETECT_SM_LIST_PMATCH];
+    FAIL_IF_NULL(smd);
+    struct DetectEngineContentProg_ *progs[CONTENT_PROG_MAX_OPS];
+    int cnt = 1;
+    while (!smd[cnt - 1].is_last)
+        cnt++;
+    FAIL_IF(cnt > CONTENT_PROG_MAX_OPS);
+    /* only contents followed by nothing but contents have a program */
+    bool all_content = true;
+    for (int i = cnt - 1; i >= 0; i--) {
+        all_content = all_content && smd[i].type == DETECT_CONTENT;
+        progs[i] = NULL;
+        if (smd[i].type == DETECT_CONTENT)
+            progs[i] = ((DetectContentData *)smd[i].ctx)->prog;
+        FAIL_IF((progs[i] != NULL) != all_content);
+    }
+
+    for (int b = 0; b < nbufs; b++) {
+        uint8_t r[2];
+        uint32_t steps[2], offset[2], discontinue[2];
+        for (int run = 0; run < 2; run++) {
+            /* second run uses the interpreter */
+            for (int i = 0; i < cnt; i++) {
+                if (smd[i].type == DETECT_CONTENT)
+                    ((DetectContentData *)smd[i].ctx)->prog = run == 0 ? progs[i] : NULL;
+            }
+            det_ctx->buffer_offset = 0;
+            det_ctx->inspection_recursion_counter = 0;
+            det_ctx->discontinue_matching = 0;
+            r[run] = DetectEngineContentInspection(de_ctx, det_ctx, s, smd, NULL, &f,
+                    (uint8_t *)bufs[b], (uint32_t)strlen(bufs[b]), 0, DETECT_CI_FLAGS_SINGLE,
+                    DETECT_ENGINE_CONTENT_INSPECTION_MODE_PAYLOAD);
+            steps[run] = det_ctx->inspection_recursion_counter;
+            offset[run] = det_ctx->buffer_offset;
+            discontinue[run] = det_ctx->discontinue_matching;
+        }
+        for (int i = 0; i < cnt; i++) {
+            if (smd[i].type == DETECT_CONTENT)
+                ((DetectContentData *)smd[i].ctx)->prog = progs[i];
+        }
+        FAIL_IF_NOT(r[0] == r[1]);
+        FAIL_IF_NOT(steps[0] == steps[1]);
+        FAIL_IF_NOT(offset[0] == offset[1]);
+        FAIL_IF_NOT(discontinue[0] == discontinue[1]);
+    }
+
+    DetectEngineThreadCtxDeinit(&tv, det_ctx);
+    DetectEngineCtxFree(de_ctx);
+    PASS;
+}
+
+/** \test compiled content chains against the interpreter */
+static int DetectEngineContentInspectionTest14(void)
+{
+    const char *bufs[] = {
+        "",
+        "ababc",
+        "GET /x HTTP/1.1\r\n",
+        "aaxxyzab",
+        "abcdeabcde",
+        "zzab",
+        "xAbcdEx",
+        "abababababababcd",
+        "ba",
+        "ab",
+    };
+    const int n = (int)(sizeof(bufs) / sizeof(bufs[0]));
+
+    FAIL_IF_NOT(ContentProgCompare("content:\"a\"; content:\"b\"; distance:0; within:1; "
+                                   "content:\"c\"; distance:0; within:1;",
+            bufs, n));
+    FAIL_IF_NOT(ContentProgCompare("content:\"ab\"; content:!\"cd\"; distance:0; within:4;", bufs, n));
+    FAIL_IF_NOT(ContentProgCompare("content:\"GET\"; startswith; content:\"HTTP\"; distance:1; "
+                                   "within:64; content:\"|0d 0a|\"; distance:0;",
+            bufs, n));
+    FAIL_IF_NOT(ContentProgCompare("content:\"x\"; offset:2; depth:6; content:\"yz\"; within:3;", bufs, n));
+    FAIL_IF_NOT(ContentProgCompare("content:\"ab\"; endswith;", bufs, n));
+    FAIL_IF_NOT(ContentProgCompare("content:!\"zz\"; content:\"ab\";", bufs, n));
+    FAIL_IF_NOT(ContentProgCompare("content:\"Ab\"; nocase; content:\"CDE\"; nocase; distance:0;", bufs, n));
+    FAIL_IF_NOT(ContentProgCompare("content:\"abcde\"; content:\"e\"; distance:-2; within:3;", bufs, n));
+    FAIL_IF_NOT(ContentProgCompare("content:\"ab\"; content:\"ab\"; distance:0; within:2; "
+                                   "content:\"cd\"; distance:0; within:2;",
+            bufs, n));
+    /* keywords other than content after a content */
+    FAIL_IF_NOT(ContentProgCompare("content:\"a\"; pcre:\"/b/R\";", bufs, n));
+    FAIL_IF_NOT(ContentProgCompare("content:\"a\"; content:\"b\"; distance:0; pcre:\"/c/R\"; "
+                                   "content:\"d\"; distance:0;",
+            bufs, n));
+    FAIL_IF_NOT(ContentProgCompare("content:\"ab\"; isdataat:2,relative;", bufs, n));
+    FAIL_IF_NOT(ContentProgCompare("content:\"ab\"; isdataat:!1,relative;", bufs, n));
+    FAIL_IF_NOT(ContentProgCompare("content:\"a\"; byte_test:1,=,0x62,0,relative;", bufs, n));
+    FAIL_IF_NOT(ContentProgCompare(
+            "content:\"a\"; byte_test:1,=,0x62,0,relative; content:\"c\"; distance:1;", bufs, n));
+    PASS;
+}
+
+/** \test fast pattern offsets from the mpm */
+static int DetectEngineContentInspectionTest15(void)
+{
+    TEST_HEADER;
+    DetectEngineCtx *de_ctx = DetectEngineCtxInit();
+    FAIL_IF_NULL(de_ctx);
+    de_ctx->flags |= DE_QUIET;
+    DetectEngineThreadCtx *det_ctx = NULL;
+    Signature *s = DetectEngineAppendSig(de_ctx,
+            "alert tcp any any -> any any (content:\"abc\"; content:\"de\"; distance:0; sid:1;)");
+    FAIL_IF_NULL(s);
+    SigGroupBuild(de_ctx);
+    DetectEngineThreadCtxInit(&tv, (void *)de_ctx, (void *)&det_ctx);
+    FAIL_IF_NULL(det_ctx);
+    if (det_ctx->pmq.pat_offsets == NULL) {
+        FAIL_IF(PmqSetupPatternOffsets(&det_ctx->pmq, de_ctx->max_fp_id) != 0);
+    }
+
+    const SigMatchData *smd = s->sm_arrays[DETECT_SM_LIST_PMATCH];
+    FAIL_IF_NULL(smd);
+    DetectContentData *cd = (DetectContentData *)smd->ctx;
+    FAIL_IF_NOT(cd->flags & DETECT_CONTENT_MPM);
+    struct DetectEngineContentProg_ *prog = cd->prog;
+    FAIL_IF_NULL(prog);
+
+    uint8_t buf[] = "xxabcdeabc";
+    uint8_t copy[] = "xxabcdeabc";
+    const uint32_t buflen = sizeof(buf) - 1;
+
+    for (int run = 0; run < 2; run++) {
+        /* second run uses the interpreter */
+        cd->prog = run == 0 ? prog : NULL;
+
+        /* no offsets */
+        det_ctx->buffer_offset = 0;
+        det_ctx->inspection_recursion_counter = 0;
+        det_ctx->discontinue_matching = 0;
+        FAIL_IF_NOT(DetectEngineContentInspection(de_ctx, det_ctx, s, smd, NULL, &f, buf, buflen,
+                            0, DETECT_CI_FLAGS_SINGLE,
+                            DETECT_ENGINE_CONTENT_INSPECTION_MODE_PAYLOAD) == 1);
+        FAIL_IF_NOT(det_ctx->buffer_offset == 7);
+
+        /* offset of the second "abc" is used as is, so "de" can't match */
+        PrefilterTrackStart(&det_ctx->pmq, buf, buflen);
+        PrefilterTrackOffset(&det_ctx->pmq, cd->id, 10);
+        PrefilterTrackEnd(&det_ctx->pmq);
+        det_ctx->buffer_offset = 0;
+        det_ctx->inspection_recursion_counter = 0;
+        det_ctx->discontinue_matching = 0;
+        FAIL_IF_NOT(DetectEngineContentInspection(de_ctx, det_ctx, s, smd, NULL, &f, buf, buflen,
+                            0, DETECT_CI_FLAGS_SINGLE,
+                            DETECT_ENGINE_CONTENT_INSPECTION_MODE_PAYLOAD) == 0);
+
+        /* offsets of another buffer are not used */
+        det_ctx->buffer_offset = 0;
+        det_ctx->inspection_recursion_counter = 0;
+        det_ctx->discontinue_matching = 0;
+        FAIL_IF_NOT(DetectEngineContentInspection(de_ctx, det_ctx, s, smd, NULL, &f, copy, buflen,
+                            0, DETECT_CI_FLAGS_SINGLE,
+                            DETECT_ENGINE_CONTENT_INSPECTION_MODE_PAYLOAD) == 1);
+
+        /* real offset */
+        PrefilterTrackStart(&det_ctx->pmq, buf, buflen);
+        PrefilterTrackOffset(&det_ctx->pmq, cd->id, 10);
+        PrefilterTrackOffset(&det_ctx->pmq, cd->id, 5);
+        PrefilterTrackEnd(&det_ctx->pmq);
+        det_ctx->buffer_offset = 0;
+        det_ctx->inspection_recursion_counter = 0;
+        det_ctx->discontinue_matching = 0;
+        FAIL_IF_NOT(DetectEngineContentInspection(de_ctx, det_ctx, s, smd, NULL, &f, buf, buflen,
+                            0, DETECT_CI_FLAGS_SINGLE,
+                            DETECT_ENGINE_CONTENT_INSPECTION_MODE_PAYLOAD) == 1);
+        FAIL_IF_NOT(det_ctx->buffer_offset == 7);
+
+        /* after a reset the buffer is searched again */
+        PrefilterTrackStart(&det_ctx->pmq, buf, buflen);
+        PrefilterTrackOffset(&det_ctx->pmq, cd->id, 10);
+        PrefilterTrackEnd(&det_ctx->pmq);
+        PrefilterTrackReset(&det_ctx->pmq);
+        det_ctx->buffer_offset = 0;
+        det_ctx->inspection_recursion_counter = 0;
+        det_ctx->discontinue_matching = 0;
+        FAIL_IF_NOT(DetectEngineContentInspection(de_ctx, det_ctx, s, smd, NULL, &f, buf, buflen,
+                            0, DETECT_CI_FLAGS_SINGLE,
+                            DETECT_ENGINE_CONTENT_INSPECTION_MODE_PAYLOAD) == 1);
+    }
+    cd->prog = prog;
+
+    DetectEngineThreadCtxDeinit(&tv, det_ctx);
+    DetectEngineCtxFree(de_ctx);
+    PASS;
+}
+
 void DetectEngineContentInspectionRegisterTests(void)
 {
     UtRegisterTest("DetectEngineContentInspectionTest01",
@@ -301,6 +509,10 @@ void DetectEngineContentInspectionRegisterTests(void)
                    DetectEngineContentInspectionTest12);
     UtRegisterTest("DetectEngineContentInspectionTest13 mix startswith/endswith",
                    DetectEngineContentInspectionTest13);
+    UtRegisterTest("DetectEngineContentInspectionTest14 compiled chains",
+            DetectEngineContentInspectionTest14);
+    UtRegisterTest("DetectEngineContentInspectionTest15 mpm offsets",
+            DetectEngineContentInspectionTest15);
 }
 
 #undef TEST_HEADER
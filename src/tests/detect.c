@@ -5039,6 +5039,133 @@ end:
     return result;
 }
 
+static int SigTestSigIntIdCompare(const void *a, const void *b)
+{
+    const SigIntId x = *(const SigIntId *)a;
+    const SigIntId y = *(const SigIntId *)b;
+    return (x > y) - (x < y);
+}
+
+/** \test the bitmap merge of the prefilter results gives the same
+ *        match array as the sort based merge */
+static int SigTestPrefilterMergeBitmap01(void)
+{
+    ThreadVars th_v;
+    DetectEngineThreadCtx *det_ctx = NULL;
+    memset(&th_v, 0, sizeof(th_v));
+
+    DetectEngineCtx *de_ctx = DetectEngineCtxInit();
+    FAIL_IF_NULL(de_ctx);
+    de_ctx->flags |= DE_QUIET;
+
+    for (int i = 0; i < 200; i++) {
+        char sig[128];
+        snprintf(sig, sizeof(sig),
+                "alert tcp any any -> any any (content:\"pattern%d\"; sid:%d;)", i, i + 1);
+        FAIL_IF_NULL(DetectEngineAppendSig(de_ctx, sig));
+    }
+    SigGroupBuild(de_ctx);
+    DetectEngineThreadCtxInit(&th_v, (void *)de_ctx, (void *)&det_ctx);
+    FAIL_IF_NULL(det_ctx);
+
+    const SigGroupHead *sgh = NULL;
+    for (uint32_t idx = 0; idx < de_ctx->sgh_array_cnt && sgh == NULL; idx++) {
+        sgh = de_ctx->sgh_array[idx];
+    }
+    FAIL_IF_NULL(sgh);
+    FAIL_IF_NOT(sgh->pf_bitmap_offset == 0);
+    FAIL_IF_NOT(sgh->pf_bitmap_words == 4);
+
+    /* unsorted with duplicates, 3 and 64 are on both lists */
+    SigIntId mpm[] = { 150, 3, 77, 3, 199, 64, 63, 150, 10, 42, 128, 127 };
+    SigIntId nonmpm[] = { 3, 5, 64, 120 };
+    const uint32_t mpm_cnt = sizeof(mpm) / sizeof(mpm[0]);
+    FAIL_IF_NOT(PrefilterUseBitmap(sgh, mpm_cnt));
+
+    SigIntId *non_pf_id_array = det_ctx->non_pf_id_array;
+    det_ctx->non_pf_id_array = nonmpm;
+    det_ctx->non_pf_id_cnt = sizeof(nonmpm) / sizeof(nonmpm[0]);
+
+    PrefilterAddSids(&det_ctx->pmq, mpm, mpm_cnt);
+    DetectPrefilterMergeBitmap(de_ctx, det_ctx, sgh);
+    Signature *bitmap_array[16];
+    const SigIntId bitmap_cnt = det_ctx->match_array_cnt;
+    FAIL_IF_NOT(bitmap_cnt == 10);
+    memcpy(bitmap_array, det_ctx->match_array, bitmap_cnt * sizeof(Signature *));
+    for (uint32_t w = 0; w < sgh->pf_bitmap_words; w++) {
+        FAIL_IF_NOT(det_ctx->pf_bitmap[w] == 0);
+    }
+
+    PrefilterAddSids(&det_ctx->pmq, mpm, mpm_cnt);
+    qsort(det_ctx->pmq.rule_id_array, mpm_cnt, sizeof(SigIntId), SigTestSigIntIdCompare);
+    DetectPrefilterMergeSort(de_ctx, det_ctx);
+    FAIL_IF_NOT(det_ctx->match_array_cnt == bitmap_cnt);
+    FAIL_IF_NOT(memcmp(bitmap_array, det_ctx->match_array, bitmap_cnt * sizeof(Signature *)) == 0);
+
+    det_ctx->non_pf_id_array = non_pf_id_array;
+    DetectEngineThreadCtxDeinit(&th_v, (void *)det_ctx);
+    DetectEngineCtxFree(de_ctx);
+    PASS;
+}
+
+/** \test bitmap merge with the mpm context shared by all rule groups: the
+ *        mpm also finds the patterns of rules in other groups */
+static int SigTestPrefilterMergeBitmap02(void)
+{
+    ThreadVars th_v;
+    DetectEngineThreadCtx *det_ctx = NULL;
+    memset(&th_v, 0, sizeof(th_v));
+
+    DetectEngineCtx *de_ctx = DetectEngineCtxInit();
+    FAIL_IF_NULL(de_ctx);
+    de_ctx->flags |= DE_QUIET;
+    /* unittests default to a context per group */
+    de_ctx->sgh_mpm_ctx_cnf = ENGINE_SGH_MPM_FACTORY_CONTEXT_SINGLE;
+
+    /* port 80 rules get the lowest ids, outside of the port 81 group words */
+    char sig[128];
+    for (int i = 0; i < 100; i++) {
+        snprintf(sig, sizeof(sig),
+                "alert tcp any any -> any 80 (content:\"a%02d\"; sid:%d;)", i, i + 1);
+        FAIL_IF_NULL(DetectEngineAppendSig(de_ctx, sig));
+    }
+    for (int i = 0; i < 100; i++) {
+        snprintf(sig, sizeof(sig),
+                "alert tcp any any -> any 81 (content:\"b%02d\"; sid:%d;)", i, i + 101);
+        FAIL_IF_NULL(DetectEngineAppendSig(de_ctx, sig));
+    }
+    FAIL_IF_NULL(DetectEngineAppendSig(
+            de_ctx, "alert tcp any any -> any 81 (content:!\"xyz\"; sid:300;)"));
+    SigGroupBuild(de_ctx);
+    DetectEngineThreadCtxInit(&th_v, (void *)de_ctx, (void *)&det_ctx);
+    FAIL_IF_NULL(det_ctx);
+
+    /* patterns of 10 port 80 rules and 4 port 81 rules */
+    uint8_t buf[] = "a00 a01 a02 a03 a04 a05 a06 a07 a08 a09 a90 a99 b10 b11 b12 b13";
+    const uint32_t words = (de_ctx->sig_array_len + 63) / 64;
+    for (int run = 0; run < 2; run++) {
+        Packet *p = UTHBuildPacketReal(
+                buf, sizeof(buf) - 1, IPPROTO_TCP, "1.2.3.4", "5.6.7.8", 1024, 81);
+        FAIL_IF_NULL(p);
+        SigMatchSignatures(&th_v, de_ctx, det_ctx, p);
+        for (uint32_t sid = 1; sid <= 100; sid++) {
+            FAIL_IF(PacketAlertCheck(p, sid));
+        }
+        for (uint32_t sid = 101; sid <= 200; sid++) {
+            FAIL_IF(PacketAlertCheck(p, sid) != (sid >= 111 && sid <= 114));
+        }
+        FAIL_IF_NOT(PacketAlertCheck(p, 300));
+        for (uint32_t w = 0; w < words; w++) {
+            FAIL_IF_NOT(det_ctx->pf_bitmap[w] == 0);
+        }
+        UTHFreePacket(p);
+    }
+
+    DetectEngineThreadCtxDeinit(&th_v, (void *)det_ctx);
+    DetectEngineCtxFree(de_ctx);
+    PASS;
+}
+
 void SigRegisterTests(void)
 {
     SigParseRegisterTests();
@@ -5144,6 +5271,8 @@ void SigRegisterTests(void)
 
     UtRegisterTest("SigTestPorts01", SigTestPorts01);
     UtRegisterTest("SigTestBug01", SigTestBug01);
+    UtRegisterTest("SigTestPrefilterMergeBitmap01", SigTestPrefilterMergeBitmap01);
+    UtRegisterTest("SigTestPrefilterMergeBitmap02", SigTestPrefilterMergeBitmap02);
 
     DetectEngineContentInspectionRegisterTests();
 }
@@ -707,6 +707,68 @@ static int StreamTcpReassembleTest32(void)
     OVERLAP_END;
 }
 
+/** \test in order appends mixed with out of order inserts keep the tree
+ *        ordered and the cached rightmost segment in sync */
+static int StreamTcpListAppendTest01(void)
+{
+    OVERLAP_START(0, OS_POLICY_BSD);
+    OVERLAP_STEP(1, "AAAAAAAAAA", 10, "AAAAAAAAAA", 10);
+    OVERLAP_STEP(11, "BBBBBBBBBB", 10, "AAAAAAAAAABBBBBBBBBB", 20);
+    FAIL_IF_NOT(stream->seg_tree_last == RB_MAX(TCPSEG, &stream->seg_tree));
+    OVERLAP_STEP(31, "DDDDDDDDDD", 10, "AAAAAAAAAABBBBBBBBBB\0\0\0\0\0\0\0\0\0\0DDDDDDDDDD", 40);
+    FAIL_IF_NOT(stream->seg_tree_last == RB_MAX(TCPSEG, &stream->seg_tree));
+    OVERLAP_STEP(21, "CCCCCCCCCC", 10, "AAAAAAAAAABBBBBBBBBBCCCCCCCCCCDDDDDDDDDD", 40);
+    FAIL_IF_NOT(stream->seg_tree_last == RB_MAX(TCPSEG, &stream->seg_tree));
+    OVERLAP_STEP(41, "EEEEEEEEEE", 10, "AAAAAAAAAABBBBBBBBBBCCCCCCCCCCDDDDDDDDDDEEEEEEEEEE", 50);
+    FAIL_IF_NOT(stream->seg_tree_last == RB_MAX(TCPSEG, &stream->seg_tree));
+    FAIL_IF_NOT(stream->segs_right_edge == stream->isn + 51);
+
+    uint32_t next_seq = stream->isn + 1;
+    TcpSegment *seg;
+    RB_FOREACH (seg, TCPSEG, &stream->seg_tree) {
+        FAIL_IF_NOT(seg->seq == next_seq);
+        next_seq += TCP_SEG_LEN(seg);
+    }
+    FAIL_IF_NOT(next_seq == stream->isn + 51);
+    OVERLAP_END;
+}
+
+/** \test lazy reassembly: in order data goes into the buffer w/o segments,
+ *        retransmissions keep the first data, a gap falls back to segments */
+static int StreamTcpListLazyTest01(void)
+{
+    OVERLAP_START(0, OS_POLICY_LAST);
+    stream_config.lazy_reassembly = true;
+    stream->flags |= STREAMTCP_STREAM_FLAG_DISABLE_RAW;
+
+    /* proto detection not done yet: segment */
+    OVERLAP_STEP(1, "AAAAAAAAAA", 10, "AAAAAAAAAA", 10);
+    FAIL_IF(RB_EMPTY(&stream->seg_tree));
+    StreamTcpSetStreamFlagAppProtoDetectionCompleted(stream);
+    /* tree needs to drain first */
+    OVERLAP_STEP(11, "BBBBBBBBBB", 10, "AAAAAAAAAABBBBBBBBBB", 20);
+    StreamTcpReturnStreamSegments(stream);
+
+    OVERLAP_STEP(21, "CCCCCCCCCC", 10, "AAAAAAAAAABBBBBBBBBBCCCCCCCCCC", 30);
+    FAIL_IF_NOT(RB_EMPTY(&stream->seg_tree));
+    FAIL_IF_NOT(stream->segs_right_edge == stream->isn + 31);
+    /* retransmission with different data, first wins */
+    OVERLAP_STEP(21, "cccccccccc", 10, "AAAAAAAAAABBBBBBBBBBCCCCCCCCCC", 30);
+    /* partly new */
+    OVERLAP_STEP(26, "ccccceeeee", 10, "AAAAAAAAAABBBBBBBBBBCCCCCCCCCCeeeee", 35);
+    FAIL_IF_NOT(RB_EMPTY(&stream->seg_tree));
+    FAIL_IF_NOT(stream->segs_right_edge == stream->isn + 36);
+
+    /* gap: segment */
+    OVERLAP_STEP(41, "GGGGG", 5, "AAAAAAAAAABBBBBBBBBBCCCCCCCCCCeeeee\0\0\0\0\0GGGGG", 45);
+    FAIL_IF(RB_EMPTY(&stream->seg_tree));
+    OVERLAP_STEP(36, "FFFFF", 5, "AAAAAAAAAABBBBBBBBBBCCCCCCCCCCeeeeeFFFFFGGGGG", 45);
+    FAIL_IF_NOT(stream->segs_right_edge == stream->isn + 46);
+
+    stream_config.lazy_reassembly = false;
+    OVERLAP_END;
+}
+
 void StreamTcpListRegisterTests(void)
 {
     UtRegisterTest("StreamTcpReassembleTest01 -- BSD policy",
@@ -728,5 +790,7 @@ void StreamTcpListRegisterTests(void)
             StreamTcpReassembleTest31);
     UtRegisterTest("StreamTcpReassembleTest32",
             StreamTcpReassembleTest32);
+    UtRegisterTest("StreamTcpListAppendTest01", StreamTcpListAppendTest01);
+    UtRegisterTest("StreamTcpListLazyTest01", StreamTcpListLazyTest01);
 
 }
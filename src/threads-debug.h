@@ -137,6 +137,7 @@
 #define SCCondT pthread_cond_t
 #define SCCondInit pthread_cond_init
 #define SCCondSignal pthread_cond_signal
+#define SCCondBroadcast pthread_cond_broadcast
 #define SCCondDestroy pthread_cond_destroy
 #define SCCondWait SCCondWait_dbg
 
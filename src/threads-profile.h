@@ -99,6 +99,7 @@ extern thread_local uint64_t mutex_lock_cnt;
 #define SCCondT pthread_cond_t
 #define SCCondInit pthread_cond_init
 #define SCCondSignal pthread_cond_signal
+#define SCCondBroadcast pthread_cond_broadcast
 #define SCCondDestroy pthread_cond_destroy
 #define SCCondWait(cond, mut) pthread_cond_wait(cond, mut)
 
@@ -235,6 +235,8 @@ const char * TmModuleTmmIdToString(TmmId id)
         CASE_CODE (TMM_ALERTPCAPINFO);
         CASE_CODE (TMM_DECODEAFP);
         CASE_CODE(TMM_DECODEAFXDP);
+        CASE_CODE(TMM_RECEIVELIPC);
+        CASE_CODE(TMM_DECODELIPC);
         CASE_CODE (TMM_STATSLOGGER);
         CASE_CODE (TMM_FLOWMANAGER);
         CASE_CODE (TMM_FLOWRECYCLER);
@@ -55,6 +55,8 @@ typedef enum {
     TMM_RECEIVEAFXDP,
     TMM_DECODEAFP,
     TMM_DECODEAFXDP,
+    TMM_RECEIVELIPC,
+    TMM_DECODELIPC,
     TMM_RECEIVEDPDK,
     TMM_DECODEDPDK,
     TMM_RECEIVENETMAP,
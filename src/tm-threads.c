@@ -35,10 +35,13 @@
 #include "tm-threads.h"
 #include "tmqh-packetpool.h"
 #include "threads.h"
+#include "flow-worker.h"
 #include "util-affinity.h"
 #include "util-debug.h"
 #include "util-privs.h"
 #include "util-cpu.h"
+#include "util-numa.h"
+#include "util-arena.h"
 #include "util-optimize.h"
 #include "util-profiling.h"
 #include "util-signal.h"
@@ -151,6 +154,85 @@ TmEcode TmThreadsSlotVarRun(ThreadVars *tv, Packet *p, TmSlot *slot)
     return TM_ECODE_OK;
 }
 
+/** \internal
+ *
+ *  \brief Run a batch of packets through the slots starting at slot
+ *
+ *  Each slot is run over the whole batch before moving on to the next one,
+ *  so the code of a stage stays hot in the caches. When a packet creates
+ *  pseudo packets, the packets before it complete the pipeline first, so
+ *  flows see packets in the same order as with TmThreadsSlotVarRun.
+ */
+static TmEcode TmThreadsSlotVarRunBatch(
+        ThreadVars *tv, TmSlot *slot, Packet **pkts, const uint32_t cnt)
+{
+    if (cnt == 0)
+        return TM_ECODE_OK;
+
+    for (TmSlot *s = slot; s != NULL; s = s->slot_next) {
+        void *slot_data = SC_ATOMIC_GET(s->slot_data);
+        if (s == tv->tm_flowworker) {
+            FlowWorkerPrefetch(slot_data, pkts, cnt);
+        }
+
+        for (uint32_t i = 0; i < cnt; i++) {
+            Packet *p = pkts[i];
+            PACKET_PROFILING_TMM_START(p, s->tm_id);
+            TmEcode r = s->SlotFunc(tv, p, slot_data);
+            PACKET_PROFILING_TMM_END(p, s->tm_id);
+            DEBUG_VALIDATE_BUG_ON(p->flow != NULL);
+
+            if (unlikely(r == TM_ECODE_FAILED)) {
+                TmThreadsSlotProcessPktFail(tv, s, NULL);
+                return TM_ECODE_FAILED;
+            }
+
+            if (unlikely(tv->decode_pq.top != NULL)) {
+                if (TmThreadsSlotVarRunBatch(tv, s->slot_next, pkts, i) != TM_ECODE_OK ||
+                        TmThreadsProcessDecodePseudoPackets(tv, &tv->decode_pq, s->slot_next) !=
+                                TM_ECODE_OK ||
+                        TmThreadsSlotVarRunBatch(tv, s->slot_next, &pkts[i], 1) != TM_ECODE_OK) {
+                    return TM_ECODE_FAILED;
+                }
+                return TmThreadsSlotVarRunBatch(tv, s, &pkts[i + 1], cnt - i - 1);
+            }
+        }
+    }
+
+    return TM_ECODE_OK;
+}
+
+/**
+ *  \brief Process a batch of packets and queue them.
+ *
+ *  Batched version of TmThreadsSlotProcessPkt for capture methods that read
+ *  packets in bursts. Before the batch enters the flow worker the flow hash
+ *  buckets of all its packets are prefetched.
+ *
+ *  \param cnt number of packets, at most TM_PKT_BATCH_SIZE
+ *
+ *  \retval TM_ECODE_FAILED on failure, all packets are returned to the pool
+ */
+TmEcode TmThreadsSlotProcessPktBatch(ThreadVars *tv, TmSlot *s, Packet **pkts, uint32_t cnt)
+{
+    DEBUG_VALIDATE_BUG_ON(cnt > TM_PKT_BATCH_SIZE);
+
+    if (s != NULL && TmThreadsSlotVarRunBatch(tv, s, pkts, cnt) != TM_ECODE_OK) {
+        for (uint32_t i = 0; i < cnt; i++) {
+            TmqhOutputPacketpool(tv, pkts[i]);
+        }
+        return TM_ECODE_FAILED;
+    }
+
+    for (uint32_t i = 0; i < cnt; i++) {
+        tv->tmqh_out(tv, pkts[i]);
+    }
+
+    TmThreadsHandleInjectedPackets(tv);
+
+    return TM_ECODE_OK;
+}
+
 /** \internal
  *
  *  \brief Process flow timeout packets
@@ -351,6 +433,7 @@ static void *TmThreadsSlotPktAcqLoop(void *td)
             }
         }
     }
+    ArenaThreadCacheFlush();
 
     tv->stream_pq = NULL;
     SCLogDebug("%s ending", tv->name);
@@ -372,13 +455,14 @@ static void *TmThreadsSlotVar(void *td)
     char run = 1;
     TmEcode r = TM_ECODE_OK;
 
-    PacketPoolInit();//Empty();
-
     SCSetThreadName(tv->name);
 
     if (tv->thread_setup_flags != 0)
         TmThreadSetupOptions(tv);
 
+    /* after pinning, so the packets are on the thread's NUMA node */
+    PacketPoolInit();
+
     /* Drop the capabilities for this thread */
     SCDropCaps(tv);
 
@@ -505,6 +589,7 @@ static void *TmThreadsSlotVar(void *td)
             }
         }
     }
+    ArenaThreadCacheFlush();
 
     SCLogDebug("%s ending", tv->name);
     tv->stream_pq = NULL;
@@ -849,6 +934,7 @@ TmEcode TmThreadSetupOptions(ThreadVars *tv)
                   "%"PRIu16", thread id %lu", tv->name, tv->cpu_affinity,
                   SCGetThreadIdLong());
         SetCPUAffinity(tv->cpu_affinity);
+        UtilNumaThreadSetup();
     }
 
 #if !defined __CYGWIN__ && !defined OS_WIN32 && !defined __OpenBSD__ && !defined sun
@@ -859,6 +945,7 @@ TmEcode TmThreadSetupOptions(ThreadVars *tv)
         if (taf->mode_flag == EXCLUSIVE_AFFINITY) {
             uint16_t cpu = AffinityGetNextCPU(taf);
             SetCPUAffinity(cpu);
+            UtilNumaThreadSetup();
             /* If CPU is in a set overwrite the default thread prio */
             if (CPU_ISSET(cpu, &taf->lowprio_cpu)) {
                 tv->thread_priority = PRIO_LOW;
@@ -882,6 +969,7 @@ TmEcode TmThreadSetupOptions(ThreadVars *tv)
         TmThreadSetPrio(tv);
     }
 #endif
+    tv->numa_node = UtilNumaThreadGetPinnedNode();
 
     return TM_ECODE_OK;
 }
@@ -919,6 +1007,7 @@ ThreadVars *TmThreadCreate(const char *name, const char *inq_name, const char *i
 
     SC_ATOMIC_INIT(tv->flags);
     SCMutexInit(&tv->perf_public_ctx.m, NULL);
+    tv->numa_node = -1;
 
     strlcpy(tv->name, name, sizeof(tv->name));
 
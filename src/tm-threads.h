@@ -48,6 +48,9 @@ static inline void SleepUsec(uint64_t usec)
 #define TM_QUEUE_NAME_MAX 16
 #define TM_THREAD_NAME_MAX 16
 
+/** max packets a capture method passes to TmThreadsSlotProcessPktBatch */
+#define TM_PKT_BATCH_SIZE 32
+
 typedef TmEcode (*TmSlotFunc)(ThreadVars *, Packet *, void *);
 
 typedef struct TmSlot_ {
@@ -116,6 +119,7 @@ void TmThreadsUnsetFlag(ThreadVars *, uint32_t);
 void TmThreadWaitForFlag(ThreadVars *, uint32_t);
 
 TmEcode TmThreadsSlotVarRun (ThreadVars *tv, Packet *p, TmSlot *slot);
+TmEcode TmThreadsSlotProcessPktBatch(ThreadVars *tv, TmSlot *s, Packet **pkts, uint32_t cnt);
 
 void TmThreadDisablePacketThreads(void);
 void TmThreadDisableReceiveThreads(void);
@@ -33,6 +33,7 @@
 #include "packet.h"
 #include "util-profiling.h"
 #include "util-validate.h"
+#include "util-numa.h"
 #include "action-globals.h"
 
 /* Number of freed packet to save for one pool before freeing them. */
@@ -308,6 +309,9 @@ void PacketPoolInit(void)
         }
         PacketPoolStorePacket(p);
     }
+    my_pool->numa_node = UtilNumaThreadNode();
+    my_pool->numa_memuse = (uint64_t)max_pending_packets * SIZE_OF_PACKET;
+    UtilNumaMemoryAdd(my_pool->numa_node, my_pool->numa_memuse);
 
     //SCLogInfo("preallocated %"PRIiMAX" packets. Total memory %"PRIuMAX"",
     //        max_pending_packets, (uintmax_t)(max_pending_packets*SIZE_OF_PACKET));
@@ -341,6 +345,10 @@ void PacketPoolDestroy(void)
     while ((p = PacketPoolGetPacket()) != NULL) {
         PacketFree(p);
     }
+    if (my_pool) {
+        UtilNumaMemorySub(my_pool->numa_node, my_pool->numa_memuse);
+        my_pool->numa_memuse = 0;
+    }
 
 #ifdef DEBUG_VALIDATION
     my_pool->initialized = 0;
@@ -51,6 +51,10 @@ typedef struct PktPool_ {
     Packet *pending_tail;
     uint32_t pending_count;
 
+    /* NUMA node and size of the preallocated packets, for the counters */
+    uint16_t numa_node;
+    uint64_t numa_memuse;
+
 #ifdef DEBUG_VALIDATION
     int initialized;
     int destroyed;
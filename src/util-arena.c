@@ -0,0 +1,505 @@
+/* Copyright (C) 2026 Open Information Security Foundation
+ *
+ * You can copy, redistribute or modify this Program under the terms of
+ * the GNU General Public License version 2 as published by the Free
+ * Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/**
+ * \file
+ *
+ * Arena allocator for fixed size objects backed by huge pages.
+ *
+ * Objects are carved from ARENA_CHUNK_SIZE chunks, mapped from hugetlbfs
+ * when pages are reserved (vm.nr_hugepages) and advised as transparent huge
+ * pages otherwise. Millions of flows, sessions and segments then need few
+ * TLB entries, and churn doesn't fragment the heap.
+ *
+ * Chunks are aligned to their size so the chunk header, and with it the NUMA
+ * node of an object, is found from the object address. Freed objects go to
+ * a per thread free list and are exchanged with the per node free list of the
+ * arena in batches. Chunks are only unmapped by ArenaDestroy, so object
+ * memory stays valid for the life of the arena.
+ *
+ * Callers keep doing their own memcap accounting per object.
+ */
+
+#include "suricata-common.h"
+#include "conf.h"
+#include "threads.h"
+#include "util-arena.h"
+#include "util-debug.h"
+#include "util-numa.h"
+#include "util-unittest.h"
+#include "util-validate.h"
+
+/** max arenas in use at the same time */
+#define ARENA_MAX 16
+/** objects moved between the thread and arena free lists at once */
+#define ARENA_CACHE_BATCH 64
+/** objects a thread keeps before returning a batch to the arena */
+#define ARENA_CACHE_MAX (ARENA_CACHE_BATCH * 4)
+/** object alignment */
+#define ARENA_ALIGN 16
+
+typedef struct ArenaFreeItem_ {
+    struct ArenaFreeItem_ *next;
+} ArenaFreeItem;
+
+/** header at the start of each chunk */
+typedef struct ArenaChunk_ {
+    struct Arena_ *arena;
+    struct ArenaChunk_ *next;
+    uint16_t node;
+    bool hugetlb;
+} ArenaChunk;
+
+#define ARENA_CHUNK_HDR_SIZE ((sizeof(ArenaChunk) + CLS - 1) & ~(CLS - 1))
+
+typedef struct ArenaNode_ {
+    ArenaChunk *chunks;
+    /** never used part of the newest chunk */
+    uint8_t *carve;
+    uint8_t *carve_end;
+    ArenaFreeItem *free;
+    uint32_t free_cnt;
+} ArenaNode;
+
+struct Arena_ {
+    char name[32];
+    uint16_t id;
+    /** generation, tells thread caches of a destroyed arena apart */
+    uint32_t gen;
+    uint32_t elt_size;
+    /** try hugetlbfs pages for new chunks */
+    bool hugetlb;
+
+    SCMutex m;
+    ArenaNode nodes[UTIL_NUMA_MAX_NODES];
+    uint32_t chunk_cnt;
+    uint32_t hugetlb_chunk_cnt;
+};
+
+typedef struct ArenaThreadCache_ {
+    ArenaFreeItem *head;
+    uint32_t cnt;
+    uint32_t gen;
+    uint16_t node;
+} ArenaThreadCache;
+
+static bool arena_enabled = false;
+static bool arena_hugetlb = true;
+
+static Arena *arenas[ARENA_MAX];
+static uint32_t arena_gen = 0;
+static SCMutex arenas_m = SCMUTEX_INITIALIZER;
+
+static thread_local ArenaThreadCache arena_tcache[ARENA_MAX];
+
+void ArenaGlobalInit(void)
+{
+    int val = 0;
+    if (ConfGetBool("arena.enabled", &val) == 1) {
+        arena_enabled = val != 0;
+    }
+    if (ConfGetBool("arena.hugetlb", &val) == 1) {
+        arena_hugetlb = val != 0;
+    }
+#if defined(OS_WIN32) || !defined(HAVE_SYS_MMAN_H)
+    if (arena_enabled) {
+        SCLogWarning("arena: not supported on this platform");
+        arena_enabled = false;
+    }
+#endif
+    if (arena_enabled) {
+        SCLogConfig("arena: flows, tcp sessions and segments use %u KiB chunks%s",
+                ARENA_CHUNK_SIZE / 1024, arena_hugetlb ? ", hugetlbfs pages if reserved" : "");
+    }
+}
+
+/** \brief true if the arena.enabled option is set */
+bool ArenaEnabled(void)
+{
+    return arena_enabled;
+}
+
+/** \internal
+ *  \brief map a chunk aligned to ARENA_CHUNK_SIZE
+ */
+static void *ArenaMapChunk(Arena *a, bool *hugetlb)
+{
+#if !defined(OS_WIN32) && defined(HAVE_SYS_MMAN_H)
+#ifdef MAP_HUGETLB
+    if (a->hugetlb) {
+        void *mem = mmap(NULL, ARENA_CHUNK_SIZE, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (mem != MAP_FAILED) {
+            *hugetlb = true;
+            return mem;
+        }
+        SCLogPerf("arena %s: no hugetlbfs pages available, using transparent huge pages",
+                a->name);
+        a->hugetlb = false;
+    }
+#endif
+    /* map twice the size so the chunk can be aligned */
+    uint8_t *mem = mmap(NULL, 2 * ARENA_CHUNK_SIZE, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) {
+        return NULL;
+    }
+    uint8_t *aligned = (uint8_t *)(((uintptr_t)mem + ARENA_CHUNK_SIZE - 1) &
+                                   ~((uintptr_t)ARENA_CHUNK_SIZE - 1));
+    if (aligned > mem) {
+        munmap(mem, aligned - mem);
+    }
+    const size_t tail = (mem + 2 * ARENA_CHUNK_SIZE) - (aligned + ARENA_CHUNK_SIZE);
+    if (tail > 0) {
+        munmap(aligned + ARENA_CHUNK_SIZE, tail);
+    }
+#ifdef MADV_HUGEPAGE
+    (void)madvise(aligned, ARENA_CHUNK_SIZE, MADV_HUGEPAGE);
+#endif
+    *hugetlb = false;
+    return aligned;
+#else
+    return NULL;
+#endif
+}
+
+/** \internal
+ *  \brief add a chunk to a node, arena must be locked
+ */
+static bool ArenaNodeGrow(Arena *a, ArenaNode *n, const uint16_t node)
+{
+    bool hugetlb = false;
+    uint8_t *mem = ArenaMapChunk(a, &hugetlb);
+    if (mem == NULL) {
+        return false;
+    }
+    /* before the first touch, so the pages are faulted in on the node */
+    UtilNumaBindMemory(mem, ARENA_CHUNK_SIZE, node);
+
+    ArenaChunk *c = (ArenaChunk *)mem;
+    c->arena = a;
+    c->node = node;
+    c->hugetlb = hugetlb;
+    c->next = n->chunks;
+    n->chunks = c;
+    n->carve = mem + ARENA_CHUNK_HDR_SIZE;
+    n->carve_end = mem + ARENA_CHUNK_SIZE;
+
+    a->chunk_cnt++;
+    if (hugetlb)
+        a->hugetlb_chunk_cnt++;
+    return true;
+}
+
+/** \brief create an arena for objects of elt_size bytes
+ *  \retval a arena or NULL if all arena slots are in use
+ */
+Arena *ArenaCreate(const char *name, uint32_t elt_size)
+{
+    elt_size = MAX(elt_size, (uint32_t)sizeof(ArenaFreeItem));
+    elt_size = (elt_size + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+    if (elt_size > ARENA_CHUNK_SIZE - ARENA_CHUNK_HDR_SIZE) {
+        return NULL;
+    }
+
+    Arena *a = SCCalloc(1, sizeof(*a));
+    if (unlikely(a == NULL)) {
+        return NULL;
+    }
+    strlcpy(a->name, name, sizeof(a->name));
+    a->elt_size = elt_size;
+    a->hugetlb = arena_hugetlb;
+    SCMutexInit(&a->m, NULL);
+
+    SCMutexLock(&arenas_m);
+    uint16_t id = 0;
+    for (; id < ARENA_MAX; id++) {
+        if (arenas[id] == NULL)
+            break;
+    }
+    if (id == ARENA_MAX) {
+        SCMutexUnlock(&arenas_m);
+        SCLogWarning("arena %s: too many arenas", name);
+        SCMutexDestroy(&a->m);
+        SCFree(a);
+        return NULL;
+    }
+    a->id = id;
+    a->gen = ++arena_gen;
+    arenas[id] = a;
+    SCMutexUnlock(&arenas_m);
+
+    SCLogDebug("arena %s: id %u, object size %u", a->name, a->id, a->elt_size);
+    return a;
+}
+
+/** \brief unmap all memory of an arena
+ *
+ *  All objects must have been freed or be unused.
+ */
+void ArenaDestroy(Arena *a)
+{
+    if (a == NULL)
+        return;
+
+    SCMutexLock(&arenas_m);
+    arenas[a->id] = NULL;
+    SCMutexUnlock(&arenas_m);
+
+    SCLogPerf("arena %s: %u chunks, %u from hugetlbfs", a->name, a->chunk_cnt,
+            a->hugetlb_chunk_cnt);
+
+    for (int node = 0; node < UTIL_NUMA_MAX_NODES; node++) {
+        ArenaChunk *c = a->nodes[node].chunks;
+        while (c != NULL) {
+            ArenaChunk *next = c->next;
+#if !defined(OS_WIN32) && defined(HAVE_SYS_MMAN_H)
+            munmap(c, ARENA_CHUNK_SIZE);
+#endif
+            c = next;
+        }
+    }
+
+    /* the cache of the calling thread, the others are dropped on their
+     * next use through the generation check */
+    ArenaThreadCache *tc = &arena_tcache[a->id];
+    memset(tc, 0, sizeof(*tc));
+
+    SCMutexDestroy(&a->m);
+    SCFree(a);
+}
+
+/** \internal
+ *  \brief return all but keep objects of a thread cache to the arena
+ */
+static void ArenaCacheSpill(Arena *a, ArenaThreadCache *tc, const uint32_t keep)
+{
+    if (tc->cnt <= keep)
+        return;
+
+    ArenaFreeItem *head = tc->head;
+    ArenaFreeItem *tail = head;
+    uint32_t cnt = 1;
+    while (cnt < tc->cnt - keep) {
+        tail = tail->next;
+        cnt++;
+    }
+    tc->head = tail->next;
+    tc->cnt -= cnt;
+
+    ArenaNode *n = &a->nodes[tc->node];
+    SCMutexLock(&a->m);
+    tail->next = n->free;
+    n->free = head;
+    n->free_cnt += cnt;
+    SCMutexUnlock(&a->m);
+}
+
+/** \internal
+ *  \brief get a batch of objects from the arena into a thread cache
+ */
+static void ArenaCacheRefill(Arena *a, ArenaThreadCache *tc)
+{
+    ArenaNode *n = &a->nodes[tc->node];
+
+    SCMutexLock(&a->m);
+    while (tc->cnt < ARENA_CACHE_BATCH) {
+        ArenaFreeItem *it = n->free;
+        if (it != NULL) {
+            n->free = it->next;
+            n->free_cnt--;
+        } else {
+            if (n->carve == NULL || n->carve + a->elt_size > n->carve_end) {
+                if (!ArenaNodeGrow(a, n, tc->node))
+                    break;
+            }
+            it = (ArenaFreeItem *)n->carve;
+            n->carve += a->elt_size;
+        }
+        it->next = tc->head;
+        tc->head = it;
+        tc->cnt++;
+    }
+    SCMutexUnlock(&a->m);
+}
+
+/** \internal
+ *  \brief get the cache of the calling thread for an arena and node
+ *
+ *  Objects cached for another node are returned to the arena first.
+ */
+static inline ArenaThreadCache *ArenaGetThreadCache(Arena *a, const uint16_t node)
+{
+    ArenaThreadCache *tc = &arena_tcache[a->id];
+    if (unlikely(tc->gen != a->gen)) {
+        memset(tc, 0, sizeof(*tc));
+        tc->gen = a->gen;
+        tc->node = node;
+    } else if (unlikely(tc->node != node)) {
+        ArenaCacheSpill(a, tc, 0);
+        tc->node = node;
+    }
+    return tc;
+}
+
+/** \brief allocate an object
+ *
+ *  The object is placed on the NUMA node of the calling thread. Its memory
+ *  is not cleared.
+ *
+ *  \retval ptr object or NULL if no chunk could be mapped
+ */
+void *ArenaAlloc(Arena *a)
+{
+    ArenaThreadCache *tc = ArenaGetThreadCache(a, UtilNumaNodeIndex(UtilNumaThreadNode()));
+    if (tc->head == NULL) {
+        ArenaCacheRefill(a, tc);
+        if (tc->head == NULL)
+            return NULL;
+    }
+
+    ArenaFreeItem *it = tc->head;
+    tc->head = it->next;
+    tc->cnt--;
+    return it;
+}
+
+/** \brief free an object allocated by ArenaAlloc */
+void ArenaFree(Arena *a, void *ptr)
+{
+    if (ptr == NULL)
+        return;
+
+    const ArenaChunk *c = (const ArenaChunk *)((uintptr_t)ptr & ~((uintptr_t)ARENA_CHUNK_SIZE - 1));
+    DEBUG_VALIDATE_BUG_ON(c->arena != a);
+
+    ArenaFreeItem *it = ptr;
+    ArenaThreadCache *tc = &arena_tcache[a->id];
+    if (tc->gen != a->gen) {
+        tc = ArenaGetThreadCache(a, c->node);
+    }
+    if (tc->node == c->node) {
+        it->next = tc->head;
+        tc->head = it;
+        tc->cnt++;
+        if (tc->cnt >= ARENA_CACHE_MAX) {
+            ArenaCacheSpill(a, tc, ARENA_CACHE_MAX - ARENA_CACHE_BATCH);
+        }
+        return;
+    }
+
+    /* object of another node, straight back to the arena */
+    ArenaNode *n = &a->nodes[c->node];
+    SCMutexLock(&a->m);
+    it->next = n->free;
+    n->free = it;
+    n->free_cnt++;
+    SCMutexUnlock(&a->m);
+}
+
+/** \brief return the cached objects of the calling thread to their arenas
+ *
+ *  Called when a thread exits, so its cached objects can be reused.
+ */
+void ArenaThreadCacheFlush(void)
+{
+    SCMutexLock(&arenas_m);
+    for (uint16_t id = 0; id < ARENA_MAX; id++) {
+        Arena *a = arenas[id];
+        ArenaThreadCache *tc = &arena_tcache[id];
+        if (a != NULL && tc->gen == a->gen) {
+            ArenaCacheSpill(a, tc, 0);
+        }
+        memset(tc, 0, sizeof(*tc));
+    }
+    SCMutexUnlock(&arenas_m);
+}
+
+#ifdef UNITTESTS
+/** \test objects are unique, aligned and reused after free */
+static int ArenaTest01(void)
+{
+    Arena *a = ArenaCreate("test", 100);
+    FAIL_IF_NULL(a);
+    FAIL_IF(a->elt_size != 112);
+
+    /* more than fits in one chunk */
+    const uint32_t cnt = 50000;
+    uint8_t **objs = SCCalloc(cnt, sizeof(uint8_t *));
+    FAIL_IF_NULL(objs);
+    for (uint32_t i = 0; i < cnt; i++) {
+        objs[i] = ArenaAlloc(a);
+        FAIL_IF_NULL(objs[i]);
+        FAIL_IF((uintptr_t)objs[i] % ARENA_ALIGN != 0);
+        memset(objs[i], 0xff, 100);
+    }
+    FAIL_IF(a->chunk_cnt < 3);
+    /* the memset didn't clobber another object or a chunk header */
+    for (uint32_t i = 0; i < cnt; i++) {
+        const ArenaChunk *c =
+                (const ArenaChunk *)((uintptr_t)objs[i] & ~((uintptr_t)ARENA_CHUNK_SIZE - 1));
+        FAIL_IF(c->arena != a);
+    }
+
+    for (uint32_t i = 0; i < cnt; i++) {
+        ArenaFree(a, objs[i]);
+    }
+    const uint32_t chunks = a->chunk_cnt;
+    for (uint32_t i = 0; i < cnt; i++) {
+        objs[i] = ArenaAlloc(a);
+        FAIL_IF_NULL(objs[i]);
+    }
+    FAIL_IF(a->chunk_cnt != chunks);
+
+    for (uint32_t i = 0; i < cnt; i++) {
+        ArenaFree(a, objs[i]);
+    }
+    ArenaThreadCacheFlush();
+    SCFree(objs);
+    ArenaDestroy(a);
+    PASS;
+}
+
+/** \test a recreated arena doesn't hand out objects of the old one */
+static int ArenaTest02(void)
+{
+    Arena *a = ArenaCreate("test", 64);
+    FAIL_IF_NULL(a);
+    void *p = ArenaAlloc(a);
+    FAIL_IF_NULL(p);
+    ArenaFree(a, p);
+    ArenaDestroy(a);
+
+    a = ArenaCreate("test", 64);
+    FAIL_IF_NULL(a);
+    FAIL_IF(arena_tcache[a->id].head != NULL && arena_tcache[a->id].gen == a->gen);
+    p = ArenaAlloc(a);
+    FAIL_IF_NULL(p);
+    FAIL_IF(a->chunk_cnt != 1);
+    ArenaFree(a, p);
+    ArenaDestroy(a);
+    PASS;
+}
+#endif /* UNITTESTS */
+
+void ArenaRegisterTests(void)
+{
+#ifdef UNITTESTS
+    UtRegisterTest("ArenaTest01", ArenaTest01);
+    UtRegisterTest("ArenaTest02", ArenaTest02);
+#endif /* UNITTESTS */
+}
@@ -0,0 +1,45 @@
+/* Copyright (C) 2026 Open Information Security Foundation
+ *
+ * You can copy, redistribute or modify this Program under the terms of
+ * the GNU General Public License version 2 as published by the Free
+ * Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/**
+ * \file
+ *
+ * Arena allocator for fixed size objects backed by huge pages.
+ */
+
+#ifndef __UTIL_ARENA_H__
+#define __UTIL_ARENA_H__
+
+/** size and alignment of the chunks objects are carved from */
+#define ARENA_CHUNK_SIZE (2 * 1024 * 1024)
+
+typedef struct Arena_ Arena;
+
+void ArenaGlobalInit(void);
+bool ArenaEnabled(void);
+
+Arena *ArenaCreate(const char *name, uint32_t elt_size);
+void ArenaDestroy(Arena *a);
+
+void *ArenaAlloc(Arena *a);
+void ArenaFree(Arena *a, void *ptr);
+
+void ArenaThreadCacheFlush(void);
+
+void ArenaRegisterTests(void);
+
+#endif /* __UTIL_ARENA_H__ */
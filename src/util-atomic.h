@@ -161,6 +161,15 @@
 #define SC_ATOMIC_SET(name, val)    \
     atomic_store(&(name ## _sc_atomic__), (val))
 
+#define SC_ATOMIC_STORE_EXPLICIT(name, val, order) \
+    atomic_store_explicit(&(name ## _sc_atomic__), (val), (order))
+
+/**
+ *  \brief Memory fence of the given order, for ordering non-atomic accesses
+ *         around atomic ones, e.g. in a seqlock.
+ */
+#define SC_ATOMIC_THREAD_FENCE(order) atomic_thread_fence((order))
+
 #else
 
 #define SC_ATOMIC_MEMORY_ORDER_RELAXED
@@ -389,6 +398,11 @@
         ;                                                       \
         })
 
+#define SC_ATOMIC_STORE_EXPLICIT(name, val, order) \
+    SC_ATOMIC_SET(name, val)
+
+#define SC_ATOMIC_THREAD_FENCE(order) __sync_synchronize()
+
 #endif /* no c11 atomics */
 
 void SCAtomicRegisterTests(void);
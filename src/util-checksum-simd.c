@@ -0,0 +1,270 @@
+/* Copyright (C) 2026 Open Information Security Foundation
+ *
+ * You can copy, redistribute or modify this Program under the terms of
+ * the GNU General Public License version 2 as published by the Free
+ * Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/**
+ * \file
+ *
+ * One's complement sum of packet data for checksum validation.
+ *
+ * Implementations: AVX2 and SSE2 on x86-64, selected at runtime, NEON on
+ * AArch64 and a plain C one elsewhere. All return a sum below
+ * 2^62, so callers can add the pseudo header words before folding.
+ */
+
+#include "suricata-common.h"
+#include "util-checksum-simd.h"
+#include "util-debug.h"
+#include "util-unittest.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define CHECKSUM_SIMD_X86 1
+#include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define CHECKSUM_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+/** \internal
+ *  \brief sum 32 bit words into independent 64 bit accumulators */
+static uint64_t ChecksumSumWords(const uint8_t *data, uint32_t len)
+{
+    uint64_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    uint32_t w[8];
+
+    while (len >= sizeof(w)) {
+        memcpy(w, data, sizeof(w));
+        s0 += (uint64_t)w[0] + w[4];
+        s1 += (uint64_t)w[1] + w[5];
+        s2 += (uint64_t)w[2] + w[6];
+        s3 += (uint64_t)w[3] + w[7];
+        data += sizeof(w);
+        len -= sizeof(w);
+    }
+    return s0 + s1 + s2 + s3 + ChecksumSumScalar(data, len);
+}
+
+ChecksumSumFunc ChecksumSumLong = ChecksumSumWords;
+static const char *checksum_impl = "scalar";
+
+#ifdef CHECKSUM_SIMD_X86
+/* zero extend the 32 bit lanes into 64 bit accumulators, which can't
+ * overflow for any uint32_t length */
+static uint64_t ChecksumSumSSE2(const uint8_t *data, uint32_t len)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i acc0 = zero, acc1 = zero;
+
+    while (len >= 32) {
+        const __m128i a = _mm_loadu_si128((const __m128i *)data);
+        const __m128i b = _mm_loadu_si128((const __m128i *)(data + 16));
+        acc0 = _mm_add_epi64(acc0, _mm_unpacklo_epi32(a, zero));
+        acc1 = _mm_add_epi64(acc1, _mm_unpackhi_epi32(a, zero));
+        acc0 = _mm_add_epi64(acc0, _mm_unpacklo_epi32(b, zero));
+        acc1 = _mm_add_epi64(acc1, _mm_unpackhi_epi32(b, zero));
+        data += 32;
+        len -= 32;
+    }
+    acc0 = _mm_add_epi64(acc0, acc1);
+
+    uint64_t lanes[2];
+    _mm_storeu_si128((__m128i *)lanes, acc0);
+    return lanes[0] + lanes[1] + ChecksumSumScalar(data, len);
+}
+
+__attribute__((target("avx2"))) static uint64_t ChecksumSumAVX2(
+        const uint8_t *data, uint32_t len)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i acc0 = zero, acc1 = zero;
+
+    while (len >= 64) {
+        const __m256i a = _mm256_loadu_si256((const __m256i *)data);
+        const __m256i b = _mm256_loadu_si256((const __m256i *)(data + 32));
+        acc0 = _mm256_add_epi64(acc0, _mm256_unpacklo_epi32(a, zero));
+        acc1 = _mm256_add_epi64(acc1, _mm256_unpackhi_epi32(a, zero));
+        acc0 = _mm256_add_epi64(acc0, _mm256_unpacklo_epi32(b, zero));
+        acc1 = _mm256_add_epi64(acc1, _mm256_unpackhi_epi32(b, zero));
+        data += 64;
+        len -= 64;
+    }
+    if (len >= 32) {
+        const __m256i a = _mm256_loadu_si256((const __m256i *)data);
+        acc0 = _mm256_add_epi64(acc0, _mm256_unpacklo_epi32(a, zero));
+        acc1 = _mm256_add_epi64(acc1, _mm256_unpackhi_epi32(a, zero));
+        data += 32;
+        len -= 32;
+    }
+    acc0 = _mm256_add_epi64(acc0, acc1);
+
+    uint64_t lanes[4];
+    _mm256_storeu_si256((__m256i *)lanes, acc0);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + ChecksumSumScalar(data, len);
+}
+#endif /* CHECKSUM_SIMD_X86 */
+
+#ifdef CHECKSUM_SIMD_NEON
+static uint64_t ChecksumSumNEON(const uint8_t *data, uint32_t len)
+{
+    uint64x2_t acc0 = vdupq_n_u64(0);
+    uint64x2_t acc1 = vdupq_n_u64(0);
+
+    while (len >= 32) {
+        acc0 = vpadalq_u32(acc0, vreinterpretq_u32_u8(vld1q_u8(data)));
+        acc1 = vpadalq_u32(acc1, vreinterpretq_u32_u8(vld1q_u8(data + 16)));
+        data += 32;
+        len -= 32;
+    }
+    acc0 = vaddq_u64(acc0, acc1);
+    return vgetq_lane_u64(acc0, 0) + vgetq_lane_u64(acc0, 1) + ChecksumSumScalar(data, len);
+}
+#endif /* CHECKSUM_SIMD_NEON */
+
+void ChecksumSimdSetup(void)
+{
+    ChecksumSumLong = ChecksumSumWords;
+    checksum_impl = "scalar";
+#if defined(CHECKSUM_SIMD_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        ChecksumSumLong = ChecksumSumAVX2;
+        checksum_impl = "avx2";
+    } else {
+        ChecksumSumLong = ChecksumSumSSE2;
+        checksum_impl = "sse2";
+    }
+#elif defined(CHECKSUM_SIMD_NEON)
+    ChecksumSumLong = ChecksumSumNEON;
+    checksum_impl = "neon";
+#endif
+    SCLogDebug("checksum sum: %s", checksum_impl);
+}
+
+const char *ChecksumSimdImpl(void)
+{
+    return checksum_impl;
+}
+
+/*************************************Unittests********************************/
+
+#ifdef UNITTESTS
+/** \internal
+ *  \brief reference sum, 16 bits at a time */
+static uint16_t ChecksumSumRef(const uint8_t *data, uint32_t len)
+{
+    uint32_t sum = 0;
+    while (len > 1) {
+        uint16_t w;
+        memcpy(&w, data, sizeof(w));
+        sum += w;
+        sum = (sum >> 16) + (sum & 0xffff);
+        data += 2;
+        len -= 2;
+    }
+    if (len == 1) {
+        uint16_t w = 0;
+        memcpy(&w, data, 1);
+        sum += w;
+        sum = (sum >> 16) + (sum & 0xffff);
+    }
+    return (uint16_t)sum;
+}
+
+typedef struct ChecksumSimdImplEntry_ {
+    const char *name;
+    ChecksumSumFunc Sum;
+    bool available;
+} ChecksumSimdImplEntry;
+
+static uint32_t ChecksumSimdTestImpls(ChecksumSimdImplEntry *impls)
+{
+    uint32_t n = 0;
+    impls[n++] = (ChecksumSimdImplEntry){ "scalar", ChecksumSumWords, true };
+#if defined(CHECKSUM_SIMD_X86)
+    __builtin_cpu_init();
+    impls[n++] = (ChecksumSimdImplEntry){ "sse2", ChecksumSumSSE2, true };
+    impls[n++] = (ChecksumSimdImplEntry){ "avx2", ChecksumSumAVX2,
+        __builtin_cpu_supports("avx2") != 0 };
+#elif defined(CHECKSUM_SIMD_NEON)
+    impls[n++] = (ChecksumSimdImplEntry){ "neon", ChecksumSumNEON, true };
+#endif
+    return n;
+}
+
+/** \test all implementations against the reference, all lengths and
+ *        alignments up to a jumbo frame */
+static int ChecksumSimdTest01(void)
+{
+    ChecksumSimdImplEntry impls[4];
+    const uint32_t n = ChecksumSimdTestImpls(impls);
+
+    const uint32_t size = 9216 + 8;
+    uint8_t *buf = SCMalloc(size);
+    FAIL_IF_NULL(buf);
+    uint32_t x = 0x12345678;
+    for (uint32_t i = 0; i < size; i++) {
+        x = x * 1103515245 + 12345;
+        buf[i] = (uint8_t)(x >> 16);
+    }
+
+    for (uint32_t i = 0; i < n; i++) {
+        if (!impls[i].available)
+            continue;
+        for (uint32_t len = 0; len <= 9216; len += (len < 512) ? 1 : 61) {
+            for (uint32_t off = 0; off < 8; off++) {
+                const uint16_t ref = ChecksumSumRef(buf + off, len);
+                const uint16_t sum = ChecksumFold(impls[i].Sum(buf + off, len));
+                if (ref != sum) {
+                    printf("%s: len %u off %u: %04x != %04x: ", impls[i].name, len, off, sum,
+                            ref);
+                    SCFree(buf);
+                    FAIL;
+                }
+                FAIL_IF(ChecksumFold(ChecksumSum(buf + off, len)) != ref);
+            }
+        }
+    }
+    SCFree(buf);
+    PASS;
+}
+
+/** \test carries with all bits set */
+static int ChecksumSimdTest02(void)
+{
+    ChecksumSimdImplEntry impls[4];
+    const uint32_t n = ChecksumSimdTestImpls(impls);
+
+    uint8_t buf[1501];
+    memset(buf, 0xff, sizeof(buf));
+
+    for (uint32_t i = 0; i < n; i++) {
+        if (!impls[i].available)
+            continue;
+        for (uint32_t len = 1; len <= sizeof(buf); len++) {
+            FAIL_IF(ChecksumFold(impls[i].Sum(buf, len)) != ChecksumSumRef(buf, len));
+        }
+    }
+    PASS;
+}
+#endif /* UNITTESTS */
+
+void ChecksumSimdRegisterTests(void)
+{
+#ifdef UNITTESTS
+    UtRegisterTest("ChecksumSimdTest01", ChecksumSimdTest01);
+    UtRegisterTest("ChecksumSimdTest02", ChecksumSimdTest02);
+#endif /* UNITTESTS */
+}
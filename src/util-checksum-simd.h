@@ -0,0 +1,103 @@
+/* Copyright (C) 2026 Open Information Security Foundation
+ *
+ * You can copy, redistribute or modify this Program under the terms of
+ * the GNU General Public License version 2 as published by the Free
+ * Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/**
+ * \file
+ *
+ * One's complement sum used by the IP, TCP, UDP and ICMP checksums.
+ *
+ * The sum is kept in 64 bits and folded only at the end. Summing the data
+ * as 32 or 64 bit words gives the same result after folding as summing
+ * 16 bit words, as 2^16 == 1 modulo 0xffff.
+ */
+
+#ifndef __UTIL_CHECKSUM_SIMD_H__
+#define __UTIL_CHECKSUM_SIMD_H__
+
+/** buffers shorter than this are summed inline */
+#define CHECKSUM_SIMD_MIN_LEN 128
+
+typedef uint64_t (*ChecksumSumFunc)(const uint8_t *data, uint32_t len);
+
+/** sum for longer buffers, set up by ChecksumSimdSetup() */
+extern ChecksumSumFunc ChecksumSumLong;
+
+/**
+ * \brief one's complement partial sum of a buffer
+ *
+ * An odd trailing byte is summed as if padded with a zero byte.
+ *
+ * \retval sum unfolded partial sum, fold with ChecksumFold()
+ */
+static inline uint64_t ChecksumSumScalar(const uint8_t *data, uint32_t len)
+{
+    uint64_t sum = 0;
+
+    while (len >= 16) {
+        uint32_t w[4];
+        memcpy(w, data, sizeof(w));
+        sum += (uint64_t)w[0] + w[1] + w[2] + w[3];
+        data += 16;
+        len -= 16;
+    }
+    while (len >= 4) {
+        uint32_t w;
+        memcpy(&w, data, sizeof(w));
+        sum += w;
+        data += 4;
+        len -= 4;
+    }
+    if (len >= 2) {
+        uint16_t w;
+        memcpy(&w, data, sizeof(w));
+        sum += w;
+        data += 2;
+        len -= 2;
+    }
+    if (len == 1) {
+        uint16_t w = 0;
+        memcpy(&w, data, 1);
+        sum += w;
+    }
+    return sum;
+}
+
+static inline uint64_t ChecksumSum(const uint8_t *data, uint32_t len)
+{
+    if (len >= CHECKSUM_SIMD_MIN_LEN)
+        return ChecksumSumLong(data, len);
+    return ChecksumSumScalar(data, len);
+}
+
+/**
+ * \brief fold a partial sum to 16 bits
+ *
+ * Doesn't return 0 for a non-zero sum, like the end-around carry.
+ */
+static inline uint16_t ChecksumFold(uint64_t sum)
+{
+    sum = (sum >> 32) + (sum & 0xffffffff);
+    while (sum >> 16)
+        sum = (sum >> 16) + (sum & 0xffff);
+    return (uint16_t)sum;
+}
+
+void ChecksumSimdSetup(void);
+const char *ChecksumSimdImpl(void);
+void ChecksumSimdRegisterTests(void);
+
+#endif /* __UTIL_CHECKSUM_SIMD_H__ */
@@ -42,6 +42,7 @@ int LiveGetOffload(void);
 #ifdef HAVE_DPDK
 typedef struct {
     struct rte_mempool *pkt_mp;
+    bool mbuf_packets; /**< pkt_mp mbufs hold a Packet in their private area */
 } DPDKDeviceResources;
 #endif /* HAVE_DPDK */
 
@@ -22,8 +22,10 @@
  */
 
 #include "suricata.h"
+#include "packet.h"
 #include "util-dpdk.h"
 #include "util-debug.h"
+#include "util-validate.h"
 
 void DPDKCleanupEAL(void)
 {
@@ -53,6 +55,8 @@ void DPDKCloseDevice(LiveDevice *ldev)
         rte_eth_dev_close(port_id);
 
         SCLogInfo("%s: releasing packet mempool", ldev->dev);
+        if (ldev->dpdk_vars.mbuf_packets)
+            DPDKMbufPacketsDestroy(ldev->dpdk_vars.pkt_mp);
         rte_mempool_free(ldev->dpdk_vars.pkt_mp);
     }
 #endif
@@ -76,4 +80,49 @@ const char *DPDKGetPortNameByPortID(uint16_t pid)
     return dev_name;
 }
 
+/**
+ * Size of the mbuf private area needed to hold a Packet
+ * @return size, 0 if a Packet doesn't fit in the private area
+ */
+uint16_t DPDKMbufPacketPrivSize(void)
+{
+    const size_t size = RTE_ALIGN(sizeof(Packet), RTE_MBUF_PRIV_ALIGN);
+    if (size > UINT16_MAX)
+        return 0;
+    return (uint16_t)size;
+}
+
+static void MbufPacketInit(struct rte_mempool *mp, void *opaque, void *obj, unsigned int idx)
+{
+    Packet *p = DPDK_MBUF_PACKET((struct rte_mbuf *)obj);
+    memset(p, 0, sizeof(*p));
+    PacketInit(p);
+}
+
+static void MbufPacketDestroy(struct rte_mempool *mp, void *opaque, void *obj, unsigned int idx)
+{
+    PacketDestructor(DPDK_MBUF_PACKET((struct rte_mbuf *)obj));
+}
+
+/**
+ * Initializes the Packets in the private area of all mbufs of a pool. The
+ * private area is not touched by DPDK after the pool is created, so the
+ * Packets stay initialized while their mbufs go through the NIC and back.
+ * @param mp pool created with DPDKMbufPacketPrivSize() as private size
+ */
+void DPDKMbufPacketsInit(struct rte_mempool *mp)
+{
+    DEBUG_VALIDATE_BUG_ON(rte_pktmbuf_priv_size(mp) < sizeof(Packet));
+    rte_mempool_obj_iter(mp, MbufPacketInit, NULL);
+}
+
+/**
+ * Cleans up the Packets of a pool set up with DPDKMbufPacketsInit(), all
+ * mbufs need to be back in the pool.
+ */
+void DPDKMbufPacketsDestroy(struct rte_mempool *mp)
+{
+    rte_mempool_obj_iter(mp, MbufPacketDestroy, NULL);
+}
+
 #endif /* HAVE_DPDK */
@@ -123,6 +123,14 @@ void DPDKCloseDevice(LiveDevice *ldev);
 
 #ifdef HAVE_DPDK
 const char *DPDKGetPortNameByPortID(uint16_t pid);
+
+/** Packet stored in the private area of a mbuf from a pool set up with
+ *  DPDKMbufPacketsInit() */
+#define DPDK_MBUF_PACKET(m) ((Packet *)rte_mbuf_to_priv(m))
+
+uint16_t DPDKMbufPacketPrivSize(void);
+void DPDKMbufPacketsInit(struct rte_mempool *mp);
+void DPDKMbufPacketsDestroy(struct rte_mempool *mp);
 #endif /* HAVE_DPDK */
 
 #endif /* UTIL_DPDK_H */
@@ -0,0 +1,672 @@
+/* Copyright (C) 2026 Open Information Security Foundation
+ *
+ * You can copy, redistribute or modify this Program under the terms of
+ * the GNU General Public License version 2 as published by the Free
+ * Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/**
+ * \file
+ *
+ * Aho-Corasick with a SIMD prefix filter, "ac-simd".
+ *
+ * Uses the state tables of the "ac" matcher, but only walks them around
+ * positions where a pattern may start. Those are found with a filter on the
+ * first 1 to 3 bytes of the patterns, in the style of the Teddy matcher of
+ * Hyperscan: patterns are spread over 8 buckets and, for each prefix byte,
+ * two 16 entry tables map the low and high nibble of an input byte to the
+ * buckets that have a pattern with such a byte there. A pshufb (tbl on ARM)
+ * looks up 16 to 64 input bytes at once; positions where a bucket survives
+ * all prefix bytes are candidates.
+ *
+ * From a candidate the AC walk starts in the root state and runs for at
+ * least the length of the longest pattern, extended while further
+ * candidates show up. Every occurrence starts at a candidate, so the matches
+ * and the match count are the same as for "ac".
+ *
+ * The filter is skipped for pattern sets it doesn't thin out, e.g. when
+ * there are single byte patterns or the prefixes cover most byte values.
+ *
+ * Filter implementations: AVX-512BW, AVX2 and SSSE3 on x86-64, selected at
+ * runtime, NEON on AArch64 and a table based one elsewhere.
+ */
+
+#include "suricata-common.h"
+#include "suricata.h"
+
+#include "util-debug.h"
+#include "util-unittest.h"
+#include "util-memcmp.h"
+#include "util-mpm-ac.h"
+#include "util-mpm-ac-simd.h"
+#include "util-validate.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define AC_SIMD_X86 1
+#include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define AC_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+/** positions checked per filter call */
+#define AC_SIMD_BLOCK 64
+
+/** skip the filter if it passes more than this share of random input */
+#define AC_SIMD_MAX_PASS_RATE 0.25
+
+typedef uint64_t (*SCACSimdFilterBlockFunc)(const SCACSimdFilter *, const uint8_t *);
+
+static SCACSimdFilterBlockFunc SCACSimdFilterBlock;
+static const char *ac_simd_impl = "scalar";
+
+/** \internal
+ *  \brief candidate mask for AC_SIMD_BLOCK positions, using the byte tables
+ *
+ *  Reads AC_SIMD_BLOCK + prefix_len - 1 bytes from buf.
+ */
+static uint64_t SCACSimdFilterBlockScalar(const SCACSimdFilter *f, const uint8_t *buf)
+{
+    uint64_t mask = 0;
+    for (uint32_t t = 0; t < AC_SIMD_BLOCK; t++) {
+        uint8_t m = f->tbl[0][buf[t]];
+        for (uint8_t j = 1; j < f->prefix_len; j++) {
+            m &= f->tbl[j][buf[t + j]];
+        }
+        if (m != 0)
+            mask |= 1ULL << t;
+    }
+    return mask;
+}
+
+#ifdef AC_SIMD_X86
+__attribute__((target("ssse3"))) static uint64_t SCACSimdFilterBlockSSSE3(
+        const SCACSimdFilter *f, const uint8_t *buf)
+{
+    const __m128i nibble = _mm_set1_epi8(0x0f);
+    uint64_t mask = 0;
+    for (uint32_t part = 0; part < AC_SIMD_BLOCK; part += 16) {
+        __m128i r = _mm_set1_epi8((char)0xff);
+        for (uint8_t j = 0; j < f->prefix_len; j++) {
+            const __m128i in = _mm_loadu_si128((const __m128i *)(buf + part + j));
+            const __m128i lo = _mm_shuffle_epi8(
+                    _mm_loadu_si128((const __m128i *)f->lo[j]), _mm_and_si128(in, nibble));
+            const __m128i hi = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)f->hi[j]),
+                    _mm_and_si128(_mm_srli_epi16(in, 4), nibble));
+            r = _mm_and_si128(r, _mm_and_si128(lo, hi));
+        }
+        const uint32_t zero = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(r, _mm_setzero_si128()));
+        mask |= (uint64_t)(~zero & 0xffff) << part;
+    }
+    return mask;
+}
+
+__attribute__((target("avx2"))) static uint64_t SCACSimdFilterBlockAVX2(
+        const SCACSimdFilter *f, const uint8_t *buf)
+{
+    const __m256i nibble = _mm256_set1_epi8(0x0f);
+    uint64_t mask = 0;
+    for (uint32_t part = 0; part < AC_SIMD_BLOCK; part += 32) {
+        __m256i r = _mm256_set1_epi8((char)0xff);
+        for (uint8_t j = 0; j < f->prefix_len; j++) {
+            const __m256i lo_tbl =
+                    _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)f->lo[j]));
+            const __m256i hi_tbl =
+                    _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)f->hi[j]));
+            const __m256i in = _mm256_loadu_si256((const __m256i *)(buf + part + j));
+            const __m256i lo = _mm256_shuffle_epi8(lo_tbl, _mm256_and_si256(in, nibble));
+            const __m256i hi =
+                    _mm256_shuffle_epi8(hi_tbl, _mm256_and_si256(_mm256_srli_epi16(in, 4), nibble));
+            r = _mm256_and_si256(r, _mm256_and_si256(lo, hi));
+        }
+        const uint32_t zero =
+                (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(r, _mm256_setzero_si256()));
+        mask |= (uint64_t)(~zero) << part;
+    }
+    return mask;
+}
+
+__attribute__((target("avx512f,avx512bw"))) static uint64_t SCACSimdFilterBlockAVX512(
+        const SCACSimdFilter *f, const uint8_t *buf)
+{
+    const __m512i nibble = _mm512_set1_epi8(0x0f);
+    __m512i r = _mm512_set1_epi8((char)0xff);
+    for (uint8_t j = 0; j < f->prefix_len; j++) {
+        const __m512i lo_tbl = _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i *)f->lo[j]));
+        const __m512i hi_tbl = _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i *)f->hi[j]));
+        const __m512i in = _mm512_loadu_si512((const void *)(buf + j));
+        const __m512i lo = _mm512_shuffle_epi8(lo_tbl, _mm512_and_si512(in, nibble));
+        const __m512i hi =
+                _mm512_shuffle_epi8(hi_tbl, _mm512_and_si512(_mm512_srli_epi16(in, 4), nibble));
+        r = _mm512_and_si512(r, _mm512_and_si512(lo, hi));
+    }
+    return (uint64_t)_mm512_test_epi8_mask(r, r);
+}
+#endif /* AC_SIMD_X86 */
+
+#ifdef AC_SIMD_NEON
+static uint64_t SCACSimdFilterBlockNEON(const SCACSimdFilter *f, const uint8_t *buf)
+{
+    static const uint8_t weights[16] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64,
+        128 };
+    const uint8x16_t w = vld1q_u8(weights);
+    const uint8x16_t nibble = vdupq_n_u8(0x0f);
+    uint64_t mask = 0;
+    for (uint32_t part = 0; part < AC_SIMD_BLOCK; part += 16) {
+        uint8x16_t r = vdupq_n_u8(0xff);
+        for (uint8_t j = 0; j < f->prefix_len; j++) {
+            const uint8x16_t in = vld1q_u8(buf + part + j);
+            const uint8x16_t lo = vqtbl1q_u8(vld1q_u8(f->lo[j]), vandq_u8(in, nibble));
+            const uint8x16_t hi = vqtbl1q_u8(vld1q_u8(f->hi[j]), vshrq_n_u8(in, 4));
+            r = vandq_u8(r, vandq_u8(lo, hi));
+        }
+        const uint8x16_t bits = vandq_u8(vtstq_u8(r, r), w);
+        const uint64_t m16 = (uint64_t)vaddv_u8(vget_low_u8(bits)) |
+                             ((uint64_t)vaddv_u8(vget_high_u8(bits)) << 8);
+        mask |= m16 << part;
+    }
+    return mask;
+}
+#endif /* AC_SIMD_NEON */
+
+/** \internal
+ *  \brief candidate mask for the positions from base to the buffer end
+ *
+ *  For the last block, which the vector loads would read past.
+ */
+static uint64_t SCACSimdFilterTail(
+        const SCACSimdFilter *f, const uint8_t *buf, const uint32_t buflen, const uint32_t base)
+{
+    uint64_t mask = 0;
+    for (uint32_t t = base; t < buflen && t - base < AC_SIMD_BLOCK; t++) {
+        /* too close to the end for the shortest pattern */
+        if (t + f->prefix_len > buflen)
+            break;
+        uint8_t m = f->tbl[0][buf[t]];
+        for (uint8_t j = 1; j < f->prefix_len; j++) {
+            m &= f->tbl[j][buf[t + j]];
+        }
+        if (m != 0)
+            mask |= 1ULL << (t - base);
+    }
+    return mask;
+}
+
+typedef struct SCACSimdCursor_ {
+    uint32_t base;
+    uint64_t mask;
+} SCACSimdCursor;
+
+/** \internal
+ *  \brief compute the candidate mask of the block starting at base */
+static inline void SCACSimdCursorLoad(const SCACSimdFilter *f, SCACSimdCursor *c,
+        const uint8_t *buf, const uint32_t buflen, const uint32_t base)
+{
+    c->base = base;
+    if (base + AC_SIMD_BLOCK + f->prefix_len - 1 <= buflen) {
+        c->mask = SCACSimdFilterBlock(f, buf + base);
+    } else {
+        c->mask = SCACSimdFilterTail(f, buf, buflen, base);
+    }
+}
+
+/** \internal
+ *  \brief next position at or after from where a pattern may start
+ *  \retval pos position or buflen if there is none
+ */
+static inline uint32_t SCACSimdNextCandidate(const SCACSimdFilter *f, SCACSimdCursor *c,
+        const uint8_t *buf, const uint32_t buflen, uint32_t from)
+{
+    while (from < buflen) {
+        if (from - c->base >= AC_SIMD_BLOCK) {
+            SCACSimdCursorLoad(f, c, buf, buflen, from & ~(AC_SIMD_BLOCK - 1));
+        }
+        const uint64_t m = c->mask >> (from - c->base);
+        if (m != 0)
+            return from + (uint32_t)__builtin_ctzll(m);
+        from = c->base + AC_SIMD_BLOCK;
+    }
+    return buflen;
+}
+
+/** \internal
+ *  \brief handle a match state, same checks as SCACSearch
+ */
+static inline uint32_t SCACSimdMatch(const SCACCtx *ctx, const uint32_t state, const uint32_t i,
+        const uint8_t *buf, uint8_t *bitarray, PrefilterRuleStore *pmq)
+{
+    const SCACOutputTable *out = &ctx->output_table[state];
+    uint32_t matches = 0;
+
+    for (uint32_t k = 0; k < out->no_of_entries; k++) {
+        const uint32_t pid = out->pids[k] & AC_PID_MASK;
+        const SCACPatternList *pat = &ctx->pid_pat_list[pid];
+        const int offset = i - pat->patlen + 1;
+
+        if (offset < (int)pat->offset || (pat->depth && i > pat->depth))
+            continue;
+        if ((out->pids[k] & AC_CASE_MASK) && SCMemcmp(pat->cs, buf + offset, pat->patlen) != 0)
+            continue;
+
+        if (!(bitarray[pid / 8] & (1 << (pid % 8)))) {
+            bitarray[pid / 8] |= (1 << (pid % 8));
+            PrefilterAddSids(pmq, pat->sids, pat->sids_size);
+        }
+        matches++;
+    }
+    return matches;
+}
+
+/** \internal
+ *  \brief walk the ac state table from each candidate
+ *
+ *  \param small use the 16 bit state table, constant so the walk is
+ *               specialized for both table types
+ */
+static inline __attribute__((always_inline)) uint32_t SCACSimdWalk(const SCACSimdCtx *sctx,
+        const uint16_t maxlen, PrefilterRuleStore *pmq, const uint8_t *buf, const uint32_t buflen,
+        uint8_t *bitarray, const bool small)
+{
+    const SCACCtx *ctx = &sctx->ac;
+    const SCACSimdFilter *f = &sctx->filter;
+    SCACSimdCursor cursor;
+    uint32_t matches = 0;
+    uint32_t state = 0;
+
+    SCACSimdCursorLoad(f, &cursor, buf, buflen, 0);
+
+    uint32_t i = SCACSimdNextCandidate(f, &cursor, buf, buflen, 0);
+    uint32_t next = i < buflen ? SCACSimdNextCandidate(f, &cursor, buf, buflen, i + 1) : buflen;
+    uint32_t end = MIN(buflen, i + maxlen);
+
+    while (i < buflen) {
+        for (; i < end; i++) {
+            if (small) {
+                state = ctx->state_table_u16[state & 0x7FFF][u8_tolower(buf[i])];
+                if (state & 0x8000)
+                    matches += SCACSimdMatch(ctx, state & 0x7FFF, i, buf, bitarray, pmq);
+            } else {
+                state = ctx->state_table_u32[state & 0x00FFFFFF][u8_tolower(buf[i])];
+                if (state & 0xFF000000)
+                    matches += SCACSimdMatch(ctx, state & 0x00FFFFFF, i, buf, bitarray, pmq);
+            }
+            /* a pattern may start inside the window, keep walking until it
+             * had its chance to complete */
+            if (next <= i) {
+                end = MIN(buflen, MAX(end, next + maxlen));
+                next = SCACSimdNextCandidate(f, &cursor, buf, buflen, next + 1);
+            }
+        }
+        if (next >= buflen)
+            break;
+        /* nothing in progress can complete, restart at the next candidate */
+        i = next;
+        state = 0;
+        end = MIN(buflen, i + maxlen);
+        next = SCACSimdNextCandidate(f, &cursor, buf, buflen, i + 1);
+    }
+    return matches;
+}
+
+/**
+ * \brief The ac-simd search function.
+ *
+ * \param mpm_ctx        Pointer to the mpm context.
+ * \param mpm_thread_ctx Pointer to the mpm thread context.
+ * \param pmq            Pointer to the Pattern Matcher Queue to hold
+ *                       search matches.
+ * \param buf            Buffer to be searched.
+ * \param buflen         Buffer length.
+ *
+ * \retval matches Match count.
+ */
+static uint32_t SCACSimdSearch(const MpmCtx *mpm_ctx, MpmThreadCtx *mpm_thread_ctx,
+        PrefilterRuleStore *pmq, const uint8_t *buf, uint32_t buflen)
+{
+    const SCACSimdCtx *sctx = (SCACSimdCtx *)mpm_ctx->ctx;
+
+    if (sctx->filter.prefix_len == 0) {
+        return SCACSearch(mpm_ctx, mpm_thread_ctx, pmq, buf, buflen);
+    }
+
+    uint8_t bitarray[sctx->ac.pattern_id_bitarray_size];
+    memset(bitarray, 0, sctx->ac.pattern_id_bitarray_size);
+
+    if (sctx->ac.state_count < 32767) {
+        return SCACSimdWalk(sctx, mpm_ctx->maxlen, pmq, buf, buflen, bitarray, true);
+    } else {
+        return SCACSimdWalk(sctx, mpm_ctx->maxlen, pmq, buf, buflen, bitarray, false);
+    }
+}
+
+/** \internal
+ *  \brief add both cases of a prefix byte to the nibble tables of a bucket */
+static void SCACSimdFilterAddByte(SCACSimdFilter *f, const uint8_t j, const uint8_t c,
+        const uint8_t bucket)
+{
+    const uint8_t variants[2] = { u8_tolower(c), (uint8_t)toupper(c) };
+    for (int v = 0; v < 2; v++) {
+        f->lo[j][variants[v] & 0x0f] |= (uint8_t)(1 << bucket);
+        f->hi[j][variants[v] >> 4] |= (uint8_t)(1 << bucket);
+    }
+}
+
+/** \internal
+ *  \brief set up the prefix filter from the patterns in the init hash
+ *
+ *  Must run before SCACPreparePatterns, which frees the patterns.
+ */
+static void SCACSimdFilterBuild(MpmCtx *mpm_ctx, SCACSimdFilter *f)
+{
+    memset(f, 0, sizeof(*f));
+
+    const uint8_t prefix_len = (uint8_t)MIN(mpm_ctx->minlen, AC_SIMD_MAX_PREFIX);
+    if (prefix_len < 2 || SCACSimdFilterBlock == NULL) {
+        SCLogDebug("%p: prefix filter not used, shortest pattern %u", mpm_ctx, mpm_ctx->minlen);
+        return;
+    }
+
+    for (uint32_t i = 0; i < MPM_INIT_HASH_SIZE; i++) {
+        for (const MpmPattern *p = mpm_ctx->init_hash[i]; p != NULL; p = p->next) {
+            /* same prefixes share a bucket so they don't set bits in others */
+            uint32_t hash = 0;
+            for (uint8_t j = 0; j < prefix_len; j++) {
+                hash = hash * 31 + p->ci[j];
+            }
+            const uint8_t bucket = (uint8_t)((hash ^ (hash >> 8)) % AC_SIMD_BUCKETS);
+            for (uint8_t j = 0; j < prefix_len; j++) {
+                SCACSimdFilterAddByte(f, j, p->ci[j], bucket);
+            }
+        }
+    }
+
+    for (uint8_t j = 0; j < prefix_len; j++) {
+        for (uint32_t c = 0; c < 256; c++) {
+            f->tbl[j][c] = f->lo[j][c & 0x0f] & f->hi[j][c >> 4];
+        }
+    }
+
+    /* share of random input positions passing the filter */
+    double pass = 0.0;
+    for (uint8_t b = 0; b < AC_SIMD_BUCKETS; b++) {
+        double bucket_pass = 1.0;
+        for (uint8_t j = 0; j < prefix_len; j++) {
+            uint32_t cnt = 0;
+            for (uint32_t c = 0; c < 256; c++) {
+                if (f->tbl[j][c] & (1 << b))
+                    cnt++;
+            }
+            bucket_pass *= (double)cnt / 256.0;
+        }
+        pass += bucket_pass;
+    }
+    if (pass > AC_SIMD_MAX_PASS_RATE) {
+        SCLogDebug("%p: prefix filter not used, pass rate %.2f", mpm_ctx, pass);
+        return;
+    }
+
+    f->prefix_len = prefix_len;
+    SCLogDebug("%p: prefix filter on %u bytes, pass rate %.4f", mpm_ctx, prefix_len, pass);
+}
+
+static int SCACSimdPreparePatterns(MpmCtx *mpm_ctx)
+{
+    SCACSimdCtx *sctx = (SCACSimdCtx *)mpm_ctx->ctx;
+
+    if (mpm_ctx->pattern_cnt != 0 && mpm_ctx->init_hash != NULL) {
+        SCACSimdFilterBuild(mpm_ctx, &sctx->filter);
+    }
+    return SCACPreparePatterns(mpm_ctx);
+}
+
+/**
+ * \brief Initialize the ac-simd context.
+ *
+ * \param mpm_ctx       Mpm context.
+ */
+static void SCACSimdInitCtx(MpmCtx *mpm_ctx)
+{
+    if (mpm_ctx->ctx != NULL)
+        return;
+
+    mpm_ctx->ctx = SCCalloc(1, sizeof(SCACSimdCtx));
+    if (mpm_ctx->ctx == NULL) {
+        exit(EXIT_FAILURE);
+    }
+    mpm_ctx->memory_cnt++;
+    mpm_ctx->memory_size += sizeof(SCACSimdCtx);
+
+    /* initialize the hash we use to speed up pattern insertions */
+    mpm_ctx->init_hash = SCCalloc(MPM_INIT_HASH_SIZE, sizeof(MpmPattern *));
+    if (mpm_ctx->init_hash == NULL) {
+        exit(EXIT_FAILURE);
+    }
+}
+
+static void SCACSimdDestroyCtx(MpmCtx *mpm_ctx)
+{
+    if (mpm_ctx->ctx == NULL)
+        return;
+
+    /* the ac destroy only accounts for its own part of the ctx */
+    mpm_ctx->memory_size -= sizeof(SCACSimdCtx) - sizeof(SCACCtx);
+    SCACDestroyCtx(mpm_ctx);
+    mpm_ctx->ctx = NULL;
+}
+
+static void SCACSimdPrintInfo(MpmCtx *mpm_ctx)
+{
+    const SCACSimdCtx *sctx = (SCACSimdCtx *)mpm_ctx->ctx;
+
+    SCACPrintInfo(mpm_ctx);
+    printf("Prefix filter:   %s, %u bytes\n", ac_simd_impl, sctx->filter.prefix_len);
+    printf("\n");
+}
+
+static void SCACSimdRegisterTests(void);
+
+/************************** Mpm Registration ***************************/
+
+/**
+ * \brief Register the ac-simd mpm.
+ */
+void MpmACSimdRegister(void)
+{
+    mpm_table[MPM_AC_SIMD].name = "ac-simd";
+    mpm_table[MPM_AC_SIMD].InitCtx = SCACSimdInitCtx;
+    mpm_table[MPM_AC_SIMD].InitThreadCtx = SCACInitThreadCtx;
+    mpm_table[MPM_AC_SIMD].DestroyCtx = SCACSimdDestroyCtx;
+    mpm_table[MPM_AC_SIMD].DestroyThreadCtx = SCACDestroyThreadCtx;
+    mpm_table[MPM_AC_SIMD].AddPattern = SCACAddPatternCS;
+    mpm_table[MPM_AC_SIMD].AddPatternNocase = SCACAddPatternCI;
+    mpm_table[MPM_AC_SIMD].Prepare = SCACSimdPreparePatterns;
+    mpm_table[MPM_AC_SIMD].Search = SCACSimdSearch;
+    mpm_table[MPM_AC_SIMD].PrintCtx = SCACSimdPrintInfo;
+    mpm_table[MPM_AC_SIMD].PrintThreadCtx = SCACPrintSearchStats;
+    mpm_table[MPM_AC_SIMD].RegisterUnittests = SCACSimdRegisterTests;
+
+    SCACSimdFilterBlock = SCACSimdFilterBlockScalar;
+    ac_simd_impl = "scalar";
+#if defined(AC_SIMD_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512bw")) {
+        SCACSimdFilterBlock = SCACSimdFilterBlockAVX512;
+        ac_simd_impl = "avx512bw";
+    } else if (__builtin_cpu_supports("avx2")) {
+        SCACSimdFilterBlock = SCACSimdFilterBlockAVX2;
+        ac_simd_impl = "avx2";
+    } else if (__builtin_cpu_supports("ssse3")) {
+        SCACSimdFilterBlock = SCACSimdFilterBlockSSSE3;
+        ac_simd_impl = "ssse3";
+    }
+#elif defined(AC_SIMD_NEON)
+    SCACSimdFilterBlock = SCACSimdFilterBlockNEON;
+    ac_simd_impl = "neon";
+#endif
+    SCLogDebug("ac-simd prefix filter: %s", ac_simd_impl);
+}
+
+/*************************************Unittests********************************/
+
+#ifdef UNITTESTS
+/** \internal
+ *  \brief search buf with both ac and ac-simd and compare the results
+ */
+static int SCACSimdCompare(
+        MpmCtx *ac, MpmCtx *simd, const uint8_t *buf, uint32_t buflen)
+{
+    MpmThreadCtx ac_tctx, simd_tctx;
+    PrefilterRuleStore ac_pmq, simd_pmq;
+    memset(&ac_tctx, 0, sizeof(ac_tctx));
+    memset(&simd_tctx, 0, sizeof(simd_tctx));
+    SCACInitThreadCtx(ac, &ac_tctx);
+    SCACInitThreadCtx(simd, &simd_tctx);
+    PmqSetup(&ac_pmq);
+    PmqSetup(&simd_pmq);
+
+    const uint32_t ac_cnt = SCACSearch(ac, &ac_tctx, &ac_pmq, buf, buflen);
+    const uint32_t simd_cnt = SCACSimdSearch(simd, &simd_tctx, &simd_pmq, buf, buflen);
+    FAIL_IF(ac_cnt != simd_cnt);
+    FAIL_IF(ac_pmq.rule_id_array_cnt != simd_pmq.rule_id_array_cnt);
+    FAIL_IF(memcmp(ac_pmq.rule_id_array, simd_pmq.rule_id_array,
+                    ac_pmq.rule_id_array_cnt * sizeof(SigIntId)) != 0);
+
+    PmqFree(&ac_pmq);
+    PmqFree(&simd_pmq);
+    SCACDestroyThreadCtx(ac, &ac_tctx);
+    SCACDestroyThreadCtx(simd, &simd_tctx);
+    PASS;
+}
+
+/** \test matches at block edges and the buffer end, mixed case */
+static int SCACSimdTest01(void)
+{
+    MpmCtx ac, simd;
+    memset(&ac, 0, sizeof(ac));
+    memset(&simd, 0, sizeof(simd));
+    MpmInitCtx(&ac, MPM_AC);
+    MpmInitCtx(&simd, MPM_AC_SIMD);
+
+    const char *pats[] = { "abcd", "bcdefgh", "XYZ", "xyzzy", "123456789" };
+    for (uint32_t i = 0; i < ARRAY_SIZE(pats); i++) {
+        const uint16_t len = (uint16_t)strlen(pats[i]);
+        if (i % 2) {
+            MpmAddPatternCI(&ac, (uint8_t *)pats[i], len, 0, 0, i, i, 0);
+            MpmAddPatternCI(&simd, (uint8_t *)pats[i], len, 0, 0, i, i, 0);
+        } else {
+            MpmAddPatternCS(&ac, (uint8_t *)pats[i], len, 0, 0, i, i, 0);
+            MpmAddPatternCS(&simd, (uint8_t *)pats[i], len, 0, 0, i, i, 0);
+        }
+    }
+    FAIL_IF(SCACPreparePatterns(&ac) != 0);
+    FAIL_IF(SCACSimdPreparePatterns(&simd) != 0);
+    FAIL_IF(((SCACSimdCtx *)simd.ctx)->filter.prefix_len != 3);
+
+    uint8_t buf[300];
+    memset(buf, '.', sizeof(buf));
+    /* across the first block edge, at the end of the vector part, at the end */
+    memcpy(buf + 62, "abcdefgh", 8);
+    memcpy(buf + 126, "XYZZY", 5);
+    memcpy(buf + 200, "xyz", 3);
+    memcpy(buf + sizeof(buf) - 9, "123456789", 9);
+    for (uint32_t len = 0; len <= sizeof(buf); len++) {
+        FAIL_IF_NOT(SCACSimdCompare(&ac, &simd, buf, len));
+    }
+
+    SCACDestroyCtx(&ac);
+    SCACSimdDestroyCtx(&simd);
+    PASS;
+}
+
+/** \test random patterns and input from a small alphabet */
+static int SCACSimdTest02(void)
+{
+    uint32_t seed = 42;
+    for (int round = 0; round < 20; round++) {
+        MpmCtx ac, simd;
+        memset(&ac, 0, sizeof(ac));
+        memset(&simd, 0, sizeof(simd));
+        MpmInitCtx(&ac, MPM_AC);
+        MpmInitCtx(&simd, MPM_AC_SIMD);
+
+        const uint32_t pat_cnt = 1 + (uint32_t)(rand_r(&seed) % 40);
+        for (uint32_t p = 0; p < pat_cnt; p++) {
+            uint8_t pat[16];
+            const uint16_t len = (uint16_t)(2 + rand_r(&seed) % 10);
+            for (uint16_t j = 0; j < len; j++) {
+                pat[j] = (uint8_t)("abcdefghABCDEFGH\x00\xff"[rand_r(&seed) % 18]);
+            }
+            const uint16_t offset = rand_r(&seed) % 4 == 0 ? (uint16_t)(rand_r(&seed) % 100) : 0;
+            const uint16_t depth =
+                    rand_r(&seed) % 4 == 0 ? (uint16_t)(offset + len + rand_r(&seed) % 200) : 0;
+            if (rand_r(&seed) % 2) {
+                MpmAddPatternCI(&ac, pat, len, offset, depth, p, p, 0);
+                MpmAddPatternCI(&simd, pat, len, offset, depth, p, p, 0);
+            } else {
+                MpmAddPatternCS(&ac, pat, len, offset, depth, p, p, 0);
+                MpmAddPatternCS(&simd, pat, len, offset, depth, p, p, 0);
+            }
+        }
+        FAIL_IF(SCACPreparePatterns(&ac) != 0);
+        FAIL_IF(SCACSimdPreparePatterns(&simd) != 0);
+
+        uint8_t buf[2048];
+        for (uint32_t i = 0; i < sizeof(buf); i++) {
+            /* mostly bytes no pattern has, so the filter skips ahead */
+            buf[i] = rand_r(&seed) % 8 == 0 ? (uint8_t)("abcdefghABCDEFGH\x00\xff"[rand_r(&seed) % 18])
+                                             : (uint8_t)('0' + rand_r(&seed) % 10);
+        }
+        for (uint32_t len = 0; len <= sizeof(buf); len += 1 + rand_r(&seed) % 97) {
+            FAIL_IF_NOT(SCACSimdCompare(&ac, &simd, buf, len));
+        }
+        FAIL_IF_NOT(SCACSimdCompare(&ac, &simd, buf, sizeof(buf)));
+
+        SCACDestroyCtx(&ac);
+        SCACSimdDestroyCtx(&simd);
+    }
+    PASS;
+}
+
+/** \test the filter is skipped if it doesn't thin out the input */
+static int SCACSimdTest03(void)
+{
+    MpmCtx simd;
+    memset(&simd, 0, sizeof(simd));
+    MpmInitCtx(&simd, MPM_AC_SIMD);
+    MpmAddPatternCS(&simd, (uint8_t *)"a", 1, 0, 0, 0, 0, 0);
+    MpmAddPatternCS(&simd, (uint8_t *)"bcd", 3, 0, 0, 1, 1, 0);
+    FAIL_IF(SCACSimdPreparePatterns(&simd) != 0);
+    FAIL_IF(((SCACSimdCtx *)simd.ctx)->filter.prefix_len != 0);
+
+    MpmThreadCtx tctx;
+    PrefilterRuleStore pmq;
+    memset(&tctx, 0, sizeof(tctx));
+    SCACInitThreadCtx(&simd, &tctx);
+    PmqSetup(&pmq);
+    const char *buf = "xxaxxbcdxxa";
+    FAIL_IF(SCACSimdSearch(&simd, &tctx, &pmq, (const uint8_t *)buf, strlen(buf)) != 3);
+    PmqFree(&pmq);
+    SCACDestroyThreadCtx(&simd, &tctx);
+    SCACSimdDestroyCtx(&simd);
+    PASS;
+}
+#endif /* UNITTESTS */
+
+static void SCACSimdRegisterTests(void)
+{
+#ifdef UNITTESTS
+    UtRegisterTest("SCACSimdTest01", SCACSimdTest01);
+    UtRegisterTest("SCACSimdTest02", SCACSimdTest02);
+    UtRegisterTest("SCACSimdTest03", SCACSimdTest03);
+#endif /* UNITTESTS */
+}
@@ -0,0 +1,52 @@
+/* Copyright (C) 2026 Open Information Security Foundation
+ *
+ * You can copy, redistribute or modify this Program under the terms of
+ * the GNU General Public License version 2 as published by the Free
+ * Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/**
+ * \file
+ *
+ * Aho-Corasick with a SIMD prefix filter in front of the state walk.
+ */
+
+#ifndef __UTIL_MPM_AC_SIMD__H__
+#define __UTIL_MPM_AC_SIMD__H__
+
+#include "util-mpm-ac.h"
+
+/** buckets of the prefix filter, one bit each in the nibble tables */
+#define AC_SIMD_BUCKETS    8
+/** max pattern prefix bytes checked by the filter */
+#define AC_SIMD_MAX_PREFIX 3
+
+typedef struct SCACSimdFilter_ {
+    /* bit b set if a pattern in bucket b has a prefix byte with this nibble */
+    uint8_t lo[AC_SIMD_MAX_PREFIX][16];
+    uint8_t hi[AC_SIMD_MAX_PREFIX][16];
+    /* lo & hi per byte value, for the buffer tail */
+    uint8_t tbl[AC_SIMD_MAX_PREFIX][256];
+    /* prefix bytes checked, 0 if the filter is not used */
+    uint8_t prefix_len;
+} SCACSimdFilter;
+
+typedef struct SCACSimdCtx_ {
+    /* first so the ac functions can use the ctx as is */
+    SCACCtx ac;
+    SCACSimdFilter filter;
+} SCACSimdCtx;
+
+void MpmACSimdRegister(void);
+
+#endif /* __UTIL_MPM_AC_SIMD__H__ */
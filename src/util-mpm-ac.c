@@ -63,18 +63,6 @@
 #include "util-validate.h"
 
 void SCACInitCtx(MpmCtx *);
-void SCACInitThreadCtx(MpmCtx *, MpmThreadCtx *);
-void SCACDestroyCtx(MpmCtx *);
-void SCACDestroyThreadCtx(MpmCtx *, MpmThreadCtx *);
-int SCACAddPatternCI(MpmCtx *, uint8_t *, uint16_t, uint16_t, uint16_t,
-                     uint32_t, SigIntId, uint8_t);
-int SCACAddPatternCS(MpmCtx *, uint8_t *, uint16_t, uint16_t, uint16_t,
-                     uint32_t, SigIntId, uint8_t);
-int SCACPreparePatterns(MpmCtx *mpm_ctx);
-uint32_t SCACSearch(const MpmCtx *mpm_ctx, MpmThreadCtx *mpm_thread_ctx,
-                    PrefilterRuleStore *pmq, const uint8_t *buf, uint32_t buflen);
-void SCACPrintInfo(MpmCtx *mpm_ctx);
-void SCACPrintSearchStats(MpmThreadCtx *mpm_thread_ctx);
 void SCACRegisterTests(void);
 
 /* a placeholder to denote a failure transition in the goto table */
@@ -82,10 +70,6 @@ void SCACRegisterTests(void);
 
 #define STATE_QUEUE_CONTAINER_SIZE 65536
 
-#define AC_CASE_MASK    0x80000000
-#define AC_PID_MASK     0x7FFFFFFF
-#define AC_CASE_BIT     31
-
 static int construct_both_16_and_32_state_tables = 0;
 
 /**
@@ -1207,6 +1191,9 @@ void MpmACRegister(void)
 #ifdef UNITTESTS
 #include "detect-engine-alert.h"
 
+/* matcher the tests run with, ac-simd runs them too as it uses the ac tables */
+static uint8_t ac_test_matcher = MPM_AC;
+
 static int SCACTest01(void)
 {
     int result = 0;
@@ -1216,18 +1203,18 @@ static int SCACTest01(void)
 
     memset(&mpm_ctx, 0, sizeof(MpmCtx));
     memset(&mpm_thread_ctx, 0, sizeof(MpmThreadCtx));
-    MpmInitCtx(&mpm_ctx, MPM_AC);
-    SCACInitThreadCtx(&mpm_ctx, &mpm_thread_ctx);
+    MpmInitCtx(&mpm_ctx, ac_test_matcher);
+    mpm_table[ac_test_matcher].InitThreadCtx(&mpm_ctx, &mpm_thread_ctx);
 
     /* 1 match */
     MpmAddPatternCS(&mpm_ctx, (uint8_t *)"abcd", 4, 0, 0, 0, 0, 0);
     PmqSetup(&pmq);
 
-    SCACPreparePatterns(&mpm_ctx);
+    mpm_table[ac_test_matcher].Prepare(&mpm_ctx);
 
     const char *buf = "abcdefghjiklmnopqrstuvwxyz";
 
-    uint32_t cnt = SCACSearch(&mpm_ctx, &mpm_thread_ctx, &pmq,
+    uint32_t cnt = mpm_table[ac_test_matcher].Search(&mpm_ctx, &mpm_thread_ctx, &pmq,
                                (uint8_t *)buf, strlen(buf));
 
     if (cnt == 1)
@@ -1235,8 +1222,8 @@ static int SCACTest01(void)
     else
         printf("1 != %" PRIu32 " ",cnt);
 
-    SCACDestroyCtx(&mpm_ctx);
-    SCACDestroyThreadCtx(&mpm_ctx, &mpm_thread_ctx);
+    mpm_table[ac_test_matcher].DestroyCtx(&mpm_ctx);
+    mpm_table[ac_test_matcher].DestroyThreadCtx(&mpm_ctx, &mpm_thread_ctx);
     PmqFree(&pmq);
     return result;
 }
@@ -1250,17 +1237,17 @@ static int SCACTest02(void)
 
     memset(&mpm_ctx, 0, sizeof(MpmCtx));
     memset(&mpm_thread_ctx, 0, sizeof(MpmThreadCtx));
-    MpmInitCtx(&mpm_ctx, MPM_AC);
-    SCACInitThreadCtx(&mpm_ctx, &mpm_thread_ctx);
+    MpmInitCtx(&mpm_ctx, ac_test_matcher);
+    mpm_table[ac_test_matcher].InitThreadCtx(&mpm_ctx, &mpm_thread_ctx);
 
     /* 1 match */
     MpmAddPatternCS(&mpm_ctx, (uint8_t *)"abce", 4, 0, 0, 0, 0, 0);
     PmqSetup(&pmq);
 
-    SCACPreparePatterns(&mpm_ctx);
+    mpm_table[ac_test_matcher].Prepare(&mpm_ctx);
 
     const char *buf = "abcdefghjiklmnopqrstuvwxyz";
-    uint32_t cnt = SCACSearch(&mpm_ctx, &mpm_thread_ctx, &pmq,
+    uint32_t cnt = mpm_table[ac_test_matcher].Search(&mpm_ctx, &mpm_thread_ctx, &pmq,
                                (uint8_t *)buf, strlen(buf));
 
     if (cnt == 0)
@@ -1268,8 +1255,8 @@ static int SCACTest02(void)
     else
         printf("0 != %" PRIu32 " ",cnt);
 
-    SCACDestroyCtx(&mpm_ctx);
-    SCACDestroyThreadCtx(&mpm_ctx, &mpm_thread_ctx);
+    mpm_table[ac_test_matcher].DestroyCtx(&mpm_ctx);
+    mpm_table[ac_test_matcher].DestroyThreadCtx(&mpm_ctx, &mpm_thread_ctx);
     PmqFree(&pmq);
     return result;
 }
@@ -1283,8 +1270,8 @@ static int SCACTest03(void)
 
     memset(&mpm_ctx, 0x00, sizeof(MpmCtx));
     memset(&mpm_thread_ctx, 0, sizeof(MpmThreadCtx));
-    MpmInitCtx(&mpm_ctx, MPM_AC);
-    SCACInitThreadCtx(&mpm_ctx, &mpm_thread_ctx);
+    MpmInitCtx(&mpm_ctx, ac_test_matcher);
+    mpm_table[ac_test_matcher].InitThreadCtx(&mpm_ctx, &mpm_thread_ctx);
 
     /* 1 match */
     MpmAddPatternCS(&mpm_ctx, (uint8_t *)"abcd", 4, 0, 0, 0, 0, 0);
@@ -1294,10 +1281,10 @@ static int SCACTest03(void)
     MpmAddPatternCS(&mpm_ctx, (uint8_t *)"fghj", 4, 0, 0, 2, 0, 0);
     PmqSetup(&pmq);
 
-    SCACPreparePatterns(&mpm_ctx);
+    mpm_table[ac_test_matcher].Prepare(&mpm_ctx);
 
     const char *buf = "abcdefghjiklmnopqrstuvwxyz";
-    uint32_t cnt = SCACSearch(&mpm_ctx, &mpm_thread_ctx, &pmq,
+    uint32_t cnt = mpm_table[ac_test_matcher].Search(&mpm_ctx, &mpm_thread_ctx, &pmq,
                                (uint8_t *)buf, strlen(buf));
 
     if (cnt == 3)
@@ -1305,8 +1292,8 @@ static int SCACTest03(void)
     else
         printf("3 != %" PRIu32 " ",cnt);
 
-    SCACDestroyCtx(&mpm_ctx);
-    SCACDestroyThreadCtx(&mpm_ctx, &mpm_thread_ctx);
+    mpm_table[ac_test_matcher].DestroyCtx(&mpm_ctx);
+    mpm_table[ac_test_matcher].DestroyThreadCtx(&mpm_ctx, &mpm_thread_ctx);
     PmqFree(&pmq);
     return result;
 }
@@ -1320,18 +1307,18 @@ static int SCACTest04(void)
 
     memset(&mpm_ctx, 0, sizeof(MpmCtx));
     memset(&mpm_thread_ctx, 0, sizeof(MpmThreadCtx));
-    MpmInitCtx(&mpm_ctx, MPM_AC);
-    SCACInitThreadCtx(&mpm_ctx, &mpm_thread_ctx);
+    MpmInitCtx(&mpm_ctx, ac_test_matcher);
+    mpm_table[ac_test_matcher].InitThreadCtx(&mpm_ctx, &mpm_thread_ctx);
 
     MpmAddPatternCS(&mpm_ctx, (uint8_t *)"abcd", 4, 0, 0, 0, 0, 0);
     MpmAddPatternCS(&mpm_ctx, (uint8_t *)"bcdegh", 6, 0, 0, 1, 0, 0);
     MpmAddPatternCS(&mpm_ctx, (uint8_t *)"fghjxyz", 7, 0, 0, 2, 0, 0);
     PmqSetup(&pmq);
 
-    SCACPreparePatterns(&mpm_ctx);
+    mpm_table[ac_test_matcher].Prepare(&mpm_ctx);
 
     const char *buf = "abcdefghjiklmnopqrstuvwxyz";
-    uint32_t cnt = SCACSearch(&mpm_ctx, &mpm_thread_ctx, &pmq,
+    uint32_t cnt = mpm_table[ac_test_matcher].Search(&mpm_ctx, &mpm_thread_ctx, &pmq,
                                (uint8_t *)buf, strlen(buf));
 
     if (cnt == 1)
@@ -1339,8 +1326,8 @@ static int SCACTest04(void)
     else
         printf("1 != %" PRIu32 " ",cnt);
 
-    SCACDestroyCtx(&mpm_ctx);
-    SCACDestroyThreadCtx(&mpm_ctx, &mpm_thread_ctx);
+    mpm_table[ac_test_matcher].DestroyCtx(&mpm_ctx);
+    mpm_table[ac_test_matcher].DestroyThreadCtx(&mpm_ctx, &mpm_thread_ctx);
     PmqFree(&pmq);
     return result;
 }
@@ -1354,18 +1341,18 @@ static int SCACTest05(void)
 
     memset(&mpm_ctx, 0x00, sizeof(MpmCtx));
     memset(&mpm_thread_ctx, 0, sizeof(MpmThreadCtx));
-    MpmInitCtx(&mpm_ctx, MPM_AC);
-    SCACInitThreadCtx(&mpm_ctx, &mpm_thread_ctx);
+    MpmInitCtx(&mpm_ctx, ac_test_matcher);
+    mpm_table[ac_test_matcher].InitThreadCtx(&mpm_ctx, &mpm_thread_ctx);
 
     MpmAddPatternCI(&mpm_ctx, (uint8_t *)"ABCD", 4, 0, 0, 0, 0, 0);
     MpmAddPatternCI(&mpm_ctx, (uint8_t *)"bCdEfG", 6, 0, 0, 1, 0, 0);
     MpmAddPatternCI(&mpm_ctx, (uint8_t *)"fghJikl", 7, 0, 0, 2, 0, 0);
     PmqSetup(&pmq);
 
-    SCACPreparePatterns(&mpm_ctx);
+    mpm_table[ac_test_matcher].Prepare(&mpm_ctx);
 
     const char *buf = "abcdefghjiklmnopqrstuvwxyz";
-    uint32_t cnt = SCACSearch(&mpm_ctx, &mpm_thread_ctx, &pmq,
+    uint32_t cnt = mpm_table[ac_test_matcher].Search(&mpm_ctx, &mpm_thread_ctx, &pmq,
                                (uint8_t *)buf, strlen(buf));
 
     if (cnt == 3)
@@ -1373,8 +1360,8 @@ static int SCACTest05(void)
     else
         printf("3 != %" PRIu32 " ",cnt);
 
-    SCACDestroyCtx(&mpm_ctx);
-    SCACDestroyThreadCtx(&mpm_ctx, &mpm_thread_ctx);
+    mpm_table[ac_test_matcher].DestroyCtx(&mpm_ctx);
+    mpm_table[ac_test_matcher].DestroyThreadCtx(&mpm_ctx, &mpm_thread_ctx);
     PmqFree(&pmq);
     return result;
 }
@@ -1388,16 +1375,16 @@ static int SCACTest06(void)
 
     memset(&mpm_ctx, 0, sizeof(MpmCtx));
     memset(&mpm_thread_ctx, 0, sizeof(MpmThreadCtx));
-    MpmInitCtx(&mpm_ctx, MPM_AC);
-    SCACInitThreadCtx(&mpm_ctx, &mpm_thread_ctx);
+    MpmInitCtx(&mpm_ctx, ac_test_matcher);
+    mpm_table[ac_test_matcher].InitThreadCtx(&mpm_ctx, &mpm_thread_ctx);
 
     MpmAddPatternCS(&mpm_ctx, (uint8_t *)"abcd", 4, 0, 0, 0, 0, 0);
     PmqSetup(&pmq);
 
-    SCACPreparePatterns(&mpm_ctx);
+    mpm_table[ac_test_matcher].Prepare(&mpm_ctx);
 
     const char *buf = "abcd";
-    uint32_t cnt = SCACSearch(&mpm_ctx, &mpm_thread_ctx, &pmq,
+    uint32_t cnt = mpm_table[ac_test_matcher].Search(&mpm_ctx, &mpm_thread_ctx, &pmq,
                                (uint8_t *)buf, strlen(buf));
 
     if (cnt == 1)
@@ -1405,8 +1392,8 @@ static int SCACTest06(void)
     else
         printf("1 != %" PRIu32 " ",cnt);
 
-    SCACDestroyCtx(&mpm_ctx);
-    SCACDestroyThreadCtx(&mpm_ctx, &mpm_thread_ctx);
+    mpm_table[ac_test_matcher].DestroyCtx(&mpm_ctx);
+    mpm_table[ac_test_matcher].DestroyThreadCtx(&mpm_ctx, &mpm_thread_ctx);
     PmqFree(&pmq);
     return result;
 }
@@ -1420,8 +1407,8 @@ static int SCACTest07(void)
 
     memset(&mpm_ctx, 0, sizeof(MpmCtx));
     memset(&mpm_thread_ctx, 0, sizeof(MpmThreadCtx));
-    MpmInitCtx(&mpm_ctx, MPM_AC);
-    SCACInitThreadCtx(&mpm_ctx, &mpm_thread_ctx);
+    MpmInitCtx(&mpm_ctx, ac_test_matcher);
+    mpm_table[ac_test_matcher].InitThreadCtx(&mpm_ctx, &mpm_thread_ctx);
 
     /* should match 30 times */
     MpmAddPatternCS(&mpm_ctx, (uint8_t *)"A", 1, 0, 0, 0, 0, 0);
@@ -1439,10 +1426,10 @@ static int SCACTest07(void)
     PmqSetup(&pmq);
     /* total matches: 135 */
 
-    SCACPreparePatterns(&mpm_ctx);
+    mpm_table[ac_test_matcher].Prepare(&mpm_ctx);
 
     const char *buf = "AAAAAAAAAAAAAAAAAAAAAAAAAAAAAA";
-    uint32_t cnt = SCACSearch(&mpm_ctx, &mpm_thread_ctx, &pmq,
+    uint32_t cnt = mpm_table[ac_test_matcher].Search(&mpm_ctx, &mpm_thread_ctx, &pmq,
                                (uint8_t *)buf, strlen(buf));
 
     if (cnt == 135)
@@ -1450,8 +1437,8 @@ static int SCACTest07(void)
     else
         printf("135 != %" PRIu32 " ",cnt);
 
-    SCACDestroyCtx(&mpm_ctx);
-    SCACDestroyThreadCtx(&mpm_ctx, &mpm_thread_ctx);
+    mpm_table[ac_test_matcher].DestroyCtx(&mpm_ctx);
+    mpm_table[ac_test_matcher].DestroyThreadCtx(&mpm_ctx, &mpm_thread_ctx);
     PmqFree(&pmq);
     return result;
 }
@@ -1465,16 +1452,16 @@ static int SCACTest08(void)
 
     memset(&mpm_ctx, 0, sizeof(MpmCtx));
     memset(&mpm_thread_ctx, 0, sizeof(MpmThreadCtx));
-    MpmInitCtx(&mpm_ctx, MPM_AC);
-    SCACInitThreadCtx(&mpm_ctx, &mpm_thread_ctx);
+    MpmInitCtx(&mpm_ctx, ac_test_matcher);
+    mpm_table[ac_test_matcher].InitThreadCtx(&mpm_ctx, &mpm_thread_ctx);
 
     /* 1 match */
     MpmAddPatternCS(&mpm_ctx, (uint8_t *)"abcd", 4, 0, 0, 0, 0, 0);
     PmqSetup(&pmq);
 
-    SCACPreparePatterns(&mpm_ctx);
+    mpm_table[ac_test_matcher].Prepare(&mpm_ctx);
 
-    uint32_t cnt = SCACSearch(&mpm_ctx, &mpm_thread_ctx, &pmq,
+    uint32_t cnt = mpm_table[ac_test_matcher].Search(&mpm_ctx, &mpm_thread_ctx, &pmq,
                                (uint8_t *)"a", 1);
 
     if (cnt == 0)
@@ -1482,8 +1469,8 @@ static int SCACTest08(void)
     else
         printf("0 != %" PRIu32 " ",cnt);
 
-    SCACDestroyCtx(&mpm_ctx);
-    SCACDestroyThreadCtx(&mpm_ctx, &mpm_thread_ctx);
+    mpm_table[ac_test_matcher].DestroyCtx(&mpm_ctx);
+    mpm_table[ac_test_matcher].DestroyThreadCtx(&mpm_ctx, &mpm_thread_ctx);
     PmqFree(&pmq);
     return result;
 }
@@ -1497,16 +1484,16 @@ static int SCACTest09(void)
 
     memset(&mpm_ctx, 0, sizeof(MpmCtx));
     memset(&mpm_thread_ctx, 0, sizeof(MpmThreadCtx));
-    MpmInitCtx(&mpm_ctx, MPM_AC);
-    SCACInitThreadCtx(&mpm_ctx, &mpm_thread_ctx);
+    MpmInitCtx(&mpm_ctx, ac_test_matcher);
+    mpm_table[ac_test_matcher].InitThreadCtx(&mpm_ctx, &mpm_thread_ctx);
 
     /* 1 match */
     MpmAddPatternCS(&mpm_ctx, (uint8_t *)"ab", 2, 0, 0, 0, 0, 0);
     PmqSetup(&pmq);
 
-    SCACPreparePatterns(&mpm_ctx);
+    mpm_table[ac_test_matcher].Prepare(&mpm_ctx);
 
-    uint32_t cnt = SCACSearch(&mpm_ctx, &mpm_thread_ctx, &pmq,
+    uint32_t cnt = mpm_table[ac_test_matcher].Search(&mpm_ctx, &mpm_thread_ctx, &pmq,
                                (uint8_t *)"ab", 2);
 
     if (cnt == 1)
@@ -1514,8 +1501,8 @@ static int SCACTest09(void)
     else
         printf("1 != %" PRIu32 " ",cnt);
 
-    SCACDestroyCtx(&mpm_ctx);
-    SCACDestroyThreadCtx(&mpm_ctx, &mpm_thread_ctx);
+    mpm_table[ac_test_matcher].DestroyCtx(&mpm_ctx);
+    mpm_table[ac_test_matcher].DestroyThreadCtx(&mpm_ctx, &mpm_thread_ctx);
     PmqFree(&pmq);
     return result;
 }
@@ -1529,21 +1516,21 @@ static int SCACTest10(void)
 
     memset(&mpm_ctx, 0, sizeof(MpmCtx));
     memset(&mpm_thread_ctx, 0, sizeof(MpmThreadCtx));
-    MpmInitCtx(&mpm_ctx, MPM_AC);
-    SCACInitThreadCtx(&mpm_ctx, &mpm_thread_ctx);
+    MpmInitCtx(&mpm_ctx, ac_test_matcher);
+    mpm_table[ac_test_matcher].InitThreadCtx(&mpm_ctx, &mpm_thread_ctx);
 
     /* 1 match */
     MpmAddPatternCS(&mpm_ctx, (uint8_t *)"abcdefgh", 8, 0, 0, 0, 0, 0);
     PmqSetup(&pmq);
 
-    SCACPreparePatterns(&mpm_ctx);
+    mpm_table[ac_test_matcher].Prepare(&mpm_ctx);
 
     const char *buf = "01234567890123456789012345678901234567890123456789"
                 "01234567890123456789012345678901234567890123456789"
                 "abcdefgh"
                 "01234567890123456789012345678901234567890123456789"
                 "01234567890123456789012345678901234567890123456789";
-    uint32_t cnt = SCACSearch(&mpm_ctx, &mpm_thread_ctx, &pmq,
+    uint32_t cnt = mpm_table[ac_test_matcher].Search(&mpm_ctx, &mpm_thread_ctx, &pmq,
                                (uint8_t *)buf, strlen(buf));
 
     if (cnt == 1)
@@ -1551,8 +1538,8 @@ static int SCACTest10(void)
     else
         printf("1 != %" PRIu32 " ",cnt);
 
-    SCACDestroyCtx(&mpm_ctx);
-    SCACDestroyThreadCtx(&mpm_ctx, &mpm_thread_ctx);
+    mpm_table[ac_test_matcher].DestroyCtx(&mpm_ctx);
+    mpm_table[ac_test_matcher].DestroyThreadCtx(&mpm_ctx, &mpm_thread_ctx);
     PmqFree(&pmq);
     return result;
 }
@@ -1566,8 +1553,8 @@ static int SCACTest11(void)
 
     memset(&mpm_ctx, 0, sizeof(MpmCtx));
     memset(&mpm_thread_ctx, 0, sizeof(MpmThreadCtx));
-    MpmInitCtx(&mpm_ctx, MPM_AC);
-    SCACInitThreadCtx(&mpm_ctx, &mpm_thread_ctx);
+    MpmInitCtx(&mpm_ctx, ac_test_matcher);
+    mpm_table[ac_test_matcher].InitThreadCtx(&mpm_ctx, &mpm_thread_ctx);
 
     if (MpmAddPatternCS(&mpm_ctx, (uint8_t *)"he", 2, 0, 0, 1, 0, 0) == -1)
         goto end;
@@ -1579,27 +1566,27 @@ static int SCACTest11(void)
         goto end;
     PmqSetup(&pmq);
 
-    if (SCACPreparePatterns(&mpm_ctx) == -1)
+    if (mpm_table[ac_test_matcher].Prepare(&mpm_ctx) == -1)
         goto end;
 
     result = 1;
 
     const char *buf = "he";
-    result &= (SCACSearch(&mpm_ctx, &mpm_thread_ctx, &pmq, (uint8_t *)buf,
+    result &= (mpm_table[ac_test_matcher].Search(&mpm_ctx, &mpm_thread_ctx, &pmq, (uint8_t *)buf,
                           strlen(buf)) == 1);
     buf = "she";
-    result &= (SCACSearch(&mpm_ctx, &mpm_thread_ctx, &pmq, (uint8_t *)buf,
+    result &= (mpm_table[ac_test_matcher].Search(&mpm_ctx, &mpm_thread_ctx, &pmq, (uint8_t *)buf,
                           strlen(buf)) == 2);
     buf = "his";
-    result &= (SCACSearch(&mpm_ctx, &mpm_thread_ctx, &pmq, (uint8_t *)buf,
+    result &= (mpm_table[ac_test_matcher].Search(&mpm_ctx, &mpm_thread_ctx, &pmq, (uint8_t *)buf,
                           strlen(buf)) == 1);
     buf = "hers";
-    result &= (SCACSearch(&mpm_ctx, &mpm_thread_ctx, &pmq, (uint8_t *)buf,
+    result &= (mpm_table[ac_test_matcher].Search(&mpm_ctx, &mpm_thread_ctx, &pmq, (uint8_t *)buf,
                           strlen(buf)) == 2);
 
  end:
-    SCACDestroyCtx(&mpm_ctx);
-    SCACDestroyThreadCtx(&mpm_ctx, &mpm_thread_ctx);
+    mpm_table[ac_test_matcher].DestroyCtx(&mpm_ctx);
+    mpm_table[ac_test_matcher].DestroyThreadCtx(&mpm_ctx, &mpm_thread_ctx);
     PmqFree(&pmq);
     return result;
 }
@@ -1613,8 +1600,8 @@ static int SCACTest12(void)
 
     memset(&mpm_ctx, 0x00, sizeof(MpmCtx));
     memset(&mpm_thread_ctx, 0, sizeof(MpmThreadCtx));
-    MpmInitCtx(&mpm_ctx, MPM_AC);
-    SCACInitThreadCtx(&mpm_ctx, &mpm_thread_ctx);
+    MpmInitCtx(&mpm_ctx, ac_test_matcher);
+    mpm_table[ac_test_matcher].InitThreadCtx(&mpm_ctx, &mpm_thread_ctx);
 
     /* 1 match */
     MpmAddPatternCS(&mpm_ctx, (uint8_t *)"wxyz", 4, 0, 0, 0, 0, 0);
@@ -1622,10 +1609,10 @@ static int SCACTest12(void)
     MpmAddPatternCS(&mpm_ctx, (uint8_t *)"vwxyz", 5, 0, 0, 1, 0, 0);
     PmqSetup(&pmq);
 
-    SCACPreparePatterns(&mpm_ctx);
+    mpm_table[ac_test_matcher].Prepare(&mpm_ctx);
 
     const char *buf = "abcdefghijklmnopqrstuvwxyz";
-    uint32_t cnt = SCACSearch(&mpm_ctx, &mpm_thread_ctx, &pmq,
+    uint32_t cnt = mpm_table[ac_test_matcher].Search(&mpm_ctx, &mpm_thread_ctx, &pmq,
                                (uint8_t *)buf, strlen(buf));
 
     if (cnt == 2)
@@ -1633,8 +1620,8 @@ static int SCACTest12(void)
     else
         printf("2 != %" PRIu32 " ",cnt);
 
-    SCACDestroyCtx(&mpm_ctx);
-    SCACDestroyThreadCtx(&mpm_ctx, &mpm_thread_ctx);
+    mpm_table[ac_test_matcher].DestroyCtx(&mpm_ctx);
+    mpm_table[ac_test_matcher].DestroyThreadCtx(&mpm_ctx, &mpm_thread_ctx);
     PmqFree(&pmq);
     return result;
 }
@@ -1648,18 +1635,18 @@ static int SCACTest13(void)
 
     memset(&mpm_ctx, 0x00, sizeof(MpmCtx));
     memset(&mpm_thread_ctx, 0, sizeof(MpmThreadCtx));
-    MpmInitCtx(&mpm_ctx, MPM_AC);
-    SCACInitThreadCtx(&mpm_ctx, &mpm_thread_ctx);
+    MpmInitCtx(&mpm_ctx, ac_test_matcher);
+    mpm_table[ac_test_matcher].InitThreadCtx(&mpm_ctx, &mpm_thread_ctx);
 
     /* 1 match */
     const char pat[] = "abcdefghijklmnopqrstuvwxyzABCD";
     MpmAddPatternCS(&mpm_ctx, (uint8_t *)pat, sizeof(pat) - 1, 0, 0, 0, 0, 0);
     PmqSetup(&pmq);
 
-    SCACPreparePatterns(&mpm_ctx);
+    mpm_table[ac_test_matcher].Prepare(&mpm_ctx);
 
     const char *buf = "abcdefghijklmnopqrstuvwxyzABCD";
-    uint32_t cnt = SCACSearch(&mpm_ctx, &mpm_thread_ctx, &pmq,
+    uint32_t cnt = mpm_table[ac_test_matcher].Search(&mpm_ctx, &mpm_thread_ctx, &pmq,
                                (uint8_t *)buf, strlen(buf));
 
     if (cnt == 1)
@@ -1667,8 +1654,8 @@ static int SCACTest13(void)
     else
         printf("1 != %" PRIu32 " ",cnt);
 
-    SCACDestroyCtx(&mpm_ctx);
-    SCACDestroyThreadCtx(&mpm_ctx, &mpm_thread_ctx);
+    mpm_table[ac_test_matcher].DestroyCtx(&mpm_ctx);
+    mpm_table[ac_test_matcher].DestroyThreadCtx(&mpm_ctx, &mpm_thread_ctx);
     PmqFree(&pmq);
     return result;
 }
@@ -1682,18 +1669,18 @@ static int SCACTest14(void)
 
     memset(&mpm_ctx, 0x00, sizeof(MpmCtx));
     memset(&mpm_thread_ctx, 0, sizeof(MpmThreadCtx));
-    MpmInitCtx(&mpm_ctx, MPM_AC);
-    SCACInitThreadCtx(&mpm_ctx, &mpm_thread_ctx);
+    MpmInitCtx(&mpm_ctx, ac_test_matcher);
+    mpm_table[ac_test_matcher].InitThreadCtx(&mpm_ctx, &mpm_thread_ctx);
 
     /* 1 match */
     const char pat[] = "abcdefghijklmnopqrstuvwxyzABCDE";
     MpmAddPatternCS(&mpm_ctx, (uint8_t *)pat, sizeof(pat) - 1, 0, 0, 0, 0, 0);
     PmqSetup(&pmq);
 
-    SCACPreparePatterns(&mpm_ctx);
+    mpm_table[ac_test_matcher].Prepare(&mpm_ctx);
 
     const char *buf = "abcdefghijklmnopqrstuvwxyzABCDE";
-    uint32_t cnt = SCACSearch(&mpm_ctx, &mpm_thread_ctx, &pmq,
+    uint32_t cnt = mpm_table[ac_test_matcher].Search(&mpm_ctx, &mpm_thread_ctx, &pmq,
                                (uint8_t *)buf, strlen(buf));
 
     if (cnt == 1)
@@ -1701,8 +1688,8 @@ static int SCACTest14(void)
     else
         printf("1 != %" PRIu32 " ",cnt);
 
-    SCACDestroyCtx(&mpm_ctx);
-    SCACDestroyThreadCtx(&mpm_ctx, &mpm_thread_ctx);
+    mpm_table[ac_test_matcher].DestroyCtx(&mpm_ctx);
+    mpm_table[ac_test_matcher].DestroyThreadCtx(&mpm_ctx, &mpm_thread_ctx);
     PmqFree(&pmq);
     return result;
 }
@@ -1716,18 +1703,18 @@ static int SCACTest15(void)
 
     memset(&mpm_ctx, 0x00, sizeof(MpmCtx));
     memset(&mpm_thread_ctx, 0, sizeof(MpmThreadCtx));
-    MpmInitCtx(&mpm_ctx, MPM_AC);
-    SCACInitThreadCtx(&mpm_ctx, &mpm_thread_ctx);
+    MpmInitCtx(&mpm_ctx, ac_test_matcher);
+    mpm_table[ac_test_matcher].InitThreadCtx(&mpm_ctx, &mpm_thread_ctx);
 
     /* 1 match */
     const char pat[] = "abcdefghijklmnopqrstuvwxyzABCDEF";
     MpmAddPatternCS(&mpm_ctx, (uint8_t *)pat, sizeof(pat) - 1, 0, 0, 0, 0, 0);
     PmqSetup(&pmq);
 
-    SCACPreparePatterns(&mpm_ctx);
+    mpm_table[ac_test_matcher].Prepare(&mpm_ctx);
 
     const char *buf = "abcdefghijklmnopqrstuvwxyzABCDEF";
-    uint32_t cnt = SCACSearch(&mpm_ctx, &mpm_thread_ctx, &pmq,
+    uint32_t cnt = mpm_table[ac_test_matcher].Search(&mpm_ctx, &mpm_thread_ctx, &pmq,
                                (uint8_t *)buf, strlen(buf));
 
     if (cnt == 1)
@@ -1735,8 +1722,8 @@ static int SCACTest15(void)
     else
         printf("1 != %" PRIu32 " ",cnt);
 
-    SCACDestroyCtx(&mpm_ctx);
-    SCACDestroyThreadCtx(&mpm_ctx, &mpm_thread_ctx);
+    mpm_table[ac_test_matcher].DestroyCtx(&mpm_ctx);
+    mpm_table[ac_test_matcher].DestroyThreadCtx(&mpm_ctx, &mpm_thread_ctx);
     PmqFree(&pmq);
     return result;
 }
@@ -1750,18 +1737,18 @@ static int SCACTest16(void)
 
     memset(&mpm_ctx, 0x00, sizeof(MpmCtx));
     memset(&mpm_thread_ctx, 0, sizeof(MpmThreadCtx));
-    MpmInitCtx(&mpm_ctx, MPM_AC);
-    SCACInitThreadCtx(&mpm_ctx, &mpm_thread_ctx);
+    MpmInitCtx(&mpm_ctx, ac_test_matcher);
+    mpm_table[ac_test_matcher].InitThreadCtx(&mpm_ctx, &mpm_thread_ctx);
 
     /* 1 match */
     const char pat[] = "abcdefghijklmnopqrstuvwxyzABC";
     MpmAddPatternCS(&mpm_ctx, (uint8_t *)pat, sizeof(pat) - 1, 0, 0, 0, 0, 0);
     PmqSetup(&pmq);
 
-    SCACPreparePatterns(&mpm_ctx);
+    mpm_table[ac_test_matcher].Prepare(&mpm_ctx);
 
     const char *buf = "abcdefghijklmnopqrstuvwxyzABC";
-    uint32_t cnt = SCACSearch(&mpm_ctx, &mpm_thread_ctx, &pmq,
+    uint32_t cnt = mpm_table[ac_test_matcher].Search(&mpm_ctx, &mpm_thread_ctx, &pmq,
                                (uint8_t *)buf, strlen(buf));
 
     if (cnt == 1)
@@ -1769,8 +1756,8 @@ static int SCACTest16(void)
     else
         printf("1 != %" PRIu32 " ",cnt);
 
-    SCACDestroyCtx(&mpm_ctx);
-    SCACDestroyThreadCtx(&mpm_ctx, &mpm_thread_ctx);
+    mpm_table[ac_test_matcher].DestroyCtx(&mpm_ctx);
+    mpm_table[ac_test_matcher].DestroyThreadCtx(&mpm_ctx, &mpm_thread_ctx);
     PmqFree(&pmq);
     return result;
 }
@@ -1784,18 +1771,18 @@ static int SCACTest17(void)
 
     memset(&mpm_ctx, 0x00, sizeof(MpmCtx));
     memset(&mpm_thread_ctx, 0, sizeof(MpmThreadCtx));
-    MpmInitCtx(&mpm_ctx, MPM_AC);
-    SCACInitThreadCtx(&mpm_ctx, &mpm_thread_ctx);
+    MpmInitCtx(&mpm_ctx, ac_test_matcher);
+    mpm_table[ac_test_matcher].InitThreadCtx(&mpm_ctx, &mpm_thread_ctx);
 
     /* 1 match */
     const char pat[] = "abcdefghijklmnopqrstuvwxyzAB";
     MpmAddPatternCS(&mpm_ctx, (uint8_t *)pat, sizeof(pat) - 1, 0, 0, 0, 0, 0);
     PmqSetup(&pmq);
 
-    SCACPreparePatterns(&mpm_ctx);
+    mpm_table[ac_test_matcher].Prepare(&mpm_ctx);
 
     const char *buf = "abcdefghijklmnopqrstuvwxyzAB";
-    uint32_t cnt = SCACSearch(&mpm_ctx, &mpm_thread_ctx, &pmq,
+    uint32_t cnt = mpm_table[ac_test_matcher].Search(&mpm_ctx, &mpm_thread_ctx, &pmq,
                                (uint8_t *)buf, strlen(buf));
 
     if (cnt == 1)
@@ -1803,8 +1790,8 @@ static int SCACTest17(void)
     else
         printf("1 != %" PRIu32 " ",cnt);
 
-    SCACDestroyCtx(&mpm_ctx);
-    SCACDestroyThreadCtx(&mpm_ctx, &mpm_thread_ctx);
+    mpm_table[ac_test_matcher].DestroyCtx(&mpm_ctx);
+    mpm_table[ac_test_matcher].DestroyThreadCtx(&mpm_ctx, &mpm_thread_ctx);
     PmqFree(&pmq);
     return result;
 }
@@ -1818,8 +1805,8 @@ static int SCACTest18(void)
 
     memset(&mpm_ctx, 0x00, sizeof(MpmCtx));
     memset(&mpm_thread_ctx, 0, sizeof(MpmThreadCtx));
-    MpmInitCtx(&mpm_ctx, MPM_AC);
-    SCACInitThreadCtx(&mpm_ctx, &mpm_thread_ctx);
+    MpmInitCtx(&mpm_ctx, ac_test_matcher);
+    mpm_table[ac_test_matcher].InitThreadCtx(&mpm_ctx, &mpm_thread_ctx);
 
     /* 1 match */
     const char pat[] = "abcde"
@@ -1831,10 +1818,10 @@ static int SCACTest18(void)
     MpmAddPatternCS(&mpm_ctx, (uint8_t *)pat, sizeof(pat) - 1, 0, 0, 0, 0, 0);
     PmqSetup(&pmq);
 
-    SCACPreparePatterns(&mpm_ctx);
+    mpm_table[ac_test_matcher].Prepare(&mpm_ctx);
 
     const char *buf = "abcde""fghij""klmno""pqrst""uvwxy""z";
-    uint32_t cnt = SCACSearch(&mpm_ctx, &mpm_thread_ctx, &pmq,
+    uint32_t cnt = mpm_table[ac_test_matcher].Search(&mpm_ctx, &mpm_thread_ctx, &pmq,
                                (uint8_t *)buf, strlen(buf));
 
     if (cnt == 1)
@@ -1842,8 +1829,8 @@ static int SCACTest18(void)
     else
         printf("1 != %" PRIu32 " ",cnt);
 
-    SCACDestroyCtx(&mpm_ctx);
-    SCACDestroyThreadCtx(&mpm_ctx, &mpm_thread_ctx);
+    mpm_table[ac_test_matcher].DestroyCtx(&mpm_ctx);
+    mpm_table[ac_test_matcher].DestroyThreadCtx(&mpm_ctx, &mpm_thread_ctx);
     PmqFree(&pmq);
     return result;
 }
@@ -1857,18 +1844,18 @@ static int SCACTest19(void)
 
     memset(&mpm_ctx, 0x00, sizeof(MpmCtx));
     memset(&mpm_thread_ctx, 0, sizeof(MpmThreadCtx));
-    MpmInitCtx(&mpm_ctx, MPM_AC);
-    SCACInitThreadCtx(&mpm_ctx, &mpm_thread_ctx);
+    MpmInitCtx(&mpm_ctx, ac_test_matcher);
+    mpm_table[ac_test_matcher].InitThreadCtx(&mpm_ctx, &mpm_thread_ctx);
 
     /* 1 */
     const char pat[] = "AAAAAAAAAAAAAAAAAAAAAAAAAAAAAA";
     MpmAddPatternCS(&mpm_ctx, (uint8_t *)pat, sizeof(pat) - 1, 0, 0, 0, 0, 0);
     PmqSetup(&pmq);
 
-    SCACPreparePatterns(&mpm_ctx);
+    mpm_table[ac_test_matcher].Prepare(&mpm_ctx);
 
     const char *buf = "AAAAAAAAAAAAAAAAAAAAAAAAAAAAAA";
-    uint32_t cnt = SCACSearch(&mpm_ctx, &mpm_thread_ctx, &pmq,
+    uint32_t cnt = mpm_table[ac_test_matcher].Search(&mpm_ctx, &mpm_thread_ctx, &pmq,
                                (uint8_t *)buf, strlen(buf));
 
     if (cnt == 1)
@@ -1876,8 +1863,8 @@ static int SCACTest19(void)
     else
         printf("1 != %" PRIu32 " ",cnt);
 
-    SCACDestroyCtx(&mpm_ctx);
-    SCACDestroyThreadCtx(&mpm_ctx, &mpm_thread_ctx);
+    mpm_table[ac_test_matcher].DestroyCtx(&mpm_ctx);
+    mpm_table[ac_test_matcher].DestroyThreadCtx(&mpm_ctx, &mpm_thread_ctx);
     PmqFree(&pmq);
     return result;
 }
@@ -1891,8 +1878,8 @@ static int SCACTest20(void)
 
     memset(&mpm_ctx, 0x00, sizeof(MpmCtx));
     memset(&mpm_thread_ctx, 0, sizeof(MpmThreadCtx));
-    MpmInitCtx(&mpm_ctx, MPM_AC);
-    SCACInitThreadCtx(&mpm_ctx, &mpm_thread_ctx);
+    MpmInitCtx(&mpm_ctx, ac_test_matcher);
+    mpm_table[ac_test_matcher].InitThreadCtx(&mpm_ctx, &mpm_thread_ctx);
 
     /* 1 */
     const char pat[] = "AAAAA"
@@ -1905,10 +1892,10 @@ static int SCACTest20(void)
     MpmAddPatternCS(&mpm_ctx, (uint8_t *)pat, sizeof(pat) - 1, 0, 0, 0, 0, 0);
     PmqSetup(&pmq);
 
-    SCACPreparePatterns(&mpm_ctx);
+    mpm_table[ac_test_matcher].Prepare(&mpm_ctx);
 
     const char *buf = "AAAAA""AAAAA""AAAAA""AAAAA""AAAAA""AAAAA""AA";
-    uint32_t cnt = SCACSearch(&mpm_ctx, &mpm_thread_ctx, &pmq,
+    uint32_t cnt = mpm_table[ac_test_matcher].Search(&mpm_ctx, &mpm_thread_ctx, &pmq,
                                (uint8_t *)buf, strlen(buf));
 
     if (cnt == 1)
@@ -1916,8 +1903,8 @@ static int SCACTest20(void)
     else
         printf("1 != %" PRIu32 " ",cnt);
 
-    SCACDestroyCtx(&mpm_ctx);
-    SCACDestroyThreadCtx(&mpm_ctx, &mpm_thread_ctx);
+    mpm_table[ac_test_matcher].DestroyCtx(&mpm_ctx);
+    mpm_table[ac_test_matcher].DestroyThreadCtx(&mpm_ctx, &mpm_thread_ctx);
     PmqFree(&pmq);
     return result;
 }
@@ -1931,16 +1918,16 @@ static int SCACTest21(void)
 
     memset(&mpm_ctx, 0x00, sizeof(MpmCtx));
     memset(&mpm_thread_ctx, 0, sizeof(MpmThreadCtx));
-    MpmInitCtx(&mpm_ctx, MPM_AC);
-    SCACInitThreadCtx(&mpm_ctx, &mpm_thread_ctx);
+    MpmInitCtx(&mpm_ctx, ac_test_matcher);
+    mpm_table[ac_test_matcher].InitThreadCtx(&mpm_ctx, &mpm_thread_ctx);
 
     /* 1 */
     MpmAddPatternCS(&mpm_ctx, (uint8_t *)"AA", 2, 0, 0, 0, 0, 0);
     PmqSetup(&pmq);
 
-    SCACPreparePatterns(&mpm_ctx);
+    mpm_table[ac_test_matcher].Prepare(&mpm_ctx);
 
-    uint32_t cnt = SCACSearch(&mpm_ctx, &mpm_thread_ctx, &pmq,
+    uint32_t cnt = mpm_table[ac_test_matcher].Search(&mpm_ctx, &mpm_thread_ctx, &pmq,
                               (uint8_t *)"AA", 2);
 
     if (cnt == 1)
@@ -1948,8 +1935,8 @@ static int SCACTest21(void)
     else
         printf("1 != %" PRIu32 " ",cnt);
 
-    SCACDestroyCtx(&mpm_ctx);
-    SCACDestroyThreadCtx(&mpm_ctx, &mpm_thread_ctx);
+    mpm_table[ac_test_matcher].DestroyCtx(&mpm_ctx);
+    mpm_table[ac_test_matcher].DestroyThreadCtx(&mpm_ctx, &mpm_thread_ctx);
     PmqFree(&pmq);
     return result;
 }
@@ -1963,8 +1950,8 @@ static int SCACTest22(void)
 
     memset(&mpm_ctx, 0x00, sizeof(MpmCtx));
     memset(&mpm_thread_ctx, 0, sizeof(MpmThreadCtx));
-    MpmInitCtx(&mpm_ctx, MPM_AC);
-    SCACInitThreadCtx(&mpm_ctx, &mpm_thread_ctx);
+    MpmInitCtx(&mpm_ctx, ac_test_matcher);
+    mpm_table[ac_test_matcher].InitThreadCtx(&mpm_ctx, &mpm_thread_ctx);
 
     /* 1 match */
     MpmAddPatternCS(&mpm_ctx, (uint8_t *)"abcd", 4, 0, 0, 0, 0, 0);
@@ -1972,10 +1959,10 @@ static int SCACTest22(void)
     MpmAddPatternCS(&mpm_ctx, (uint8_t *)"abcde", 5, 0, 0, 1, 0, 0);
     PmqSetup(&pmq);
 
-    SCACPreparePatterns(&mpm_ctx);
+    mpm_table[ac_test_matcher].Prepare(&mpm_ctx);
 
     const char *buf = "abcdefghijklmnopqrstuvwxyz";
-    uint32_t cnt = SCACSearch(&mpm_ctx, &mpm_thread_ctx, &pmq,
+    uint32_t cnt = mpm_table[ac_test_matcher].Search(&mpm_ctx, &mpm_thread_ctx, &pmq,
                               (uint8_t *)buf, strlen(buf));
 
     if (cnt == 2)
@@ -1983,8 +1970,8 @@ static int SCACTest22(void)
     else
         printf("2 != %" PRIu32 " ",cnt);
 
-    SCACDestroyCtx(&mpm_ctx);
-    SCACDestroyThreadCtx(&mpm_ctx, &mpm_thread_ctx);
+    mpm_table[ac_test_matcher].DestroyCtx(&mpm_ctx);
+    mpm_table[ac_test_matcher].DestroyThreadCtx(&mpm_ctx, &mpm_thread_ctx);
     PmqFree(&pmq);
     return result;
 }
@@ -1998,16 +1985,16 @@ static int SCACTest23(void)
 
     memset(&mpm_ctx, 0x00, sizeof(MpmCtx));
     memset(&mpm_thread_ctx, 0, sizeof(MpmThreadCtx));
-    MpmInitCtx(&mpm_ctx, MPM_AC);
-    SCACInitThreadCtx(&mpm_ctx, &mpm_thread_ctx);
+    MpmInitCtx(&mpm_ctx, ac_test_matcher);
+    mpm_table[ac_test_matcher].InitThreadCtx(&mpm_ctx, &mpm_thread_ctx);
 
     /* 1 */
     MpmAddPatternCS(&mpm_ctx, (uint8_t *)"AA", 2, 0, 0, 0, 0, 0);
     PmqSetup(&pmq);
 
-    SCACPreparePatterns(&mpm_ctx);
+    mpm_table[ac_test_matcher].Prepare(&mpm_ctx);
 
-    uint32_t cnt = SCACSearch(&mpm_ctx, &mpm_thread_ctx, &pmq,
+    uint32_t cnt = mpm_table[ac_test_matcher].Search(&mpm_ctx, &mpm_thread_ctx, &pmq,
                               (uint8_t *)"aa", 2);
 
     if (cnt == 0)
@@ -2015,8 +2002,8 @@ static int SCACTest23(void)
     else
         printf("1 != %" PRIu32 " ",cnt);
 
-    SCACDestroyCtx(&mpm_ctx);
-    SCACDestroyThreadCtx(&mpm_ctx, &mpm_thread_ctx);
+    mpm_table[ac_test_matcher].DestroyCtx(&mpm_ctx);
+    mpm_table[ac_test_matcher].DestroyThreadCtx(&mpm_ctx, &mpm_thread_ctx);
     PmqFree(&pmq);
     return result;
 }
@@ -2030,16 +2017,16 @@ static int SCACTest24(void)
 
     memset(&mpm_ctx, 0x00, sizeof(MpmCtx));
     memset(&mpm_thread_ctx, 0, sizeof(MpmThreadCtx));
-    MpmInitCtx(&mpm_ctx, MPM_AC);
-    SCACInitThreadCtx(&mpm_ctx, &mpm_thread_ctx);
+    MpmInitCtx(&mpm_ctx, ac_test_matcher);
+    mpm_table[ac_test_matcher].InitThreadCtx(&mpm_ctx, &mpm_thread_ctx);
 
     /* 1 */
     MpmAddPatternCI(&mpm_ctx, (uint8_t *)"AA", 2, 0, 0, 0, 0, 0);
     PmqSetup(&pmq);
 
-    SCACPreparePatterns(&mpm_ctx);
+    mpm_table[ac_test_matcher].Prepare(&mpm_ctx);
 
-    uint32_t cnt = SCACSearch(&mpm_ctx, &mpm_thread_ctx, &pmq,
+    uint32_t cnt = mpm_table[ac_test_matcher].Search(&mpm_ctx, &mpm_thread_ctx, &pmq,
                               (uint8_t *)"aa", 2);
 
     if (cnt == 1)
@@ -2047,8 +2034,8 @@ static int SCACTest24(void)
     else
         printf("1 != %" PRIu32 " ",cnt);
 
-    SCACDestroyCtx(&mpm_ctx);
-    SCACDestroyThreadCtx(&mpm_ctx, &mpm_thread_ctx);
+    mpm_table[ac_test_matcher].DestroyCtx(&mpm_ctx);
+    mpm_table[ac_test_matcher].DestroyThreadCtx(&mpm_ctx, &mpm_thread_ctx);
     PmqFree(&pmq);
     return result;
 }
@@ -2062,18 +2049,18 @@ static int SCACTest25(void)
 
     memset(&mpm_ctx, 0x00, sizeof(MpmCtx));
     memset(&mpm_thread_ctx, 0, sizeof(MpmThreadCtx));
-    MpmInitCtx(&mpm_ctx, MPM_AC);
-    SCACInitThreadCtx(&mpm_ctx, &mpm_thread_ctx);
+    MpmInitCtx(&mpm_ctx, ac_test_matcher);
+    mpm_table[ac_test_matcher].InitThreadCtx(&mpm_ctx, &mpm_thread_ctx);
 
     MpmAddPatternCI(&mpm_ctx, (uint8_t *)"ABCD", 4, 0, 0, 0, 0, 0);
     MpmAddPatternCI(&mpm_ctx, (uint8_t *)"bCdEfG", 6, 0, 0, 1, 0, 0);
     MpmAddPatternCI(&mpm_ctx, (uint8_t *)"fghiJkl", 7, 0, 0, 2, 0, 0);
     PmqSetup(&pmq);
 
-    SCACPreparePatterns(&mpm_ctx);
+    mpm_table[ac_test_matcher].Prepare(&mpm_ctx);
 
     const char *buf = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
-    uint32_t cnt = SCACSearch(&mpm_ctx, &mpm_thread_ctx, &pmq,
+    uint32_t cnt = mpm_table[ac_test_matcher].Search(&mpm_ctx, &mpm_thread_ctx, &pmq,
                                (uint8_t *)buf, strlen(buf));
 
     if (cnt == 3)
@@ -2081,8 +2068,8 @@ static int SCACTest25(void)
     else
         printf("3 != %" PRIu32 " ",cnt);
 
-    SCACDestroyCtx(&mpm_ctx);
-    SCACDestroyThreadCtx(&mpm_ctx, &mpm_thread_ctx);
+    mpm_table[ac_test_matcher].DestroyCtx(&mpm_ctx);
+    mpm_table[ac_test_matcher].DestroyThreadCtx(&mpm_ctx, &mpm_thread_ctx);
     PmqFree(&pmq);
     return result;
 }
@@ -2096,17 +2083,17 @@ static int SCACTest26(void)
 
     memset(&mpm_ctx, 0x00, sizeof(MpmCtx));
     memset(&mpm_thread_ctx, 0, sizeof(MpmThreadCtx));
-    MpmInitCtx(&mpm_ctx, MPM_AC);
-    SCACInitThreadCtx(&mpm_ctx, &mpm_thread_ctx);
+    MpmInitCtx(&mpm_ctx, ac_test_matcher);
+    mpm_table[ac_test_matcher].InitThreadCtx(&mpm_ctx, &mpm_thread_ctx);
 
     MpmAddPatternCI(&mpm_ctx, (uint8_t *)"Works", 5, 0, 0, 0, 0, 0);
     MpmAddPatternCS(&mpm_ctx, (uint8_t *)"Works", 5, 0, 0, 1, 0, 0);
     PmqSetup(&pmq);
 
-    SCACPreparePatterns(&mpm_ctx);
+    mpm_table[ac_test_matcher].Prepare(&mpm_ctx);
 
     const char *buf = "works";
-    uint32_t cnt = SCACSearch(&mpm_ctx, &mpm_thread_ctx, &pmq,
+    uint32_t cnt = mpm_table[ac_test_matcher].Search(&mpm_ctx, &mpm_thread_ctx, &pmq,
                                (uint8_t *)buf, strlen(buf));
 
     if (cnt == 1)
@@ -2114,8 +2101,8 @@ static int SCACTest26(void)
     else
         printf("3 != %" PRIu32 " ",cnt);
 
-    SCACDestroyCtx(&mpm_ctx);
-    SCACDestroyThreadCtx(&mpm_ctx, &mpm_thread_ctx);
+    mpm_table[ac_test_matcher].DestroyCtx(&mpm_ctx);
+    mpm_table[ac_test_matcher].DestroyThreadCtx(&mpm_ctx, &mpm_thread_ctx);
     PmqFree(&pmq);
     return result;
 }
@@ -2129,17 +2116,17 @@ static int SCACTest27(void)
 
     memset(&mpm_ctx, 0, sizeof(MpmCtx));
     memset(&mpm_thread_ctx, 0, sizeof(MpmThreadCtx));
-    MpmInitCtx(&mpm_ctx, MPM_AC);
-    SCACInitThreadCtx(&mpm_ctx, &mpm_thread_ctx);
+    MpmInitCtx(&mpm_ctx, ac_test_matcher);
+    mpm_table[ac_test_matcher].InitThreadCtx(&mpm_ctx, &mpm_thread_ctx);
 
     /* 0 match */
     MpmAddPatternCS(&mpm_ctx, (uint8_t *)"ONE", 3, 0, 0, 0, 0, 0);
     PmqSetup(&pmq);
 
-    SCACPreparePatterns(&mpm_ctx);
+    mpm_table[ac_test_matcher].Prepare(&mpm_ctx);
 
     const char *buf = "tone";
-    uint32_t cnt = SCACSearch(&mpm_ctx, &mpm_thread_ctx, &pmq,
+    uint32_t cnt = mpm_table[ac_test_matcher].Search(&mpm_ctx, &mpm_thread_ctx, &pmq,
                                (uint8_t *)buf, strlen(buf));
 
     if (cnt == 0)
@@ -2147,8 +2134,8 @@ static int SCACTest27(void)
     else
         printf("0 != %" PRIu32 " ",cnt);
 
-    SCACDestroyCtx(&mpm_ctx);
-    SCACDestroyThreadCtx(&mpm_ctx, &mpm_thread_ctx);
+    mpm_table[ac_test_matcher].DestroyCtx(&mpm_ctx);
+    mpm_table[ac_test_matcher].DestroyThreadCtx(&mpm_ctx, &mpm_thread_ctx);
     PmqFree(&pmq);
     return result;
 }
@@ -2162,17 +2149,17 @@ static int SCACTest28(void)
 
     memset(&mpm_ctx, 0, sizeof(MpmCtx));
     memset(&mpm_thread_ctx, 0, sizeof(MpmThreadCtx));
-    MpmInitCtx(&mpm_ctx, MPM_AC);
-    SCACInitThreadCtx(&mpm_ctx, &mpm_thread_ctx);
+    MpmInitCtx(&mpm_ctx, ac_test_matcher);
+    mpm_table[ac_test_matcher].InitThreadCtx(&mpm_ctx, &mpm_thread_ctx);
 
     /* 0 match */
     MpmAddPatternCS(&mpm_ctx, (uint8_t *)"one", 3, 0, 0, 0, 0, 0);
     PmqSetup(&pmq);
 
-    SCACPreparePatterns(&mpm_ctx);
+    mpm_table[ac_test_matcher].Prepare(&mpm_ctx);
 
     const char *buf = "tONE";
-    uint32_t cnt = SCACSearch(&mpm_ctx, &mpm_thread_ctx, &pmq,
+    uint32_t cnt = mpm_table[ac_test_matcher].Search(&mpm_ctx, &mpm_thread_ctx, &pmq,
                                (uint8_t *)buf, strlen(buf));
 
     if (cnt == 0)
@@ -2180,8 +2167,8 @@ static int SCACTest28(void)
     else
         printf("0 != %" PRIu32 " ",cnt);
 
-    SCACDestroyCtx(&mpm_ctx);
-    SCACDestroyThreadCtx(&mpm_ctx, &mpm_thread_ctx);
+    mpm_table[ac_test_matcher].DestroyCtx(&mpm_ctx);
+    mpm_table[ac_test_matcher].DestroyThreadCtx(&mpm_ctx, &mpm_thread_ctx);
     PmqFree(&pmq);
     return result;
 }
@@ -2240,6 +2227,44 @@ end:
     return result;
 }
 
+/* the pattern tests again, with the ac-simd matcher */
+#define SCAC_SIMD_TEST(n)                                                                          \
+    static int SCACSimdPatternTest##n(void)                                                        \
+    {                                                                                              \
+        ac_test_matcher = MPM_AC_SIMD;                                                             \
+        int r = SCACTest##n();                                                                     \
+        ac_test_matcher = MPM_AC;                                                                  \
+        return r;                                                                                  \
+    }
+SCAC_SIMD_TEST(01)
+SCAC_SIMD_TEST(02)
+SCAC_SIMD_TEST(03)
+SCAC_SIMD_TEST(04)
+SCAC_SIMD_TEST(05)
+SCAC_SIMD_TEST(06)
+SCAC_SIMD_TEST(07)
+SCAC_SIMD_TEST(08)
+SCAC_SIMD_TEST(09)
+SCAC_SIMD_TEST(10)
+SCAC_SIMD_TEST(11)
+SCAC_SIMD_TEST(12)
+SCAC_SIMD_TEST(13)
+SCAC_SIMD_TEST(14)
+SCAC_SIMD_TEST(15)
+SCAC_SIMD_TEST(16)
+SCAC_SIMD_TEST(17)
+SCAC_SIMD_TEST(18)
+SCAC_SIMD_TEST(19)
+SCAC_SIMD_TEST(20)
+SCAC_SIMD_TEST(21)
+SCAC_SIMD_TEST(22)
+SCAC_SIMD_TEST(23)
+SCAC_SIMD_TEST(24)
+SCAC_SIMD_TEST(25)
+SCAC_SIMD_TEST(26)
+SCAC_SIMD_TEST(27)
+SCAC_SIMD_TEST(28)
+
 #endif /* UNITTESTS */
 
 void SCACRegisterTests(void)
@@ -2275,6 +2300,35 @@ void SCACRegisterTests(void)
     UtRegisterTest("SCACTest27", SCACTest27);
     UtRegisterTest("SCACTest28", SCACTest28);
     UtRegisterTest("SCACTest29", SCACTest29);
+
+    UtRegisterTest("SCACSimdPatternTest01", SCACSimdPatternTest01);
+    UtRegisterTest("SCACSimdPatternTest02", SCACSimdPatternTest02);
+    UtRegisterTest("SCACSimdPatternTest03", SCACSimdPatternTest03);
+    UtRegisterTest("SCACSimdPatternTest04", SCACSimdPatternTest04);
+    UtRegisterTest("SCACSimdPatternTest05", SCACSimdPatternTest05);
+    UtRegisterTest("SCACSimdPatternTest06", SCACSimdPatternTest06);
+    UtRegisterTest("SCACSimdPatternTest07", SCACSimdPatternTest07);
+    UtRegisterTest("SCACSimdPatternTest08", SCACSimdPatternTest08);
+    UtRegisterTest("SCACSimdPatternTest09", SCACSimdPatternTest09);
+    UtRegisterTest("SCACSimdPatternTest10", SCACSimdPatternTest10);
+    UtRegisterTest("SCACSimdPatternTest11", SCACSimdPatternTest11);
+    UtRegisterTest("SCACSimdPatternTest12", SCACSimdPatternTest12);
+    UtRegisterTest("SCACSimdPatternTest13", SCACSimdPatternTest13);
+    UtRegisterTest("SCACSimdPatternTest14", SCACSimdPatternTest14);
+    UtRegisterTest("SCACSimdPatternTest15", SCACSimdPatternTest15);
+    UtRegisterTest("SCACSimdPatternTest16", SCACSimdPatternTest16);
+    UtRegisterTest("SCACSimdPatternTest17", SCACSimdPatternTest17);
+    UtRegisterTest("SCACSimdPatternTest18", SCACSimdPatternTest18);
+    UtRegisterTest("SCACSimdPatternTest19", SCACSimdPatternTest19);
+    UtRegisterTest("SCACSimdPatternTest20", SCACSimdPatternTest20);
+    UtRegisterTest("SCACSimdPatternTest21", SCACSimdPatternTest21);
+    UtRegisterTest("SCACSimdPatternTest22", SCACSimdPatternTest22);
+    UtRegisterTest("SCACSimdPatternTest23", SCACSimdPatternTest23);
+    UtRegisterTest("SCACSimdPatternTest24", SCACSimdPatternTest24);
+    UtRegisterTest("SCACSimdPatternTest25", SCACSimdPatternTest25);
+    UtRegisterTest("SCACSimdPatternTest26", SCACSimdPatternTest26);
+    UtRegisterTest("SCACSimdPatternTest27", SCACSimdPatternTest27);
+    UtRegisterTest("SCACSimdPatternTest28", SCACSimdPatternTest28);
 #endif
 
     return;
@@ -30,6 +30,11 @@
 #define SC_AC_STATE_TYPE_U16 uint16_t
 #define SC_AC_STATE_TYPE_U32 uint32_t
 
+/* pids in the output table, case sensitive ones have the top bit set */
+#define AC_CASE_MASK    0x80000000
+#define AC_PID_MASK     0x7FFFFFFF
+#define AC_CASE_BIT     31
+
 typedef struct SCACPatternList_ {
     uint8_t *cs;
     uint16_t patlen;
@@ -86,4 +91,18 @@ typedef struct SCACThreadCtx_ {
 
 void MpmACRegister(void);
 
+/* used by the ac-simd variant, which walks the same tables */
+void SCACInitThreadCtx(MpmCtx *, MpmThreadCtx *);
+void SCACDestroyCtx(MpmCtx *);
+void SCACDestroyThreadCtx(MpmCtx *, MpmThreadCtx *);
+int SCACAddPatternCI(MpmCtx *, uint8_t *, uint16_t, uint16_t, uint16_t,
+                     uint32_t, SigIntId, uint8_t);
+int SCACAddPatternCS(MpmCtx *, uint8_t *, uint16_t, uint16_t, uint16_t,
+                     uint32_t, SigIntId, uint8_t);
+int SCACPreparePatterns(MpmCtx *mpm_ctx);
+uint32_t SCACSearch(const MpmCtx *mpm_ctx, MpmThreadCtx *mpm_thread_ctx,
+                    PrefilterRuleStore *pmq, const uint8_t *buf, uint32_t buflen);
+void SCACPrintInfo(MpmCtx *mpm_ctx);
+void SCACPrintSearchStats(MpmThreadCtx *mpm_thread_ctx);
+
 #endif /* __UTIL_MPM_AC__H__ */
@@ -42,6 +42,10 @@
 #include "util-hash.h"
 #include "util-hash-lookup3.h"
 #include "util-hyperscan.h"
+#include "util-file.h"
+#include "util-path.h"
+#include "counters.h"
+#include "rust.h"
 
 #ifdef BUILD_HYPERSCAN
 
@@ -68,6 +72,9 @@ void SCHSRegisterTests(void);
 /* Initial size of the global database hash (used for de-duplication). */
 #define INIT_DB_HASH_SIZE 1000
 
+/* Default location of the on-disk database cache. */
+#define SCHS_CACHE_DEFAULT_PATH LOCAL_STATE_DIR "/lib/suricata/cache/sgh"
+
 /* Global prototype scratch, built incrementally as Hyperscan databases are
  * built and then cloned for each thread context. Access is serialised via
  * g_scratch_proto_mutex. */
@@ -79,6 +86,12 @@ static SCMutex g_scratch_proto_mutex = SCMUTEX_INITIALIZER;
 static HashTable *g_db_table = NULL;
 static SCMutex g_db_table_mutex = SCMUTEX_INITIALIZER;
 
+/* Global hash table of compiled Hyperscan databases keyed on the compiled
+ * patterns only, shared by pattern databases whose sids differ, such as the
+ * groups of an engine being reloaded and of its replacement. Access is
+ * serialised via g_db_table_mutex. */
+static HashTable *g_compiled_table = NULL;
+
 /**
  * \internal
  * \brief Wraps SCMalloc (which is a macro) so that it can be passed to
@@ -449,6 +462,19 @@ static void SCHSFreeCompileData(SCHSCompileData *cd)
     SCFree(cd);
 }
 
+#define SCHS_CACHE_KEY_LEN (SC_SHA256_LEN * 2 + 1)
+
+/* Compiled Hyperscan database, shared between pattern databases with the same
+ * patterns in the same order. */
+typedef struct SCHSCompiledDb_ {
+    /* hex SHA-256 over the compiled pattern properties, see SCHSCacheKey */
+    char key[SCHS_CACHE_KEY_LEN];
+    hs_database_t *hs_db;
+
+    /* Reference count: number of pattern databases using this database. */
+    uint32_t ref_cnt;
+} SCHSCompiledDb;
+
 typedef struct PatternDatabase_ {
     SCHSPattern **parray;
     hs_database_t *hs_db;
@@ -456,8 +482,46 @@ typedef struct PatternDatabase_ {
 
     /* Reference count: number of MPM contexts using this pattern database. */
     uint32_t ref_cnt;
+
+    /* shared owner of hs_db, NULL if hs_db is owned by this database */
+    SCHSCompiledDb *compiled;
 } PatternDatabase;
 
+static uint32_t SCHSCompiledDbHash(HashTable *ht, void *data, uint16_t len)
+{
+    const SCHSCompiledDb *cdb = data;
+    return hashlittle_safe(cdb->key, strlen(cdb->key), 0) % ht->array_size;
+}
+
+static char SCHSCompiledDbCompare(void *data1, uint16_t len1, void *data2, uint16_t len2)
+{
+    const SCHSCompiledDb *cdb1 = data1;
+    const SCHSCompiledDb *cdb2 = data2;
+    return strcmp(cdb1->key, cdb2->key) == 0;
+}
+
+static void SCHSCompiledDbTableFree(void *data)
+{
+    /* Stub function handed to hash table; compiled databases are freed when
+     * the last pattern database using them is freed. */
+}
+
+/** \internal
+ *  \brief Drop a reference to a shared compiled database.
+ *
+ *  Must be called with g_db_table_mutex held.
+ */
+static void SCHSCompiledDbRelease(SCHSCompiledDb *cdb)
+{
+    BUG_ON(cdb->ref_cnt == 0);
+    cdb->ref_cnt--;
+    if (cdb->ref_cnt == 0) {
+        HashTableRemove(g_compiled_table, cdb, 1);
+        hs_free_database(cdb->hs_db);
+        SCFree(cdb);
+    }
+}
+
 static uint32_t SCHSPatternHash(const SCHSPattern *p, uint32_t hash)
 {
     BUG_ON(p->original_pat == NULL);
@@ -543,7 +607,11 @@ static void PatternDatabaseFree(PatternDatabase *pd)
         SCFree(pd->parray);
     }
 
-    hs_free_database(pd->hs_db);
+    if (pd->compiled != NULL) {
+        SCHSCompiledDbRelease(pd->compiled);
+    } else {
+        hs_free_database(pd->hs_db);
+    }
 
     SCFree(pd);
 }
@@ -577,6 +645,275 @@ static PatternDatabase *PatternDatabaseAlloc(uint32_t pattern_cnt)
     return pd;
 }
 
+/**
+ * \brief On-disk cache of compiled Hyperscan databases.
+ *
+ * Databases are stored in serialized form in the directory set by
+ * detect.sgh-mpm-caching-path, one file per database named after a SHA-256
+ * over the Hyperscan version, the host platform and the patterns in database
+ * order. Entries that no longer deserialize, e.g. after a Hyperscan upgrade
+ * or on a different CPU, are counted as stale and replaced.
+ */
+#define SCHS_CACHE_VERSION 1
+
+static bool g_cache_configured = false;
+static char *g_cache_dir = NULL;
+
+static SC_ATOMIC_DECLARE(uint64_t, g_cache_hits);
+static SC_ATOMIC_DECLARE(uint64_t, g_cache_misses);
+static SC_ATOMIC_DECLARE(uint64_t, g_cache_stale);
+static SC_ATOMIC_DECLARE(uint64_t, g_cache_shared);
+
+/** \internal
+ *  \brief Read the cache settings, called once under g_db_table_mutex. */
+static void SCHSCacheConfigure(void)
+{
+    int enabled = 0;
+    const char *path = NULL;
+
+    g_cache_configured = true;
+    if (ConfGetBool("detect.sgh-mpm-caching", &enabled) != 1 || !enabled) {
+        return;
+    }
+    if (ConfGet("detect.sgh-mpm-caching-path", &path) != 1 || path == NULL) {
+        path = SCHS_CACHE_DEFAULT_PATH;
+    }
+    if (SCCreateDirectoryTree(path, true) != 0) {
+        SCLogWarning("unable to create mpm cache directory %s, caching disabled", path);
+        return;
+    }
+    g_cache_dir = SCStrdup(path);
+    if (g_cache_dir == NULL) {
+        return;
+    }
+    SCLogConfig("caching Hyperscan databases in %s", g_cache_dir);
+}
+
+/** \internal
+ *  \brief Compute the key of the compiled form of a pattern database.
+ *
+ *  Used both for sharing compiled databases in memory and as the cache file
+ *  name.
+ *
+ *  Only the pattern properties that end up in the Hyperscan database are
+ *  hashed, so databases differing only in sids share an entry. The pattern
+ *  order matters as the array index is the Hyperscan expression id.
+ */
+static int SCHSCacheKey(const PatternDatabase *pd, char *key, size_t key_len)
+{
+    hs_platform_info_t plat;
+    if (hs_populate_platform(&plat) != HS_SUCCESS) {
+        return -1;
+    }
+
+    SCSha256 *hasher = SCSha256New();
+    if (hasher == NULL) {
+        return -1;
+    }
+    const uint32_t version = SCHS_CACHE_VERSION;
+    const char *hs_ver = hs_version();
+    SCSha256Update(hasher, (const uint8_t *)&version, sizeof(version));
+    SCSha256Update(hasher, (const uint8_t *)hs_ver, (uint32_t)strlen(hs_ver));
+    SCSha256Update(hasher, (const uint8_t *)&plat.tune, sizeof(plat.tune));
+    SCSha256Update(hasher, (const uint8_t *)&plat.cpu_features, sizeof(plat.cpu_features));
+    SCSha256Update(hasher, (const uint8_t *)&pd->pattern_cnt, sizeof(pd->pattern_cnt));
+
+    for (uint32_t i = 0; i < pd->pattern_cnt; i++) {
+        const SCHSPattern *p = pd->parray[i];
+        const uint8_t flags = p->flags & (MPM_PATTERN_FLAG_NOCASE | MPM_PATTERN_FLAG_OFFSET |
+                                                 MPM_PATTERN_FLAG_DEPTH);
+        SCSha256Update(hasher, (const uint8_t *)&p->len, sizeof(p->len));
+        SCSha256Update(hasher, &flags, sizeof(flags));
+        SCSha256Update(hasher, (const uint8_t *)&p->offset, sizeof(p->offset));
+        SCSha256Update(hasher, (const uint8_t *)&p->depth, sizeof(p->depth));
+        SCSha256Update(hasher, p->original_pat, p->len);
+    }
+
+    SCSha256FinalizeToHex(hasher, key, (uint32_t)key_len);
+    return 0;
+}
+
+static int SCHSCachePath(char *path, size_t path_len, const char *key)
+{
+    int r = snprintf(path, path_len, "%s/%s.hs", g_cache_dir, key);
+    return (r < 0 || (size_t)r >= path_len) ? -1 : 0;
+}
+
+/** \internal
+ *  \brief Load a database from the cache into pd->hs_db.
+ *
+ *  \retval 0 on hit, -1 on miss or stale entry
+ */
+static int SCHSCacheLoad(PatternDatabase *pd, const char *key)
+{
+    char path[PATH_MAX];
+    if (SCHSCachePath(path, sizeof(path), key) != 0) {
+        return -1;
+    }
+
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL) {
+        (void)SC_ATOMIC_ADD(g_cache_misses, 1);
+        return -1;
+    }
+
+    char *bytes = NULL;
+    hs_database_t *db = NULL;
+    struct stat st;
+    if (fstat(fileno(fp), &st) != 0 || st.st_size <= 0) {
+        goto stale;
+    }
+    bytes = SCMalloc((size_t)st.st_size);
+    if (bytes == NULL) {
+        fclose(fp);
+        return -1;
+    }
+    if (fread(bytes, 1, (size_t)st.st_size, fp) != (size_t)st.st_size) {
+        goto stale;
+    }
+
+    size_t db_size = 0;
+    if (hs_serialized_database_size(bytes, (size_t)st.st_size, &db_size) != HS_SUCCESS) {
+        goto stale;
+    }
+    db = SCMalloc(db_size);
+    if (db == NULL) {
+        SCFree(bytes);
+        fclose(fp);
+        return -1;
+    }
+    hs_error_t err = hs_deserialize_database_at(bytes, (size_t)st.st_size, db);
+    if (err != HS_SUCCESS) {
+        SCLogDebug("cached database %s rejected: %d", path, err);
+        goto stale;
+    }
+
+    SCFree(bytes);
+    fclose(fp);
+    pd->hs_db = db;
+    (void)SC_ATOMIC_ADD(g_cache_hits, 1);
+    SCLogDebug("loaded %" PRIu32 " patterns from %s", pd->pattern_cnt, path);
+    return 0;
+
+stale:
+    (void)SC_ATOMIC_ADD(g_cache_stale, 1);
+    SCFree(db);
+    SCFree(bytes);
+    fclose(fp);
+    return -1;
+}
+
+/** \internal
+ *  \brief Store a compiled database in the cache.
+ *
+ *  The file is written under a per thread temporary name and renamed into
+ *  place so concurrent readers never see a partial entry. Failures only
+ *  cost a recompile on the next start and are not fatal.
+ */
+static void SCHSCacheSave(const PatternDatabase *pd, const char *key)
+{
+    char path[PATH_MAX];
+    char tmp_path[PATH_MAX];
+    if (SCHSCachePath(path, sizeof(path), key) != 0 ||
+            snprintf(tmp_path, sizeof(tmp_path), "%s.%d.%lu.tmp", path, (int)getpid(),
+                    SCGetThreadIdLong()) >=
+                    (int)sizeof(tmp_path)) {
+        return;
+    }
+
+    char *bytes = NULL;
+    size_t len = 0;
+    if (hs_serialize_database(pd->hs_db, &bytes, &len) != HS_SUCCESS) {
+        SCLogWarning("failed to serialize Hyperscan database");
+        return;
+    }
+
+    FILE *fp = fopen(tmp_path, "wb");
+    if (fp == NULL) {
+        SCLogWarning("failed to open mpm cache file %s: %s", tmp_path, strerror(errno));
+        SCFree(bytes);
+        return;
+    }
+    bool ok = fwrite(bytes, 1, len, fp) == len;
+    ok = (fclose(fp) == 0) && ok;
+    SCFree(bytes);
+
+    if (!ok || rename(tmp_path, path) != 0) {
+        SCLogWarning("failed to write mpm cache file %s: %s", path, strerror(errno));
+        unlink(tmp_path);
+    }
+}
+
+static uint64_t SCHSCacheSharedCounter(void)
+{
+    return SC_ATOMIC_GET(g_cache_shared);
+}
+
+static uint64_t SCHSCacheHitsCounter(void)
+{
+    return SC_ATOMIC_GET(g_cache_hits);
+}
+
+static uint64_t SCHSCacheMissesCounter(void)
+{
+    return SC_ATOMIC_GET(g_cache_misses);
+}
+
+static uint64_t SCHSCacheStaleCounter(void)
+{
+    return SC_ATOMIC_GET(g_cache_stale);
+}
+
+/** \internal
+ *  \brief Compile the patterns of pd into pd->hs_db. */
+static int SCHSCompilePatternDatabase(PatternDatabase *pd, SCHSCompileData *cd)
+{
+    hs_compile_error_t *compile_err = NULL;
+
+    for (uint32_t i = 0; i < pd->pattern_cnt; i++) {
+        const SCHSPattern *p = pd->parray[i];
+
+        cd->ids[i] = i;
+        cd->flags[i] = HS_FLAG_SINGLEMATCH;
+        if (p->flags & MPM_PATTERN_FLAG_NOCASE) {
+            cd->flags[i] |= HS_FLAG_CASELESS;
+        }
+
+        cd->expressions[i] = HSRenderPattern(p->original_pat, p->len);
+
+        if (p->flags & (MPM_PATTERN_FLAG_OFFSET | MPM_PATTERN_FLAG_DEPTH)) {
+            cd->ext[i] = SCMalloc(sizeof(hs_expr_ext_t));
+            if (cd->ext[i] == NULL) {
+                return -1;
+            }
+            memset(cd->ext[i], 0, sizeof(hs_expr_ext_t));
+
+            if (p->flags & MPM_PATTERN_FLAG_OFFSET) {
+                cd->ext[i]->flags |= HS_EXT_FLAG_MIN_OFFSET;
+                cd->ext[i]->min_offset = p->offset + p->len;
+            }
+            if (p->flags & MPM_PATTERN_FLAG_DEPTH) {
+                cd->ext[i]->flags |= HS_EXT_FLAG_MAX_OFFSET;
+                cd->ext[i]->max_offset = p->offset + p->depth;
+            }
+        }
+    }
+
+    hs_error_t err = hs_compile_ext_multi((const char *const *)cd->expressions, cd->flags,
+            cd->ids, (const hs_expr_ext_t *const *)cd->ext, cd->pattern_cnt, HS_MODE_BLOCK, NULL,
+            &pd->hs_db, &compile_err);
+
+    if (err != HS_SUCCESS) {
+        SCLogError("failed to compile hyperscan database");
+        if (compile_err) {
+            SCLogError("compile error: %s", compile_err->message);
+        }
+        hs_free_compile_error(compile_err);
+        return -1;
+    }
+    return 0;
+}
+
 /**
  * \brief Process the patterns added to the mpm, and create the internal tables.
  *
@@ -592,7 +929,6 @@ int SCHSPreparePatterns(MpmCtx *mpm_ctx)
     }
 
     hs_error_t err;
-    hs_compile_error_t *compile_err = NULL;
     SCHSCompileData *cd = NULL;
     PatternDatabase *pd = NULL;
 
@@ -621,8 +957,8 @@ int SCHSPreparePatterns(MpmCtx *mpm_ctx)
     SCFree(ctx->init_hash);
     ctx->init_hash = NULL;
 
-    /* Serialise whole database compilation as a relatively easy way to ensure
-     * dedupe is safe. */
+    /* The lookups and table updates are done under the lock, the compile
+     * itself is not so rule groups can be compiled in parallel. */
     SCMutexLock(&g_db_table_mutex);
 
     /* Init global pattern database hash if necessary. */
@@ -654,52 +990,90 @@ int SCHSPreparePatterns(MpmCtx *mpm_ctx)
     }
 
     BUG_ON(ctx->pattern_db != NULL); /* already built? */
+    BUG_ON(mpm_ctx->pattern_cnt == 0);
 
-    for (uint32_t i = 0; i < pd->pattern_cnt; i++) {
-        const SCHSPattern *p = pd->parray[i];
+    if (!g_cache_configured) {
+        SCHSCacheConfigure();
+    }
 
-        cd->ids[i] = i;
-        cd->flags[i] = HS_FLAG_SINGLEMATCH;
-        if (p->flags & MPM_PATTERN_FLAG_NOCASE) {
-            cd->flags[i] |= HS_FLAG_CASELESS;
+    /* Databases only differing in sids, e.g. after a rule reload that
+     * renumbered the signatures, share the compiled Hyperscan database. */
+    if (g_compiled_table == NULL) {
+        g_compiled_table = HashTableInit(INIT_DB_HASH_SIZE, SCHSCompiledDbHash,
+                SCHSCompiledDbCompare, SCHSCompiledDbTableFree);
+        if (g_compiled_table == NULL) {
+            SCMutexUnlock(&g_db_table_mutex);
+            goto error;
         }
+    }
 
-        cd->expressions[i] = HSRenderPattern(p->original_pat, p->len);
+    SCHSCompiledDb lookup;
+    if (SCHSCacheKey(pd, lookup.key, sizeof(lookup.key)) != 0) {
+        lookup.key[0] = '\0';
+    }
+    SCHSCompiledDb *cdb = NULL;
+    if (lookup.key[0] != '\0') {
+        cdb = HashTableLookup(g_compiled_table, &lookup, 1);
+    }
 
-        if (p->flags & (MPM_PATTERN_FLAG_OFFSET | MPM_PATTERN_FLAG_DEPTH)) {
-            cd->ext[i] = SCMalloc(sizeof(hs_expr_ext_t));
-            if (cd->ext[i] == NULL) {
-                SCMutexUnlock(&g_db_table_mutex);
-                goto error;
-            }
-            memset(cd->ext[i], 0, sizeof(hs_expr_ext_t));
+    if (cdb != NULL) {
+        SCLogDebug("Sharing compiled database %p (ref_cnt=%" PRIu32 ")", cdb->hs_db,
+                cdb->ref_cnt);
+        (void)SC_ATOMIC_ADD(g_cache_shared, 1);
+        cdb->ref_cnt++;
+        pd->compiled = cdb;
+        pd->hs_db = cdb->hs_db;
+    }
+    const bool use_disk = g_cache_dir != NULL && lookup.key[0] != '\0';
+    SCMutexUnlock(&g_db_table_mutex);
 
-            if (p->flags & MPM_PATTERN_FLAG_OFFSET) {
-                cd->ext[i]->flags |= HS_EXT_FLAG_MIN_OFFSET;
-                cd->ext[i]->min_offset = p->offset + p->len;
+    if (pd->compiled == NULL) {
+        if (!use_disk || SCHSCacheLoad(pd, lookup.key) != 0) {
+            if (SCHSCompilePatternDatabase(pd, cd) != 0) {
+                goto error;
             }
-            if (p->flags & MPM_PATTERN_FLAG_DEPTH) {
-                cd->ext[i]->flags |= HS_EXT_FLAG_MAX_OFFSET;
-                cd->ext[i]->max_offset = p->offset + p->depth;
+            if (use_disk) {
+                SCHSCacheSave(pd, lookup.key);
             }
         }
     }
 
-    BUG_ON(mpm_ctx->pattern_cnt == 0);
-
-    err = hs_compile_ext_multi((const char *const *)cd->expressions, cd->flags,
-                               cd->ids, (const hs_expr_ext_t *const *)cd->ext,
-                               cd->pattern_cnt, HS_MODE_BLOCK, NULL, &pd->hs_db,
-                               &compile_err);
+    SCMutexLock(&g_db_table_mutex);
 
-    if (err != HS_SUCCESS) {
-        SCLogError("failed to compile hyperscan database");
-        if (compile_err) {
-            SCLogError("compile error: %s", compile_err->message);
+    if (pd->compiled == NULL && lookup.key[0] != '\0') {
+        /* the same database may have been compiled by another thread
+         * while we didn't hold the lock */
+        cdb = HashTableLookup(g_compiled_table, &lookup, 1);
+        if (cdb != NULL) {
+            (void)SC_ATOMIC_ADD(g_cache_shared, 1);
+            hs_free_database(pd->hs_db);
+            cdb->ref_cnt++;
+            pd->compiled = cdb;
+            pd->hs_db = cdb->hs_db;
+        } else {
+            cdb = SCCalloc(1, sizeof(*cdb));
+            if (cdb != NULL) {
+                memcpy(cdb->key, lookup.key, sizeof(cdb->key));
+                cdb->hs_db = pd->hs_db;
+                if (HashTableAdd(g_compiled_table, cdb, 1) == 0) {
+                    cdb->ref_cnt = 1;
+                    pd->compiled = cdb;
+                } else {
+                    SCFree(cdb);
+                }
+            }
         }
-        hs_free_compile_error(compile_err);
+    }
+
+    /* same for the pattern database itself */
+    pd_cached = HashTableLookup(g_db_table, pd, 1);
+    if (pd_cached != NULL) {
+        pd_cached->ref_cnt++;
+        ctx->pattern_db = pd_cached;
+        PatternDatabaseFree(pd);
         SCMutexUnlock(&g_db_table_mutex);
-        goto error;
+        SCHSFreeCompileData(cd);
+        return 0;
     }
 
     ctx->pattern_db = pd;
@@ -738,7 +1112,10 @@ int SCHSPreparePatterns(MpmCtx *mpm_ctx)
 
 error:
     if (pd) {
+        /* may drop a shared compiled database */
+        SCMutexLock(&g_db_table_mutex);
         PatternDatabaseFree(pd);
+        SCMutexUnlock(&g_db_table_mutex);
     }
     if (cd) {
         SCHSFreeCompileData(cd);
@@ -909,6 +1286,10 @@ static int SCHSMatchEvent(unsigned int id, unsigned long long from,
                cctx->match_count, (uint32_t)id, (uintmax_t)to, pat->id);
 
     PrefilterAddSids(pmq, pat->sids, pat->sids_size);
+    /* with offset or depth the first match reported may not be the first
+     * in the buffer */
+    if (pat->offset == 0 && pat->depth == 0)
+        PrefilterTrackOffset(pmq, pat->id, (uint32_t)to);
 
     cctx->match_count++;
     return 0;
@@ -1066,12 +1447,29 @@ void MpmHSRegister(void)
 
     /* Set Hyperscan memory allocators */
     SCHSSetAllocators();
+
+    SC_ATOMIC_INIT(g_cache_hits);
+    SC_ATOMIC_INIT(g_cache_misses);
+    SC_ATOMIC_INIT(g_cache_stale);
+    SC_ATOMIC_INIT(g_cache_shared);
+}
+
+/**
+ * \brief Register the on-disk database cache counters.
+ */
+void MpmHSRegisterGlobalCounters(void)
+{
+    StatsRegisterGlobalCounter("detect.mpm_cache.hits", SCHSCacheHitsCounter);
+    StatsRegisterGlobalCounter("detect.mpm_cache.misses", SCHSCacheMissesCounter);
+    StatsRegisterGlobalCounter("detect.mpm_cache.stale", SCHSCacheStaleCounter);
+    StatsRegisterGlobalCounter("detect.mpm_cache.shared", SCHSCacheSharedCounter);
 }
 
 /**
  * \brief Clean up global memory used by all Hyperscan MPM instances.
  *
- * Currently, this is just the global scratch prototype.
+ * This is the global scratch prototype, the database hash and the cache
+ * settings.
  */
 void MpmHSGlobalCleanup(void)
 {
@@ -1089,6 +1487,15 @@ void MpmHSGlobalCleanup(void)
         HashTableFree(g_db_table);
         g_db_table = NULL;
     }
+    if (g_compiled_table != NULL) {
+        HashTableFree(g_compiled_table);
+        g_compiled_table = NULL;
+    }
+    if (g_cache_dir != NULL) {
+        SCFree(g_cache_dir);
+        g_cache_dir = NULL;
+    }
+    g_cache_configured = false;
     SCMutexUnlock(&g_db_table_mutex);
 }
 
@@ -2145,6 +2552,91 @@ end:
     return result;
 }
 
+
+/** \test database round trip through the on-disk cache */
+static int SCHSTest30(void)
+{
+    char dir[] = "/tmp/suricata-hs-cache-XXXXXX";
+    FAIL_IF_NULL(mkdtemp(dir));
+
+    ConfCreateContextBackup();
+    ConfInit();
+    ConfSet("detect.sgh-mpm-caching", "yes");
+    ConfSet("detect.sgh-mpm-caching-path", dir);
+    MpmHSGlobalCleanup();
+
+    const uint64_t hits = SC_ATOMIC_GET(g_cache_hits);
+    const uint64_t misses = SC_ATOMIC_GET(g_cache_misses);
+    char key[SCHS_CACHE_KEY_LEN] = "";
+
+    for (int pass = 0; pass < 2; pass++) {
+        MpmCtx mpm_ctx;
+        MpmThreadCtx mpm_thread_ctx;
+        PrefilterRuleStore pmq;
+
+        memset(&mpm_ctx, 0, sizeof(MpmCtx));
+        memset(&mpm_thread_ctx, 0, sizeof(MpmThreadCtx));
+        MpmInitCtx(&mpm_ctx, MPM_HS);
+
+        MpmAddPatternCS(&mpm_ctx, (uint8_t *)"abcd", 4, 0, 0, 0, 0, 0);
+        MpmAddPatternCI(&mpm_ctx, (uint8_t *)"WXYZ", 4, 0, 0, 1, 1, 0);
+        PmqSetup(&pmq);
+
+        FAIL_IF(SCHSPreparePatterns(&mpm_ctx) != 0);
+        SCHSInitThreadCtx(&mpm_ctx, &mpm_thread_ctx);
+
+        const char *buf = "abcdefghjiklmnopqrstuvwxyz";
+        uint32_t cnt = SCHSSearch(&mpm_ctx, &mpm_thread_ctx, &pmq, (uint8_t *)buf, strlen(buf));
+        FAIL_IF(cnt != 2);
+
+        SCHSCtx *ctx = (SCHSCtx *)mpm_ctx.ctx;
+        FAIL_IF(SCHSCacheKey(ctx->pattern_db, key, sizeof(key)) != 0);
+
+        SCHSDestroyCtx(&mpm_ctx);
+        SCHSDestroyThreadCtx(&mpm_ctx, &mpm_thread_ctx);
+        PmqFree(&pmq);
+    }
+
+    FAIL_IF(SC_ATOMIC_GET(g_cache_misses) != misses + 1);
+    FAIL_IF(SC_ATOMIC_GET(g_cache_hits) != hits + 1);
+
+    char path[PATH_MAX];
+    FAIL_IF(SCHSCachePath(path, sizeof(path), key) != 0);
+    FAIL_IF(unlink(path) != 0);
+    FAIL_IF(rmdir(dir) != 0);
+
+    MpmHSGlobalCleanup();
+    ConfDeInit();
+    ConfRestoreContextBackup();
+    PASS;
+}
+
+/** \test databases differing only in sids share the compiled database */
+static int SCHSTest31(void)
+{
+    MpmCtx mpm_ctx1, mpm_ctx2;
+    memset(&mpm_ctx1, 0, sizeof(MpmCtx));
+    memset(&mpm_ctx2, 0, sizeof(MpmCtx));
+    MpmInitCtx(&mpm_ctx1, MPM_HS);
+    MpmInitCtx(&mpm_ctx2, MPM_HS);
+
+    MpmAddPatternCS(&mpm_ctx1, (uint8_t *)"abcd", 4, 0, 0, 0, 0, 0);
+    MpmAddPatternCS(&mpm_ctx2, (uint8_t *)"abcd", 4, 0, 0, 0, 7, 0);
+
+    const uint64_t shared = SC_ATOMIC_GET(g_cache_shared);
+    FAIL_IF(SCHSPreparePatterns(&mpm_ctx1) != 0);
+    FAIL_IF(SCHSPreparePatterns(&mpm_ctx2) != 0);
+
+    const PatternDatabase *pd1 = ((SCHSCtx *)mpm_ctx1.ctx)->pattern_db;
+    const PatternDatabase *pd2 = ((SCHSCtx *)mpm_ctx2.ctx)->pattern_db;
+    FAIL_IF(pd1 == pd2);
+    FAIL_IF(pd1->hs_db != pd2->hs_db);
+    FAIL_IF(SC_ATOMIC_GET(g_cache_shared) != shared + 1);
+
+    SCHSDestroyCtx(&mpm_ctx1);
+    SCHSDestroyCtx(&mpm_ctx2);
+    PASS;
+}
 #endif /* UNITTESTS */
 
 void SCHSRegisterTests(void)
@@ -2179,6 +2671,8 @@ void SCHSRegisterTests(void)
     UtRegisterTest("SCHSTest27", SCHSTest27);
     UtRegisterTest("SCHSTest28", SCHSTest28);
     UtRegisterTest("SCHSTest29", SCHSTest29);
+    UtRegisterTest("SCHSTest30", SCHSTest30);
+    UtRegisterTest("SCHSTest31", SCHSTest31);
 #endif
 
     return;
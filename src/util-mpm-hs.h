@@ -70,6 +70,7 @@ typedef struct SCHSThreadCtx_ {
 } SCHSThreadCtx;
 
 void MpmHSRegister(void);
+void MpmHSRegisterGlobalCounters(void);
 
 void MpmHSGlobalCleanup(void);
 
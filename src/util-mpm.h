@@ -36,6 +36,7 @@ enum {
     MPM_AC,
     MPM_AC_BS,
     MPM_AC_KS,
+    MPM_AC_SIMD,
     MPM_HS,
     /* table size */
     MPM_TABLE_SIZE,
@@ -0,0 +1,243 @@
+/* Copyright (C) 2026 Open Information Security Foundation
+ *
+ * You can copy, redistribute or modify this Program under the terms of
+ * the GNU General Public License version 2 as published by the Free
+ * Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/**
+ * \file
+ *
+ * NUMA node lookup and placement of per thread memory.
+ *
+ * A thread pinned to a single CPU records the node of that CPU. Pools that
+ * hand memory to such threads keep a list per node, and code allocating on
+ * behalf of another thread can steer the pages to that thread's node with
+ * UtilNumaSetPreferredNode. Placement uses libnuma, without it (no HAVE_NUMA),
+ * without threading.numa-aware or on single node systems all calls are no-ops
+ * and everything uses node 0.
+ */
+
+#include "suricata-common.h"
+#include "conf.h"
+#include "counters.h"
+#include "util-debug.h"
+#include "util-numa.h"
+
+#ifdef HAVE_NUMA
+#include <numa.h>
+#include <numaif.h>
+#endif
+
+static bool numa_enabled = false;
+static uint16_t numa_nodes = 1;
+
+typedef struct NumaNodeMemuse_ {
+    SC_ATOMIC_DECLARE(uint64_t, memuse);
+} NumaNodeMemuse;
+
+/** memory placed on each node by the NUMA aware pools */
+static NumaNodeMemuse numa_memuse[UTIL_NUMA_MAX_NODES];
+
+/** node of the cpu the thread is pinned to, -1 if not pinned */
+static thread_local int numa_thread_node = -1;
+/** node the thread currently allocates for, -1 for its own */
+static thread_local int numa_preferred_node = -1;
+
+static uint16_t UtilNumaDetectNodes(void)
+{
+#ifdef HAVE_NUMA
+    if (numa_available() < 0)
+        return 1;
+    const int max = numa_max_node();
+    if (max < 0 || max >= UINT16_MAX)
+        return 1;
+    return (uint16_t)(max + 1);
+#else
+    return 1;
+#endif
+}
+
+void UtilNumaInit(void)
+{
+    for (int n = 0; n < UTIL_NUMA_MAX_NODES; n++) {
+        SC_ATOMIC_INIT(numa_memuse[n].memuse);
+    }
+
+    numa_nodes = UtilNumaDetectNodes();
+    numa_enabled = numa_nodes > 1;
+
+    int enabled = 0;
+    if (ConfGetBool("threading.numa-aware", &enabled) == 1) {
+        if (enabled && numa_nodes == 1) {
+            SCLogConfig("threading.numa-aware: system has a single NUMA node");
+        }
+        numa_enabled = enabled && numa_nodes > 1;
+    }
+
+    if (numa_enabled) {
+        SCLogConfig("NUMA aware pools for %u nodes", numa_nodes);
+    }
+}
+
+bool UtilNumaEnabled(void)
+{
+    return numa_enabled;
+}
+
+/** \brief number of nodes with their own pools, 1 if disabled */
+uint16_t UtilNumaNodeCount(void)
+{
+    if (!numa_enabled)
+        return 1;
+    return MIN(numa_nodes, UTIL_NUMA_MAX_NODES);
+}
+
+/** \brief record the node of the calling thread
+ *
+ *  Called after pinning the thread to a single CPU.
+ */
+void UtilNumaThreadSetup(void)
+{
+#ifdef HAVE_NUMA
+    if (!numa_enabled)
+        return;
+    const int cpu = sched_getcpu();
+    if (cpu < 0)
+        return;
+    const int node = numa_node_of_cpu(cpu);
+    if (node >= 0) {
+        numa_thread_node = node;
+        SCLogDebug("thread on cpu %d, node %d", cpu, node);
+    }
+#endif
+}
+
+/** \brief node the calling thread was pinned to or -1 */
+int UtilNumaThreadGetPinnedNode(void)
+{
+    return numa_thread_node;
+}
+
+/** \brief node for memory allocated by the calling thread
+ *
+ *  The preferred node if set, otherwise the node the thread is pinned to.
+ *  Unpinned threads use node 0. Use UtilNumaNodeIndex to get its pool.
+ */
+uint16_t UtilNumaThreadNode(void)
+{
+    if (!numa_enabled)
+        return 0;
+
+    const int node = numa_preferred_node >= 0 ? numa_preferred_node : numa_thread_node;
+    if (node < 0)
+        return 0;
+    return (uint16_t)node;
+}
+
+/** \brief place new memory of the calling thread on a node
+ *
+ *  \param node node to allocate on, -1 to go back to the default local
+ *              allocation
+ */
+void UtilNumaSetPreferredNode(int node)
+{
+    if (!numa_enabled || node == numa_preferred_node)
+        return;
+
+#ifdef HAVE_NUMA
+    if (node < 0) {
+        numa_set_localalloc();
+    } else {
+        numa_set_preferred(node);
+    }
+#endif
+    numa_preferred_node = node;
+}
+
+/** \brief move the pages fully inside a range of memory to a node
+ *
+ *  numa_tonode_memory only sets the policy for pages that are not faulted
+ *  in yet, so use libnuma's mbind to also move the ones already touched.
+ */
+void UtilNumaBindMemory(void *addr, size_t len, uint16_t node)
+{
+    if (!numa_enabled || node >= sizeof(unsigned long) * 8)
+        return;
+
+#ifdef HAVE_NUMA
+    const uintptr_t page = (uintptr_t)sysconf(_SC_PAGESIZE);
+    const uintptr_t start = ((uintptr_t)addr + page - 1) & ~(page - 1);
+    const uintptr_t end = ((uintptr_t)addr + len) & ~(page - 1);
+    if (end <= start)
+        return;
+
+    const unsigned long mask = 1UL << node;
+    if (mbind((void *)start, end - start, MPOL_PREFERRED, &mask, sizeof(mask) * 8,
+                MPOL_MF_MOVE) != 0) {
+        SCLogDebug("mbind of %p/%" PRIuMAX " to node %u failed: %s", (void *)start,
+                (uintmax_t)(end - start), node, strerror(errno));
+    }
+#endif
+}
+
+void UtilNumaMemoryAdd(uint16_t node, uint64_t size)
+{
+    if (numa_enabled)
+        (void)SC_ATOMIC_ADD(numa_memuse[UtilNumaNodeIndex(node)].memuse, size);
+}
+
+void UtilNumaMemorySub(uint16_t node, uint64_t size)
+{
+    if (numa_enabled)
+        (void)SC_ATOMIC_SUB(numa_memuse[UtilNumaNodeIndex(node)].memuse, size);
+}
+
+#define NUMA_MEMUSE_COUNTER(n)                                                                     \
+    static uint64_t UtilNumaMemuseNode##n(void)                                                    \
+    {                                                                                              \
+        return SC_ATOMIC_GET(numa_memuse[n].memuse);                                               \
+    }
+
+NUMA_MEMUSE_COUNTER(0)
+NUMA_MEMUSE_COUNTER(1)
+NUMA_MEMUSE_COUNTER(2)
+NUMA_MEMUSE_COUNTER(3)
+NUMA_MEMUSE_COUNTER(4)
+NUMA_MEMUSE_COUNTER(5)
+NUMA_MEMUSE_COUNTER(6)
+NUMA_MEMUSE_COUNTER(7)
+
+static const struct {
+    const char *name;
+    uint64_t (*Func)(void);
+} numa_memuse_counters[UTIL_NUMA_MAX_NODES] = {
+    { "numa.node0.memuse", UtilNumaMemuseNode0 },
+    { "numa.node1.memuse", UtilNumaMemuseNode1 },
+    { "numa.node2.memuse", UtilNumaMemuseNode2 },
+    { "numa.node3.memuse", UtilNumaMemuseNode3 },
+    { "numa.node4.memuse", UtilNumaMemuseNode4 },
+    { "numa.node5.memuse", UtilNumaMemuseNode5 },
+    { "numa.node6.memuse", UtilNumaMemuseNode6 },
+    { "numa.node7.memuse", UtilNumaMemuseNode7 },
+};
+
+void UtilNumaRegisterGlobalCounters(void)
+{
+    if (!numa_enabled)
+        return;
+
+    for (uint16_t n = 0; n < UtilNumaNodeCount(); n++) {
+        StatsRegisterGlobalCounter(numa_memuse_counters[n].name, numa_memuse_counters[n].Func);
+    }
+}
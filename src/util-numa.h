@@ -0,0 +1,51 @@
+/* Copyright (C) 2026 Open Information Security Foundation
+ *
+ * You can copy, redistribute or modify this Program under the terms of
+ * the GNU General Public License version 2 as published by the Free
+ * Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/**
+ * \file
+ *
+ * NUMA node lookup and placement of per thread memory.
+ */
+
+#ifndef __UTIL_NUMA_H__
+#define __UTIL_NUMA_H__
+
+/** nodes with their own pools and counters, higher nodes share the last */
+#define UTIL_NUMA_MAX_NODES 8
+
+/** \brief index of the pools and counters of a node */
+static inline uint16_t UtilNumaNodeIndex(const uint16_t node)
+{
+    return MIN(node, UTIL_NUMA_MAX_NODES - 1);
+}
+
+void UtilNumaInit(void);
+void UtilNumaRegisterGlobalCounters(void);
+
+bool UtilNumaEnabled(void);
+uint16_t UtilNumaNodeCount(void);
+
+void UtilNumaThreadSetup(void);
+int UtilNumaThreadGetPinnedNode(void);
+uint16_t UtilNumaThreadNode(void);
+void UtilNumaSetPreferredNode(int node);
+void UtilNumaBindMemory(void *addr, size_t len, uint16_t node);
+
+void UtilNumaMemoryAdd(uint16_t node, uint64_t size);
+void UtilNumaMemorySub(uint16_t node, uint64_t size);
+
+#endif /* __UTIL_NUMA_H__ */
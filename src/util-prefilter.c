@@ -94,6 +94,36 @@ PrefilterAddSidsResize(PrefilterRuleStore *pmq, uint32_t new_size)
     return new_size;
 }
 
+/** \brief Setup the pattern offset tracking of a pmq
+ *
+ *  \param pmq Pattern matcher queue set up by PmqSetup
+ *  \param size number of pattern ids
+ *
+ *  \retval -1 error
+ *  \retval 0 ok
+ */
+int PmqSetupPatternOffsets(PrefilterRuleStore *pmq, uint32_t size)
+{
+    if (pmq == NULL || size == 0)
+        return -1;
+
+    pmq->pat_offsets = SCCalloc(size, sizeof(PrefilterPatternOffset));
+    if (pmq->pat_offsets == NULL)
+        return -1;
+    pmq->pat_offsets_size = size;
+    pmq->pat_gen = 0;
+    return 0;
+}
+
+/** \brief Clear the pattern offsets when the generation wraps around so
+ *         no old entry can match a new search. */
+void PrefilterPatternOffsetsWrap(PrefilterRuleStore *pmq)
+{
+    memset(pmq->pat_offsets, 0, pmq->pat_offsets_size * sizeof(PrefilterPatternOffset));
+    memset(pmq->pat_bufs, 0, sizeof(pmq->pat_bufs));
+    pmq->pat_gen = 1;
+}
+
 /** \brief Reset a Pmq for reusage. Meant to be called after a single search.
  *  \param pmq Pattern matcher to be reset.
  *  \todo memset is expensive, but we need it as we merge pmq's. We might use
@@ -118,6 +148,11 @@ void PmqCleanup(PrefilterRuleStore *pmq)
         SCFree(pmq->rule_id_array);
         pmq->rule_id_array = NULL;
     }
+    if (pmq->pat_offsets != NULL) {
+        SCFree(pmq->pat_offsets);
+        pmq->pat_offsets = NULL;
+        pmq->pat_offsets_size = 0;
+    }
 }
 
 /** \brief Cleanup and free a Pmq
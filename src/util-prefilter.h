@@ -26,6 +26,20 @@
 
 #include "util-debug.h"
 
+/** number of searched buffers for which the pattern offsets are kept */
+#define PREFILTER_TRACKED_BUFFERS 4
+
+typedef struct PrefilterPatternOffset_ {
+    uint32_t gen; /**< generation of the search that found the pattern */
+    uint32_t end; /**< end of the first match in the buffer */
+} PrefilterPatternOffset;
+
+typedef struct PrefilterTrackedBuffer_ {
+    const uint8_t *buf;
+    uint32_t buf_len;
+    uint32_t gen;
+} PrefilterTrackedBuffer;
+
 /** \brief structure for storing potential rule matches
  *
  *  Helper structure for the prefilter engine. The Pattern Matchers
@@ -41,6 +55,18 @@ typedef struct PrefilterRuleStore_ {
     /* The number of slots allocated for storing rule IDs */
     uint32_t rule_id_array_size;
 
+    /* End offset of the first match of each pattern id, only filled by
+     * mpm's that support it and only during a tracked search. */
+    PrefilterPatternOffset *pat_offsets;
+    /* Number of pattern ids in pat_offsets */
+    uint32_t pat_offsets_size;
+    /* Generation of the last tracked search */
+    uint32_t pat_gen;
+    /* Set while a tracked search is running */
+    bool pat_track;
+    /* Buffers of the last tracked searches, indexed by generation */
+    PrefilterTrackedBuffer pat_bufs[PREFILTER_TRACKED_BUFFERS];
+
 } PrefilterRuleStore;
 
 #define PMQ_RESET(pmq) (pmq)->rule_id_array_cnt = 0
@@ -82,7 +108,83 @@ PrefilterAddSids(PrefilterRuleStore *pmq, SigIntId *sids, uint32_t sids_size)
     pmq->rule_id_array_cnt += sids_size;
 }
 
+void PrefilterPatternOffsetsWrap(PrefilterRuleStore *pmq);
+
+/** \brief Start tracking the pattern offsets for a search of buf
+ *
+ *  The buffer must not change until the offsets are used or
+ *  PrefilterTrackReset is called.
+ */
+static inline void PrefilterTrackStart(
+        PrefilterRuleStore *pmq, const uint8_t *buf, const uint32_t buf_len)
+{
+    if (pmq->pat_offsets == NULL)
+        return;
+    if (unlikely(++pmq->pat_gen == 0))
+        PrefilterPatternOffsetsWrap(pmq);
+
+    PrefilterTrackedBuffer *t = &pmq->pat_bufs[pmq->pat_gen % PREFILTER_TRACKED_BUFFERS];
+    t->buf = buf;
+    t->buf_len = buf_len;
+    t->gen = pmq->pat_gen;
+    pmq->pat_track = true;
+}
+
+static inline void PrefilterTrackEnd(PrefilterRuleStore *pmq)
+{
+    pmq->pat_track = false;
+}
+
+/** \brief Forget the tracked buffers, e.g. when their data is changed
+ *         or reused for the next packet or transaction. */
+static inline void PrefilterTrackReset(PrefilterRuleStore *pmq)
+{
+    if (pmq->pat_offsets == NULL)
+        return;
+    memset(pmq->pat_bufs, 0, sizeof(pmq->pat_bufs));
+}
+
+/** \brief Record a match of pattern pid ending at end
+ *
+ *  Only the first match is kept. Must only be called for patterns that were
+ *  searched without offset and depth, so it's the first in the buffer.
+ */
+static inline void PrefilterTrackOffset(
+        PrefilterRuleStore *pmq, const uint32_t pid, const uint32_t end)
+{
+    if (!pmq->pat_track || pid >= pmq->pat_offsets_size)
+        return;
+
+    PrefilterPatternOffset *o = &pmq->pat_offsets[pid];
+    if (o->gen != pmq->pat_gen || end < o->end) {
+        o->gen = pmq->pat_gen;
+        o->end = end;
+    }
+}
+
+/** \brief Get the end of the first match of pattern pid in buf
+ *
+ *  \retval true if buf was searched by a tracked search and the pattern
+ *          was found in it
+ *  \retval false unknown, the buffer needs to be searched
+ */
+static inline bool PrefilterPatternFirstEnd(const PrefilterRuleStore *pmq, const uint32_t pid,
+        const uint8_t *buf, const uint32_t buf_len, uint32_t *end)
+{
+    if (pid >= pmq->pat_offsets_size)
+        return false;
+
+    const PrefilterPatternOffset *o = &pmq->pat_offsets[pid];
+    const PrefilterTrackedBuffer *t = &pmq->pat_bufs[o->gen % PREFILTER_TRACKED_BUFFERS];
+    if (o->gen == 0 || t->gen != o->gen || t->buf != buf || t->buf_len != buf_len)
+        return false;
+
+    *end = o->end;
+    return true;
+}
+
 int PmqSetup(PrefilterRuleStore *);
+int PmqSetupPatternOffsets(PrefilterRuleStore *, uint32_t);
 void PmqReset(PrefilterRuleStore *);
 void PmqCleanup(PrefilterRuleStore *);
 void PmqFree(PrefilterRuleStore *);
@@ -64,6 +64,55 @@ static void *CallocFunc(const size_t nm, const size_t sz)
 
 static void SBBFree(StreamingBuffer *sb, const StreamingBufferConfig *cfg);
 
+/* A slide of the main region w/o blocks doesn't move the data: it advances
+ * buf and records the skipped bytes in head. The space is reclaimed when
+ * the region has to grow, so the data is moved at most once per growth
+ * instead of on every slide. */
+#define REGION_ALLOC(r)      ((r)->buf - (r)->head)
+#define REGION_ALLOC_SIZE(r) ((r)->buf_size + (r)->head)
+
+static inline void RegionFreeBuf(const StreamingBufferConfig *cfg, StreamingBufferRegion *r)
+{
+    FREE(cfg, REGION_ALLOC(r), REGION_ALLOC_SIZE(r));
+    r->buf = NULL;
+    r->head = 0;
+}
+
+/** \internal
+ *  \brief move the data back to the start of the allocation */
+static inline void RegionCompact(const StreamingBuffer *sb, StreamingBufferRegion *r)
+{
+    if (r->head == 0)
+        return;
+    DEBUG_VALIDATE_BUG_ON(r != &sb->region || sb->head != NULL);
+
+    uint8_t *alloc = REGION_ALLOC(r);
+    memmove(alloc, r->buf, r->buf_offset);
+    /* clear what is left of the moved data */
+    memset(alloc + r->buf_offset, 0, r->head);
+    r->buf = alloc;
+    r->buf_size += r->head;
+    r->head = 0;
+}
+
+/** \internal
+ *  \brief slide the main region w/o moving its data */
+static inline void RegionSlideHead(StreamingBufferRegion *r, const uint32_t slide)
+{
+    DEBUG_VALIDATE_BUG_ON(slide > r->buf_offset);
+    if (slide == r->buf_offset) {
+        /* no data left, start over at the beginning of the allocation */
+        r->buf = REGION_ALLOC(r);
+        r->buf_size += r->head;
+        r->head = 0;
+    } else {
+        r->buf += slide;
+        r->buf_size -= slide;
+        r->head += slide;
+    }
+    r->buf_offset -= slide;
+}
+
 RB_GENERATE(SBB, StreamingBufferBlock, rb, SBBCompare);
 
 int SBBCompare(struct StreamingBufferBlock *a, struct StreamingBufferBlock *b)
@@ -277,8 +326,7 @@ void StreamingBufferClear(StreamingBuffer *sb, const StreamingBufferConfig *cfg)
         SBBFree(sb, cfg);
         ListRegions(sb);
         if (sb->region.buf != NULL) {
-            FREE(cfg, sb->region.buf, sb->region.buf_size);
-            sb->region.buf = NULL;
+            RegionFreeBuf(cfg, &sb->region);
         }
 
         for (StreamingBufferRegion *r = sb->region.next; r != NULL;) {
@@ -715,6 +763,13 @@ static inline int WARN_UNUSED GrowRegionToSize(StreamingBuffer *sb,
         return SC_ELIMIT;
     }
 
+    if (region->head) {
+        /* reclaim the space slid off first, it may be all we need */
+        RegionCompact(sb, region);
+        if (size <= region->buf_size)
+            return SC_OK;
+    }
+
     /* try to grow in multiples of cfg->buf_size */
     const uint32_t grow = ToNextMultipleOf(size, cfg->buf_size);
     SCLogDebug("grow %u", grow);
@@ -788,6 +843,7 @@ static inline void StreamingBufferSlideToOffsetWithRegions(
 {
     ListRegions(sb);
     DEBUG_VALIDATE_BUG_ON(slide_offset == sb->region.stream_offset);
+    RegionCompact(sb, &sb->region);
 
     SCLogDebug("slide_offset %" PRIu64, slide_offset);
     SCLogDebug("main: offset %" PRIu64 " buf %p size %u offset %u", sb->region.stream_offset,
@@ -799,8 +855,7 @@ static inline void StreamingBufferSlideToOffsetWithRegions(
         SCLogDebug("main_is_oow");
         if (sb->region.buf != NULL) {
             SCLogDebug("clearing main");
-            FREE(cfg, sb->region.buf, sb->region.buf_size);
-            sb->region.buf = NULL;
+            RegionFreeBuf(cfg, &sb->region);
             sb->region.buf_size = 0;
             sb->region.buf_offset = 0;
             sb->region.stream_offset = slide_offset;
@@ -919,7 +974,7 @@ static inline void StreamingBufferSlideToOffsetWithRegions(
                     memcpy(next->buf, start->buf + start_data_offset, start_data_size);
 
                     // free "start"s buffer, we will use the one from "next"
-                    FREE(cfg, start->buf, start->buf_size);
+                    RegionFreeBuf(cfg, start);
 
                     // update "main" to use "next"
                     start->stream_offset = slide_offset;
@@ -1024,6 +1079,7 @@ void StreamingBufferSlideToOffset(
         const uint32_t slide = offset - sb->region.stream_offset;
         if (sb->head != NULL) {
             /* have sbb's, so can't rely on buf_offset for the slide */
+            DEBUG_VALIDATE_BUG_ON(sb->region.head != 0);
             if (slide < sb->region.buf_size) {
                 const uint32_t size = sb->region.buf_size - slide;
                 SCLogDebug("sliding %u forward, size of original buffer left after slide %u", slide,
@@ -1041,16 +1097,14 @@ void StreamingBufferSlideToOffset(
         } else {
             /* no sbb's, so we can use buf_offset */
             if (offset <= sb->region.stream_offset + sb->region.buf_offset) {
-                const uint32_t size = sb->region.buf_offset - slide;
                 SCLogDebug("sliding %u forward, size of original buffer left after slide %u", slide,
-                        size);
-                memmove(sb->region.buf, sb->region.buf + slide, size);
+                        sb->region.buf_offset - slide);
+                RegionSlideHead(&sb->region, slide);
                 sb->region.stream_offset = offset;
-                sb->region.buf_offset = size;
             } else {
                 /* moved past all data */
+                RegionSlideHead(&sb->region, sb->region.buf_offset);
                 sb->region.stream_offset = offset;
-                sb->region.buf_offset = 0;
             }
         }
         SBBPrune(sb, cfg);
@@ -1063,23 +1117,50 @@ void StreamingBufferSlideToOffset(
 
 #define DATA_FITS(sb, len) ((sb)->region.buf_offset + (len) <= (sb)->region.buf_size)
 
+/** max extra space added when growing the main region for an append */
+#define APPEND_HEADROOM_MAX (64 * 1024)
+
+/** \internal
+ *  \brief grow the main region for an append
+ *
+ *  Appends keep coming on large transfers, so grow by up to half the current
+ *  size at once instead of a realloc per cfg->buf_size worth of data. Falls
+ *  back to the exact size if the headroom can't be had.
+ */
+static int WARN_UNUSED AppendGrowToSize(
+        StreamingBuffer *sb, const StreamingBufferConfig *cfg, const uint32_t size)
+{
+    if (sb->region.head) {
+        RegionCompact(sb, &sb->region);
+        if (size <= sb->region.buf_size)
+            return SC_OK;
+    }
+    const uint32_t headroom = MIN(sb->region.buf_size / 2, APPEND_HEADROOM_MAX);
+    if (headroom > 0 && size + headroom <= BIT_U32(30)) {
+        if (GrowToSize(sb, cfg, size + headroom) == SC_OK)
+            return SC_OK;
+    }
+    return GrowToSize(sb, cfg, size);
+}
+
 int StreamingBufferAppend(StreamingBuffer *sb, const StreamingBufferConfig *cfg,
         StreamingBufferSegment *seg, const uint8_t *data, uint32_t data_len)
 {
+    int r;
     DEBUG_VALIDATE_BUG_ON(seg == NULL);
 
     if (sb->region.buf == NULL) {
-        if (InitBuffer(sb, cfg) == -1)
-            return -1;
+        if ((r = InitBuffer(sb, cfg)) != SC_OK)
+            return r;
     }
 
     if (!DATA_FITS(sb, data_len)) {
         if (sb->region.buf_size == 0) {
-            if (GrowToSize(sb, cfg, data_len) != SC_OK)
-                return -1;
+            if ((r = GrowToSize(sb, cfg, data_len)) != SC_OK)
+                return r;
         } else {
-            if (GrowToSize(sb, cfg, sb->region.buf_offset + data_len) != SC_OK)
-                return -1;
+            if ((r = AppendGrowToSize(sb, cfg, sb->region.buf_offset + data_len)) != SC_OK)
+                return r;
         }
     }
     DEBUG_VALIDATE_BUG_ON(!DATA_FITS(sb, data_len));
@@ -1103,18 +1184,19 @@ int StreamingBufferAppend(StreamingBuffer *sb, const StreamingBufferConfig *cfg,
 int StreamingBufferAppendNoTrack(StreamingBuffer *sb, const StreamingBufferConfig *cfg,
         const uint8_t *data, uint32_t data_len)
 {
+    int r;
     if (sb->region.buf == NULL) {
-        if (InitBuffer(sb, cfg) == -1)
-            return -1;
+        if ((r = InitBuffer(sb, cfg)) != SC_OK)
+            return r;
     }
 
     if (!DATA_FITS(sb, data_len)) {
         if (sb->region.buf_size == 0) {
-            if (GrowToSize(sb, cfg, data_len) != SC_OK)
-                return -1;
+            if ((r = GrowToSize(sb, cfg, data_len)) != SC_OK)
+                return r;
         } else {
-            if (GrowToSize(sb, cfg, sb->region.buf_offset + data_len) != SC_OK)
-                return -1;
+            if ((r = AppendGrowToSize(sb, cfg, sb->region.buf_offset + data_len)) != SC_OK)
+                return r;
         }
     }
     DEBUG_VALIDATE_BUG_ON(!DATA_FITS(sb, data_len));
@@ -1320,7 +1402,7 @@ static StreamingBufferRegion *BufferInsertAtRegionConsolidate(StreamingBuffer *s
     if (start_is_main && dst != &sb->region) {
         DEBUG_VALIDATE_BUG_ON(sb->region.next != dst);
         SCLogDebug("start_is_main && dst != main region");
-        FREE(cfg, sb->region.buf, sb->region.buf_size);
+        RegionFreeBuf(cfg, &sb->region);
         sb->region.buf = dst->buf;
         sb->region.buf_size = dst->buf_size;
         sb->region.buf_offset = new_offset;
@@ -1481,6 +1563,8 @@ int StreamingBufferInsertAt(StreamingBuffer *sb, const StreamingBufferConfig *cf
     if (offset < sb->region.stream_offset) {
         return SC_EINVAL;
     }
+    /* region and block handling below works on the full allocation */
+    RegionCompact(sb, &sb->region);
 
     StreamingBufferRegion *region = BufferInsertAtRegion(sb, cfg, data, data_len, offset);
     if (region == NULL) {
@@ -2319,6 +2403,67 @@ static int StreamingBufferTest10(void)
 
 #endif
 
+/** \test slide w/o moving the data, then append and insert */
+static int StreamingBufferTest11(void)
+{
+    StreamingBufferConfig cfg = { 16, 1, STREAMING_BUFFER_REGION_GAP_DEFAULT, NULL, NULL, NULL };
+    StreamingBuffer *sb = StreamingBufferInit(&cfg);
+    FAIL_IF(sb == NULL);
+
+    StreamingBufferSegment seg1;
+    FAIL_IF(StreamingBufferAppend(sb, &cfg, &seg1, (const uint8_t *)"ABCDEFGH", 8) != 0);
+    uint8_t *alloc = sb->region.buf;
+    StreamingBufferSlideToOffset(sb, &cfg, 4);
+    FAIL_IF(sb->region.stream_offset != 4);
+    FAIL_IF(sb->region.buf_offset != 4);
+    FAIL_IF(sb->region.head != 4);
+    FAIL_IF(sb->region.buf != alloc + 4);
+    FAIL_IF(sb->region.buf_size != 12);
+    FAIL_IF(memcmp(sb->region.buf, "EFGH", 4) != 0);
+
+    /* fits in what is left, no compaction */
+    StreamingBufferSegment seg2;
+    FAIL_IF(StreamingBufferAppend(sb, &cfg, &seg2, (const uint8_t *)"IJKL", 4) != 0);
+    FAIL_IF(sb->region.head != 4);
+    FAIL_IF(seg2.stream_offset != 8);
+    FAIL_IF(sb->region.buf_offset != 8);
+    FAIL_IF(memcmp(sb->region.buf, "EFGHIJKL", 8) != 0);
+
+    /* needs the space in front of the data */
+    StreamingBufferSegment seg3;
+    FAIL_IF(StreamingBufferAppend(sb, &cfg, &seg3, (const uint8_t *)"MNOPQR", 6) != 0);
+    FAIL_IF(sb->region.head != 0);
+    FAIL_IF(sb->region.buf_size < 14);
+    FAIL_IF(sb->region.buf != alloc);
+    FAIL_IF(sb->region.buf_offset != 14);
+    FAIL_IF(memcmp(sb->region.buf, "EFGHIJKLMNOPQR", 14) != 0);
+    FAIL_IF(StreamingBufferSegmentCompareRawData(sb, &seg3, (const uint8_t *)"MNOPQR", 6) != 1);
+
+    /* slide past all data resets to the start of the allocation */
+    StreamingBufferSlideToOffset(sb, &cfg, 10);
+    FAIL_IF(sb->region.head != 6);
+    StreamingBufferSlideToOffset(sb, &cfg, 18);
+    FAIL_IF(sb->region.head != 0);
+    FAIL_IF(sb->region.buf_offset != 0);
+
+    StreamingBufferSegment seg4;
+    FAIL_IF(StreamingBufferAppend(sb, &cfg, &seg4, (const uint8_t *)"ST", 2) != 0);
+    StreamingBufferSlideToOffset(sb, &cfg, 19);
+    FAIL_IF(sb->region.head != 1);
+    StreamingBufferSegment seg5;
+    FAIL_IF(StreamingBufferInsertAt(sb, &cfg, &seg5, (const uint8_t *)"XY", 2, 24) != 0);
+    FAIL_IF(sb->region.head != 0);
+    FAIL_IF(StreamingBufferSegmentCompareRawData(sb, &seg5, (const uint8_t *)"XY", 2) != 1);
+    const uint8_t *data = NULL;
+    uint32_t data_len = 0;
+    uint64_t stream_offset = 0;
+    FAIL_IF(StreamingBufferGetData(sb, &data, &data_len, &stream_offset) != 1);
+    FAIL_IF(data_len != 1 || stream_offset != 19 || data[0] != 'T');
+
+    StreamingBufferFree(sb, &cfg);
+    PASS;
+}
+
 void StreamingBufferRegisterTests(void)
 {
 #ifdef UNITTESTS
@@ -2330,5 +2475,6 @@ void StreamingBufferRegisterTests(void)
     UtRegisterTest("StreamingBufferTest08", StreamingBufferTest08);
     UtRegisterTest("StreamingBufferTest09", StreamingBufferTest09);
     UtRegisterTest("StreamingBufferTest10", StreamingBufferTest10);
+    UtRegisterTest("StreamingBufferTest11", StreamingBufferTest11);
 #endif
 }
@@ -79,7 +79,7 @@ typedef struct StreamingBufferConfig_ {
 
 #define STREAMING_BUFFER_REGION_INIT                                                               \
     {                                                                                              \
-        NULL, 0, 0, 0ULL, NULL,                                                                    \
+        NULL, 0, 0, 0ULL, NULL, 0,                                                                 \
     }
 
 typedef struct StreamingBufferRegion_ {
@@ -88,6 +88,7 @@ typedef struct StreamingBufferRegion_ {
     uint32_t buf_offset;    /**< how far we are in buf_size */
     uint64_t stream_offset; /**< stream offset of this region */
     struct StreamingBufferRegion_ *next;
+    uint32_t head; /**< bytes slid off in front of buf, still part of the allocation */
 } StreamingBufferRegion;
 
 /**